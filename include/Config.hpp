@@ -7,20 +7,42 @@
  *   - show_notifications
  *   - stylize_output
  *   - known_dns_path
+ *   - known_dns_db_path (compiled known DNS database, see --compile-known-dns)
  *
  * Section [Monitors] supports:
  *   - arp_monitor
+ *   - ndp_monitor
  *   - dns_monitor
  *   - icmp_monitor
  *
+ * Section [Capture] supports:
+ *   - workers (packet capture threads sharing the traffic; 0 = one per CPU)
+ *   - xdp_interfaces (comma-separated interfaces where ARP and ping requests are
+ *     pre-aggregated in the kernel by an XDP program; empty = disabled)
+ *
+ * Section [ARP] supports:
+ *   - rate_table_kb (memory ceiling of the per-MAC ARP rate table)
+ *
+ * Section [NDP] supports:
+ *   - trusted_routers (comma-separated router link-local addresses and/or MACs;
+ *     with both kinds listed, an RA must match one of each)
+ *
+ * Section [DNS] supports:
+ *   - trusted_resolvers (comma-separated resolvers, optionally "IPv4:port" or
+ *     "[IPv6]:port", that sampled answers are re-checked against; empty = disabled)
+ *   - consistency_rate (re-queries per second)
+ *   - consistency_in_flight (re-queries outstanding at once)
+ *
  * Licensed under GPLv3.
  */
 
 #pragma once
 
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 /**
  * @class Config
@@ -46,12 +68,29 @@ public:
     bool showNotifications() const noexcept;
     bool stylizeOutput() const noexcept;
     const std::string& getKnownDNSPath() const noexcept;
+    const std::string& getKnownDNSDbPath() const noexcept;
 
     // ----- Monitors section -----
     bool arpMonitorEnabled() const noexcept;
+    bool ndpMonitorEnabled() const noexcept;
     bool dnsMonitorEnabled() const noexcept;
     bool icmpMonitorEnabled() const noexcept;
 
+    // ----- Capture section -----
+    unsigned captureWorkers() const noexcept;
+    std::vector<std::string> captureXdpInterfaces() const;
+
+    // ----- ARP section -----
+    std::size_t arpRateTableKb() const noexcept;
+
+    // ----- NDP section -----
+    std::vector<std::string> ndpTrustedRouters() const;
+
+    // ----- DNS section -----
+    std::vector<std::string> dnsTrustedResolvers() const;
+    unsigned dnsConsistencyRate() const noexcept;
+    unsigned dnsConsistencyInFlight() const noexcept;
+
     // ----- Generic access -----
     bool hasKey(const std::string& key) const noexcept;
     std::string getRaw(const std::string& key) const noexcept;
@@ -65,4 +104,6 @@ private:
     static std::string trim(const std::string& s);
     static std::string toLower(const std::string& s);
     static bool parseBool(const std::string& s, bool defaultValue) noexcept;
+    static std::size_t parseSize(const std::string& s, std::size_t defaultValue) noexcept;
+    static std::vector<std::string> parseList(const std::string& s);
 };
@@ -8,21 +8,23 @@
 #pragma once
 
 #include "Config.hpp"
+#include "capture/CaptureEngine.hpp"
 #include "monitors/ArpMonitor.hpp"
 #include "monitors/DnsMonitor.hpp"
 #include "monitors/IcmpMonitor.hpp"
+#include "monitors/NdpMonitor.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Notifier.hpp"
 
 #include <atomic>
 #include <chrono>
-#include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 /**
  * @class Core
- * @brief Manages the lifecycle of network monitors (ARP, DNS, ICMP) and notifications.
+ * @brief Manages the lifecycle of network monitors (ARP, NDP, DNS, ICMP) and notifications.
  */
 class Core {
 public:
@@ -41,16 +43,26 @@ public:
     void run(std::atomic<bool>& keepRunning);
 
 private:
+    /**
+     * @brief Warn about frames the kernel dropped because a capture ring was full.
+     * @param final Also log the totals (on shutdown).
+     */
+    void reportCaptureStats(bool final);
+
+    /** Interval between two checks of the capture drop counters. */
+    static constexpr std::chrono::seconds CAPTURE_STATS_INTERVAL{60};
+
     int m_pollIntervalSeconds;
     std::string m_forcedGateway;
     bool m_notificationsEnabled;
+    std::vector<std::string> m_xdpInterfaces;  ///< Interfaces folding ARP/ICMP in the kernel
 
     std::optional<monitors::ArpMonitor> m_arpMonitor;
     std::optional<monitors::DnsMonitor> m_dnsMonitor;
     std::optional<monitors::IcmpMonitor> m_icmpMonitor;
+    std::optional<monitors::NdpMonitor> m_ndpMonitor;
 
-    // ICMP alert throttling
-    static constexpr std::chrono::seconds ICMP_ALERT_INTERVAL{60};
-    std::mutex m_icmpMutex;
-    std::chrono::steady_clock::time_point m_lastIcmpAlert;
+    /// Shared packet capture; declared last so it stops before the monitors it calls into
+    capture::CaptureEngine m_capture;
+    uint64_t m_reportedDrops{0};
 };
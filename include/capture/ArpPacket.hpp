@@ -0,0 +1,60 @@
+/**
+ * @file ArpPacket.hpp
+ * @brief Decoded view of a captured Ethernet/IPv4 ARP frame.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "capture/PacketRing.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @struct ArpPacket
+ * @brief Fields of an ARP request/reply, decoded in place from the ring.
+ *
+ * Addresses use the NetAddr conventions: IPv4 in network byte order, MACs
+ * packed into the low 48 bits.
+ */
+struct ArpPacket {
+    /** ARP operation. */
+    enum class Op : uint8_t { REQUEST = 1, REPLY = 2 };
+
+    Op op = Op::REQUEST;
+    uint64_t ethSrc = 0;       ///< Ethernet source MAC
+    uint64_t ethDst = 0;       ///< Ethernet destination MAC
+    uint64_t senderMac = 0;
+    uint32_t senderIp = 0;
+    uint64_t targetMac = 0;
+    uint32_t targetIp = 0;
+    uint32_t tsSec = 0;        ///< Capture timestamp, seconds
+    uint32_t tsNsec = 0;       ///< Capture timestamp, nanoseconds
+    int ifindex = 0;           ///< Receiving interface
+    bool outgoing = false;     ///< Sent by this host
+
+    /** @brief Gratuitous announcement: sender and target IP are the same. */
+    bool isGratuitous() const noexcept { return senderIp != 0 && senderIp == targetIp; }
+
+    /** @brief ARP probe (RFC 5227): sender IP is 0.0.0.0, no binding is claimed. */
+    bool isProbe() const noexcept { return senderIp == 0; }
+};
+
+/**
+ * @brief Decode an Ethernet/IPv4 ARP frame.
+ * @param frame Captured ARP frame.
+ * @param[out] arp Decoded packet.
+ * @return False if the frame is not a well-formed Ethernet/IPv4 ARP request or reply.
+ */
+bool parseArpFrame(const PacketFrame& frame, ArpPacket& arp) noexcept;
+
+/**
+ * @brief Classic BPF program accepting only Ethernet ARP frames, truncated to the ARP payload.
+ */
+std::vector<sock_filter> arpCaptureFilter();
+
+} // namespace capture
@@ -0,0 +1,191 @@
+/**
+ * @file CaptureEngine.hpp
+ * @brief Shared packet capture demultiplexing frames to the packet-based monitors.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "capture/PacketRing.hpp"
+#include "capture/XdpAggregator.hpp"
+#include "utils/WakeupFd.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @brief Traffic classes a monitor can subscribe to.
+ *
+ * Each subscribed class adds one block to the kernel filter, so traffic no
+ * monitor asked for never reaches userspace.
+ */
+enum class Interest : uint8_t {
+    ARP,            ///< All ARP frames
+    NDP,            ///< ICMPv6 Router/Neighbor Advertisements and Neighbor Solicitations
+    ICMPV4,         ///< Inbound ICMPv4 echo requests and redirects, outbound ICMPv4 (headers only)
+    ICMPV6_ECHO,    ///< Inbound ICMPv6 echo requests (headers only)
+    IPV4_OUTBOUND,  ///< TCP and UDP sent by this host (headers only)
+    TCP_SYN,        ///< Inbound TCP connection attempts (headers only)
+    DNS,            ///< UDP/53 queries sent by this host and responses it receives (whole message)
+    COUNT
+};
+
+/**
+ * @struct PacketView
+ * @brief A captured frame with its link and network headers already located.
+ *
+ * Points into the ring: only valid inside the handler call.
+ */
+struct PacketView {
+    PacketFrame frame;                  ///< Raw frame and capture metadata
+    uint16_t ethertype = 0;             ///< Ethertype, host byte order
+    uint8_t ipVersion = 0;              ///< 4 or 6, 0 if not IP
+    uint8_t ipProto = 0;                ///< IPv4 protocol or IPv6 next header
+    const uint8_t* l3 = nullptr;        ///< Network header
+    uint32_t l3Len = 0;                 ///< Captured bytes at l3
+    const uint8_t* l4 = nullptr;        ///< Transport header, nullptr for non-first fragments
+    uint32_t l4Len = 0;                 ///< Captured bytes at l4
+    bool outgoing = false;              ///< Sent by this host
+    unsigned worker = 0;                ///< Index of the worker that received the frame
+    uint32_t count = 1;                 ///< Identical frames this one stands for (XDP folding)
+};
+
+/**
+ * @class CaptureEngine
+ * @brief TPACKET_V3 capture with one combined BPF program for every monitor.
+ *
+ * Monitors subscribe handlers per Interest before start(). The engine then
+ * opens an ETH_P_ALL ring per worker whose filter is the union of the
+ * subscribed classes, parses the link and IP headers of each frame once, and calls the
+ * handlers of the class the frame belongs to. Frames are never copied out
+ * of the ring, so enabling more monitors adds filter blocks and handler
+ * calls, not capture sockets or buffers.
+ *
+ * Frames are handed over in batches: the views of a ring block are grouped
+ * by class, and each handler is called once per block with all of its
+ * frames, so a monitor pays for its call and its lock once per block
+ * instead of once per packet.
+ *
+ * With several workers, each one owns a ring in a PACKET_FANOUT group. The
+ * kernel steers frames by remote endpoint: the destination (ARP target) of
+ * frames this host sends, the source (ARP sender) of the others, and the
+ * quoted destination of ICMP redirects. All traffic from one host, and both
+ * halves of every exchange with it, land on the same worker in capture
+ * order, so per-peer state can be sharded by PacketView::worker without
+ * locks.
+ *
+ * With XDP pre-aggregation enabled, inbound ARP and ICMPv4 echo requests on
+ * the chosen interfaces are folded in the kernel instead (see XdpAggregator)
+ * and filtered out of the rings; worker 0 dispatches the folded records like
+ * frames, with PacketView::count set to the number of frames each one stands for.
+ * They skip the ring blocks, so they can reach the handlers up to
+ * RETIRE_TIMEOUT_MS ahead of ring frames captured before them.
+ *
+ * Handlers run on worker threads, concurrently when there are several, and
+ * must synchronize with the rest of their monitor.
+ */
+class CaptureEngine {
+public:
+    /** Handler called once per ring block with the frames of a subscribed class. */
+    using Handler = std::function<void(const PacketView* views, std::size_t count)>;
+
+    CaptureEngine() = default;
+    ~CaptureEngine();
+
+    // Non-copyable
+    CaptureEngine(const CaptureEngine&) = delete;
+    CaptureEngine& operator=(const CaptureEngine&) = delete;
+
+    /**
+     * @brief Register a handler. Must be called before start().
+     * @param interest Traffic class to receive.
+     * @param handler Called on a worker thread with each batch of matching frames.
+     */
+    void subscribe(Interest interest, Handler handler);
+
+    /**
+     * @brief Set the number of capture workers. Must be called before start()
+     *        and before monitors size per-worker state from workerCount().
+     * @param count Worker threads, 0 for one per online CPU (capped at MAX_WORKERS).
+     */
+    void setWorkers(unsigned count);
+
+    /** @brief Number of capture workers (PacketView::worker is below this). */
+    unsigned workerCount() const noexcept { return m_workerCount; }
+
+    /** @brief Upper bound on capture workers. */
+    static constexpr unsigned MAX_WORKERS = 64;
+
+    /** Longest time a frame waits in a partially filled ring block (milliseconds). */
+    static constexpr uint32_t RETIRE_TIMEOUT_MS = 20;
+
+    /**
+     * @brief Fold inbound ARP and ICMPv4 echo requests in the kernel. Must be
+     *        called after the monitors subscribed and before start().
+     * @param interfaces Interfaces to attach the XDP program to.
+     * @param[out] error Reason of failure; capture then works as without it.
+     * @return True on success.
+     */
+    bool enableXdp(const std::vector<std::string>& interfaces, std::string& error);
+
+    /** @brief True if at least one handler is registered. */
+    bool hasSubscribers() const noexcept;
+
+    /**
+     * @brief Open the rings and start one dispatching thread per worker.
+     * @param[out] error Reason of failure.
+     * @return True on success.
+     */
+    bool start(std::string& error);
+
+    /** @brief Stop dispatching, join the workers, close the rings and detach XDP. */
+    void stop();
+
+    /** @brief True while the workers are running. */
+    bool isRunning() const noexcept { return m_running.load(); }
+
+    /** @brief Human-readable list of subscribed classes, e.g. "ARP, NDP". */
+    std::string describe() const;
+
+    /** @brief Kernel counters summed over the rings. */
+    PacketRing::Stats stats();
+
+private:
+    /** @brief Concatenate the filter blocks of the subscribed classes. */
+    std::vector<sock_filter> buildFilter() const;
+
+    /** One ring, the thread draining it and the views of the block being parsed. */
+    struct Worker {
+        PacketRing ring;
+        std::thread thread;
+        std::array<std::vector<PacketView>, static_cast<std::size_t>(Interest::COUNT)> pending;
+    };
+
+    /** @brief Locate the headers of a frame and queue it for its class. */
+    void classify(const PacketFrame& frame, Worker& worker, unsigned index, uint32_t count = 1);
+
+    /** @brief Hand the queued views of a block to the handlers. */
+    void flush(Worker& worker);
+
+    /** @brief Poll one worker's ring (and, for worker 0, the XDP records) until stop(). */
+    void loop(unsigned index);
+
+    std::array<std::vector<Handler>, static_cast<std::size_t>(Interest::COUNT)> m_handlers;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    unsigned m_workerCount{1};
+    XdpAggregator m_xdp;
+    WakeupFd m_wakeup;
+    std::atomic<bool> m_running{false};
+};
+
+} // namespace capture
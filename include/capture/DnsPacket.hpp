@@ -0,0 +1,127 @@
+/**
+ * @file DnsPacket.hpp
+ * @brief Decoded view of a captured DNS-over-UDP datagram.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/NetAddr.hpp"
+
+#include <cstdint>
+#include <linux/filter.h>
+#include <string>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @struct DnsPacket
+ * @brief Header and question of a DNS message, decoded in place from the ring.
+ *
+ * Addresses of both families are kept as Ipv6Addr, IPv4 as ::ffff:a.b.c.d,
+ * so one key type covers every resolver. Only the first question is decoded
+ * (that is all resolvers accept); the answer section stays in the ring and
+ * is read with DnsAnswerReader.
+ */
+struct DnsPacket {
+    Ipv6Addr source;                  ///< IP source address
+    Ipv6Addr destination;             ///< IP destination address
+    uint16_t sourcePort = 0;
+    uint16_t destinationPort = 0;
+
+    uint16_t id = 0;                  ///< Transaction ID
+    bool response = false;            ///< QR bit
+    bool truncated = false;           ///< TC bit: the full answer needs TCP
+    uint8_t opcode = 0;
+    uint8_t rcode = 0;
+    uint16_t questionCount = 0;
+    uint16_t answerCount = 0;
+
+    uint16_t qtype = 0;               ///< Type of the first question, 0 without question
+    uint16_t qclass = 0;
+    uint64_t questionHash = 0;        ///< Case-insensitive hash of the first question, 0 without question
+    uint16_t questionNameLen = 0;     ///< Encoded length of the first question name (at offset 12)
+
+    const uint8_t* message = nullptr; ///< DNS message (points into the ring)
+    uint32_t messageLen = 0;          ///< Captured bytes at message
+    uint32_t answerOffset = 0;        ///< Start of the answer section in message
+};
+
+/**
+ * @struct DnsRecord
+ * @brief One resource record of the answer section, pointing into the ring.
+ */
+struct DnsRecord {
+    uint16_t type = 0;
+    uint16_t rclass = 0;
+    uint32_t ttl = 0;
+    const uint8_t* rdata = nullptr;
+    uint16_t rdataLen = 0;
+};
+
+/**
+ * @class DnsAnswerReader
+ * @brief Walks the answer section of a DnsPacket without copying or allocating.
+ *
+ * Stops at the last announced record or at the end of the captured bytes,
+ * whichever comes first.
+ */
+class DnsAnswerReader {
+public:
+    explicit DnsAnswerReader(const DnsPacket& packet) noexcept
+        : m_message(packet.message), m_len(packet.messageLen), m_offset(packet.answerOffset),
+          m_remaining(packet.answerCount) {}
+
+    /**
+     * @brief Decode the next record.
+     * @return False when no (complete) record is left.
+     */
+    bool next(DnsRecord& record) noexcept;
+
+private:
+    const uint8_t* m_message;
+    uint32_t m_len;
+    uint32_t m_offset;
+    uint16_t m_remaining;
+};
+
+/**
+ * @brief Decode an IPv4 or IPv6 UDP datagram carrying a DNS message.
+ * @param l3 Network header.
+ * @param l3Len Captured bytes at l3.
+ * @param[out] dns Decoded packet.
+ * @return False if the datagram is not UDP or its DNS header or question is malformed.
+ */
+bool parseDnsDatagram(const uint8_t* l3, uint32_t l3Len, DnsPacket& dns) noexcept;
+
+/**
+ * @brief Decode a DNS message received on a socket. Addresses and ports are left untouched.
+ * @param message First byte of the DNS header.
+ * @param len Bytes at message.
+ * @param[out] dns Decoded message.
+ * @return False if the header or question is malformed.
+ */
+bool parseDnsMessage(const uint8_t* message, uint32_t len, DnsPacket& dns) noexcept;
+
+/**
+ * @brief Order-independent digest of the addresses a response answers with.
+ *
+ * Covers the rcode and the A/AAAA records, not the TTLs (which shrink in
+ * caches) nor the name compression layout, so two honest copies of an
+ * answer digest alike and a forged competing answer does not.
+ */
+uint64_t dnsAnswerDigest(const DnsPacket& dns) noexcept;
+
+/** @brief Name of the first question in dotted form, "." for the root or without question. */
+std::string dnsQuestionName(const DnsPacket& dns);
+
+/**
+ * @brief Classic BPF program accepting UDP/53 queries sent by this host and responses it receives.
+ *
+ * Frames are cut at 1300 bytes, enough for a 1232-byte EDNS response over IPv6.
+ */
+std::vector<sock_filter> dnsCaptureFilter();
+
+} // namespace capture
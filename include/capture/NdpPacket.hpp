@@ -0,0 +1,114 @@
+/**
+ * @file NdpPacket.hpp
+ * @brief Decoded views of captured IPv6 Neighbor Discovery messages (NS, NA, RA).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "capture/PacketRing.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstdint>
+#include <linux/filter.h>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @struct NdpPacket
+ * @brief Fields of a Neighbor Solicitation or Advertisement, decoded in place from the ring.
+ *
+ * MACs use the NetAddr packing. The link-layer address is the Source
+ * (NS) or Target (NA) Link-Layer Address option, when present.
+ */
+struct NdpPacket {
+    /** ICMPv6 message type. */
+    enum class Type : uint8_t { NEIGHBOR_SOLICITATION = 135, NEIGHBOR_ADVERTISEMENT = 136 };
+
+    Type type = Type::NEIGHBOR_SOLICITATION;
+    uint64_t ethSrc = 0;        ///< Ethernet source MAC
+    Ipv6Addr source;            ///< IPv6 source address
+    Ipv6Addr destination;       ///< IPv6 destination address
+    Ipv6Addr target;            ///< Target address of the NS/NA
+    uint64_t linkAddr = 0;      ///< Link-layer address option (0 if absent)
+    uint8_t hopLimit = 0;       ///< 255 unless the packet was routed (forged off-link)
+    bool router = false;        ///< NA R flag: sender is a router
+    bool solicited = false;     ///< NA S flag: answer to a solicitation
+    bool override = false;      ///< NA O flag: replace cached link-layer address
+    uint32_t tsSec = 0;         ///< Capture timestamp, seconds
+    uint32_t tsNsec = 0;        ///< Capture timestamp, nanoseconds
+    int ifindex = 0;            ///< Receiving interface
+    bool outgoing = false;      ///< Sent by this host
+
+    /** @brief Duplicate Address Detection probe: NS from "::", no binding is claimed. */
+    bool isDadProbe() const noexcept {
+        return type == Type::NEIGHBOR_SOLICITATION && source.isUnspecified();
+    }
+};
+
+/**
+ * @brief Decode an Ethernet/IPv6 Neighbor Solicitation or Advertisement.
+ * @param frame Captured IPv6 frame.
+ * @param[out] ndp Decoded packet.
+ * @return False if the frame is not a well-formed NS or NA.
+ */
+bool parseNdpFrame(const PacketFrame& frame, NdpPacket& ndp) noexcept;
+
+/**
+ * @struct RaPacket
+ * @brief Fields of a Router Advertisement, decoded in place from the ring.
+ *
+ * Fixed size: up to MAX_PREFIXES Prefix Information options are kept, so
+ * decoding never allocates.
+ */
+struct RaPacket {
+    /** Maximum number of Prefix Information options decoded per RA. */
+    static constexpr uint8_t MAX_PREFIXES = 8;
+
+    /** Prefix Information option. */
+    struct Prefix {
+        Ipv6Addr prefix;
+        uint8_t length = 0;
+        bool onLink = false;              ///< L flag
+        bool autonomous = false;          ///< A flag (SLAAC)
+        uint32_t validLifetime = 0;       ///< Seconds, 0 withdraws the prefix
+        uint32_t preferredLifetime = 0;   ///< Seconds
+    };
+
+    uint64_t ethSrc = 0;          ///< Ethernet source MAC
+    Ipv6Addr source;              ///< IPv6 source address (link-local for genuine routers)
+    uint8_t hopLimit = 0;         ///< 255 unless the packet was routed (forged off-link)
+    uint8_t curHopLimit = 0;      ///< Advertised hop limit for hosts
+    bool managed = false;         ///< M flag (DHCPv6 addresses)
+    bool otherConfig = false;     ///< O flag (DHCPv6 other configuration)
+    uint16_t routerLifetime = 0;  ///< Seconds, 0: not a default router (any more)
+    uint64_t linkAddr = 0;        ///< Source Link-Layer Address option (0 if absent)
+    Prefix prefixes[MAX_PREFIXES];
+    uint8_t prefixCount = 0;
+    uint32_t tsSec = 0;           ///< Capture timestamp, seconds
+    int ifindex = 0;              ///< Receiving interface
+    bool outgoing = false;        ///< Sent by this host
+
+    /** @brief MAC the router claims: the SLLA option, else the frame source. */
+    uint64_t routerMac() const noexcept { return linkAddr != 0 ? linkAddr : ethSrc; }
+};
+
+/**
+ * @brief Decode an Ethernet/IPv6 Router Advertisement.
+ * @param frame Captured IPv6 frame.
+ * @param[out] ra Decoded packet.
+ * @return False if the frame is not a well-formed RA.
+ */
+bool parseRaFrame(const PacketFrame& frame, RaPacket& ra) noexcept;
+
+/**
+ * @brief Classic BPF program accepting only Ethernet/IPv6 RA, NS and NA frames.
+ *
+ * Runs in the kernel, so the ring only ever receives neighbour discovery
+ * traffic, never the host's bulk IPv6 flows.
+ */
+std::vector<sock_filter> ndpCaptureFilter();
+
+} // namespace capture
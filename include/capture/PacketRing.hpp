@@ -0,0 +1,173 @@
+/**
+ * @file PacketRing.hpp
+ * @brief Memory-mapped AF_PACKET receive ring (TPACKET_V3) for passive capture.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @struct PacketFrame
+ * @brief One captured frame, pointing straight into the ring block.
+ *
+ * Only valid until its block is handed back to the kernel, right after the
+ * PacketRing::drain() callbacks for that block return.
+ */
+struct PacketFrame {
+    const uint8_t* data = nullptr;    ///< Start of the link-layer header
+    uint32_t caplen = 0;              ///< Captured bytes available at data
+    const uint8_t* network = nullptr; ///< Start of the network-layer header (ARP, IP, ...)
+    uint32_t networkLen = 0;          ///< Captured bytes available at network
+    uint32_t len = 0;                 ///< Original length on the wire
+    uint32_t tsSec = 0;               ///< Capture timestamp, seconds
+    uint32_t tsNsec = 0;              ///< Capture timestamp, nanoseconds
+    int ifindex = 0;                  ///< Receiving interface
+    uint16_t hatype = 0;              ///< ARPHRD_* link type of the interface
+    uint16_t protocol = 0;            ///< Ethertype (network byte order)
+    uint8_t pkttype = 0;              ///< PACKET_HOST, PACKET_OUTGOING, ...
+};
+
+/**
+ * @class PacketRing
+ * @brief TPACKET_V3 ring on an AF_PACKET socket.
+ *
+ * The kernel fills fixed-size blocks with variable-length frames; a block is
+ * handed to userspace when full or when its retire timeout expires. Frames are
+ * parsed in place, so capturing does not copy packets beyond the ring itself.
+ * Requires CAP_NET_RAW.
+ */
+class PacketRing {
+public:
+    /** Ring configuration. */
+    struct Options {
+        uint16_t protocol = 0x0003;       ///< Ethertype to capture (host order, default ETH_P_ALL)
+        std::string interface;            ///< Interface name, empty for all interfaces
+        uint32_t blockSize = 1u << 18;    ///< Block size in bytes (multiple of the page size)
+        uint32_t blockCount = 8;          ///< Number of blocks in the ring
+        uint32_t frameSize = 2048;        ///< Nominal frame size used for ring accounting
+        uint32_t retireTimeoutMs = 20;    ///< Hand partially filled blocks over after this delay
+        std::vector<sock_filter> filter;  ///< Optional classic BPF filter
+        bool fanout = false;              ///< Join a PACKET_FANOUT group after binding
+        uint16_t fanoutGroup = 0;         ///< Group id shared by the rings of one process
+        uint16_t fanoutType = PACKET_FANOUT_HASH; ///< PACKET_FANOUT_* demultiplexing mode
+        std::vector<sock_filter> fanoutProgram;   ///< Steering program for PACKET_FANOUT_CBPF
+    };
+
+    /** Cumulative socket statistics. */
+    struct Stats {
+        uint64_t packets = 0;   ///< Packets that passed the filter
+        uint64_t drops = 0;     ///< Packets dropped because the ring was full
+    };
+
+    PacketRing() = default;
+    ~PacketRing();
+
+    // Non-copyable
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    /**
+     * @brief Create the socket, attach the filter, map the ring and bind.
+     * @param options Ring configuration.
+     * @param[out] error Reason of failure.
+     * @return True on success.
+     */
+    bool open(const Options& options, std::string& error);
+
+    /** @brief Unmap the ring and close the socket. */
+    void close() noexcept;
+
+    /** @brief True if the ring is mapped. */
+    bool isOpen() const noexcept { return m_fd >= 0; }
+
+    /** @brief Descriptor to add to a poll set (POLLIN when a block is ready). */
+    int fd() const noexcept { return m_fd; }
+
+    /**
+     * @brief Process every block currently owned by userspace.
+     * @param fn Called as fn(const PacketFrame&) for each frame.
+     * @return Number of frames processed.
+     */
+    template <typename Fn>
+    std::size_t drain(Fn&& fn) {
+        return drain(std::forward<Fn>(fn), [] {});
+    }
+
+    /**
+     * @brief Process every ready block, with a hook once each block is parsed.
+     * @param fn Called as fn(const PacketFrame&) for each frame.
+     * @param blockDone Called after the last frame of a block, while its
+     *        frames are still valid (the block is released right after).
+     * @return Number of frames processed.
+     */
+    template <typename Fn, typename BlockFn>
+    std::size_t drain(Fn&& fn, BlockFn&& blockDone);
+
+    /** @brief Read and accumulate kernel counters (PACKET_STATISTICS). */
+    Stats stats();
+
+private:
+    /** @brief Block at the current ring position if the kernel released it, else nullptr. */
+    tpacket_block_desc* readyBlock() const noexcept;
+
+    /** @brief Return the current block to the kernel and advance. */
+    void releaseBlock(tpacket_block_desc* block) noexcept;
+
+    int m_fd{-1};
+    uint8_t* m_map{nullptr};
+    std::size_t m_mapSize{0};
+    uint32_t m_blockSize{0};
+    uint32_t m_blockCount{0};
+    uint32_t m_current{0};
+    Stats m_stats{};
+};
+
+template <typename Fn, typename BlockFn>
+std::size_t PacketRing::drain(Fn&& fn, BlockFn&& blockDone) {
+    std::size_t processed = 0;
+    while (tpacket_block_desc* block = readyBlock()) {
+        uint32_t count = block->hdr.bh1.num_pkts;
+        auto* base = reinterpret_cast<uint8_t*>(block);
+        auto* hdr = reinterpret_cast<tpacket3_hdr*>(base + block->hdr.bh1.offset_to_first_pkt);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            auto* raw = reinterpret_cast<uint8_t*>(hdr);
+            const auto* sll = reinterpret_cast<const sockaddr_ll*>(raw + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+
+            PacketFrame frame;
+            frame.data = raw + hdr->tp_mac;
+            frame.caplen = hdr->tp_snaplen;
+            uint32_t linkLen = hdr->tp_net >= hdr->tp_mac ? hdr->tp_net - hdr->tp_mac : 0;
+            frame.network = raw + hdr->tp_mac + linkLen;
+            frame.networkLen = hdr->tp_snaplen > linkLen ? hdr->tp_snaplen - linkLen : 0;
+            frame.len = hdr->tp_len;
+            frame.tsSec = hdr->tp_sec;
+            frame.tsNsec = hdr->tp_nsec;
+            frame.ifindex = sll->sll_ifindex;
+            frame.hatype = sll->sll_hatype;
+            frame.protocol = sll->sll_protocol;
+            frame.pkttype = sll->sll_pkttype;
+            fn(static_cast<const PacketFrame&>(frame));
+
+            hdr = reinterpret_cast<tpacket3_hdr*>(raw + hdr->tp_next_offset);
+        }
+
+        processed += count;
+        blockDone();
+        releaseBlock(block);
+    }
+    return processed;
+}
+
+} // namespace capture
@@ -0,0 +1,156 @@
+/**
+ * @file XdpAggregator.hpp
+ * @brief Optional XDP program folding repeated ARP frames and ICMP echo requests in the kernel.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "capture/PacketRing.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/bpf.h>
+#include <string>
+#include <vector>
+
+namespace capture {
+
+/**
+ * @class XdpAggregator
+ * @brief Pre-aggregates inbound ARP and ICMP echo traffic before it reaches userspace.
+ *
+ * An eBPF program attached at XDP on the chosen interfaces keeps, in LRU hash
+ * maps, a counter per distinct ARP frame (source MAC, opcode, sender and
+ * target bindings) and per IPv4 echo source/destination pair. Only the first
+ * frame of a key, then one frame per second or per FOLD_MAX repeats, is
+ * pushed through a BPF ring buffer, together with the number of frames it
+ * stands for. A new IP->MAC binding is a new key, so it always reaches the
+ * monitors immediately; a flood of identical frames costs one record.
+ *
+ * The program always returns XDP_PASS: the host sees every frame unchanged.
+ * Records look like captured frames (the first SNAPLEN bytes) so the capture
+ * engine dispatches them like ring frames. Up to FOLD_MAX - 1 repeats of a
+ * key can stay uncounted when its traffic stops. XDP only sees received
+ * traffic. Requires CAP_BPF and CAP_NET_ADMIN.
+ */
+class XdpAggregator {
+public:
+    /** Bytes of each folded frame copied to userspace (Ethernet, IPv4 with options, ICMP). */
+    static constexpr uint32_t SNAPLEN = 96;
+
+    /** A key is flushed after this many repeats even within the same second. */
+    static constexpr uint32_t FOLD_MAX = 64;
+
+    /** Record pushed by the program. */
+    struct Record {
+        uint32_t count;         ///< Frames this record stands for
+        uint32_t ifindex;       ///< Receiving interface
+        uint64_t tsNs;          ///< CLOCK_MONOTONIC time of the last frame
+        uint32_t len;           ///< Bytes valid in data
+        uint32_t reserved;
+        uint8_t data[SNAPLEN];  ///< Frame head, from the Ethernet header
+    };
+
+    XdpAggregator() = default;
+    ~XdpAggregator();
+
+    // Non-copyable
+    XdpAggregator(const XdpAggregator&) = delete;
+    XdpAggregator& operator=(const XdpAggregator&) = delete;
+
+    /**
+     * @brief Create the maps, load the program and attach it to each interface.
+     * @param interfaces Interface names (Ethernet-like links).
+     * @param[out] error Reason of failure, including the verifier log tail.
+     * @return True on success; nothing stays attached on failure.
+     */
+    bool open(const std::vector<std::string>& interfaces, std::string& error);
+
+    /** @brief Detach the program and release every kernel object. */
+    void close() noexcept;
+
+    /** @brief True while the program is attached. */
+    bool isOpen() const noexcept { return m_events >= 0; }
+
+    /** @brief Ring buffer descriptor to add to a poll set (POLLIN when records are ready). */
+    int fd() const noexcept { return m_events; }
+
+    /** @brief Indexes of the interfaces the program is attached to. */
+    const std::vector<int>& ifindexes() const noexcept { return m_ifindexes; }
+
+    /** @brief Names of the interfaces the program is attached to. */
+    const std::vector<std::string>& interfaces() const noexcept { return m_interfaces; }
+
+    /**
+     * @brief Consume every submitted record.
+     * @param fn Called as fn(const PacketFrame&, uint32_t count) for each record.
+     * @param batchDone Called once the records are parsed, before their space
+     *        is handed back to the kernel.
+     * @return Number of records processed.
+     */
+    template <typename Fn, typename BatchFn>
+    std::size_t drain(Fn&& fn, BatchFn&& batchDone);
+
+private:
+    int m_arpFolds{-1};
+    int m_echoFolds{-1};
+    int m_events{-1};
+    int m_prog{-1};
+    std::vector<int> m_links;
+    std::vector<int> m_ifindexes;
+    std::vector<std::string> m_interfaces;
+    uint64_t* m_consumerPos{nullptr};
+    const uint64_t* m_producerPos{nullptr};
+    const uint8_t* m_data{nullptr};
+    std::size_t m_pageSize{0};
+    std::size_t m_ringSize{0};
+    int64_t m_clockOffsetNs{0};  ///< CLOCK_REALTIME - CLOCK_MONOTONIC
+};
+
+template <typename Fn, typename BatchFn>
+std::size_t XdpAggregator::drain(Fn&& fn, BatchFn&& batchDone) {
+    if (!m_consumerPos) return 0;
+    std::size_t processed = 0;
+    uint64_t cons = *m_consumerPos;
+    uint64_t prod = __atomic_load_n(m_producerPos, __ATOMIC_ACQUIRE);
+
+    while (cons < prod) {
+        const uint8_t* hdr = m_data + (cons & (m_ringSize - 1));
+        uint32_t len = __atomic_load_n(reinterpret_cast<const uint32_t*>(hdr), __ATOMIC_ACQUIRE);
+        if (len & BPF_RINGBUF_BUSY_BIT) break;
+
+        uint32_t size = len & ~(BPF_RINGBUF_BUSY_BIT | BPF_RINGBUF_DISCARD_BIT);
+        if (!(len & BPF_RINGBUF_DISCARD_BIT) && size >= sizeof(Record)) {
+            const auto* rec = reinterpret_cast<const Record*>(hdr + BPF_RINGBUF_HDR_SZ);
+            uint32_t caplen = rec->len < SNAPLEN ? rec->len : SNAPLEN;
+            int64_t ts = static_cast<int64_t>(rec->tsNs) + m_clockOffsetNs;
+
+            PacketFrame frame;
+            frame.data = rec->data;
+            frame.caplen = caplen;
+            frame.network = rec->data + 14;
+            frame.networkLen = caplen > 14 ? caplen - 14 : 0;
+            frame.len = caplen;
+            frame.tsSec = static_cast<uint32_t>(ts / 1000000000);
+            frame.tsNsec = static_cast<uint32_t>(ts % 1000000000);
+            frame.ifindex = static_cast<int>(rec->ifindex);
+            frame.hatype = 1;  // ARPHRD_ETHER
+            std::memcpy(&frame.protocol, rec->data + 12, sizeof(frame.protocol));
+            static const uint8_t BROADCAST[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+            frame.pkttype = std::memcmp(rec->data, BROADCAST, 6) == 0 ? PACKET_BROADCAST
+                          : (rec->data[0] & 1) ? PACKET_MULTICAST : PACKET_HOST;
+            fn(static_cast<const PacketFrame&>(frame), rec->count);
+            ++processed;
+        }
+        cons += (size + BPF_RINGBUF_HDR_SZ + 7) & ~uint64_t{7};
+    }
+
+    batchDone();
+    __atomic_store_n(m_consumerPos, cons, __ATOMIC_RELEASE);
+    return processed;
+}
+
+} // namespace capture
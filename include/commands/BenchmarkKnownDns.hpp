@@ -0,0 +1,52 @@
+/**
+ * @file BenchmarkKnownDns.hpp
+ * @brief Defines the BenchmarkKnownDns command for SpoofEye.
+ * 
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "commands/Init.hpp"
+#include "Config.hpp"
+
+#include <string>
+
+namespace commands {
+
+/**
+ * @class BenchmarkKnownDns
+ * @brief Command to time known DNS lookups against the configured list.
+ * 
+ * Compares the string set the DNS monitor used to keep with the packed
+ * arrays of monitors::KnownDnsDb (std::binary_search and the branchless
+ * search it uses), on a mix of listed and random addresses.
+ */
+class BenchmarkKnownDns : public Command {
+public:
+    /**
+     * @brief Constructor.
+     */
+    explicit BenchmarkKnownDns();
+
+    /**
+     * @brief Executes the command.
+     * @param arg Optional argument (ignored).
+     * 
+     * Sets the internal flag indicating that the benchmark should run once
+     * the configuration (and thus the known DNS path) is known.
+     */
+    void execute(const std::string& arg = "") override;
+
+    /**
+     * @brief Run the benchmark and print the time per lookup of each strategy.
+     * @param cfg Configuration giving the known DNS JSON path.
+     * @return True on success.
+     */
+    static bool runBenchmark(const Config& cfg);
+
+    /// Flag indicating whether the benchmark should run
+    static bool benchmark_known_dns;
+};
+
+} // namespace commands
@@ -0,0 +1,51 @@
+/**
+ * @file CompileKnownDns.hpp
+ * @brief Defines the CompileKnownDns command for SpoofEye.
+ * 
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "commands/Init.hpp"
+#include "Config.hpp"
+
+#include <string>
+
+namespace commands {
+
+/**
+ * @class CompileKnownDns
+ * @brief Command to compile the known DNS JSON list into the binary database.
+ * 
+ * The database is memory-mapped by the DNS monitor at startup instead of
+ * parsing the JSON list (see monitors::KnownDnsDb).
+ */
+class CompileKnownDns : public Command {
+public:
+    /**
+     * @brief Constructor.
+     */
+    explicit CompileKnownDns();
+
+    /**
+     * @brief Executes the command.
+     * @param arg Optional argument (ignored).
+     * 
+     * Sets the internal flag indicating that the database should be compiled
+     * once the configuration (and thus both paths) is known.
+     */
+    void execute(const std::string& arg = "") override;
+
+    /**
+     * @brief Compile known_dns_path into known_dns_db_path.
+     * @param cfg Configuration giving both paths.
+     * @return True on success.
+     */
+    static bool compileDatabase(const Config& cfg);
+
+    /// Flag indicating whether the database should be compiled
+    static bool compile_known_dns;
+};
+
+} // namespace commands
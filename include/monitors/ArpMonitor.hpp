@@ -7,11 +7,18 @@
 
 #pragma once
 
+#include "monitors/Init.hpp"
+
 #include <atomic>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 
+namespace capture {
+class CaptureEngine;
+}
+
 namespace monitors {
 
 /**
@@ -19,6 +26,17 @@ namespace monitors {
  * @brief Monitors the ARP entry of the network gateway for MAC changes.
  * 
  * Provides blocking monitoring with callback support for MAC address changes.
+ * The bindings of all other IPv4 neighbours are tracked as well, and hosts
+ * whose MAC changes are reported through the notification callback. When the
+ * shared capture engine runs, ARP frames are also captured on the link so racing
+ * replies and gratuitous announcements are seen, not only the kernel's winner,
+ * and each source MAC is rate-checked for ARP storms and poisoning cadence.
+ * The capture workers only decode frames; they are queued, one lock-free
+ * queue per worker, and judged on the monitor thread with the kernel events.
+ * A reply matching no request is only reported after a short hold, since XDP
+ * records can overtake the request they answer.
+ * Changes are picked up from rtnetlink neighbour notifications as they happen;
+ * polling /proc/net/arp is only used as a fallback when netlink is unavailable.
  */
 class ArpMonitor {
 public:
@@ -34,14 +52,14 @@ public:
 
     /**
      * @brief Construct monitor using autodetected gateway IP.
-     * @param poll_interval_seconds Polling interval in seconds (default 5).
+     * @param poll_interval_seconds Fallback polling interval in seconds (default 5).
      */
     explicit ArpMonitor(int poll_interval_seconds = 5);
 
     /**
      * @brief Construct monitor for a specific gateway IP.
      * @param gateway_ip Gateway IP address to monitor.
-     * @param poll_interval_seconds Polling interval in seconds (default 5).
+     * @param poll_interval_seconds Fallback polling interval in seconds (default 5).
      */
     ArpMonitor(const std::string& gateway_ip, int poll_interval_seconds = 5);
 
@@ -61,6 +79,24 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Set the callback for alerts about hosts other than the gateway.
+     * @param cb Callback invoked with a title and a message body.
+     */
+    void setNotificationCallback(NotificationCallback cb);
+
+    /**
+     * @brief Receive ARP frames from the shared capture engine.
+     * @param engine Engine to subscribe to; call before the engine starts.
+     */
+    void attachCapture(capture::CaptureEngine& engine);
+
+    /**
+     * @brief Set the memory ceiling of the per-MAC ARP rate table.
+     * @param bytes Budget in bytes; call before start().
+     */
+    void setRateTableMemory(std::size_t bytes);
+
     /**
      * @brief Get the detected gateway IP.
      * @return Gateway IP or empty string if not found.
@@ -0,0 +1,119 @@
+/**
+ * @file ArpRateTracker.hpp
+ * @brief Per-source-MAC token buckets for ARP storm and poisoning cadence detection.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class ArpRateTracker
+ * @brief Estimates how fast each source MAC emits ARP traffic.
+ *
+ * Every MAC owns two token buckets: one for all ARP frames (storms) and one
+ * for binding claims nobody asked for, i.e. gratuitous announcements and
+ * unsolicited replies (the steady cadence of a poisoning tool). A bucket that
+ * runs dry means the source kept exceeding the rate for longer than the burst
+ * allows; it is reported once and re-armed when the bucket refills.
+ *
+ * The table never grows past a fixed memory budget. Idle sources are swept
+ * out at most once a second; when the table is still full, traffic from new
+ * MACs is charged to one shared bucket, so a MAC-randomising flood is still
+ * detected without exhausting memory.
+ */
+class ArpRateTracker {
+public:
+    /** Traffic class charged to a bucket. */
+    enum class Kind {
+        FRAME,  ///< Any ARP frame
+        CLAIM   ///< Gratuitous announcement or unsolicited reply
+    };
+
+    /** Outcome of recording one event. */
+    enum class Result {
+        NORMAL,     ///< Within the rate
+        EXCEEDED,   ///< Bucket just ran dry: report it
+        THROTTLED,  ///< Still over the rate, already reported
+        OVERFLOW    ///< Table full and the shared bucket of untracked sources just ran dry
+    };
+
+    /** Sustained rate and burst of one bucket. */
+    struct Limit {
+        uint32_t perMinute;  ///< Refill rate (events per minute)
+        uint32_t burst;      ///< Bucket size (events)
+    };
+
+    /** Default memory budget of the source table (bytes). */
+    static constexpr std::size_t DEFAULT_MEMORY_BYTES = 256u * 1024;
+
+    /** Default limit for all ARP frames: 10 per second, bursts of 100. */
+    static constexpr Limit DEFAULT_FRAME_LIMIT{600, 100};
+
+    /** Default limit for unsolicited claims: one every 10 seconds, bursts of 10. */
+    static constexpr Limit DEFAULT_CLAIM_LIMIT{6, 10};
+
+    /**
+     * @brief Construct an empty tracker.
+     * @param memoryBytes Memory budget of the source table.
+     * @param frameLimit Limit applied to Kind::FRAME.
+     * @param claimLimit Limit applied to Kind::CLAIM.
+     */
+    explicit ArpRateTracker(std::size_t memoryBytes = DEFAULT_MEMORY_BYTES,
+                            Limit frameLimit = DEFAULT_FRAME_LIMIT,
+                            Limit claimLimit = DEFAULT_CLAIM_LIMIT);
+
+    /**
+     * @brief Charge events to a source.
+     * @param mac Source MAC, see NetAddr::packMac.
+     * @param kind Bucket to charge.
+     * @param nowMs Capture time in milliseconds.
+     * @param count Identical events folded into this one (XDP pre-aggregation).
+     */
+    Result record(uint64_t mac, Kind kind, uint64_t nowMs, uint32_t count = 1);
+
+    /** @brief Number of tracked sources. */
+    std::size_t size() const noexcept { return m_sources.size(); }
+
+    /** @brief Maximum number of tracked sources allowed by the memory budget. */
+    std::size_t maxSources() const noexcept { return m_sources.maxSize(); }
+
+    /** @brief Limit applied to a traffic class. */
+    const Limit& limit(Kind kind) const noexcept {
+        return kind == Kind::FRAME ? m_frameLimit : m_claimLimit;
+    }
+
+private:
+    /** Buckets of one source, tokens counted in thousandths. */
+    struct Source {
+        uint64_t lastMs = 0;         ///< Time of the last refill
+        uint32_t frameTokens = 0;
+        uint32_t claimTokens = 0;
+        uint8_t reported = 0;        ///< Bit per Kind: dry bucket already reported
+        bool initialized = false;
+    };
+
+    /** @brief Credit the tokens earned since the last event. */
+    void refill(Source& source, uint64_t nowMs) const noexcept;
+
+    /** @brief True if both buckets of source are full at nowMs. */
+    bool idle(const Source& source, uint64_t nowMs) const noexcept;
+
+    /** @brief Take count tokens from a bucket (emptying it if short) and classify the result. */
+    Result take(Source& source, Kind kind, uint32_t count) noexcept;
+
+    FlatHashMap<uint64_t, Source> m_sources;
+    Source m_untracked;           ///< Shared by sources that did not fit in the table
+    Limit m_frameLimit;
+    Limit m_claimLimit;
+    uint64_t m_lastSweepMs{0};
+};
+
+} // namespace monitors
@@ -0,0 +1,102 @@
+/**
+ * @file ArpRequestTracker.hpp
+ * @brief Matches captured ARP replies against recently seen requests.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+#include "utils/TimingWheel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class ArpRequestTracker
+ * @brief Classifies ARP replies as solicited or unsolicited.
+ *
+ * Every who-has seen on the link opens a pending exchange keyed on
+ * (target IP, requester IP); a reply from the target to the requester closes
+ * it. Pending exchanges are expired by a hierarchical timing wheel, so the
+ * cost per packet is O(1) regardless of how many requests are in flight and
+ * nothing is allocated after construction.
+ *
+ * Time is driven by packet timestamps: the wheel only advances when a frame
+ * is processed, so an idle link costs nothing.
+ */
+class ArpRequestTracker {
+public:
+    /** Classification of a reply. */
+    enum class Verdict {
+        SOLICITED,    ///< Answers a pending request
+        UNSOLICITED,  ///< No matching request within the timeout
+        CONFLICTING,  ///< Answers a pending request already answered by another MAC
+        UNVERIFIED    ///< No match, but requests may have been missed (warm-up or table full)
+    };
+
+    /** Default number of requests tracked at once. */
+    static constexpr std::size_t DEFAULT_MAX_PENDING = 16384;
+
+    /** Default time a request stays open for replies (milliseconds). */
+    static constexpr uint32_t DEFAULT_TIMEOUT_MS = 2000;
+
+    /** Resolution of the expiry wheel (milliseconds). */
+    static constexpr uint32_t TICK_MS = 10;
+
+    /**
+     * @brief Construct an empty tracker.
+     * @param maxPending Upper bound on requests tracked at once.
+     * @param timeoutMs Time a request stays open for replies.
+     */
+    explicit ArpRequestTracker(std::size_t maxPending = DEFAULT_MAX_PENDING,
+                               uint32_t timeoutMs = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Record a who-has request.
+     * @param requesterIp Sender IP of the request, network byte order.
+     * @param targetIp Address being resolved, network byte order.
+     * @param nowMs Capture time in milliseconds.
+     */
+    void onRequest(uint32_t requesterIp, uint32_t targetIp, uint64_t nowMs);
+
+    /**
+     * @brief Classify an is-at reply.
+     * @param senderIp Address the reply claims, network byte order.
+     * @param senderMac MAC the reply claims.
+     * @param targetIp Address the reply is sent to, network byte order.
+     * @param nowMs Capture time in milliseconds.
+     * @param[out] firstMac MAC of the earlier answer when the result is CONFLICTING.
+     */
+    Verdict onReply(uint32_t senderIp, uint64_t senderMac, uint32_t targetIp, uint64_t nowMs,
+                    uint64_t* firstMac = nullptr);
+
+    /** @brief Number of requests waiting for (or within the window of) a reply. */
+    std::size_t pending() const noexcept { return m_pending.size(); }
+
+private:
+    /** One request, open until its timer fires. */
+    struct Exchange {
+        TimingWheel<uint64_t>::Handle timer = 0;
+        uint64_t answerMac = 0;  ///< MAC of the first reply, 0 while unanswered
+    };
+
+    /** @brief Key of the exchange between requester and target. */
+    static uint64_t key(uint32_t targetIp, uint32_t requesterIp) noexcept {
+        return (static_cast<uint64_t>(targetIp) << 32) | requesterIp;
+    }
+
+    /** @brief Advance the wheel to nowMs and close expired exchanges. */
+    void advance(uint64_t nowMs);
+
+    FlatHashMap<uint64_t, Exchange> m_pending;
+    TimingWheel<uint64_t> m_timers;
+    uint64_t m_timeoutTicks;
+    uint64_t m_blindUntil{0};  ///< Tick before which unmatched replies are UNVERIFIED
+    bool m_started{false};
+};
+
+} // namespace monitors
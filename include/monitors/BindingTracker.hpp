@@ -0,0 +1,165 @@
+/**
+ * @file BindingTracker.hpp
+ * @brief IP -> MAC binding table for every neighbour on the LAN (ARP and NDP).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @struct NeighborBinding
+ * @brief Last known hardware address of a neighbour (16 bytes).
+ */
+struct NeighborBinding {
+    uint64_t mac : 48;       ///< 48-bit MAC, see NetAddr::packMac
+    uint64_t confirmed : 1;  ///< The kernel's neighbour table held this address
+    uint32_t firstSeen = 0;  ///< Unix time the current MAC was first observed
+    uint32_t lastSeen = 0;   ///< Unix time the current MAC was last confirmed
+
+    NeighborBinding() : mac(0), confirmed(0) {}
+};
+
+/**
+ * @class BindingTracker
+ * @brief Tracks IP -> MAC bindings of all neighbours and reports rebindings.
+ *
+ * Bindings are stored inline in an open-addressing table keyed on the packed
+ * address, so a /16 worth of neighbours costs a few megabytes and no
+ * per-entry allocation. Bindings outlive kernel neighbour entries: a host whose
+ * entry expired and later comes back with another MAC is still reported.
+ *
+ * Addresses only ever seen in captured frames cost an attacker nothing to
+ * invent, so they get a budget of their own (a quarter of the table by
+ * default) and are the only ones evicted early: once the budget is spent,
+ * a sweep (at most one per SWEEP_INTERVAL_SECONDS) forgets the least
+ * recently seen half of them. Bindings the kernel confirmed are only ever
+ * forgotten after the retention period.
+ *
+ * A reverse index counts the IPs claimed by each MAC. It is updated in O(1)
+ * on every observation, which makes the classic MITM fan-in (the gateway's
+ * MAC also answering for other hosts) cheap to check even during ARP storms.
+ *
+ * @tparam Address Packed address: IPv4 in network byte order or Ipv6Addr.
+ */
+template <typename Address>
+class BindingTracker {
+public:
+    /** Outcome of an observation. */
+    enum class Update {
+        NEW,        ///< First binding seen for this IP
+        REFRESHED,  ///< Same MAC as before
+        REBOUND,    ///< IP now maps to a different MAC
+        DROPPED     ///< Table full, observation ignored
+    };
+
+    /** Where an observation comes from. */
+    enum class Origin {
+        KERNEL,  ///< Kernel neighbour table: confirms the address
+        WIRE     ///< Captured frame only
+    };
+
+    /** Default number of tracked neighbours before old bindings are evicted. */
+    static constexpr std::size_t DEFAULT_MAX_BINDINGS = 1u << 18;
+
+    /** Bindings not confirmed for this long are forgotten (seconds). */
+    static constexpr uint32_t DEFAULT_RETENTION_SECONDS = 3600;
+
+    /** Minimum delay between two sweeps forced by a full table or budget (seconds). */
+    static constexpr uint32_t SWEEP_INTERVAL_SECONDS = 5;
+
+    /**
+     * @brief Construct an empty tracker.
+     * @param maxBindings Upper bound on tracked neighbours.
+     * @param retentionSeconds Age after which unconfirmed bindings may be evicted.
+     * @param maxWireOnly Upper bound on bindings only seen on the wire, 0 for a quarter of maxBindings.
+     */
+    explicit BindingTracker(std::size_t maxBindings = DEFAULT_MAX_BINDINGS,
+                            uint32_t retentionSeconds = DEFAULT_RETENTION_SECONDS,
+                            std::size_t maxWireOnly = 0);
+
+    /**
+     * @brief Record that ip currently resolves to mac.
+     * @param ip Neighbour address.
+     * @param mac 48-bit MAC.
+     * @param now Current Unix time.
+     * @param origin Kernel table or captured frame.
+     * @param[out] previousMac Old MAC when the result is REBOUND.
+     */
+    Update observe(const Address& ip, uint64_t mac, uint32_t now, Origin origin,
+                   uint64_t* previousMac = nullptr);
+
+    /**
+     * @brief Look up the binding of an IP.
+     * @return Binding or nullptr if unknown. Invalidated by the next observe().
+     */
+    const NeighborBinding* find(const Address& ip) const noexcept;
+
+    /**
+     * @brief Number of IPs currently bound to a MAC.
+     */
+    uint32_t claimCount(uint64_t mac) const noexcept;
+
+    /**
+     * @brief Check whether the gateway's MAC also claims other IPs.
+     *
+     * Call after observing a binding to mac. Reports each offending MAC once,
+     * until it no longer claims the gateway plus another IP.
+     *
+     * @param gatewayIp Gateway address.
+     * @param mac MAC that just gained an IP.
+     * @return True the first time mac is seen claiming the gateway and another IP.
+     */
+    bool checkGatewayFanIn(const Address& gatewayIp, uint64_t mac) noexcept;
+
+    /**
+     * @brief Forget bindings not confirmed within the retention period.
+     * @return Number of evicted bindings.
+     */
+    std::size_t expire(uint32_t now);
+
+    /** @brief Number of tracked neighbours. */
+    std::size_t size() const noexcept { return m_table.size(); }
+
+    /** @brief Number of tracked neighbours the kernel never confirmed. */
+    std::size_t wireOnlyCount() const noexcept { return m_wireOnly; }
+
+private:
+    /** Reverse index entry: how many IPs a MAC currently answers for. */
+    struct MacClaims {
+        uint32_t ipCount = 0;
+        bool fanInReported = false;
+    };
+
+    void claim(uint64_t mac);
+    void release(uint64_t mac) noexcept;
+
+    /** @brief Expire stale bindings, then the older half of the wire-only ones if still short of room. */
+    void makeRoom(uint32_t now);
+
+    FlatHashMap<Address, NeighborBinding> m_table;
+    FlatHashMap<uint64_t, MacClaims> m_claims;
+    uint32_t m_retentionSeconds;
+    std::size_t m_maxWireOnly;
+    std::size_t m_wireOnly{0};
+    uint32_t m_nextSweep{0};  ///< Earliest time of the next forced sweep
+};
+
+/** IPv4 neighbours, keyed on the network-order address. */
+using ArpBindingTracker = BindingTracker<uint32_t>;
+
+/** IPv6 neighbours, keyed on the packed 128-bit address. */
+using NdpBindingTracker = BindingTracker<Ipv6Addr>;
+
+extern template class BindingTracker<uint32_t>;
+extern template class BindingTracker<Ipv6Addr>;
+
+} // namespace monitors
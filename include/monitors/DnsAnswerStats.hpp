@@ -0,0 +1,125 @@
+/**
+ * @file DnsAnswerStats.hpp
+ * @brief Per-name history of DNS answers, flagging sudden changes of network or TTL.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/CountMinSketch.hpp"
+#include "utils/LruMap.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class DnsAnswerStats
+ * @brief Learns the networks and TTLs each name usually resolves to.
+ *
+ * A name is only given an entry once a count-min sketch has seen it
+ * resolved a few times recently; the long tail of names resolved once
+ * never displaces the recurring ones, whose entries live in a bounded LRU
+ * table. Memory is therefore fixed (about 60 bytes per entry plus 16 KiB
+ * of sketch) whatever the number of distinct names.
+ *
+ * An entry keeps the /24 (IPv4) or /48 (IPv6) networks of its answers and
+ * the highest TTL seen. Once learned, an answer is flagged when none of its
+ * addresses falls in a known network, or when its TTL is far above the
+ * usual one: poisoned records are planted with long TTLs to outlive the
+ * attack. Names that keep moving between networks (CDNs, round-robin over
+ * many ranges) stop being judged on networks after a couple of moves.
+ */
+class DnsAnswerStats {
+public:
+    /** Outcome of one answer. */
+    enum class Anomaly {
+        NONE,
+        NEW_NETWORK,  ///< No address in the networks the name usually resolves to
+        LONG_TTL      ///< TTL far above the highest seen for the name
+    };
+
+    /** Default number of names tracked at once. */
+    static constexpr std::size_t DEFAULT_MAX_NAMES = 4096;
+
+    /** Recent resolutions (per the sketch) before a name gets an entry. */
+    static constexpr uint8_t ADMIT_COUNT = 3;
+
+    /** Answers recorded before an entry is judged. */
+    static constexpr uint16_t LEARN_ANSWERS = 4;
+
+    /** Networks kept per name. */
+    static constexpr std::size_t MAX_NETWORKS = 4;
+
+    /** Networks learned after the learning phase that make a name volatile. */
+    static constexpr uint8_t VOLATILE_CHANGES = 2;
+
+    /** A TTL above this many times the usual one, and above MIN_FLAGGED_TTL, is flagged. */
+    static constexpr uint32_t TTL_FACTOR = 4;
+
+    /** Shortest TTL ever flagged (seconds). */
+    static constexpr uint32_t MIN_FLAGGED_TTL = 3600;
+
+    /** Minimum delay between two reports about the same name (seconds). */
+    static constexpr uint32_t ALERT_INTERVAL = 600;
+
+    /**
+     * @brief Construct an empty table.
+     * @param maxNames Upper bound on tracked names (least recently resolved are dropped).
+     */
+    explicit DnsAnswerStats(std::size_t maxNames = DEFAULT_MAX_NAMES);
+
+    /** @brief Network key of an address: its /24 (IPv4) or a hash of its /48 (IPv6). */
+    static uint32_t networkKey(const Ipv6Addr& addr) noexcept;
+
+    /**
+     * @brief Record an answer and judge it against the name's history.
+     * @param questionHash DnsPacket::questionHash of the response.
+     * @param networks networkKey() of each answered address.
+     * @param count Entries in networks.
+     * @param ttl Lowest TTL of the answered records.
+     * @param now Capture time in seconds.
+     * @param[out] usualTtl Highest TTL seen before this answer (set for LONG_TTL).
+     * @return Anomaly to report, NONE while learning or within ALERT_INTERVAL of the last report.
+     */
+    Anomaly observe(uint64_t questionHash, const uint32_t* networks, std::size_t count, uint32_t ttl, uint32_t now,
+                    uint32_t& usualTtl);
+
+    /** @brief Number of names with an entry. */
+    std::size_t size() const noexcept { return m_names.size(); }
+
+    /** @brief True if the name kept moving between networks (CDN), so no longer judged on them. */
+    bool isVolatile(uint64_t questionHash) const noexcept {
+        const NameStats* stats = m_names.find(questionHash);
+        return stats && stats->changes >= VOLATILE_CHANGES;
+    }
+
+private:
+    struct NameStats {
+        uint32_t networks[MAX_NETWORKS] = {};
+        uint8_t hits[MAX_NETWORKS] = {};  ///< Saturating; the least hit network is replaced first
+        uint8_t networkCount = 0;
+        uint8_t changes = 0;              ///< Networks learned after the learning phase
+        uint16_t answers = 0;
+        uint32_t maxTtl = 0;
+        uint32_t alertedAt = 0;
+        bool alerted = false;
+    };
+
+    /** @brief Merge an answer's networks into the entry. */
+    void learn(NameStats& stats, const uint32_t* networks, std::size_t count) noexcept;
+
+    using Sketch = CountMinSketch<12>;
+
+    /** Sketch additions between two halvings. */
+    static constexpr uint32_t AGING_PERIOD = 8 * Sketch::WIDTH;
+
+    LruMap<uint64_t, NameStats> m_names;
+    Sketch m_sketch;
+    uint32_t m_additions{0};
+};
+
+} // namespace monitors
@@ -0,0 +1,80 @@
+/**
+ * @file DnsBurstDetector.hpp
+ * @brief Flags floods of guessed DNS responses aimed at one query (Kaminsky-style poisoning).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/LruMap.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class DnsBurstDetector
+ * @brief Counts, per (resolver, question), responses that match no pending query.
+ *
+ * A blind poisoning attempt races the real answer with as many responses
+ * as it can send, each guessing a transaction ID (and, against randomized
+ * ports, a port). One legitimate response rarely misses its query; dozens
+ * for the same question within seconds do not happen by accident.
+ *
+ * Counters live in a bounded LRU table and restart once their window has
+ * elapsed, so memory is fixed (about 40 bytes per question) and a response
+ * costs O(1) with no allocation. A flood spread over random names, as
+ * Kaminsky's attack sends, only recycles the stalest counters; each of its
+ * queries is still judged on its own count.
+ */
+class DnsBurstDetector {
+public:
+    /** Default guessed responses for one question that make an attack. */
+    static constexpr uint32_t DEFAULT_THRESHOLD = 32;
+
+    /** Default window length, the time a query stays open (milliseconds). */
+    static constexpr uint32_t DEFAULT_WINDOW_MS = 10000;
+
+    /** Default number of questions tracked at once. */
+    static constexpr std::size_t DEFAULT_MAX_QUESTIONS = 4096;
+
+    /**
+     * @brief Construct an empty detector.
+     * @param threshold Guessed responses within the window that trigger a report.
+     * @param windowMs Window length.
+     * @param maxQuestions Upper bound on tracked questions (least recently hit are dropped).
+     */
+    explicit DnsBurstDetector(uint32_t threshold = DEFAULT_THRESHOLD, uint32_t windowMs = DEFAULT_WINDOW_MS,
+                              std::size_t maxQuestions = DEFAULT_MAX_QUESTIONS);
+
+    /**
+     * @brief Record a response that matched no pending query.
+     * @param resolver Source of the response.
+     * @param questionHash DnsPacket::questionHash of the response.
+     * @param nowMs Capture time in milliseconds.
+     * @param[out] count Guessed responses for this question in the current window.
+     * @return True when count reaches the threshold, once per window.
+     */
+    bool observe(const Ipv6Addr& resolver, uint64_t questionHash, uint64_t nowMs, uint32_t& count);
+
+    /** @brief Guessed responses that trigger a report. */
+    uint32_t threshold() const noexcept { return m_threshold; }
+
+    /** @brief Window length in milliseconds. */
+    uint32_t windowMs() const noexcept { return m_window; }
+
+private:
+    struct Counter {
+        uint64_t windowStart = 0;
+        uint32_t count = 0;
+    };
+
+    LruMap<uint64_t, Counter> m_questions;
+    uint32_t m_threshold;
+    uint32_t m_window;
+};
+
+} // namespace monitors
@@ -0,0 +1,178 @@
+/**
+ * @file DnsConsistencyChecker.hpp
+ * @brief Re-queries sampled names through trusted resolvers and reports diverging answers.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "monitors/DnsQueryEngine.hpp"
+#include "monitors/Init.hpp"
+#include "utils/LruMap.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/WakeupFd.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace capture {
+struct DnsPacket;
+}
+
+namespace monitors {
+
+/**
+ * @class DnsConsistencyChecker
+ * @brief Catches a configured resolver that lies, by asking trusted resolvers the same question.
+ *
+ * The capture path offers the answers the configured resolvers give this
+ * host. A few are kept: A/AAAA answers with public addresses only (private
+ * ones are split-horizon or ad-blocking, which trusted resolvers cannot
+ * confirm), each name at most once per recheck interval, and never more than
+ * the backlog holds. A worker thread re-asks every trusted resolver through
+ * a DnsQueryEngine and reports the answer when it shares no network (/24
+ * for IPv4, /48 for IPv6) with any trusted answer, or when every trusted
+ * resolver says the name does not exist. Comparing networks rather than
+ * addresses keeps CDNs, which answer each resolver differently, quiet.
+ *
+ * CDNs spread over several networks need more: a divergence only counts
+ * when the trusted resolvers agree among themselves, and it is only
+ * reported when the next sample of the name, accepted CONFIRM_DELAY later
+ * instead of RECHECK_INTERVAL, diverges again. Anything short of that is
+ * logged, not notified. The DNS monitor does not offer names its answer
+ * statistics found volatile.
+ *
+ * The engine bounds both the queries in flight and their rate, so the
+ * checker never turns captured traffic into a query flood.
+ */
+class DnsConsistencyChecker {
+public:
+    /** Upper bound on trusted resolvers. */
+    static constexpr std::size_t MAX_TRUSTED = 4;
+
+    /** Samples waiting for a check. */
+    static constexpr std::size_t BACKLOG = 32;
+
+    /** Minimum delay before the same name is checked again (seconds). */
+    static constexpr uint32_t RECHECK_INTERVAL = 600;
+
+    /** Names remembered as recently checked. */
+    static constexpr std::size_t MAX_RECENT = 1024;
+
+    /** Delay before a diverging name may be sampled again to confirm it (seconds). */
+    static constexpr uint32_t CONFIRM_DELAY = 30;
+
+    DnsConsistencyChecker() = default;
+    ~DnsConsistencyChecker();
+
+    // Non-copyable
+    DnsConsistencyChecker(const DnsConsistencyChecker&) = delete;
+    DnsConsistencyChecker& operator=(const DnsConsistencyChecker&) = delete;
+
+    /**
+     * @brief Set the resolvers answers are compared with. Call before start().
+     * @param entries "address", "IPv4:port" or "[IPv6]:port".
+     * @param[out] error First entry that could not be parsed.
+     * @return True if every entry was valid.
+     */
+    bool setTrustedResolvers(const std::vector<std::string>& entries, std::string& error);
+
+    /**
+     * @brief Bound the re-queries. Call before start().
+     * @param maxInFlight Queries outstanding at once.
+     * @param queriesPerSecond Sustained query rate.
+     */
+    void setLimits(std::size_t maxInFlight, uint32_t queriesPerSecond);
+
+    /** @brief Set the callback receiving divergence reports. */
+    void setNotificationCallback(NotificationCallback cb);
+
+    /** @brief True if trusted resolvers are set. */
+    bool enabled() const noexcept { return !m_trusted.empty(); }
+
+    /**
+     * @brief Open the query engine and start the worker thread.
+     * @param[out] error Reason of failure.
+     * @return True on success.
+     */
+    bool start(std::string& error);
+
+    /** @brief Stop the worker and close the engine. */
+    void stop();
+
+    /**
+     * @brief Offer a response a configured resolver sent this host (capture thread).
+     * @param dns Response, matched to a query of this host.
+     * @param now Capture time in seconds.
+     */
+    void offer(const capture::DnsPacket& dns, uint32_t now);
+
+private:
+    /** An answer to re-check. */
+    struct Sample {
+        std::string name;   ///< Dotted form, for reports
+        uint64_t questionHash = 0;
+        std::array<uint8_t, 255> qname{};
+        uint16_t qnameLen = 0;
+        uint16_t qtype = 0;
+        Ipv6Addr resolver;
+        uint8_t addressCount = 0;
+        std::array<Ipv6Addr, DnsQueryEngine::MAX_ADDRESSES> addresses{};
+    };
+
+    /** A sample being re-queried. */
+    struct Check {
+        Sample sample;
+        bool active = false;
+        uint8_t submitted = 0;    ///< Trusted resolvers asked (or skipped) so far
+        uint8_t outstanding = 0;  ///< Queries in flight
+        uint8_t replies = 0;      ///< Trusted resolvers that answered
+        uint8_t nxdomain = 0;     ///< Trusted resolvers that answered NXDOMAIN
+        uint8_t trustedCount = 0;
+        std::array<Ipv6Addr, MAX_TRUSTED * DnsQueryEngine::MAX_ADDRESSES> trusted{};
+        std::array<uint8_t, MAX_TRUSTED + 1> replyEnds{};  ///< trusted[replyEnds[r]..replyEnds[r + 1]) came from reply r
+        uint8_t addressReplies = 0;                         ///< Replies with at least one address
+    };
+
+    /** @brief Submit queries, collect replies and judge completed checks until stop(). */
+    void loop();
+
+    /** @brief Submit as many pending queries as the engine allows; true if work is left. */
+    bool submitPending();
+
+    /** @brief Compare a completed check's answers and report a confirmed divergence. */
+    void judge(const Check& check);
+
+    /** @brief True if every trusted reply shares a network with every other one. */
+    static bool trustedAgree(const Check& check) noexcept;
+
+    std::vector<DnsQueryEngine::Server> m_trusted;
+    std::size_t m_maxInFlight{DnsQueryEngine::DEFAULT_MAX_IN_FLIGHT};
+    uint32_t m_rate{DnsQueryEngine::DEFAULT_QUERIES_PER_SECOND};
+    NotificationCallback m_notify;
+
+    std::mutex m_mutex;  ///< Guards the backlog and the recent names
+    std::array<Sample, BACKLOG> m_backlog;
+    std::size_t m_backlogHead{0};
+    std::size_t m_backlogSize{0};
+    LruMap<uint64_t, uint32_t> m_recent{MAX_RECENT};  ///< Question hash -> time offered
+
+    // Worker thread only
+    std::unique_ptr<DnsQueryEngine> m_engine;
+    std::vector<Check> m_checks;
+    LruMap<uint64_t, uint32_t> m_suspects{MAX_RECENT};  ///< Question hash -> time of an unconfirmed divergence
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    WakeupFd m_wakeup;  ///< Signalled by offer() and stop()
+};
+
+} // namespace monitors
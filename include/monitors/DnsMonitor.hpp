@@ -7,32 +7,69 @@
 
 #pragma once
 
+#include "capture/DnsPacket.hpp"
+#include "monitors/Init.hpp"
+#include "monitors/DnsAnswerStats.hpp"
+#include "monitors/DnsBurstDetector.hpp"
+#include "monitors/DnsConsistencyChecker.hpp"
+#include "monitors/DnsTransactionTracker.hpp"
+#include "monitors/KnownDnsDb.hpp"
+#include "utils/LruMap.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/SpscQueue.hpp"
+#include "utils/WakeupFd.hpp"
+
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <set>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
+namespace capture {
+class CaptureEngine;
+struct PacketView;
+}
+
 namespace monitors {
 
 /**
- * @brief Default polling interval in seconds.
+ * @brief Default polling interval in seconds, used when inotify is unavailable.
  */
 inline constexpr std::chrono::seconds DEFAULT_POLL_INTERVAL{5};
 
-/**
- * @brief Callback type for DNS change notifications.
- * @param title Notification title.
- * @param body Notification message body.
- */
-using NotificationCallback = std::function<void(const std::string& title, const std::string& body)>;
-
 /**
  * @class DnsMonitor
  * @brief Monitors system DNS servers and notifies when unknown DNS servers appear.
+ *
+ * On Linux the resolver configuration is only re-read when inotify reports
+ * a change to /etc/resolv.conf, the file it links to, or the runtime files
+ * written by systemd-resolved and NetworkManager: a resolver pushed by DHCP
+ * is reported as soon as it is written, and the monitor sleeps otherwise.
+ * Without inotify it falls back to polling every poll interval.
+ *
+ * Once attached to the capture engine it also watches DNS traffic: every
+ * query this host sends opens a transaction (DnsTransactionTracker), and
+ * responses are checked against it. Forged responses racing the real one,
+ * answers to another question, guessed transaction IDs and answers from a
+ * resolver that is neither configured nor queried are reported, as are
+ * floods of guessed responses for one question (DnsBurstDetector),
+ * aggregated per resolver.
+ * Answers to this host's queries also feed per-name statistics
+ * (DnsAnswerStats) that report a name suddenly resolving outside its usual
+ * networks or with an unusually long TTL. All of this state is kept per
+ * capture worker without locks: queries are steered by the resolver they go
+ * to and responses by the resolver they come from, so a resolver's queries
+ * and every response claiming to be from it, forged or not, meet on the
+ * same worker. Alerts are queued to the monitor thread, which notifies at
+ * most MAX_ALERTS_PER_SECOND and summarizes the rest, so a slow
+ * notification never stalls a capture worker. Optionally, answers of the configured resolvers are sampled
+ * and compared with those of trusted resolvers (DnsConsistencyChecker).
  */
 class DnsMonitor {
 public:
@@ -46,6 +83,22 @@ public:
     DnsMonitor(const DnsMonitor&) = delete;
     DnsMonitor& operator=(const DnsMonitor&) = delete;
 
+    /**
+     * Subscribe to DNS queries and responses to detect spoofed answers.
+     * Call before the engine starts.
+     */
+    void attachCapture(capture::CaptureEngine& engine);
+
+    /**
+     * @brief Re-check sampled answers of the configured resolvers against
+     *        trusted ones (see DnsConsistencyChecker). Call before start().
+     * @param trustedResolvers "address", "IPv4:port" or "[IPv6]:port"; empty disables the check.
+     * @param maxInFlight Re-queries outstanding at once.
+     * @param queriesPerSecond Sustained re-query rate.
+     */
+    void setConsistencyCheck(const std::vector<std::string>& trustedResolvers, std::size_t maxInFlight,
+                             uint32_t queriesPerSecond);
+
     // -------------------- Control --------------------
     void start();
     void stop();
@@ -62,6 +115,13 @@ public:
      */
     void setKnownDnsPath(const std::string& path);
 
+    /**
+     * @brief Set the compiled known DNS database, preferred over the JSON file
+     *        when it is at least as recent. Call before setKnownDnsPath().
+     * @param path Database written by --compile-known-dns.
+     */
+    void setKnownDnsDbPath(const std::string& path);
+
     /**
      * @brief Get the current known DNS JSON path.
      * @return Path to known DNS file.
@@ -92,11 +152,48 @@ public:
 private:
     // -------------------- Internal Worker --------------------
     void workerLoop();
+    bool watchLoop();
+    void pollLoop();
+    void checkGuarded();
     void checkOnce();
     std::vector<std::string> getSystemDnsServers() const;
     void notify(const std::string& title, const std::string& body);
     bool loadKnownDnsFromFile(const std::string& path);
 
+    /** Notify the alerts every capture worker queued (monitor thread) */
+    void drainAlerts();
+
+    /** Notify a captured-traffic alert within the per-second budget, or count it */
+    void raiseAlert(const char* title, const std::string& body, uint32_t now);
+
+    /** Count alerts past the budget or lost to a full queue; the first of a flood raises one summary */
+    void withholdAlerts(uint64_t count, uint32_t now);
+
+    /** Match a batch of captured queries and responses (engine thread) */
+    void handleDns(const capture::PacketView* views, std::size_t count);
+
+    /** Questions of one resolver that drew a burst of guessed responses since its last alert */
+    struct BurstReport {
+        uint32_t lastAlert = 0;
+        uint32_t questions = 0;
+        uint32_t responses = 0;
+    };
+
+    /**
+     * Count a response that matched no pending query. Questions crossing the
+     * burst threshold are aggregated per resolver, which is reported at most
+     * once per RESPONSE_ALERT_INTERVAL with the number of questions hit
+     */
+    void checkBurst(DnsBurstDetector& bursts, LruMap<Ipv6Addr, BurstReport>& reports, const capture::DnsPacket& dns,
+                    uint64_t nowMs, std::vector<std::pair<const char*, std::string>>& alerts);
+
+    /** Judge a matched answer against the name's history and queue an alert if it deviates */
+    void checkAnswer(DnsAnswerStats& stats, const capture::DnsPacket& dns, uint32_t now,
+                     std::vector<std::pair<const char*, std::string>>& alerts);
+
+    /** True if a suspicious response from resolver may be reported now */
+    bool takeResponseAlert(LruMap<Ipv6Addr, uint32_t>& alerts, const Ipv6Addr& resolver, uint32_t now);
+
     // -------------------- Members --------------------
     std::chrono::seconds m_pollInterval;
     std::atomic<bool> m_running{false};
@@ -104,13 +201,68 @@ private:
     NotificationCallback m_notifyCb;
 
     mutable std::recursive_mutex m_mutex;
-    std::set<std::string> m_knownDns;           ///< Known DNS servers
+    KnownDnsDb m_knownDns;                      ///< Known DNS servers
     std::vector<std::string> m_lastObservedDns; ///< Last observed DNS snapshot
-    std::set<std::string> m_lastUnknownDns;     ///< Last detected unknown DNS
+    std::vector<std::string> m_lastUnknownDns;  ///< Last detected unknown DNS (sorted)
 
     std::thread m_thread;
+    WakeupFd m_wakeup;          ///< Signalled by stop() to interrupt poll()
     std::string m_knownDnsPath; ///< Path to known DNS JSON
+    std::string m_knownDbPath;  ///< Path to the compiled known DNS database
     bool stopped_ = false;
+
+    /** Minimum delay between two alerts about the same resolver (seconds) */
+    static constexpr uint32_t RESPONSE_ALERT_INTERVAL = 60;
+
+    /** Resolvers remembered as queried, and as recently reported */
+    static constexpr std::size_t MAX_RESOLVERS = 256;
+
+    /** Alerts a capture worker may queue ahead of the monitor thread */
+    static constexpr std::size_t ALERT_QUEUE_SIZE = 256;
+
+    /** Upper bound on captured-traffic notifications per second; the rest is summarized */
+    static constexpr uint32_t MAX_ALERTS_PER_SECOND = 5;
+
+    /** Alert raised on a capture worker, notified by the monitor thread */
+    struct QueuedAlert {
+        const char* title = nullptr;
+        std::string body;
+    };
+
+    WakeupFd m_alertsReady;                  ///< Signalled by a worker after queuing alerts
+    std::atomic<uint64_t> m_alertDrops{0};   ///< Alerts lost to a full queue
+    uint32_t m_alertSecond = 0;              ///< Second the alerts below were counted in (monitor thread)
+    uint32_t m_alertsInSecond = 0;
+    uint64_t m_suppressedAlerts = 0;         ///< Alerts withheld by the current flood
+    uint32_t m_suppressedAt = 0;             ///< Last time an alert was withheld
+
+    // Parsed m_lastObservedDns, published to the workers: each copies it
+    // when the generation moves, so the lock is only taken after a change
+    std::mutex m_resolversMutex;
+    std::vector<Ipv6Addr> m_configuredResolvers;
+    std::atomic<uint64_t> m_resolversGeneration{1};
+
+    DnsConsistencyChecker m_consistency;
+
+    /** Names and queries tracked across all workers, and per worker at least */
+    static constexpr std::size_t MAX_ANSWER_NAMES = 16384;
+    static constexpr std::size_t MIN_SHARD_NAMES = 1024;
+    static constexpr std::size_t MIN_SHARD_PENDING = 4096;
+
+    /** Per-worker captured traffic state, only touched by the worker owning the shard */
+    struct WorkerShard {
+        WorkerShard(std::size_t maxNames, std::size_t maxPending) : transactions(maxPending), stats(maxNames) {}
+        DnsTransactionTracker transactions;
+        std::vector<Ipv6Addr> configuredResolvers;                      ///< Copy of m_configuredResolvers
+        uint64_t resolversGeneration = 0;                               ///< Generation of that copy
+        LruMap<Ipv6Addr, uint32_t> queriedResolvers{MAX_RESOLVERS};     ///< Resolver -> last query time
+        LruMap<Ipv6Addr, uint32_t> responseAlerts{MAX_RESOLVERS};       ///< Resolver -> last alert time
+        DnsBurstDetector bursts;                                        ///< Guessed responses per question
+        LruMap<Ipv6Addr, BurstReport> burstReports{MAX_RESOLVERS};      ///< Resolver -> bursts since its last alert
+        DnsAnswerStats stats;
+        SpscQueue<QueuedAlert> alerts{ALERT_QUEUE_SIZE};                ///< To the monitor thread
+    };
+    std::vector<std::unique_ptr<WorkerShard>> m_shards;
 };
 
 } // namespace monitors
@@ -0,0 +1,159 @@
+/**
+ * @file DnsQueryEngine.hpp
+ * @brief Non-blocking DNS client multiplexing bounded queries over epoll.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/TimingWheel.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <vector>
+
+namespace monitors {
+
+/**
+ * @class DnsQueryEngine
+ * @brief Sends A/AAAA queries over UDP and collects the addresses answered.
+ *
+ * Every query gets its own non-blocking socket, connected to the server from
+ * a fresh ephemeral port, so an off-path spoofer must guess the port as well
+ * as the random transaction ID, and the kernel drops datagrams from any other
+ * source. The sockets of the queries in flight and an optional wakeup
+ * descriptor share a single epoll set. Queries sit in a table keyed by their
+ * socket and expire on a timing wheel; a reply is only accepted with the same
+ * ID and question, and the socket is closed as soon as the query completes.
+ *
+ * Load is bounded twice: at most maxInFlight queries (and sockets) are
+ * outstanding, and a token bucket caps the rate at queriesPerSecond (bursts
+ * of one second's worth). submit() refuses work beyond either limit instead
+ * of queuing it.
+ */
+class DnsQueryEngine {
+public:
+    /** Addresses kept per reply. */
+    static constexpr std::size_t MAX_ADDRESSES = 8;
+
+    /** Default queries outstanding at once. */
+    static constexpr std::size_t DEFAULT_MAX_IN_FLIGHT = 8;
+
+    /** Default sustained query rate. */
+    static constexpr uint32_t DEFAULT_QUERIES_PER_SECOND = 2;
+
+    /** Default time to wait for a reply (milliseconds). */
+    static constexpr uint32_t DEFAULT_TIMEOUT_MS = 3000;
+
+    /** A server to query; IPv4 as ::ffff:a.b.c.d. */
+    struct Server {
+        Ipv6Addr address;
+        uint16_t port = 53;
+    };
+
+    /** Outcome of one query. */
+    struct Reply {
+        uint64_t tag = 0;           ///< Tag passed to submit()
+        bool answered = false;      ///< False if the query timed out
+        bool truncated = false;     ///< TC bit: the answer did not fit in UDP
+        uint8_t rcode = 0;
+        uint8_t addressCount = 0;   ///< Addresses of the queried type, at most MAX_ADDRESSES
+        std::array<Ipv6Addr, MAX_ADDRESSES> addresses{};
+    };
+
+    /**
+     * @brief Construct a closed engine.
+     * @param maxInFlight Upper bound on outstanding queries.
+     * @param queriesPerSecond Sustained query rate.
+     * @param timeoutMs Time to wait for a reply.
+     */
+    explicit DnsQueryEngine(std::size_t maxInFlight = DEFAULT_MAX_IN_FLIGHT,
+                            uint32_t queriesPerSecond = DEFAULT_QUERIES_PER_SECOND,
+                            uint32_t timeoutMs = DEFAULT_TIMEOUT_MS);
+    ~DnsQueryEngine();
+
+    // Non-copyable
+    DnsQueryEngine(const DnsQueryEngine&) = delete;
+    DnsQueryEngine& operator=(const DnsQueryEngine&) = delete;
+
+    /**
+     * @brief Open the epoll set.
+     * @param wakeupFd Descriptor that interrupts poll() when readable (not drained), -1 for none.
+     * @param[out] error Reason of failure.
+     * @return True on success.
+     */
+    bool open(int wakeupFd, std::string& error);
+
+    /** @brief Close the epoll set and forget the queries in flight, closing their sockets. */
+    void close() noexcept;
+
+    /** @brief True if both limits currently allow one more query. */
+    bool ready();
+
+    /**
+     * @brief Send a query.
+     * @param server Server to ask.
+     * @param qname Encoded question name (uncompressed wire format).
+     * @param qnameLen Bytes at qname.
+     * @param qtype Queried type (A or AAAA).
+     * @param tag Returned with the reply.
+     * @return False if a limit is reached, no socket of the server's family could be opened or sending failed.
+     */
+    bool submit(const Server& server, const uint8_t* qname, uint32_t qnameLen, uint16_t qtype, uint64_t tag);
+
+    /**
+     * @brief Wait for replies and expire queries, at most until the next timeout.
+     * @param maxWaitMs Upper bound on the wait, -1 to wait until a query expires or the wakeup fires.
+     * @param[out] replies Appended with every reply received or query expired.
+     */
+    void poll(int maxWaitMs, std::vector<Reply>& replies);
+
+    /** @brief Number of outstanding queries. */
+    std::size_t inFlight() const noexcept { return m_pending.size(); }
+
+private:
+    /** One outstanding query, keyed by its socket. */
+    struct Pending {
+        uint64_t tag = 0;
+        uint64_t questionHash = 0;
+        uint16_t id = 0;
+        uint16_t qtype = 0;
+        TimingWheel<int>::Handle timer = 0;
+    };
+
+    /** @brief Current time on the steady clock (milliseconds). */
+    static uint64_t nowMs() noexcept;
+
+    /** @brief Credit the tokens earned since the last call. */
+    void refill(uint64_t now) noexcept;
+
+    /** @brief Read the datagrams waiting on a query's socket until one answers it. */
+    void receive(int fd, Pending& pending, std::vector<Reply>& replies);
+
+    /** @brief Decode a datagram into reply if it answers the query. */
+    static bool parseReply(const Pending& pending, const uint8_t* data, std::size_t len, Reply& reply);
+
+    /** @brief Close a query's socket and forget it; its timer must have fired or been cancelled. */
+    void release(int fd) noexcept;
+
+    int m_epoll{-1};
+
+    FlatHashMap<int, Pending> m_pending;       ///< Socket -> query
+    TimingWheel<int> m_timers;                 ///< Millisecond ticks, payload is the socket
+    std::vector<epoll_event> m_events;         ///< One per query in flight, plus the wakeup
+    std::size_t m_maxInFlight;
+    uint32_t m_rate;
+    uint32_t m_timeoutMs;
+    uint64_t m_tokens{0};                      ///< Thousandths of a query
+    uint64_t m_refilledAt{0};
+    std::mt19937 m_random;
+};
+
+} // namespace monitors
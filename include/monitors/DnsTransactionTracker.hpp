@@ -0,0 +1,139 @@
+/**
+ * @file DnsTransactionTracker.hpp
+ * @brief Matches captured DNS responses against the queries this host sent.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/TimingWheel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class DnsTransactionTracker
+ * @brief Classifies DNS responses as matching, forged or unsolicited.
+ *
+ * Every query sent opens a transaction keyed on (resolver, local port,
+ * TXID) that records the question asked; the first response records a
+ * digest of its answer. The transaction stays in the table until its timer
+ * fires, so a second, different answer racing the first one is still
+ * caught. A per-(resolver, port) count of open transactions tells a
+ * guessed TXID apart from a response to a query that was never sent.
+ *
+ * Transactions are expired by a hierarchical timing wheel: the cost per
+ * packet is O(1) whatever the number of queries in flight, and nothing is
+ * allocated after construction. Time is driven by packet timestamps.
+ */
+class DnsTransactionTracker {
+public:
+    /** Classification of a response. */
+    enum class Verdict {
+        MATCHED,            ///< First answer to an open query, or the same answer again
+        COMPETING,          ///< Answers an open query already answered differently
+        QUESTION_MISMATCH,  ///< Right resolver, port and TXID, but another question
+        TXID_MISMATCH,      ///< Queries are open from that port to that resolver, none with this TXID
+        UNSOLICITED,        ///< No query open from that port to that resolver
+        UNVERIFIED          ///< No match, but queries may have been missed (warm-up or table full)
+    };
+
+    /** Default number of queries tracked at once. */
+    static constexpr std::size_t DEFAULT_MAX_PENDING = 16384;
+
+    /** Default time a query stays open for responses (milliseconds). */
+    static constexpr uint32_t DEFAULT_TIMEOUT_MS = 10000;
+
+    /** Resolution of the expiry wheel (milliseconds). */
+    static constexpr uint32_t TICK_MS = 10;
+
+    /**
+     * @brief Construct an empty tracker.
+     * @param maxPending Upper bound on queries tracked at once.
+     * @param timeoutMs Time a query stays open for responses.
+     */
+    explicit DnsTransactionTracker(std::size_t maxPending = DEFAULT_MAX_PENDING,
+                                   uint32_t timeoutMs = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Record a query sent by this host.
+     * @param resolver Destination of the query.
+     * @param port Local (source) port.
+     * @param id Transaction ID.
+     * @param questionHash DnsPacket::questionHash of the query.
+     * @param nowMs Capture time in milliseconds.
+     */
+    void onQuery(const Ipv6Addr& resolver, uint16_t port, uint16_t id, uint64_t questionHash, uint64_t nowMs);
+
+    /**
+     * @brief Classify a response received by this host.
+     * @param resolver Source of the response.
+     * @param port Local (destination) port.
+     * @param id Transaction ID.
+     * @param questionHash DnsPacket::questionHash of the response.
+     * @param answerDigest dnsAnswerDigest() of the response.
+     * @param nowMs Capture time in milliseconds.
+     */
+    Verdict onResponse(const Ipv6Addr& resolver, uint16_t port, uint16_t id, uint64_t questionHash,
+                       uint64_t answerDigest, uint64_t nowMs);
+
+    /** @brief Number of queries waiting for (or within the window of) a response. */
+    std::size_t pending() const noexcept { return m_pending.size(); }
+
+private:
+    /** Resolver and local port of a transaction. */
+    struct Endpoint {
+        Ipv6Addr resolver;
+        uint32_t port = 0;
+
+        bool operator==(const Endpoint& o) const noexcept { return resolver == o.resolver && port == o.port; }
+    };
+
+    /** Endpoint and TXID: one transaction. */
+    struct Key {
+        Endpoint endpoint;
+        uint32_t id = 0;
+
+        bool operator==(const Key& o) const noexcept { return endpoint == o.endpoint && id == o.id; }
+    };
+
+    struct EndpointHash {
+        uint64_t operator()(const Endpoint& e) const noexcept {
+            return FlatHash<Ipv6Addr>{}(e.resolver) ^ hashMix64(e.port);
+        }
+    };
+
+    struct KeyHash {
+        uint64_t operator()(const Key& k) const noexcept {
+            return EndpointHash{}(k.endpoint) ^ hashMix64(static_cast<uint64_t>(k.id) << 32 | k.endpoint.port);
+        }
+    };
+
+    /** One query, open until its timer fires. */
+    struct Transaction {
+        TimingWheel<Key>::Handle timer = 0;
+        uint64_t questionHash = 0;
+        uint64_t answerDigest = 0;  ///< Digest of the first response
+        bool answered = false;
+    };
+
+    /** @brief Advance the wheel to nowMs and close expired transactions. */
+    void advance(uint64_t nowMs);
+
+    /** @brief Forget a transaction and release its endpoint count. */
+    void close(const Key& key);
+
+    FlatHashMap<Key, Transaction, KeyHash> m_pending;
+    FlatHashMap<Endpoint, uint32_t, EndpointHash> m_endpoints;  ///< Open transactions per endpoint
+    TimingWheel<Key> m_timers;
+    uint64_t m_timeoutTicks;
+    uint64_t m_blindUntil{0};  ///< Tick before which unmatched responses are UNVERIFIED
+    bool m_started{false};
+};
+
+} // namespace monitors
@@ -1,66 +1,173 @@
 /**
  * @file IcmpMonitor.hpp
- * @brief Monitors ICMP echo requests on the network and notifies via callback.
+ * @brief Monitors ICMP echo requests and redirects on the network and notifies via callback.
  * 
  * Part of the SpoofEye project, licensed under GPLv3.
  */
 
 #pragma once
 
+#include "monitors/Init.hpp"
+#include "monitors/OutboundFlowRing.hpp"
+#include "monitors/ScanDetector.hpp"
+#include "utils/LruMap.hpp"
+#include "utils/NetAddr.hpp"
+
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
-#include <pcap.h>
+#include <memory>
 #include <string>
-#include <thread>
+#include <vector>
+
+namespace capture {
+class CaptureEngine;
+struct PacketView;
+}
 
 namespace monitors {
 
 /**
  * @class IcmpMonitor
- * @brief Captures ICMP echo (ping) packets on all interfaces.
+ * @brief Watches ICMP and ICMPv6 echo (ping) packets and validates ICMP redirects on all interfaces.
+ *
+ * Frames come from the shared capture engine, whose kernel filter only
+ * passes echo requests and redirects, truncated to the headers (redirects
+ * keep the datagram they quote). Outbound TCP/UDP/ICMP packets
+ * are received as well (headers only), just to remember the
+ * flows this host recently sent. A redirect is expected only when it comes
+ * from the default gateway and quotes one of those flows; anything else is
+ * reported as a possible route hijack.
+ *
+ * Echo requests are throttled per source in a bounded LRU table, so a noisy
+ * pinger cannot hide the others, and each alert carries that source's
+ * counters.
+ *
+ * Inbound echo requests and TCP SYNs also feed per-source scan detectors,
+ * which report sources probing many distinct hosts (ping sweeps) or
+ * host/port pairs (SYN scans).
+ *
+ * All state is sharded by capture worker. The engine steers inbound packets
+ * by source, outbound ones by destination and redirects by the destination
+ * they quote, so a source's echo requests and probes, and a flow and the
+ * redirects about it, meet on a single worker whose shard no other thread
+ * touches.
  */
 class IcmpMonitor {
 public:
+    /** Echo request counters of one source */
+    struct PingStats {
+        uint64_t total = 0;        ///< Echo requests seen since the source was first tracked
+        uint64_t sinceAlert = 0;   ///< Echo requests since the previous alert (including this one)
+        uint32_t firstSeen = 0;    ///< Capture time of the first echo request (seconds)
+        uint32_t lastAlert = 0;    ///< Capture time of the previous alert (seconds)
+    };
+
     /** Callback type for ICMP echo notification */
-    using Callback = std::function<void(const std::string& srcIp)>;
+    using Callback = std::function<void(const std::string& srcIp, const PingStats& stats)>;
 
     /** Minimum interval between notifications for the same source */
     static constexpr std::chrono::seconds NOTIFY_INTERVAL{60};
 
-    /** Default constructor with 100ms poll interval */
-    IcmpMonitor();
+    /** Number of sources tracked for echo and redirect throttling */
+    static constexpr std::size_t MAX_SOURCES = 1024;
 
-    /** Constructor with custom poll interval */
-    explicit IcmpMonitor(std::chrono::milliseconds pollInterval);
+    IcmpMonitor();
 
     /** Destructor stops monitoring if running */
     ~IcmpMonitor();
 
-    /** Start monitoring in a background thread */
+    /**
+     * Subscribe to ICMP, outbound TCP/UDP and inbound SYNs, with one shard of
+     * per-source state per capture worker. Call before the engine starts.
+     */
+    void attachCapture(capture::CaptureEngine& engine);
+
+    /** Start processing captured packets */
     void start();
 
-    /** Stop monitoring and join thread */
+    /** Stop processing and log the echo summary; stop the capture engine first */
     void stop();
 
     /** Set callback to be called when an ICMP echo is detected */
     void setPingCallback(Callback cb);
 
+    /** Set callback to be called when a suspicious ICMP redirect is detected */
+    void setNotificationCallback(NotificationCallback cb);
+
+    /** Use this IPv4 gateway instead of detecting the default route */
+    void setGateway(const std::string& gatewayIp);
+
     /** Always returns true (monitor is always initialized) */
     bool isInitialized() const {
         return true;
     }
 
 private:
-    /** Background worker that captures ICMP packets */
-    void workerLoop();
+    /** Dispatch a captured ICMPv4 message (engine thread) */
+    void handleIcmp(const capture::PacketView& view);
+
+    /** Count a captured ICMPv6 echo request (engine thread) */
+    void handleIcmp6Echo(const capture::PacketView& view);
+
+    /** Remember the flows of a batch of outbound packets (engine thread) */
+    void recordOutbound(const capture::PacketView* views, std::size_t count);
+
+    /** Captured traffic state of one capture worker */
+    struct alignas(64) Shard {
+        explicit Shard(std::size_t maxSources);
+
+        LruMap<uint32_t, PingStats> pingSources;  ///< Echo source -> counters
+        LruMap<Ipv6Addr, PingStats> pingSources6; ///< ICMPv6 echo source -> counters
+        ScanDetector pingSweeps;                  ///< Distinct hosts pinged per source
+        ScanDetector pingSweeps6;                 ///< Distinct IPv6 hosts pinged per source
+        ScanDetector synScans;                    ///< Distinct host:port pairs probed with SYN per source
+        OutboundFlowRing flows;                   ///< Flows sent to the destinations steered here
+        LruMap<uint32_t, uint32_t> redirectAlerts; ///< Redirect source -> last alert time
+        uint32_t gateway = 0;                     ///< Detected default gateway, network order
+        uint32_t gatewayCheckedAt = 0;
+    };
+
+    /** Shard owned by the worker that captured the packet */
+    Shard& shardFor(const capture::PacketView& view);
+
+    /** Count echo requests (count > 1 for XDP-folded ones) and alert if their source is not throttled */
+    template <typename Addr>
+    void handleEcho(LruMap<Addr, PingStats>& sources, const Addr& source, uint32_t count, uint32_t now);
+
+    /** Take one of the echo alerts allowed this second, shared by all workers */
+    bool takeAlertSlot(uint32_t now);
+
+    /** Count a probe towards a scan detector and alert when the source crosses its threshold */
+    template <typename Addr>
+    void checkScan(ScanDetector& detector, const char* kind, const Addr& source, uint64_t destination, uint32_t now);
+
+    /** Log the busiest echo sources across shards when stopping */
+    void logPingSummary();
+
+    /** Validate a received redirect (IPv4 header, its ICMP message and captured length) */
+    void checkRedirect(Shard& shard, const uint8_t* ip, const uint8_t* icmp, std::size_t icmpLen, uint32_t now);
+
+    /** Current default gateway (network order, 0 if unknown), re-detected every GATEWAY_REFRESH */
+    uint32_t currentGateway(Shard& shard, uint32_t now);
+
+    /** Minimum interval between redirect alerts for the same source (seconds) */
+    static constexpr uint32_t REDIRECT_ALERT_INTERVAL = 60;
+
+    /** Upper bound on echo alerts per second across all sources */
+    static constexpr uint32_t MAX_ALERTS_PER_SECOND = 5;
+
+    /** Interval between default gateway lookups (seconds) */
+    static constexpr uint32_t GATEWAY_REFRESH = 30;
 
-    std::chrono::milliseconds m_pollInterval;
     std::atomic<bool> m_running{false};
-    std::thread m_thread;
     Callback m_callback{nullptr};
-    pcap_t* m_handle{nullptr};
-    std::chrono::steady_clock::time_point m_lastNotification{};
+    NotificationCallback m_notify{nullptr};
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<uint64_t> m_alertSlots{0}; ///< Current second << 32 | echo alerts sent in it
+
+    uint32_t m_pinnedGateway{0}; ///< Set by setGateway() before the capture starts, 0 to detect
 };
 
 } // namespace monitors
@@ -7,10 +7,18 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace monitors {
 
+/**
+ * @brief Callback type for monitor alert notifications.
+ * @param title Notification title.
+ * @param body Notification message body.
+ */
+using NotificationCallback = std::function<void(const std::string& title, const std::string& body)>;
+
 /**
  * @struct LogPrefixes
  * @brief Contains prefix strings used for logging different monitor types.
@@ -24,6 +32,9 @@ struct LogPrefixes {
 
     /** Prefix for ICMP monitor logs */
     static const std::string icmp_monitor;
+
+    /** Prefix for NDP monitor logs */
+    static const std::string ndp_monitor;
 };
 
 } // namespace monitors
@@ -0,0 +1,144 @@
+/**
+ * @file KnownDnsDb.hpp
+ * @brief Known DNS resolver set, loaded from JSON or from a compiled memory-mapped file.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/NetAddr.hpp"
+#include "utils/PrefixTrie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace monitors {
+
+/**
+ * @class KnownDnsDb
+ * @brief Trusted resolver addresses and address ranges.
+ *
+ * Addresses are stored as numbers, not strings: IPv4 as host-order uint32_t
+ * (so numeric order is address order) and IPv6 as Ipv6Addr, IPv4-mapped IPv6
+ * counting as IPv4. Each array is sorted, so a lookup is a binary search
+ * without allocation.
+ *
+ * Entries written as CIDR prefixes ("203.0.113.0/24", "2001:db8::/32") go to
+ * one PrefixTrie per family instead; an address is known if it is listed or
+ * covered by a listed prefix.
+ *
+ * The arrays are either built from the JSON list or mapped read-only from a
+ * compiled database written by compile(). The compiled file is exactly the
+ * in-memory layout, so opening it costs a checksum pass: no parsing, and the
+ * pages are shared by every process mapping it.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ *   Header (48 bytes), ipv4Count x uint32_t, ipv6Count x Ipv6Addr,
+ *   IPv4 trie jump table (2^trie4Stride x uint32_t) and trie4Nodes x Node,
+ *   IPv6 trie jump table and nodes.
+ */
+class KnownDnsDb {
+public:
+    /** Compiled file header. */
+    struct Header {
+        char magic[8];        ///< "SPEYEKDB"
+        uint32_t version;     ///< FORMAT_VERSION
+        uint32_t byteOrder;   ///< BYTE_ORDER_MARK as written by the compiling host
+        uint32_t ipv4Count;
+        uint32_t ipv6Count;
+        uint32_t trie4Nodes;  ///< 0 if no IPv4 prefix
+        uint32_t trie6Nodes;
+        uint8_t trie4Stride;
+        uint8_t trie6Stride;
+        uint8_t reserved[6];
+        uint64_t checksum;    ///< FNV-1a 64 of everything after the header
+    };
+
+    static constexpr uint32_t FORMAT_VERSION = 2;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    KnownDnsDb() = default;
+    ~KnownDnsDb();
+
+    KnownDnsDb(KnownDnsDb&& other) noexcept;
+    KnownDnsDb& operator=(KnownDnsDb&& other) noexcept;
+
+    // Non-copyable
+    KnownDnsDb(const KnownDnsDb&) = delete;
+    KnownDnsDb& operator=(const KnownDnsDb&) = delete;
+
+    /**
+     * @brief Build the set from a JSON array of address and CIDR prefix strings.
+     * @param path JSON file path.
+     * @param[out] error Reason of failure.
+     * @param[out] skipped Entries that are neither IP addresses nor prefixes.
+     * @return True if at least one entry was loaded.
+     */
+    bool loadJson(const std::string& path, std::string& error, std::size_t* skipped = nullptr);
+
+    /**
+     * @brief Map a compiled database.
+     * @param path File written by compile().
+     * @param[out] error Reason of failure (missing, truncated, corrupt, other byte order).
+     * @return True on success.
+     */
+    bool open(const std::string& path, std::string& error);
+
+    /**
+     * @brief Write the set to a compiled database, atomically (temporary file + rename).
+     * @param path Destination file.
+     * @param[out] error Reason of failure.
+     * @return True on success.
+     */
+    bool compile(const std::string& path, std::string& error) const;
+
+    /** @brief True if ip (textual IPv4 or IPv6, optional %scope) is listed or covered by a prefix. */
+    bool contains(const std::string& ip) const;
+
+    /** @brief True if the IPv4 address (network byte order, see NetAddr) is listed or covered. */
+    bool containsIpv4(uint32_t ip) const noexcept;
+
+    /** @brief True if the IPv6 address is listed or covered. */
+    bool containsIpv6(const Ipv6Addr& ip) const noexcept;
+
+    /** @brief Number of entries, addresses and prefixes. */
+    std::size_t size() const noexcept { return addressCount() + prefixCount(); }
+
+    /** @brief Number of individual addresses. */
+    std::size_t addressCount() const noexcept { return m_ipv4Count + m_ipv6Count; }
+
+    /** @brief Number of CIDR prefixes. */
+    std::size_t prefixCount() const noexcept { return m_prefixes4.size() + m_prefixes6.size(); }
+
+    /** @brief True if nothing is loaded. */
+    bool empty() const noexcept { return size() == 0; }
+
+    /** @brief True if the arrays live in a mapped compiled file. */
+    bool isMapped() const noexcept { return m_mapping != nullptr; }
+
+private:
+    /** @brief Release the mapping and the owned arrays. */
+    void reset() noexcept;
+
+    void swap(KnownDnsDb& other) noexcept;
+
+    /** @brief Exact or prefix match of a host-order IPv4 address. */
+    bool containsHostIpv4(uint32_t ip) const noexcept;
+
+    const uint32_t* m_ipv4{nullptr};
+    const Ipv6Addr* m_ipv6{nullptr};
+    std::size_t m_ipv4Count{0};
+    std::size_t m_ipv6Count{0};
+    PrefixTrie m_prefixes4;             ///< IPv4 prefixes in the top 32 bits of the key
+    PrefixTrie m_prefixes6;
+
+    std::vector<uint32_t> m_ownedIpv4;  ///< Backing store when loaded from JSON
+    std::vector<Ipv6Addr> m_ownedIpv6;
+    void* m_mapping{nullptr};           ///< Backing store when mapped
+    std::size_t m_mappingSize{0};
+};
+
+} // namespace monitors
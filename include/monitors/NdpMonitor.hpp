@@ -0,0 +1,93 @@
+/**
+ * @file NdpMonitor.hpp
+ * @brief IPv6 Neighbor Discovery monitor for router and neighbour spoofing.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "monitors/Init.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace capture {
+class CaptureEngine;
+}
+
+namespace monitors {
+
+/**
+ * @class NdpMonitor
+ * @brief Tracks IPv6 link-layer bindings and reports hijacked routers and neighbours.
+ *
+ * The IPv6 counterpart of ArpMonitor. Bindings come from rtnetlink AF_INET6
+ * neighbour notifications and, when the shared capture engine runs, from Neighbor
+ * Solicitations and Advertisements captured on the link, so a forged
+ * advertisement is seen even when the kernel ignores it. The capture workers
+ * only decode those messages and queue them, one lock-free queue per worker,
+ * for the monitor thread that owns the trackers. Routers are learnt
+ * from the IPv6 default route, the kernel's router flag and the NA R flag; a
+ * router whose link-layer address changes raises a critical alert.
+ *
+ * Router Advertisements are captured as well and checked against
+ * the trusted routers: unknown routers, spoofed RAs, prefix changes and
+ * lifetime-zero withdrawals are reported.
+ */
+class NdpMonitor {
+public:
+    /** @brief Construct the monitor and detect the IPv6 default router. */
+    NdpMonitor();
+
+    /** @brief Destructor. Stops the monitor if running. */
+    ~NdpMonitor();
+
+    /**
+     * @brief Start monitoring (blocking).
+     */
+    void start();
+
+    /**
+     * @brief Stop monitoring (thread-safe).
+     */
+    void stop();
+
+    /**
+     * @brief Set the callback for alerts.
+     * @param cb Callback invoked with a title and a message body.
+     */
+    void setNotificationCallback(NotificationCallback cb);
+
+    /**
+     * @brief Receive NDP frames from the shared capture engine.
+     * @param engine Engine to subscribe to; call before the engine starts.
+     */
+    void attachCapture(capture::CaptureEngine& engine);
+
+    /**
+     * @brief Whitelist legitimate routers; call before start().
+     * @param routers Router link-local addresses and/or MACs. Empty to trust
+     *        the default router on first use.
+     */
+    void setTrustedRouters(const std::vector<std::string>& routers);
+
+    /**
+     * @brief Get the detected IPv6 default router.
+     * @return Router address or empty string if none.
+     */
+    std::string router_ip() const;
+
+    /** Always returns true (neighbours are tracked even without a default router) */
+    bool isInitialized() const {
+        return true;
+    }
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl; ///< Pimpl to hide implementation details
+    bool stopped_ = false;       ///< Flag indicating if monitor was stopped
+};
+
+} // namespace monitors
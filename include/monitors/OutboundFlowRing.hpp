@@ -0,0 +1,126 @@
+/**
+ * @file OutboundFlowRing.hpp
+ * @brief Remembers the IPv4 flows this host recently sent.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace monitors {
+
+/**
+ * @struct Ipv4Flow
+ * @brief Addresses, protocol and ports of an IPv4 datagram.
+ *
+ * Addresses are in network byte order. For TCP and UDP, ports holds the
+ * source port in the high 16 bits and the destination port in the low 16
+ * bits; for ICMP echo it holds the identifier, otherwise 0.
+ */
+struct Ipv4Flow {
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    uint32_t ports = 0;
+    uint8_t proto = 0;
+
+    bool operator==(const Ipv4Flow& o) const noexcept {
+        return src == o.src && dst == o.dst && ports == o.ports && proto == o.proto;
+    }
+};
+
+/**
+ * @brief Decode the flow of an IPv4 header followed by (at least) 8 bytes of payload.
+ *
+ * This is what ICMP errors quote of the offending datagram, so outbound
+ * packets and quoted datagrams map to the same flow.
+ *
+ * @param ip Start of the IPv4 header.
+ * @param len Bytes available at ip.
+ * @param[out] flow Decoded flow.
+ * @return False if the header is malformed or truncated, or the datagram is a non-first fragment.
+ */
+bool parseIpv4Flow(const uint8_t* ip, std::size_t len, Ipv4Flow& flow) noexcept;
+
+/**
+ * @class OutboundFlowRing
+ * @brief Fixed-size ring of recently sent flows with O(1) lookup.
+ *
+ * Each distinct flow occupies one ring slot; seeing it again only refreshes
+ * its timestamp. When the ring is full the oldest slot is reused, so a burst
+ * of new flows pushes out the oldest ones. Lookups report UNVERIFIED while a
+ * miss cannot be trusted: right after start-up, or while flows still inside
+ * the window are being pushed out.
+ */
+class OutboundFlowRing {
+public:
+    /** Result of a lookup. */
+    enum class Match {
+        SENT,       ///< Flow sent within the window
+        UNKNOWN,    ///< Flow not sent within the window
+        UNVERIFIED  ///< Not found, but it may have been missed or pushed out
+    };
+
+    /** Default number of flows remembered. */
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    /** Default time a flow is remembered after its last packet (seconds). */
+    static constexpr uint32_t DEFAULT_WINDOW_SECONDS = 60;
+
+    /**
+     * @brief Construct an empty ring.
+     * @param capacity Number of flows remembered.
+     * @param windowSeconds Time a flow stays known after its last packet.
+     */
+    explicit OutboundFlowRing(std::size_t capacity = DEFAULT_CAPACITY,
+                              uint32_t windowSeconds = DEFAULT_WINDOW_SECONDS);
+
+    /**
+     * @brief Record an outbound packet.
+     * @param flow Flow of the packet.
+     * @param now Capture time in seconds.
+     */
+    void record(const Ipv4Flow& flow, uint32_t now);
+
+    /**
+     * @brief Check whether a flow was recently sent.
+     * @param flow Flow to look up.
+     * @param now Capture time in seconds.
+     */
+    Match lookup(const Ipv4Flow& flow, uint32_t now);
+
+    /** @brief Number of flows remembered. */
+    std::size_t size() const noexcept { return m_index.size(); }
+
+private:
+    struct Entry {
+        Ipv4Flow flow;
+        uint32_t lastSeen = 0;
+        bool used = false;
+    };
+
+    struct FlowHash {
+        uint64_t operator()(const Ipv4Flow& f) const noexcept {
+            return hashMix64(((static_cast<uint64_t>(f.src) << 32) | f.dst) ^
+                             hashMix64((static_cast<uint64_t>(f.proto) << 32) | f.ports));
+        }
+    };
+
+    /** @brief Note the first timestamp seen: misses are unverified for one window after it. */
+    void start(uint32_t now) noexcept;
+
+    std::vector<Entry> m_ring;
+    FlatHashMap<Ipv4Flow, uint32_t, FlowHash> m_index;  ///< Flow -> ring slot
+    std::size_t m_next{0};
+    uint32_t m_window;
+    uint32_t m_startedAt{0};
+    uint32_t m_evictedSeen{0};  ///< Last-seen time of the most recently pushed-out flow
+    bool m_started{false};
+};
+
+} // namespace monitors
@@ -0,0 +1,116 @@
+/**
+ * @file RouterAdvertTracker.hpp
+ * @brief Tracks IPv6 routers and their advertised prefixes to spot rogue RAs.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "capture/NdpPacket.hpp"
+#include "utils/FlatHashMap.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class RouterAdvertTracker
+ * @brief Judges Router Advertisements against trusted routers.
+ *
+ * Trust comes from a whitelist of router link-local addresses and/or MACs.
+ * Without a whitelist, the current default router (or, failing that, the
+ * first router heard) is trusted on first use and every other router is
+ * reported.
+ *
+ * For each router the tracker remembers its MAC, router lifetime and up to
+ * RaPacket::MAX_PREFIXES prefixes, inline in a bounded table: processing an
+ * RA never allocates.
+ */
+class RouterAdvertTracker {
+public:
+    /** What an RA revealed. Several findings may be set at once. */
+    struct Findings {
+        bool learned = false;        ///< Router trusted on first use
+        bool untrusted = false;      ///< First RA of a router that is not trusted
+        bool overflow = false;       ///< Table full: judged without remembering the router
+        bool spoofed = false;        ///< Trusted router address advertised from another MAC
+        bool withdrawn = false;      ///< Trusted router dropped its router lifetime to 0
+        uint8_t newPrefixes = 0;     ///< Bit i: ra.prefixes[i] was not advertised before
+        uint8_t killedPrefixes = 0;  ///< Bit i: ra.prefixes[i] is a known prefix sent with valid lifetime 0
+        uint64_t expectedMac = 0;    ///< MAC of the trusted router when spoofed
+    };
+
+    /** Default number of routers remembered. */
+    static constexpr std::size_t DEFAULT_MAX_ROUTERS = 64;
+
+    /** Minimum delay between two sweeps of a full table (seconds). */
+    static constexpr uint32_t SWEEP_INTERVAL_SECONDS = 5;
+
+    /**
+     * @brief Construct an empty tracker.
+     * @param maxRouters Upper bound on remembered routers.
+     */
+    explicit RouterAdvertTracker(std::size_t maxRouters = DEFAULT_MAX_ROUTERS);
+
+    /** @brief Whitelist a router address (link-local, without scope). */
+    void trustAddress(const Ipv6Addr& addr);
+
+    /** @brief Whitelist a router MAC (combined with addresses, both must match). */
+    void trustMac(uint64_t mac);
+
+    /** @brief True if a whitelist was configured. */
+    bool hasWhitelist() const noexcept { return !m_trustedAddrs.empty() || !m_trustedMacs.empty(); }
+
+    /**
+     * @brief Trust a router on first use (ignored when a whitelist is configured).
+     * @param key Scoped router address.
+     * @param mac Router MAC, 0 to learn it from its first RA.
+     */
+    void trustRouter(const Ipv6Addr& key, uint64_t mac);
+
+    /**
+     * @brief Process one Router Advertisement.
+     * @param ra Decoded RA.
+     * @param key Scoped source address (table key).
+     * @return Findings, all clear for a known router repeating itself.
+     */
+    Findings observe(const capture::RaPacket& ra, const Ipv6Addr& key);
+
+    /** @brief Number of remembered routers. */
+    std::size_t size() const noexcept { return m_routers.size(); }
+
+private:
+    /** Prefix as remembered per router. */
+    struct KnownPrefix {
+        Ipv6Addr prefix;
+        uint8_t length = 0;
+    };
+
+    /** State of one router (about 300 bytes, inline in the table). */
+    struct RouterState {
+        uint64_t mac = 0;            ///< 0 until learnt
+        uint32_t lastSeen = 0;
+        uint16_t lifetime = 0;       ///< Last router lifetime
+        bool trusted = false;
+        uint8_t prefixCount = 0;
+        uint8_t nextSlot = 0;        ///< Round-robin slot reused when the prefix list is full
+        KnownPrefix prefixes[capture::RaPacket::MAX_PREFIXES];
+    };
+
+    /** @brief Decide whether a router heard for the first time is trusted. */
+    bool admit(const Ipv6Addr& addr, uint64_t mac) const noexcept;
+
+    /** @brief Compare the advertised prefixes with those already known. */
+    static void updatePrefixes(RouterState& state, const capture::RaPacket& ra, Findings& findings) noexcept;
+
+    FlatHashMap<Ipv6Addr, RouterState> m_routers;
+    FlatHashMap<Ipv6Addr, uint8_t> m_trustedAddrs;
+    FlatHashMap<uint64_t, uint8_t> m_trustedMacs;
+    bool m_anyTrusted{false};   ///< A router was trusted on first use
+    uint32_t m_nextSweep{0};    ///< Earliest time of the next sweep of a full table
+};
+
+} // namespace monitors
@@ -0,0 +1,87 @@
+/**
+ * @file ScanDetector.hpp
+ * @brief Flags sources that contact many distinct destinations (sweeps and scans).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/HyperLogLog.hpp"
+#include "utils/LruMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace monitors {
+
+/**
+ * @class ScanDetector
+ * @brief Estimates, per source, the distinct destinations probed in a sliding window.
+ *
+ * Each source keeps two small HyperLogLog sketches, one for the current
+ * window and one for the previous; their union approximates the last one
+ * to two windows of probes. Sources live in a bounded LRU table, so memory
+ * is fixed (about 150 bytes per source) and every probe costs O(1) with no
+ * allocation. A source is reported when its estimate reaches the
+ * threshold, then at most once every two windows while it keeps scanning.
+ */
+class ScanDetector {
+public:
+    /** Sketch precision: 64 one-byte registers, ~13% standard error. */
+    static constexpr unsigned PRECISION = 6;
+
+    /** Default distinct destinations that make a scan. */
+    static constexpr uint32_t DEFAULT_THRESHOLD = 64;
+
+    /** Default window length (seconds). */
+    static constexpr uint32_t DEFAULT_WINDOW_SECONDS = 60;
+
+    /** Default number of sources tracked at once. */
+    static constexpr std::size_t DEFAULT_MAX_SOURCES = 1024;
+
+    /**
+     * @brief Construct an empty detector.
+     * @param threshold Distinct destinations within the window that trigger a report.
+     * @param windowSeconds Window length.
+     * @param maxSources Upper bound on tracked sources (least recently active are dropped).
+     */
+    explicit ScanDetector(uint32_t threshold = DEFAULT_THRESHOLD,
+                          uint32_t windowSeconds = DEFAULT_WINDOW_SECONDS,
+                          std::size_t maxSources = DEFAULT_MAX_SOURCES);
+
+    /**
+     * @brief Record a probe.
+     * @param source Prober (packed IPv4 or MAC).
+     * @param destination Probed destination (address, or address and port).
+     * @param now Capture time in seconds.
+     * @param[out] distinct Estimated distinct destinations in the window.
+     * @return True if the source reached the threshold and is due for a report.
+     */
+    bool observe(uint64_t source, uint64_t destination, uint32_t now, uint32_t& distinct);
+
+    /** @brief Distinct destinations that trigger a report. */
+    uint32_t threshold() const noexcept { return m_threshold; }
+
+    /** @brief Window length in seconds. */
+    uint32_t windowSeconds() const noexcept { return m_window; }
+
+private:
+    struct SourceState {
+        HyperLogLog<PRECISION> current;
+        HyperLogLog<PRECISION> previous;
+        uint32_t windowStart = 0;
+        uint32_t distinct = 0;   ///< Cached estimate, refreshed when a register changes
+        uint32_t reportedAt = 0; ///< Time of the last report
+        bool reported = false;
+    };
+
+    /** @brief Slide the source's window forward to now. */
+    void rotate(SourceState& state, uint32_t now) const noexcept;
+
+    LruMap<uint64_t, SourceState> m_sources;
+    uint32_t m_threshold;
+    uint32_t m_window;
+};
+
+} // namespace monitors
@@ -0,0 +1,70 @@
+/**
+ * @file ConnectedNetworks.hpp
+ * @brief Prefixes assigned to the local interfaces, to tell on-link neighbours from forged ones.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/NetAddr.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class ConnectedNetworks
+ * @brief Snapshot of the IPv4 and IPv6 prefixes connected to each interface.
+ *
+ * A captured ARP or NDP message may claim any address; only the ones inside
+ * a prefix of the interface it arrived on can be real neighbours. The
+ * snapshot is read with getifaddrs() and refreshed by the owner whenever
+ * rtnetlink reports an address change. Not thread-safe.
+ */
+class ConnectedNetworks {
+public:
+    /**
+     * @brief Re-read the addresses of every interface.
+     * @return False if they could not be read; the previous snapshot is kept.
+     */
+    bool refresh();
+
+    /** @brief True once refresh() succeeded. */
+    bool loaded() const noexcept { return m_loaded; }
+
+    /**
+     * @brief Check that an IPv4 address lies in a prefix of an interface.
+     * @param ifindex Interface index, 0 to accept any interface.
+     * @param ip IPv4 address, network byte order.
+     */
+    bool containsIpv4(int ifindex, uint32_t ip) const noexcept;
+
+    /**
+     * @brief Check that an IPv6 address is on-link for an interface.
+     *
+     * Link-local addresses are always on-link; others must lie in a prefix
+     * assigned to the interface.
+     * @param ifindex Interface index, 0 to accept any interface.
+     * @param addr Unscoped IPv6 address.
+     */
+    bool containsIpv6(int ifindex, const Ipv6Addr& addr) const noexcept;
+
+private:
+    /** IPv4 prefix, network byte order. */
+    struct Ipv4Prefix {
+        int ifindex = 0;
+        uint32_t network = 0;
+        uint32_t mask = 0;
+    };
+
+    /** IPv6 prefix, packed like Ipv6Addr. */
+    struct Ipv6Prefix {
+        int ifindex = 0;
+        Ipv6Addr network;
+        Ipv6Addr mask;
+    };
+
+    std::vector<Ipv4Prefix> m_ipv4;
+    std::vector<Ipv6Prefix> m_ipv6;
+    bool m_loaded{false};
+};
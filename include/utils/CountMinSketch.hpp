@@ -0,0 +1,79 @@
+/**
+ * @file CountMinSketch.hpp
+ * @brief Fixed-size count-min sketch for approximate frequency counting.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @class CountMinSketch
+ * @brief Estimates how often each hash was added, in 4 * 2^W bytes.
+ *
+ * Each value is fed as a well-mixed 64-bit hash; row r counts it in the
+ * slot picked by the r-th 16-bit slice of the hash. The estimate is the
+ * smallest of the four counters, which never undercounts and overcounts
+ * only by collisions. Updates are conservative (only the counters equal
+ * to the minimum move), which keeps the overcount low, and counters
+ * saturate at 255: the sketch tells rare from recurring, not exact counts.
+ * halve() ages every counter so the estimates follow recent activity.
+ *
+ * @tparam W Width of a row in bits (4 to 16).
+ */
+template <unsigned W>
+class CountMinSketch {
+    static_assert(W >= 4 && W <= 16, "CountMinSketch width must be between 4 and 16 bits");
+
+public:
+    /** Number of rows. */
+    static constexpr std::size_t DEPTH = 4;
+
+    /** Counters per row. */
+    static constexpr std::size_t WIDTH = std::size_t{1} << W;
+
+    /**
+     * @brief Count a hashed value once.
+     * @return Estimated count, this addition included.
+     */
+    uint8_t add(uint64_t hash) noexcept {
+        uint8_t current = estimate(hash);
+        if (current == UINT8_MAX) return current;
+        for (std::size_t r = 0; r < DEPTH; ++r) {
+            uint8_t& counter = m_counters[r][slot(hash, r)];
+            if (counter == current) ++counter;
+        }
+        return static_cast<uint8_t>(current + 1);
+    }
+
+    /** @brief Estimated number of times a hashed value was added. */
+    uint8_t estimate(uint64_t hash) const noexcept {
+        uint8_t lowest = UINT8_MAX;
+        for (std::size_t r = 0; r < DEPTH; ++r) {
+            uint8_t counter = m_counters[r][slot(hash, r)];
+            if (counter < lowest) lowest = counter;
+        }
+        return lowest;
+    }
+
+    /** @brief Halve every counter, so older additions weigh less. */
+    void halve() noexcept {
+        for (auto& row : m_counters) {
+            for (auto& counter : row) counter = static_cast<uint8_t>(counter >> 1);
+        }
+    }
+
+    /** @brief Forget every value. */
+    void clear() noexcept { std::memset(m_counters, 0, sizeof(m_counters)); }
+
+private:
+    static std::size_t slot(uint64_t hash, std::size_t row) noexcept {
+        return static_cast<std::size_t>(hash >> (16 * row)) & (WIDTH - 1);
+    }
+
+    uint8_t m_counters[DEPTH][WIDTH] = {};
+};
@@ -0,0 +1,73 @@
+/**
+ * @file DefaultGateway.hpp
+ * @brief In-process default gateway discovery (rtnetlink, /proc/net/route, /proc/net/ipv6_route).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <linux/netlink.h>
+#include <string>
+
+/**
+ * @class DefaultGateway
+ * @brief Looks up the IPv4 default gateway and IPv6 default router without spawning processes.
+ */
+class DefaultGateway {
+public:
+    /**
+     * @brief Detect the default gateway.
+     *
+     * Dumps the main routing table over rtnetlink (RTM_GETROUTE) and falls back
+     * to parsing /proc/net/route. When several default routes exist, the one
+     * with the lowest metric wins.
+     *
+     * @return Gateway IP in dotted notation, or empty string if none.
+     */
+    static std::string detect();
+
+    /** @brief Detect the default gateway from an rtnetlink route dump only. */
+    static std::string fromNetlink();
+
+    /**
+     * @brief Detect the default gateway from a /proc/net/route style file.
+     * @param path File to parse (default /proc/net/route).
+     */
+    static std::string fromProcRoute(const std::string& path = "/proc/net/route");
+
+    /**
+     * @brief Check whether an rtnetlink message is an IPv4 default route update.
+     * @param msg RTM_NEWROUTE / RTM_DELROUTE message.
+     * @return True if the message adds or removes a default route in the main table.
+     */
+    static bool isDefaultRouteMessage(const nlmsghdr& msg) noexcept;
+
+    /**
+     * @brief Detect the IPv6 default router.
+     *
+     * Same strategy as detect(), with /proc/net/ipv6_route as the fallback.
+     *
+     * @param[out] ifindex Outgoing interface of the route, if not null.
+     * @return Router address (usually link-local), or empty string if none.
+     */
+    static std::string detectIpv6(int* ifindex = nullptr);
+
+    /** @brief Detect the IPv6 default router from an rtnetlink route dump only. */
+    static std::string fromNetlinkIpv6(int* ifindex = nullptr);
+
+    /**
+     * @brief Detect the IPv6 default router from a /proc/net/ipv6_route style file.
+     * @param path File to parse (default /proc/net/ipv6_route).
+     * @param[out] ifindex Outgoing interface of the route, if not null.
+     */
+    static std::string fromProcIpv6Route(const std::string& path = "/proc/net/ipv6_route",
+                                         int* ifindex = nullptr);
+
+    /**
+     * @brief Check whether an rtnetlink message is an IPv6 default route update.
+     * @param msg RTM_NEWROUTE / RTM_DELROUTE message.
+     */
+    static bool isIpv6DefaultRouteMessage(const nlmsghdr& msg) noexcept;
+};
@@ -0,0 +1,73 @@
+/**
+ * @file FileWatcher.hpp
+ * @brief Minimal inotify wrapper reporting changes to a set of files.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class FileWatcher
+ * @brief Non-blocking inotify descriptor watching individual files.
+ *
+ * Files are watched through their parent directory, so atomic replacements
+ * (write to a temporary file, then rename) and deletions are seen as well as
+ * in-place writes. A symlink is watched together with the file it points to.
+ * A file whose directory does not exist yet is watched through its nearest
+ * existing ancestor, which reports the creation of the missing directory.
+ *
+ * After a change, call watch() again: symlink targets and directories may
+ * have moved.
+ */
+class FileWatcher {
+public:
+    /** Result of draining the descriptor. */
+    enum class Status {
+        UNCHANGED,  ///< Only events about unrelated files
+        CHANGED,    ///< A watched file (or a directory leading to it) changed
+        ERROR       ///< Unrecoverable read error
+    };
+
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    // Non-copyable
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * @brief Create the inotify descriptor.
+     * @return True on success.
+     */
+    bool open();
+
+    /** @brief Close the descriptor and drop every watch. */
+    void close() noexcept;
+
+    /** @brief Descriptor to add to a poll set (POLLIN). */
+    int fd() const noexcept { return m_fd; }
+
+    /**
+     * @brief Replace the watched set.
+     * @param paths Absolute file paths; missing files are fine.
+     * @return Number of directories watched.
+     */
+    std::size_t watch(const std::vector<std::string>& paths);
+
+    /** @brief Drain all pending events without blocking. */
+    Status receive();
+
+private:
+    /** @brief Watch the entry name of dir, or the nearest existing ancestor of dir. */
+    void watchEntry(std::string dir, std::string name);
+
+    int m_fd{-1};
+    std::unordered_map<int, std::unordered_set<std::string>> m_names;  ///< Watch descriptor -> entry names
+};
@@ -0,0 +1,259 @@
+/**
+ * @file FlatHashMap.hpp
+ * @brief Open-addressing hash map with inline storage for hot-path monitor state.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 64-bit finalizer (MurmurHash3 fmix64) used to spread integer keys.
+ */
+inline uint64_t hashMix64(uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Default hasher: mixes integral keys, specialize or pass a functor for others.
+ */
+template <typename Key>
+struct FlatHash {
+    static_assert(std::is_integral_v<Key>, "FlatHash needs a custom hasher for non-integral keys");
+    uint64_t operator()(Key key) const noexcept {
+        return hashMix64(static_cast<uint64_t>(key));
+    }
+};
+
+/**
+ * @class FlatHashMap
+ * @brief Linear-probing hash map storing keys and values in one contiguous array.
+ *
+ * Entries live inline in a power-of-two slot array, so inserting does not
+ * allocate per entry and a lookup usually touches a single cache line. Deletion
+ * uses backward shifting, so there are no tombstones to clean up.
+ *
+ * The map can be bounded: once maxSize entries are stored, insert() refuses new
+ * keys and the owner decides what to evict. Pointers returned by find() and
+ * insert() are invalidated by any later insert() or erase().
+ *
+ * @tparam Key Trivially copyable key type.
+ * @tparam Value Default-constructible value type.
+ * @tparam Hash Hasher returning a well-mixed 64-bit value.
+ */
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class FlatHashMap {
+public:
+    /**
+     * @brief Construct an empty map.
+     * @param initialCapacity Initial number of slots (rounded up to a power of two).
+     * @param maxSize Maximum number of entries, 0 for unbounded.
+     */
+    explicit FlatHashMap(std::size_t initialCapacity = 16, std::size_t maxSize = 0)
+        : m_maxSize(maxSize) {
+        allocate(roundUp(initialCapacity));
+    }
+
+    /**
+     * @brief Largest maxSize whose fully grown slot array fits in a memory budget.
+     * @param bytes Budget for the slot and occupancy arrays.
+     * @return Entry limit to pass to the constructor (at least 6).
+     */
+    static constexpr std::size_t maxSizeForBytes(std::size_t bytes) noexcept {
+        std::size_t cap = 8;
+        while (cap * 2 * (sizeof(Slot) + 1) <= bytes) cap <<= 1;
+        return cap / 4 * 3;
+    }
+
+    /** @brief Number of stored entries. */
+    std::size_t size() const noexcept { return m_size; }
+
+    /** @brief True if no entries are stored. */
+    bool empty() const noexcept { return m_size == 0; }
+
+    /** @brief Number of slots. */
+    std::size_t capacity() const noexcept { return m_slots.size(); }
+
+    /** @brief Entry limit, 0 if unbounded. */
+    std::size_t maxSize() const noexcept { return m_maxSize; }
+
+    /** @brief True if the map is bounded and holds maxSize entries. */
+    bool full() const noexcept { return m_maxSize != 0 && m_size >= m_maxSize; }
+
+    /** @brief Remove all entries, keeping the slot array. */
+    void clear() noexcept {
+        for (auto& used : m_used) used = 0;
+        m_size = 0;
+    }
+
+    /**
+     * @brief Look up a key.
+     * @return Pointer to the value, or nullptr if absent.
+     */
+    Value* find(const Key& key) noexcept {
+        std::size_t idx = locate(key);
+        return idx == NPOS ? nullptr : &m_slots[idx].value;
+    }
+
+    /** @copydoc find */
+    const Value* find(const Key& key) const noexcept {
+        std::size_t idx = locate(key);
+        return idx == NPOS ? nullptr : &m_slots[idx].value;
+    }
+
+    /**
+     * @brief Find a key or insert it with a value-initialized Value.
+     * @return {value, inserted}; value is nullptr if the key is new and the map is full.
+     */
+    std::pair<Value*, bool> insert(const Key& key) {
+        std::size_t idx = locate(key);
+        if (idx != NPOS) return {&m_slots[idx].value, false};
+        if (full()) return {nullptr, false};
+
+        // Keep the load factor at or below 3/4
+        if ((m_size + 1) * 4 > m_slots.size() * 3) rehash(m_slots.size() * 2);
+
+        idx = probeStart(key);
+        while (m_used[idx]) idx = (idx + 1) & m_mask;
+        m_used[idx] = 1;
+        m_slots[idx].key = key;
+        m_slots[idx].value = Value{};
+        ++m_size;
+        return {&m_slots[idx].value, true};
+    }
+
+    /**
+     * @brief Remove a key.
+     * @return True if the key was present.
+     */
+    bool erase(const Key& key) noexcept {
+        std::size_t idx = locate(key);
+        if (idx == NPOS) return false;
+        eraseSlot(idx);
+        return true;
+    }
+
+    /**
+     * @brief Visit every entry.
+     * @param fn Callable as fn(const Key&, Value&).
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (std::size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_used[i]) fn(static_cast<const Key&>(m_slots[i].key), m_slots[i].value);
+        }
+    }
+
+    /** @copydoc forEach */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (std::size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_used[i]) fn(m_slots[i].key, m_slots[i].value);
+        }
+    }
+
+    /**
+     * @brief Remove every entry matching a predicate.
+     * @param pred Callable as pred(const Key&, const Value&) returning true to erase.
+     * @return Number of erased entries.
+     */
+    template <typename Pred>
+    std::size_t eraseIf(Pred&& pred) {
+        std::size_t erased = 0;
+        std::size_t i = 0;
+        while (i < m_slots.size()) {
+            // A backward shift may move a not-yet-visited entry into slot i, so re-check it
+            if (m_used[i] && pred(static_cast<const Key&>(m_slots[i].key),
+                                  static_cast<const Value&>(m_slots[i].value))) {
+                eraseSlot(i);
+                ++erased;
+            } else {
+                ++i;
+            }
+        }
+        return erased;
+    }
+
+private:
+    struct Slot {
+        Key key{};
+        Value value{};
+    };
+
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+
+    static std::size_t roundUp(std::size_t n) noexcept {
+        std::size_t cap = 8;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+    void allocate(std::size_t cap) {
+        m_slots.assign(cap, Slot{});
+        m_used.assign(cap, 0);
+        m_mask = cap - 1;
+        m_size = 0;
+    }
+
+    std::size_t probeStart(const Key& key) const noexcept {
+        return static_cast<std::size_t>(m_hash(key)) & m_mask;
+    }
+
+    std::size_t locate(const Key& key) const noexcept {
+        std::size_t idx = probeStart(key);
+        while (m_used[idx]) {
+            if (m_slots[idx].key == key) return idx;
+            idx = (idx + 1) & m_mask;
+        }
+        return NPOS;
+    }
+
+    void rehash(std::size_t newCap) {
+        std::vector<Slot> oldSlots = std::move(m_slots);
+        std::vector<uint8_t> oldUsed = std::move(m_used);
+        allocate(newCap);
+        for (std::size_t i = 0; i < oldSlots.size(); ++i) {
+            if (!oldUsed[i]) continue;
+            std::size_t idx = probeStart(oldSlots[i].key);
+            while (m_used[idx]) idx = (idx + 1) & m_mask;
+            m_used[idx] = 1;
+            m_slots[idx] = std::move(oldSlots[i]);
+            ++m_size;
+        }
+    }
+
+    void eraseSlot(std::size_t hole) noexcept {
+        // Backward-shift deletion: pull later entries of the probe run into the hole
+        std::size_t idx = hole;
+        while (true) {
+            idx = (idx + 1) & m_mask;
+            if (!m_used[idx]) break;
+            std::size_t home = probeStart(m_slots[idx].key);
+            // Move the entry if its home slot is not cyclically within (hole, idx]
+            if (((idx - home) & m_mask) >= ((idx - hole) & m_mask)) {
+                m_slots[hole] = std::move(m_slots[idx]);
+                hole = idx;
+            }
+        }
+        m_used[hole] = 0;
+        --m_size;
+    }
+
+    std::vector<Slot> m_slots;
+    std::vector<uint8_t> m_used;
+    std::size_t m_mask{0};
+    std::size_t m_size{0};
+    std::size_t m_maxSize{0};
+    Hash m_hash{};
+};
@@ -0,0 +1,86 @@
+/**
+ * @file HyperLogLog.hpp
+ * @brief Fixed-size HyperLogLog sketch for approximate distinct counting.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @class HyperLogLog
+ * @brief Estimates the number of distinct hashes added, in 2^P bytes.
+ *
+ * Each value is fed as a well-mixed 64-bit hash: the top P bits select a
+ * register, which keeps the longest run of leading zeros seen in the rest.
+ * The relative standard error is about 1.04 / sqrt(2^P). Small cardinalities
+ * use linear counting on the empty registers, so counts in the tens stay
+ * close to exact.
+ *
+ * @tparam P Precision in bits (4 to 16).
+ */
+template <unsigned P>
+class HyperLogLog {
+    static_assert(P >= 4 && P <= 16, "HyperLogLog precision must be between 4 and 16");
+
+public:
+    /** Number of registers. */
+    static constexpr std::size_t REGISTERS = std::size_t{1} << P;
+
+    /**
+     * @brief Add a hashed value.
+     * @return True if a register changed (the estimate may have moved).
+     */
+    bool add(uint64_t hash) noexcept {
+        std::size_t idx = static_cast<std::size_t>(hash >> (64 - P));
+        uint64_t rest = hash << P;
+        uint8_t rank = rest == 0 ? static_cast<uint8_t>(64 - P + 1)
+                                 : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        if (rank > 64 - P + 1) rank = static_cast<uint8_t>(64 - P + 1);
+        if (rank <= m_registers[idx]) return false;
+        m_registers[idx] = rank;
+        return true;
+    }
+
+    /** @brief Fold another sketch in: the result estimates the union. */
+    void merge(const HyperLogLog& other) noexcept {
+        for (std::size_t i = 0; i < REGISTERS; ++i) {
+            if (other.m_registers[i] > m_registers[i]) m_registers[i] = other.m_registers[i];
+        }
+    }
+
+    /** @brief Forget every value. */
+    void clear() noexcept { std::memset(m_registers, 0, sizeof(m_registers)); }
+
+    /** @brief Estimated number of distinct values added. */
+    double estimate() const noexcept {
+        double sum = 0.0;
+        std::size_t zeros = 0;
+        for (std::size_t i = 0; i < REGISTERS; ++i) {
+            sum += std::ldexp(1.0, -static_cast<int>(m_registers[i]));
+            if (m_registers[i] == 0) ++zeros;
+        }
+        constexpr double m = static_cast<double>(REGISTERS);
+        double raw = alpha() * m * m / sum;
+        if (raw <= 2.5 * m && zeros != 0) {
+            // Linear counting is more accurate while many registers are empty
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return raw;
+    }
+
+private:
+    static constexpr double alpha() noexcept {
+        if (REGISTERS == 16) return 0.673;
+        if (REGISTERS == 32) return 0.697;
+        if (REGISTERS == 64) return 0.709;
+        return 0.7213 / (1.0 + 1.079 / static_cast<double>(REGISTERS));
+    }
+
+    uint8_t m_registers[REGISTERS] = {};
+};
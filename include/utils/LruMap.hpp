@@ -0,0 +1,162 @@
+/**
+ * @file LruMap.hpp
+ * @brief Fixed-capacity map that evicts the least recently used entry.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class LruMap
+ * @brief Bounded key/value table with least-recently-used eviction.
+ *
+ * Entries live in a preallocated node pool threaded on an intrusive recency
+ * list, and a FlatHashMap sized for the full capacity maps keys to nodes.
+ * Lookups, insertions and evictions are O(1) and nothing is allocated after
+ * construction, so the table can sit on a packet path fed by untrusted
+ * sources: a flood of new keys only recycles the stalest entries.
+ *
+ * @tparam Key Trivially copyable key type.
+ * @tparam Value Default-constructible value type.
+ * @tparam Hash Hasher returning a well-mixed 64-bit value.
+ */
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class LruMap {
+public:
+    /**
+     * @brief Construct an empty map.
+     * @param capacity Maximum number of entries (at least 1).
+     */
+    explicit LruMap(std::size_t capacity)
+        : m_nodes(capacity > 0 ? capacity : 1),
+          m_index(m_nodes.size() * 4 / 3 + 1, m_nodes.size()) {
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            m_nodes[i].next = i + 1 < m_nodes.size() ? static_cast<uint32_t>(i + 1) : NIL;
+        }
+        m_free = 0;
+    }
+
+    /** @brief Number of stored entries. */
+    std::size_t size() const noexcept { return m_index.size(); }
+
+    /** @brief Maximum number of entries. */
+    std::size_t capacity() const noexcept { return m_nodes.size(); }
+
+    /**
+     * @brief Look up a key without refreshing it.
+     * @return Pointer to the value, or nullptr if absent.
+     */
+    Value* find(const Key& key) noexcept {
+        const uint32_t* idx = m_index.find(key);
+        return idx ? &m_nodes[*idx].value : nullptr;
+    }
+
+    /** @copydoc find */
+    const Value* find(const Key& key) const noexcept {
+        const uint32_t* idx = m_index.find(key);
+        return idx ? &m_nodes[*idx].value : nullptr;
+    }
+
+    /**
+     * @brief Find a key or insert it with a value-initialized Value, marking it most recent.
+     * @param key Key to look up.
+     * @param[out] evicted Set to true if the least recently used entry was dropped to make room.
+     * @return {value, inserted}.
+     */
+    std::pair<Value*, bool> touch(const Key& key, bool* evicted = nullptr) noexcept {
+        if (evicted) *evicted = false;
+        if (const uint32_t* found = m_index.find(key)) {
+            uint32_t idx = *found;
+            unlink(idx);
+            pushFront(idx);
+            return {&m_nodes[idx].value, false};
+        }
+
+        if (m_free == NIL) {
+            // Recycle the least recently used node
+            uint32_t victim = m_tail;
+            m_index.erase(m_nodes[victim].key);
+            unlink(victim);
+            m_nodes[victim].next = m_free;
+            m_free = victim;
+            if (evicted) *evicted = true;
+        }
+
+        uint32_t idx = m_free;
+        m_free = m_nodes[idx].next;
+        Node& n = m_nodes[idx];
+        n.key = key;
+        n.value = Value{};
+        pushFront(idx);
+        *m_index.insert(key).first = idx;
+        return {&n.value, true};
+    }
+
+    /**
+     * @brief Remove a key.
+     * @return True if the key was present.
+     */
+    bool erase(const Key& key) noexcept {
+        const uint32_t* found = m_index.find(key);
+        if (!found) return false;
+        uint32_t idx = *found;
+        m_index.erase(key);
+        unlink(idx);
+        m_nodes[idx].next = m_free;
+        m_free = idx;
+        return true;
+    }
+
+    /**
+     * @brief Visit every entry, most recently used first.
+     * @param fn Callable as fn(const Key&, Value&).
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (uint32_t idx = m_head; idx != NIL; idx = m_nodes[idx].next) {
+            fn(static_cast<const Key&>(m_nodes[idx].key), m_nodes[idx].value);
+        }
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        Key key{};
+        Value value{};
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+    };
+
+    void unlink(uint32_t idx) noexcept {
+        Node& n = m_nodes[idx];
+        if (n.prev != NIL) m_nodes[n.prev].next = n.next;
+        else m_head = n.next;
+        if (n.next != NIL) m_nodes[n.next].prev = n.prev;
+        else m_tail = n.prev;
+        n.prev = n.next = NIL;
+    }
+
+    void pushFront(uint32_t idx) noexcept {
+        Node& n = m_nodes[idx];
+        n.prev = NIL;
+        n.next = m_head;
+        if (m_head != NIL) m_nodes[m_head].prev = idx;
+        else m_tail = idx;
+        m_head = idx;
+    }
+
+    std::vector<Node> m_nodes;
+    FlatHashMap<Key, uint32_t, Hash> m_index;  ///< Key -> node
+    uint32_t m_head{NIL};
+    uint32_t m_tail{NIL};
+    uint32_t m_free{NIL};
+};
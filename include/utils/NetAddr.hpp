@@ -0,0 +1,137 @@
+/**
+ * @file NetAddr.hpp
+ * @brief Packed IPv4 / IPv6 / MAC address helpers shared by the monitors.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/FlatHashMap.hpp"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <string>
+
+/**
+ * @struct Ipv6Addr
+ * @brief IPv6 address packed into two 64-bit words, first octet most significant.
+ */
+struct Ipv6Addr {
+    uint64_t hi = 0;  ///< Octets 0-7
+    uint64_t lo = 0;  ///< Octets 8-15
+
+    bool operator==(const Ipv6Addr& other) const noexcept { return hi == other.hi && lo == other.lo; }
+    bool operator!=(const Ipv6Addr& other) const noexcept { return !(*this == other); }
+
+    /** @brief True for "::". */
+    bool isUnspecified() const noexcept { return hi == 0 && lo == 0; }
+
+    /** @brief True for fe80::/10. */
+    bool isLinkLocal() const noexcept { return (hi >> 54) == 0x3fa; }
+
+    /** @brief True for ff00::/8. */
+    bool isMulticast() const noexcept { return (hi >> 56) == 0xff; }
+};
+
+/**
+ * @brief Hasher for packed IPv6 keys in a FlatHashMap.
+ */
+template <>
+struct FlatHash<Ipv6Addr> {
+    uint64_t operator()(const Ipv6Addr& addr) const noexcept {
+        return hashMix64(addr.hi ^ hashMix64(addr.lo));
+    }
+};
+
+/**
+ * @class NetAddr
+ * @brief Conversions between packed integer addresses and their text forms.
+ *
+ * IPv4 addresses are kept as a uint32_t in network byte order (as found in
+ * packets and rtnetlink attributes), IPv6 addresses as an Ipv6Addr. MAC
+ * addresses are kept in the low 48 bits of a uint64_t, first octet most
+ * significant.
+ */
+class NetAddr {
+public:
+    /** @brief Pack 6 bytes of hardware address. */
+    static uint64_t packMac(const uint8_t* bytes) noexcept {
+        uint64_t mac = 0;
+        for (int i = 0; i < 6; ++i) mac = (mac << 8) | bytes[i];
+        return mac;
+    }
+
+    /** @brief Unpack a MAC into 6 bytes. */
+    static void unpackMac(uint64_t mac, uint8_t* bytes) noexcept {
+        for (int i = 5; i >= 0; --i) {
+            bytes[i] = static_cast<uint8_t>(mac & 0xff);
+            mac >>= 8;
+        }
+    }
+
+    /** @brief Format a MAC as lowercase "aa:bb:cc:dd:ee:ff". */
+    static std::string formatMac(uint64_t mac);
+
+    /**
+     * @brief Parse "aa:bb:cc:dd:ee:ff" (or '-' separated, any case).
+     * @return True on success.
+     */
+    static bool parseMac(const std::string& text, uint64_t& mac) noexcept;
+
+    /** @brief Format a network-order IPv4 address in dotted notation. */
+    static std::string formatIpv4(uint32_t ip);
+
+    /**
+     * @brief Parse a dotted IPv4 address into network byte order.
+     * @return True on success.
+     */
+    static bool parseIpv4(const std::string& text, uint32_t& ip) noexcept;
+
+    /** @brief Pack 16 bytes of IPv6 address. */
+    static Ipv6Addr packIpv6(const uint8_t* bytes) noexcept {
+        Ipv6Addr addr;
+        for (int i = 0; i < 8; ++i) addr.hi = (addr.hi << 8) | bytes[i];
+        for (int i = 8; i < 16; ++i) addr.lo = (addr.lo << 8) | bytes[i];
+        return addr;
+    }
+
+    /** @brief Unpack an IPv6 address into 16 bytes. */
+    static void unpackIpv6(const Ipv6Addr& addr, uint8_t* bytes) noexcept {
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<uint8_t>(addr.hi >> (56 - 8 * i));
+            bytes[8 + i] = static_cast<uint8_t>(addr.lo >> (56 - 8 * i));
+        }
+    }
+
+    /** @brief Format an IPv6 address in RFC 5952 notation. */
+    static std::string formatIpv6(const Ipv6Addr& addr);
+
+    /**
+     * @brief Parse an IPv6 address.
+     * @return True on success.
+     */
+    static bool parseIpv6(const std::string& text, Ipv6Addr& addr) noexcept;
+
+    /** @brief Map a network-order IPv4 address to ::ffff:a.b.c.d, so one key type covers both families. */
+    static Ipv6Addr mapIpv4(uint32_t ip) noexcept {
+        Ipv6Addr addr;
+        addr.lo = 0xffff00000000ull | ntohl(ip);
+        return addr;
+    }
+
+    /** @brief True for an IPv4-mapped address (::ffff:a.b.c.d). */
+    static bool isMappedIpv4(const Ipv6Addr& addr) noexcept { return addr.hi == 0 && (addr.lo >> 32) == 0xffff; }
+
+    /** @brief Network-order IPv4 address of an IPv4-mapped address. */
+    static uint32_t unmapIpv4(const Ipv6Addr& addr) noexcept { return htonl(static_cast<uint32_t>(addr.lo)); }
+
+    /** @brief Format an address of either family, IPv4-mapped ones in dotted notation. */
+    static std::string formatIp(const Ipv6Addr& addr);
+
+    /**
+     * @brief Parse an IPv4 address (mapped to ::ffff:a.b.c.d) or an IPv6 address.
+     * @return True on success.
+     */
+    static bool parseIp(const std::string& text, Ipv6Addr& addr) noexcept;
+};
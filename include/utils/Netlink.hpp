@@ -0,0 +1,94 @@
+/**
+ * @file Netlink.hpp
+ * @brief Minimal rtnetlink socket wrapper for event-driven kernel table monitoring.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+/**
+ * @class NetlinkSocket
+ * @brief Non-blocking NETLINK_ROUTE socket subscribed to multicast groups.
+ *
+ * Used to receive neighbour (and other rtnetlink) notifications pushed by the
+ * kernel, and to request full table dumps for the initial state or after the
+ * socket receive buffer overflowed.
+ */
+class NetlinkSocket {
+public:
+    /** Handler invoked once per received rtnetlink message. */
+    using MessageHandler = std::function<void(const nlmsghdr& msg)>;
+
+    /** Result of draining the socket. */
+    enum class RecvStatus {
+        OK,       ///< All pending messages were handled
+        OVERRUN,  ///< Kernel dropped notifications (ENOBUFS); state must be re-dumped
+        ERROR     ///< Unrecoverable socket error
+    };
+
+    NetlinkSocket() = default;
+    ~NetlinkSocket();
+
+    // Non-copyable
+    NetlinkSocket(const NetlinkSocket&) = delete;
+    NetlinkSocket& operator=(const NetlinkSocket&) = delete;
+
+    /**
+     * @brief Open the socket and join the given multicast groups.
+     * @param groups Bitmask of legacy RTMGRP_* groups.
+     * @return True on success.
+     */
+    bool open(uint32_t groups);
+
+    /** @brief Close the socket if open. */
+    void close() noexcept;
+
+    /** @brief True if the socket is open. */
+    bool isOpen() const noexcept { return m_fd >= 0; }
+
+    /** @brief Descriptor to add to a poll set (POLLIN). */
+    int fd() const noexcept { return m_fd; }
+
+    /**
+     * @brief Request a table dump and handle every reply until NLMSG_DONE.
+     * @param type Request type (e.g. RTM_GETNEIGH).
+     * @param family Address family to dump (e.g. AF_INET).
+     * @param handler Called for every message received meanwhile, including
+     *                multicast notifications interleaved with the dump.
+     * @param timeoutMs Maximum time to wait for the dump to complete.
+     * @return True if the dump completed.
+     */
+    bool dump(uint16_t type, uint8_t family, const MessageHandler& handler, int timeoutMs = 2000);
+
+    /**
+     * @brief Drain all pending messages without blocking.
+     * @param handler Called for every received message.
+     */
+    RecvStatus receive(const MessageHandler& handler);
+
+    /**
+     * @brief Index rtnetlink attributes by type.
+     * @param rta First attribute.
+     * @param len Total length of the attribute block.
+     * @param table Output table of size max + 1, filled with nullptr for missing attributes.
+     * @param max Highest attribute type to record.
+     */
+    static void parseAttributes(const rtattr* rta, int len, const rtattr** table, int max) noexcept;
+
+private:
+    /** Outcome of reading one datagram. */
+    enum class ReadResult { MESSAGES, DONE, EMPTY, OVERRUN, ERROR };
+
+    ReadResult readOnce(const MessageHandler& handler, uint32_t dumpSeq);
+
+    int m_fd{-1};
+    uint32_t m_seq{0};
+    alignas(nlmsghdr) char m_buffer[32768]; ///< Receive buffer (one datagram)
+};
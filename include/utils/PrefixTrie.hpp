@@ -0,0 +1,99 @@
+/**
+ * @file PrefixTrie.hpp
+ * @brief Path-compressed binary trie answering longest-prefix-match queries.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include "utils/NetAddr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class PrefixTrie
+ * @brief Set of address prefixes with longest-prefix match.
+ *
+ * Keys are Ipv6Addr values read from the most significant bit of hi; IPv4
+ * prefixes use the top 32 bits of hi. Nodes are path-compressed (every node
+ * stores its whole prefix, so chains of single children collapse into one
+ * node) and live in one flat array linked by index, root first. A lookup
+ * starts from a jump table indexed by the first stride() bits of the key,
+ * which skips the top levels, then walks at most a few 32-byte nodes.
+ *
+ * Because nodes are linked by index the arrays can be written to a file as
+ * they are and used from a read-only mapping with attach().
+ *
+ * Build with insert() then finalize(); lookups are only valid after either
+ * finalize() or attach().
+ */
+class PrefixTrie {
+public:
+    /** One trie node, also the on-disk record. */
+    struct Node {
+        Ipv6Addr prefix;        ///< Bits past len are zero
+        uint32_t child[2];      ///< Children by bit len of the key, 0 if none (the root is never a child)
+        uint8_t len;            ///< Prefix length, 0 to 128
+        uint8_t terminal;       ///< 1 if the prefix is in the set, 0 for a branching node
+        uint8_t reserved[6];
+    };
+
+    /** Largest jump table: 2^16 entries of 4 bytes. */
+    static constexpr unsigned MAX_STRIDE = 16;
+
+    /** Node indexes share a jump table entry with the best length found above them. */
+    static constexpr uint32_t MAX_NODES = (1u << 24) - 1;
+
+    PrefixTrie() = default;
+
+    /**
+     * @brief Add a prefix; bits of prefix past len are ignored.
+     * @return False if len exceeds 128 or the node limit is reached.
+     */
+    bool insert(const Ipv6Addr& prefix, unsigned len);
+
+    /** @brief Size and fill the jump table after the last insert(). */
+    void finalize();
+
+    /**
+     * @brief Use arrays owned by someone else (typically a mapped file).
+     * @return False if the arrays are inconsistent (bad indexes or stride).
+     */
+    bool attach(const Node* nodes, std::size_t nodeCount, const uint32_t* jump, unsigned stride);
+
+    /** @brief Drop every prefix and detach. */
+    void clear() noexcept;
+
+    /**
+     * @brief Longest stored prefix covering key.
+     * @return Its length, or -1 if no prefix covers key.
+     */
+    int longestMatch(const Ipv6Addr& key) const noexcept;
+
+    /** @brief Number of stored prefixes. */
+    std::size_t size() const noexcept { return m_prefixCount; }
+
+    /** @brief True if no prefix is stored. */
+    bool empty() const noexcept { return m_prefixCount == 0; }
+
+    /** @brief Node array, for serialisation. */
+    const Node* nodes() const noexcept { return m_nodes; }
+    std::size_t nodeCount() const noexcept { return m_nodeCount; }
+
+    /** @brief Jump table of 2^stride() entries, for serialisation. */
+    const uint32_t* jumpTable() const noexcept { return m_jump; }
+    unsigned stride() const noexcept { return m_stride; }
+
+private:
+    const Node* m_nodes{nullptr};
+    std::size_t m_nodeCount{0};
+    const uint32_t* m_jump{nullptr};
+    unsigned m_stride{0};
+    std::size_t m_prefixCount{0};
+
+    std::vector<Node> m_ownedNodes;  ///< Backing store while building
+    std::vector<uint32_t> m_ownedJump;
+};
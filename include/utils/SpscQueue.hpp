@@ -0,0 +1,86 @@
+/**
+ * @file SpscQueue.hpp
+ * @brief Bounded lock-free queue between one producer and one consumer thread.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class SpscQueue
+ * @brief Fixed-capacity ring handing items from one thread to another.
+ *
+ * The producer fills a slot in place (acquire(), then commit()) and the
+ * consumer reads committed slots in place (drain()), so items are never
+ * copied through a temporary. Each side only writes its own index and
+ * caches the other one, so the indexes' cache lines are only exchanged
+ * when the cached value runs out. Nothing is allocated after construction:
+ * a full queue rejects new items and the producer decides what to count.
+ *
+ * @tparam T Default-constructible item type, overwritten in place.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Construct an empty queue.
+     * @param capacity Maximum number of items, rounded up to a power of two.
+     */
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    // Non-copyable: the indexes are shared with another thread
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /** @brief Maximum number of items. */
+    std::size_t capacity() const noexcept { return m_slots.size(); }
+
+    /**
+     * @brief Producer side: slot for the next item, to fill and commit().
+     * @return nullptr if the queue is full. Until commit(), the same slot is returned again.
+     */
+    T* acquire() noexcept {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache == m_slots.size()) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache == m_slots.size()) return nullptr;
+        }
+        return &m_slots[tail & m_mask];
+    }
+
+    /** @brief Producer side: publish the slot returned by the last acquire(). */
+    void commit() noexcept {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer side: hand every committed item to fn and free the slots.
+     * @param fn Called as fn(const T&) in commit order.
+     * @return Number of items consumed.
+     */
+    template <typename Fn>
+    std::size_t drain(Fn&& fn) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        for (std::size_t i = head; i != tail; ++i) fn(static_cast<const T&>(m_slots[i & m_mask]));
+        m_head.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+private:
+    std::vector<T> m_slots;
+    std::size_t m_mask = 0;
+    alignas(64) std::atomic<std::size_t> m_head{0};  ///< Next slot to consume, written by the consumer
+    alignas(64) std::atomic<std::size_t> m_tail{0};  ///< Next slot to fill, written by the producer
+    std::size_t m_headCache = 0;                     ///< Producer's last view of m_head
+};
@@ -0,0 +1,223 @@
+/**
+ * @file TimingWheel.hpp
+ * @brief Bounded hierarchical timing wheel for O(1) timer scheduling and expiry.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class TimingWheel
+ * @brief Hierarchical timing wheel with a fixed-size timer pool.
+ *
+ * Time is counted in abstract ticks. Four levels of 64 slots cover 2^24 ticks;
+ * timers further away are clamped to the farthest slot and re-cascaded. Timers
+ * live in a preallocated pool linked into per-slot intrusive lists, so
+ * scheduling, cancelling and expiring are O(1) and memory is fixed at
+ * construction: when the pool is exhausted, schedule() fails instead of
+ * allocating.
+ *
+ * @tparam T Payload stored with each timer (trivially copyable).
+ */
+template <typename T>
+class TimingWheel {
+public:
+    /** Opaque timer handle. */
+    using Handle = uint32_t;
+
+    /** Returned by schedule() when the pool is full. */
+    static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+    /**
+     * @brief Construct a wheel.
+     * @param capacity Maximum number of pending timers.
+     * @param startTick Current time in ticks.
+     */
+    explicit TimingWheel(std::size_t capacity, uint64_t startTick = 0)
+        : m_nodes(capacity), m_now(startTick) {
+        for (auto& head : m_heads) head = NIL;
+        for (std::size_t i = 0; i < capacity; ++i) {
+            m_nodes[i].next = i + 1 < capacity ? static_cast<uint32_t>(i + 1) : NIL;
+        }
+        m_free = capacity > 0 ? 0 : NIL;
+    }
+
+    /** @brief Number of pending timers. */
+    std::size_t size() const noexcept { return m_size; }
+
+    /** @brief Maximum number of pending timers. */
+    std::size_t capacity() const noexcept { return m_nodes.size(); }
+
+    /** @brief True if no timer can be scheduled. */
+    bool full() const noexcept { return m_free == NIL; }
+
+    /** @brief Current time in ticks. */
+    uint64_t now() const noexcept { return m_now; }
+
+    /**
+     * @brief Schedule a timer.
+     * @param expiryTick Tick at which the timer fires (past ticks fire on the next advance).
+     * @param value Payload handed back on expiry.
+     * @return Handle, or INVALID_HANDLE if the pool is full.
+     */
+    Handle schedule(uint64_t expiryTick, const T& value) noexcept {
+        if (m_free == NIL) return INVALID_HANDLE;
+        uint32_t idx = m_free;
+        Node& n = m_nodes[idx];
+        m_free = n.next;
+
+        n.value = value;
+        n.expiry = expiryTick;
+        n.active = true;
+        link(idx, false);
+        ++m_size;
+        return idx;
+    }
+
+    /**
+     * @brief Cancel a pending timer.
+     * @return True if the handle referred to a pending timer.
+     */
+    bool cancel(Handle handle) noexcept {
+        if (handle >= m_nodes.size() || !m_nodes[handle].active) return false;
+        unlink(handle);
+        release(handle);
+        return true;
+    }
+
+    /**
+     * @brief Access the payload of a pending timer.
+     * @return Payload, or nullptr if the handle is not pending.
+     */
+    T* get(Handle handle) noexcept {
+        if (handle >= m_nodes.size() || !m_nodes[handle].active) return nullptr;
+        return &m_nodes[handle].value;
+    }
+
+    /**
+     * @brief Move time forward, firing every timer that expired.
+     * @param nowTick New current time in ticks (ignored if in the past).
+     * @param onExpire Called as onExpire(const T&) for each expired timer.
+     * @return Number of expired timers.
+     */
+    template <typename Fn>
+    std::size_t advance(uint64_t nowTick, Fn&& onExpire) {
+        std::size_t fired = 0;
+        if (nowTick <= m_now) return 0;
+        if (m_size == 0) {
+            m_now = nowTick;
+            return 0;
+        }
+
+        while (m_now < nowTick) {
+            ++m_now;
+            cascade();
+
+            uint32_t& head = m_heads[m_now & SLOT_MASK];
+            while (head != NIL) {
+                uint32_t idx = head;
+                unlink(idx);
+                if (m_nodes[idx].expiry > m_now) {
+                    // Clamped far-future timer: re-file it
+                    link(idx, false);
+                    continue;
+                }
+                T value = m_nodes[idx].value;
+                release(idx);
+                onExpire(static_cast<const T&>(value));
+                ++fired;
+            }
+
+            if (m_size == 0) {
+                m_now = nowTick;
+                break;
+            }
+        }
+        return fired;
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr unsigned LEVELS = 4;
+
+    struct Node {
+        T value{};
+        uint64_t expiry = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint16_t slot = 0;  ///< Index into m_heads
+        bool active = false;
+    };
+
+    /**
+     * @brief File a node into the slot matching its distance to now.
+     * @param allowCurrent True while cascading: the current level-0 slot is
+     *        processed right after, so timers due now may go there.
+     */
+    void link(uint32_t idx, bool allowCurrent) noexcept {
+        Node& n = m_nodes[idx];
+        uint64_t earliest = allowCurrent ? m_now : m_now + 1;
+        uint64_t expiry = n.expiry > earliest ? n.expiry : earliest;
+        uint64_t delta = expiry - m_now;
+
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) ++level;
+        if (delta >= (uint64_t{1} << (SLOT_BITS * LEVELS))) {
+            // Beyond the wheel's range: park in the farthest slot, refiled when it cascades
+            expiry = m_now + (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+        }
+
+        unsigned slot = level * SLOTS + static_cast<unsigned>((expiry >> (SLOT_BITS * level)) & SLOT_MASK);
+        n.slot = static_cast<uint16_t>(slot);
+        n.prev = NIL;
+        n.next = m_heads[slot];
+        if (n.next != NIL) m_nodes[n.next].prev = idx;
+        m_heads[slot] = idx;
+    }
+
+    void unlink(uint32_t idx) noexcept {
+        Node& n = m_nodes[idx];
+        if (n.prev != NIL) m_nodes[n.prev].next = n.next;
+        else m_heads[n.slot] = n.next;
+        if (n.next != NIL) m_nodes[n.next].prev = n.prev;
+        n.prev = n.next = NIL;
+    }
+
+    void release(uint32_t idx) noexcept {
+        Node& n = m_nodes[idx];
+        n.active = false;
+        n.next = m_free;
+        m_free = idx;
+        --m_size;
+    }
+
+    /** @brief When a lower level wraps, redistribute the next slot of the level above. */
+    void cascade() noexcept {
+        for (unsigned level = 1; level < LEVELS; ++level) {
+            if ((m_now & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0) break;
+
+            unsigned slot = level * SLOTS + static_cast<unsigned>((m_now >> (SLOT_BITS * level)) & SLOT_MASK);
+            uint32_t idx = m_heads[slot];
+            m_heads[slot] = NIL;
+            while (idx != NIL) {
+                uint32_t next = m_nodes[idx].next;
+                link(idx, true);
+                idx = next;
+            }
+        }
+    }
+
+    std::vector<Node> m_nodes;
+    uint32_t m_heads[LEVELS * SLOTS];
+    uint32_t m_free{NIL};
+    std::size_t m_size{0};
+    uint64_t m_now{0};
+};
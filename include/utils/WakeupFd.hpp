@@ -0,0 +1,40 @@
+/**
+ * @file WakeupFd.hpp
+ * @brief eventfd-based wakeup handle used to interrupt blocking poll() loops.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+/**
+ * @class WakeupFd
+ * @brief Pollable file descriptor that another thread can signal.
+ *
+ * Event-driven monitors block in poll() with no timeout; stop() signals this
+ * descriptor so the loop wakes up immediately instead of on the next tick.
+ */
+class WakeupFd {
+public:
+    /** @brief Create the underlying eventfd (non-blocking, close-on-exec). */
+    WakeupFd();
+
+    /** @brief Close the underlying eventfd. */
+    ~WakeupFd();
+
+    // Non-copyable
+    WakeupFd(const WakeupFd&) = delete;
+    WakeupFd& operator=(const WakeupFd&) = delete;
+
+    /** @brief Wake up any thread polling fd(). Safe to call from any thread. */
+    void notify() noexcept;
+
+    /** @brief Consume pending wakeups so the descriptor is no longer readable. */
+    void drain() noexcept;
+
+    /** @brief Descriptor to add to a poll set (POLLIN), or -1 if creation failed. */
+    int fd() const noexcept { return m_fd; }
+
+private:
+    int m_fd{-1};
+};
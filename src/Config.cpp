@@ -50,12 +50,23 @@ const std::string& Config::getKnownDNSPath() const noexcept {
     return it != data_.end() ? it->second : default_val;
 }
 
+const std::string& Config::getKnownDNSDbPath() const noexcept {
+    static const std::string default_val = "/etc/spoofeye/known_dns.bin";
+    auto it = data_.find("known_dns_db_path");
+    return it != data_.end() ? it->second : default_val;
+}
+
 // ----- Monitors section -----
 bool Config::arpMonitorEnabled() const noexcept {
     auto it = data_.find("monitors.arp_monitor");
     return it != data_.end() ? parseBool(it->second, true) : false;
 }
 
+bool Config::ndpMonitorEnabled() const noexcept {
+    auto it = data_.find("monitors.ndp_monitor");
+    return it != data_.end() ? parseBool(it->second, true) : false;
+}
+
 bool Config::dnsMonitorEnabled() const noexcept {
     auto it = data_.find("monitors.dns_monitor");
     return it != data_.end() ? parseBool(it->second, true) : false;
@@ -66,6 +77,49 @@ bool Config::icmpMonitorEnabled() const noexcept {
     return it != data_.end() ? parseBool(it->second, true) : false;
 }
 
+// ----- Capture section -----
+unsigned Config::captureWorkers() const noexcept {
+    auto it = data_.find("capture.workers");
+    if (it == data_.end()) return 1;
+    // 0 asks for one worker per CPU, which parseSize would reject
+    if (trim(it->second) == "0") return 0;
+    return static_cast<unsigned>(std::min<std::size_t>(parseSize(it->second, 1), 1024));
+}
+
+std::vector<std::string> Config::captureXdpInterfaces() const {
+    auto it = data_.find("capture.xdp_interfaces");
+    return it != data_.end() ? parseList(it->second) : std::vector<std::string>{};
+}
+
+// ----- ARP section -----
+std::size_t Config::arpRateTableKb() const noexcept {
+    auto it = data_.find("arp.rate_table_kb");
+    return it != data_.end() ? parseSize(it->second, 256) : 256;
+}
+
+// ----- NDP section -----
+std::vector<std::string> Config::ndpTrustedRouters() const {
+    auto it = data_.find("ndp.trusted_routers");
+    return it != data_.end() ? parseList(it->second) : std::vector<std::string>{};
+}
+
+// ----- DNS section -----
+std::vector<std::string> Config::dnsTrustedResolvers() const {
+    auto it = data_.find("dns.trusted_resolvers");
+    return it != data_.end() ? parseList(it->second) : std::vector<std::string>{};
+}
+
+unsigned Config::dnsConsistencyRate() const noexcept {
+    auto it = data_.find("dns.consistency_rate");
+    // Capped so a typo cannot turn the checker into a load generator
+    return static_cast<unsigned>(std::min<std::size_t>(it != data_.end() ? parseSize(it->second, 2) : 2, 50));
+}
+
+unsigned Config::dnsConsistencyInFlight() const noexcept {
+    auto it = data_.find("dns.consistency_in_flight");
+    return static_cast<unsigned>(std::min<std::size_t>(it != data_.end() ? parseSize(it->second, 8) : 8, 64));
+}
+
 // ----- Generic access -----
 bool Config::hasKey(const std::string& key) const noexcept {
     return data_.find(toLower(key)) != data_.end();
@@ -84,9 +138,18 @@ std::string Config::summary() const {
         << " - show_notifications   = " << (showNotifications() ? "true" : "false") << "\n"
         << " - stylize_output       = " << (stylizeOutput() ? "true" : "false") << "\n"
         << " - known_dns_path       = " << getKnownDNSPath() << "\n"
+        << " - known_dns_db_path    = " << getKnownDNSDbPath() << "\n"
         << " - monitors.arp_monitor = " << (arpMonitorEnabled() ? "true" : "false") << "\n"
+        << " - monitors.ndp_monitor = " << (ndpMonitorEnabled() ? "true" : "false") << "\n"
         << " - monitors.dns_monitor = " << (dnsMonitorEnabled() ? "true" : "false") << "\n"
-        << " - monitors.icmp_monitor = " << (icmpMonitorEnabled() ? "true" : "false") << "\n";
+        << " - monitors.icmp_monitor = " << (icmpMonitorEnabled() ? "true" : "false") << "\n"
+        << " - capture.workers      = " << captureWorkers() << "\n"
+        << " - capture.xdp_interfaces = " << getRaw("capture.xdp_interfaces") << "\n"
+        << " - arp.rate_table_kb    = " << arpRateTableKb() << "\n"
+        << " - ndp.trusted_routers  = " << getRaw("ndp.trusted_routers") << "\n"
+        << " - dns.trusted_resolvers = " << getRaw("dns.trusted_resolvers") << "\n"
+        << " - dns.consistency_rate = " << dnsConsistencyRate() << "\n"
+        << " - dns.consistency_in_flight = " << dnsConsistencyInFlight() << "\n";
     return oss.str();
 }
 
@@ -143,3 +206,30 @@ bool Config::parseBool(const std::string& s, bool defaultValue) noexcept {
     if (t == "0" || t == "false" || t == "no" || t == "off") return false;
     return defaultValue;
 }
+
+std::size_t Config::parseSize(const std::string& s, std::size_t defaultValue) noexcept {
+    std::string t = trim(s);
+    if (t.empty() || !std::all_of(t.begin(), t.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return defaultValue;
+    }
+    try {
+        unsigned long long v = std::stoull(t);
+        return v > 0 ? static_cast<std::size_t>(v) : defaultValue;
+    } catch (...) {
+        return defaultValue;
+    }
+}
+
+std::vector<std::string> Config::parseList(const std::string& s) {
+    std::vector<std::string> items;
+    std::string item;
+    for (char c : s + ",") {
+        if (c == ',' || std::isspace(static_cast<unsigned char>(c))) {
+            if (!item.empty()) items.push_back(item);
+            item.clear();
+        } else {
+            item.push_back(c);
+        }
+    }
+    return items;
+}
@@ -15,8 +15,7 @@
 Core::Core(int pollIntervalSeconds, const std::string& forcedGateway, const Config& cfg)
     : m_pollIntervalSeconds(pollIntervalSeconds),
       m_forcedGateway(forcedGateway),
-      m_notificationsEnabled(cfg.showNotifications()),
-      m_lastIcmpAlert(std::chrono::steady_clock::now() - ICMP_ALERT_INTERVAL)
+      m_notificationsEnabled(cfg.showNotifications())
 {
     // Initialize logging
     Logger::init(cfg.getOutputLogPath(), cfg.stylizeOutput());
@@ -26,6 +25,10 @@ Core::Core(int pollIntervalSeconds, const std::string& forcedGateway, const Conf
     Logger::log("Output log path: " + cfg.getOutputLogPath());
     Logger::log("Initializing monitors...");
 
+    // Packet-based monitors size their per-worker state when attaching
+    m_capture.setWorkers(cfg.captureWorkers());
+    m_xdpInterfaces = cfg.captureXdpInterfaces();
+
     // ----- ARP Monitor -----
     if (cfg.arpMonitorEnabled()) {
         if (forcedGateway.empty()) {
@@ -33,12 +36,33 @@ Core::Core(int pollIntervalSeconds, const std::string& forcedGateway, const Conf
         } else {
             m_arpMonitor.emplace(forcedGateway, pollIntervalSeconds);
         }
+        m_arpMonitor->setRateTableMemory(cfg.arpRateTableKb() * 1024);
+        m_arpMonitor->attachCapture(m_capture);
+        m_arpMonitor->setNotificationCallback([this](const std::string& title, const std::string& body) {
+            Notifier notifier(m_notificationsEnabled);
+            notifier.send(title, body, Notifier::Level::WARNING, "dialog-warning");
+        });
+    }
+
+    // ----- NDP Monitor -----
+    if (cfg.ndpMonitorEnabled()) {
+        m_ndpMonitor.emplace();
+        m_ndpMonitor->setTrustedRouters(cfg.ndpTrustedRouters());
+        m_ndpMonitor->attachCapture(m_capture);
+        m_ndpMonitor->setNotificationCallback([this](const std::string& title, const std::string& body) {
+            Notifier notifier(m_notificationsEnabled);
+            notifier.send(title, body, Notifier::Level::WARNING, "dialog-warning");
+        });
     }
 
     // ----- DNS Monitor -----
     if (cfg.dnsMonitorEnabled()) {
         m_dnsMonitor.emplace(std::chrono::seconds(pollIntervalSeconds));
+        m_dnsMonitor->setKnownDnsDbPath(cfg.getKnownDNSDbPath());
         m_dnsMonitor->setKnownDnsPath(cfg.getKnownDNSPath());
+        m_dnsMonitor->attachCapture(m_capture);
+        m_dnsMonitor->setConsistencyCheck(cfg.dnsTrustedResolvers(), cfg.dnsConsistencyInFlight(),
+                                          cfg.dnsConsistencyRate());
         m_dnsMonitor->setNotificationCallback([this](const std::string& title, const std::string& body) {
             Logger::log(title + " -> " + body, Logger::LogType::WARNING, monitors::LogPrefixes::dns_monitor);
             Notifier notifier(m_notificationsEnabled);
@@ -48,21 +72,40 @@ Core::Core(int pollIntervalSeconds, const std::string& forcedGateway, const Conf
 
     // ----- ICMP Monitor -----
     if (cfg.icmpMonitorEnabled()) {
-        m_icmpMonitor.emplace(std::chrono::milliseconds(100));
-        m_icmpMonitor->setPingCallback([this](const std::string& srcIp) {
-            std::lock_guard<std::mutex> lock(m_icmpMutex);
-            auto now = std::chrono::steady_clock::now();
-            if (now - m_lastIcmpAlert >= ICMP_ALERT_INTERVAL) {
-                std::string msg = "Ping detected from " + srcIp;
-                Logger::log(msg, Logger::LogType::DEFAULT, monitors::LogPrefixes::icmp_monitor);
-                Notifier notifier(m_notificationsEnabled);
-                notifier.send("ICMP Ping Alert", msg, Notifier::Level::INFO, "network-transmit-receive");
-                m_lastIcmpAlert = now;
+        m_icmpMonitor.emplace();
+        if (!forcedGateway.empty()) m_icmpMonitor->setGateway(forcedGateway);
+        m_icmpMonitor->attachCapture(m_capture);
+        m_icmpMonitor->setNotificationCallback([this](const std::string& title, const std::string& body) {
+            Notifier notifier(m_notificationsEnabled);
+            notifier.send(title, body, Notifier::Level::WARNING, "dialog-warning");
+        });
+        m_icmpMonitor->setPingCallback([this](const std::string& srcIp, const monitors::IcmpMonitor::PingStats& stats) {
+            std::string msg = "Ping detected from " + srcIp;
+            if (stats.total > 1) {
+                msg += " (" + std::to_string(stats.sinceAlert) + " echo request(s) since last alert, " +
+                       std::to_string(stats.total) + " in total)";
             }
+            Logger::log(msg, Logger::LogType::DEFAULT, monitors::LogPrefixes::icmp_monitor);
+            Notifier notifier(m_notificationsEnabled);
+            notifier.send("ICMP Ping Alert", msg, Notifier::Level::INFO, "network-transmit-receive");
         });
     }
 }
 
+void Core::reportCaptureStats(bool final) {
+    capture::PacketRing::Stats stats = m_capture.stats();
+    if (stats.drops > m_reportedDrops) {
+        Logger::log("Packet capture dropped " + std::to_string(stats.drops - m_reportedDrops) +
+                    " frame(s) because the ring was full; consider more [Capture] workers.",
+                    Logger::LogType::WARNING);
+        m_reportedDrops = stats.drops;
+    }
+    if (final) {
+        Logger::log("Packet capture: " + std::to_string(stats.packets) + " frame(s) matched the filter, " +
+                    std::to_string(stats.drops) + " dropped by the kernel.", Logger::LogType::INFO);
+    }
+}
+
 void Core::run(std::atomic<bool>& keepRunning) {
     // ----- Log monitored resources -----
     if (m_arpMonitor && m_arpMonitor->isInitialized()) {
@@ -77,13 +120,18 @@ void Core::run(std::atomic<bool>& keepRunning) {
                     Logger::LogType::INFO);
     }
 
+    if (m_ndpMonitor && m_ndpMonitor->isInitialized()) {
+        std::string router = m_ndpMonitor->router_ip();
+        Logger::log("Monitoring IPv6 neighbours" + (router.empty() ? std::string{} : ", default router " + router) + ".",
+                    Logger::LogType::INFO);
+    }
+
     if (m_dnsMonitor && m_dnsMonitor->isInitialized()) {
-        Logger::log("Monitoring DNS servers (poll interval " +
-                    std::to_string(m_pollIntervalSeconds) + "s).", Logger::LogType::INFO);
+        Logger::log("Monitoring DNS servers.", Logger::LogType::INFO);
     }
 
     // ----- Start monitor threads -----
-    std::thread tArp, tDns, tIcmp;
+    std::thread tArp, tNdp, tDns;
 
     if (m_arpMonitor && m_arpMonitor->isInitialized()) {
         tArp = std::thread([this] {
@@ -99,30 +147,60 @@ void Core::run(std::atomic<bool>& keepRunning) {
         });
     }
 
+    if (m_ndpMonitor && m_ndpMonitor->isInitialized()) {
+        tNdp = std::thread([this] { m_ndpMonitor->start(); });
+    }
+
     if (m_dnsMonitor && m_dnsMonitor->isInitialized()) {
         tDns = std::thread([this] { m_dnsMonitor->start(); });
     }
 
     if (m_icmpMonitor && m_icmpMonitor->isInitialized()) {
-        tIcmp = std::thread([this] { m_icmpMonitor->start(); });
+        m_icmpMonitor->start();
+    }
+
+    // ----- Start shared packet capture -----
+    if (m_capture.hasSubscribers()) {
+        std::string error;
+        if (!m_xdpInterfaces.empty() && !m_capture.enableXdp(m_xdpInterfaces, error)) {
+            Logger::log("XDP pre-aggregation unavailable (" + error + "), capturing every frame.",
+                        Logger::LogType::WARNING);
+            error.clear();
+        }
+        if (m_capture.start(error)) {
+            Logger::log("Packet capture enabled (" + m_capture.describe() + ").", Logger::LogType::INFO);
+        } else {
+            Logger::log("Packet capture unavailable (" + error + "), relying on kernel tables only.",
+                        Logger::LogType::WARNING);
+        }
     }
 
     // ----- Main loop -----
+    auto lastStatsCheck = std::chrono::steady_clock::now();
     while (keepRunning.load()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (m_capture.isRunning() && now - lastStatsCheck >= CAPTURE_STATS_INTERVAL) {
+            lastStatsCheck = now;
+            reportCaptureStats(false);
+        }
     }
 
     // ----- Shutdown -----
     Logger::log("Shutting down " + std::string(SOFTWARE_NAME) + " v" + std::string(SOFTWARE_VERSION) + "...");
     Logger::log("Stopping monitors...");
 
+    if (m_capture.isRunning()) reportCaptureStats(true);
+    m_capture.stop();
+
     if (m_arpMonitor) m_arpMonitor->stop();
+    if (m_ndpMonitor) m_ndpMonitor->stop();
     if (m_dnsMonitor) m_dnsMonitor->stop();
     if (m_icmpMonitor) m_icmpMonitor->stop();
 
     if (tArp.joinable()) tArp.join();
+    if (tNdp.joinable()) tNdp.join();
     if (tDns.joinable()) tDns.join();
-    if (tIcmp.joinable()) tIcmp.join();
 
     Logger::log("Exited.");
 }
@@ -0,0 +1,69 @@
+/**
+ * @file ArpPacket.cpp
+ * @brief Decoded view of a captured Ethernet/IPv4 ARP frame.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/ArpPacket.hpp"
+#include "utils/NetAddr.hpp"
+
+#include <cstring>
+#include <linux/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+namespace capture {
+
+namespace {
+
+/// Ethernet/IPv4 ARP payload: 8-byte header + 2 * (6-byte MAC + 4-byte IP)
+constexpr uint32_t ARP_IPV4_LEN = 28;
+
+/// Ethernet header + ARP payload, rounded up
+constexpr uint32_t FILTER_SNAPLEN = 64;
+
+/// Ethertype as the kernel classified it, whatever the link layer
+constexpr uint32_t SKF_PROTOCOL = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL);
+
+uint16_t load_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace
+
+bool parseArpFrame(const PacketFrame& frame, ArpPacket& arp) noexcept {
+    if (frame.hatype != ARPHRD_ETHER || frame.caplen < ETH_HLEN) return false;
+    if (!frame.network || frame.networkLen < ARP_IPV4_LEN) return false;
+
+    const uint8_t* p = frame.network;
+    if (load_be16(p) != ARPHRD_ETHER || load_be16(p + 2) != ETH_P_IP) return false;
+    if (p[4] != ETH_ALEN || p[5] != 4) return false;
+
+    uint16_t op = load_be16(p + 6);
+    if (op != ARPOP_REQUEST && op != ARPOP_REPLY) return false;
+
+    arp.op = static_cast<ArpPacket::Op>(op);
+    arp.ethDst = NetAddr::packMac(frame.data);
+    arp.ethSrc = NetAddr::packMac(frame.data + ETH_ALEN);
+    arp.senderMac = NetAddr::packMac(p + 8);
+    std::memcpy(&arp.senderIp, p + 14, 4);
+    arp.targetMac = NetAddr::packMac(p + 18);
+    std::memcpy(&arp.targetIp, p + 24, 4);
+    arp.tsSec = frame.tsSec;
+    arp.tsNsec = frame.tsNsec;
+    arp.ifindex = frame.ifindex;
+    arp.outgoing = frame.pkttype == PACKET_OUTGOING;
+    return true;
+}
+
+std::vector<sock_filter> arpCaptureFilter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_ARP, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, FILTER_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+} // namespace capture
@@ -0,0 +1,494 @@
+/**
+ * @file CaptureEngine.cpp
+ * @brief Shared packet capture demultiplexing frames to the packet-based monitors.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/CaptureEngine.hpp"
+#include "capture/ArpPacket.hpp"
+#include "capture/DnsPacket.hpp"
+#include "capture/NdpPacket.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+constexpr uint32_t OFF_TCP_FLAGS = 13;  ///< Relative to the TCP header
+
+constexpr uint16_t DNS_PORT = 53;
+
+constexpr uint8_t TCP_SYN = 0x02;
+constexpr uint8_t TCP_ACK = 0x10;
+
+constexpr uint8_t ICMPV4_ECHO_REQUEST = 8;
+constexpr uint8_t ICMPV4_REDIRECT = 5;
+constexpr uint8_t ICMPV6_ECHO_REQUEST = 128;
+constexpr uint8_t ICMPV6_ROUTER_ADVERTISEMENT = 134;
+constexpr uint8_t ICMPV6_NEIGHBOR_ADVERTISEMENT = 136;
+
+/// Redirects quote an IP header + 8 bytes behind our own headers: 14 + 2 * (60 + 8)
+constexpr uint32_t REDIRECT_SNAPLEN = 256;
+
+/// Link, IPv4 (with options) and TCP/UDP headers
+constexpr uint32_t HEADERS_SNAPLEN = 128;
+
+/// Initial batch capacity per class; grows once if a block holds more frames
+constexpr std::size_t BATCH_RESERVE = 256;
+
+constexpr uint32_t SKF_PKTTYPE = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PKTTYPE);
+constexpr uint32_t SKF_PROTOCOL = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL);
+constexpr uint32_t SKF_IFINDEX = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_IFINDEX);
+
+/// Interfaces per XDP exclusion block, so every jump fits in 8 bits
+constexpr std::size_t MAX_XDP_INTERFACES = 200;
+
+/// Offsets relative to the network header, whatever the link layer: the ring
+/// also sees tun, WireGuard and PPP links, which have no Ethernet header
+constexpr uint32_t NET_IPV4 = static_cast<uint32_t>(SKF_NET_OFF);
+constexpr uint32_t NET_IPV4_FRAG = NET_IPV4 + 6;
+constexpr uint32_t NET_IPV4_PROTO = NET_IPV4 + 9;
+constexpr uint32_t NET_IPV4_SRC = NET_IPV4 + 12;
+constexpr uint32_t NET_IPV4_DST = NET_IPV4 + 16;
+constexpr uint32_t NET_ARP_SENDER_IP = static_cast<uint32_t>(SKF_NET_OFF + 14);
+constexpr uint32_t NET_ARP_TARGET_IP = static_cast<uint32_t>(SKF_NET_OFF + 24);
+constexpr uint32_t NET_IPV6_NEXT = static_cast<uint32_t>(SKF_NET_OFF + 6);
+constexpr uint32_t NET_IPV6_SRC_LOW = static_cast<uint32_t>(SKF_NET_OFF + 8 + 12);
+constexpr uint32_t NET_IPV6_DST_LOW = static_cast<uint32_t>(SKF_NET_OFF + 24 + 12);
+constexpr uint32_t NET_ICMPV6_TYPE = static_cast<uint32_t>(SKF_NET_OFF + 40);
+
+/// Fibonacci hashing constant, spreads consecutive addresses over the workers
+constexpr uint32_t STEERING_MULTIPLIER = 0x9e3779b1;
+
+/// Unfragmented ICMPv4: inbound echo requests and redirects, anything this host sends
+std::vector<sock_filter> icmpv4_filter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 12),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMP, 0, 10),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_IPV4_FRAG),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 8, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 5, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, NET_IPV4),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, NET_IPV4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMPV4_ECHO_REQUEST, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMPV4_REDIRECT, 0, 2),
+        BPF_STMT(BPF_RET | BPF_K, REDIRECT_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, HEADERS_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+/// Inbound ICMPv6 echo requests directly behind the IPv6 header
+std::vector<sock_filter> icmpv6_echo_filter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 7),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 5, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV6_NEXT),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMPV6, 0, 3),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_ICMPV6_TYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMPV6_ECHO_REQUEST, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, HEADERS_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+/// IPv4 TCP and UDP sent by this host
+std::vector<sock_filter> ipv4_outbound_filter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 4),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, HEADERS_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+/// Inbound IPv4 TCP segments with SYN set and ACK clear
+std::vector<sock_filter> tcp_syn_filter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 11),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 9, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_IPV4_FRAG),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 5, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, NET_IPV4),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, NET_IPV4 + OFF_TCP_FLAGS),
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, TCP_SYN | TCP_ACK),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, TCP_SYN, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, HEADERS_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+/**
+ * @brief Drop what the XDP program already reports: inbound ARP and
+ *        unfragmented ICMPv4 echo requests on its interfaces.
+ *
+ * Unlike the capture blocks it only returns on a match and otherwise falls
+ * through to the next block.
+ */
+std::vector<sock_filter> xdp_exclusion(const std::vector<int>& ifindexes) {
+    auto n = static_cast<uint8_t>(ifindexes.size());
+    const uint8_t next = n + 15;  // First instruction after the block
+    const uint8_t drop = n + 14;
+    const uint8_t check = n + 4;
+    std::vector<sock_filter> block;
+    // Targets are block indexes, 0 meaning "next instruction"
+    auto jump = [&](uint16_t code, uint32_t k, uint8_t jt, uint8_t jf) {
+        auto here = static_cast<uint8_t>(block.size() + 1);
+        block.push_back(BPF_JUMP(BPF_JMP | code, k, static_cast<uint8_t>(jt ? jt - here : 0),
+                                 static_cast<uint8_t>(jf ? jf - here : 0)));
+    };
+
+    block.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE));
+    jump(BPF_JEQ | BPF_K, PACKET_OUTGOING, next, 0);
+    block.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_IFINDEX));
+    for (int ifindex : ifindexes) jump(BPF_JEQ | BPF_K, static_cast<uint32_t>(ifindex), check, 0);
+    block.push_back(BPF_JUMP(BPF_JMP | BPF_JA, static_cast<uint32_t>(next - check), 0, 0));
+
+    block.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL));
+    jump(BPF_JEQ | BPF_K, ETH_P_ARP, drop, 0);
+    jump(BPF_JEQ | BPF_K, ETH_P_IP, 0, next);
+    block.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO));
+    jump(BPF_JEQ | BPF_K, IPPROTO_ICMP, 0, next);
+    block.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_IPV4_FRAG));
+    jump(BPF_JSET | BPF_K, 0x1fff, next, 0);
+    block.push_back(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, NET_IPV4));
+    block.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, NET_IPV4));
+    jump(BPF_JEQ | BPF_K, ICMPV4_ECHO_REQUEST, drop, next);
+    block.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+    return block;
+}
+
+/**
+ * @brief Fanout steering: hash of the remote endpoint (the kernel takes it modulo the group size).
+ *
+ * Frames this host sends are steered by destination (ARP target) and the
+ * others by source (ARP sender), so a request and its reply, a query and
+ * its response, land on the same worker. A redirect is steered by the
+ * destination of the datagram it quotes, like the flow it reports on. IPv6
+ * uses the low 24 bits only: a solicitation sent to a solicited-node
+ * multicast address then hashes like the unicast address that answers it.
+ */
+std::vector<sock_filter> remote_steering() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 15),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 11, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_IPV4_FRAG),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 5, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, NET_IPV4),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, NET_IPV4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ICMPV4_REDIRECT, 0, 2),
+        BPF_STMT(BPF_LD | BPF_W | BPF_IND, NET_IPV4 + 8 + 16),  // Quoted destination
+        BPF_JUMP(BPF_JMP | BPF_JA, 20, 0, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_IPV4_SRC),
+        BPF_JUMP(BPF_JMP | BPF_JA, 18, 0, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_IPV4_DST),
+        BPF_JUMP(BPF_JMP | BPF_JA, 16, 0, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_ARP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 2),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_ARP_TARGET_IP),
+        BPF_JUMP(BPF_JMP | BPF_JA, 11, 0, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_ARP_SENDER_IP),
+        BPF_JUMP(BPF_JMP | BPF_JA, 9, 0, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 7),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 2),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_IPV6_DST_LOW),
+        BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, NET_IPV6_SRC_LOW),
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x00ffffff),
+        BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, STEERING_MULTIPLIER),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+}
+
+uint16_t load_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace
+
+CaptureEngine::~CaptureEngine() {
+    stop();
+}
+
+void CaptureEngine::subscribe(Interest interest, Handler handler) {
+    if (interest == Interest::COUNT || !handler) return;
+    m_handlers[static_cast<std::size_t>(interest)].push_back(std::move(handler));
+}
+
+void CaptureEngine::setWorkers(unsigned count) {
+    if (m_running.load()) return;
+    if (count == 0) {
+        long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+        count = cpus > 0 ? static_cast<unsigned>(cpus) : 1;
+    }
+    m_workerCount = count < MAX_WORKERS ? count : MAX_WORKERS;
+}
+
+bool CaptureEngine::hasSubscribers() const noexcept {
+    for (const auto& handlers : m_handlers) {
+        if (!handlers.empty()) return true;
+    }
+    return false;
+}
+
+std::string CaptureEngine::describe() const {
+    static const char* const NAMES[] = {"ARP", "NDP", "ICMPv4", "ICMPv6 echo", "outbound TCP/UDP", "inbound TCP SYN",
+                                         "DNS"};
+    std::string out;
+    for (std::size_t i = 0; i < m_handlers.size(); ++i) {
+        if (m_handlers[i].empty()) continue;
+        if (!out.empty()) out += ", ";
+        out += NAMES[i];
+    }
+    if (m_workerCount > 1) out += ", " + std::to_string(m_workerCount) + " workers";
+    if (m_xdp.isOpen()) {
+        out += ", XDP folding on ";
+        for (std::size_t i = 0; i < m_xdp.interfaces().size(); ++i) {
+            out += (i ? "/" : "") + m_xdp.interfaces()[i];
+        }
+    }
+    return out;
+}
+
+std::vector<sock_filter> CaptureEngine::buildFilter() const {
+    // Each block is a standalone program ending in "ret snaplen; ret 0" whose
+    // failures all jump to the final "ret 0": dropping that instruction makes
+    // them fall through to the next block instead, so blocks chain as an OR.
+    std::vector<sock_filter> program;
+    if (m_xdp.isOpen()) program = xdp_exclusion(m_xdp.ifindexes());
+    auto append = [&](Interest interest, std::vector<sock_filter> block) {
+        if (m_handlers[static_cast<std::size_t>(interest)].empty() || block.empty()) return;
+        program.insert(program.end(), block.begin(), block.end() - 1);
+    };
+    append(Interest::ARP, arpCaptureFilter());
+    append(Interest::NDP, ndpCaptureFilter());
+    append(Interest::ICMPV4, icmpv4_filter());
+    append(Interest::ICMPV6_ECHO, icmpv6_echo_filter());
+    // Before the outbound block, whose short snaplen would cut queries
+    append(Interest::DNS, dnsCaptureFilter());
+    append(Interest::IPV4_OUTBOUND, ipv4_outbound_filter());
+    append(Interest::TCP_SYN, tcp_syn_filter());
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+    return program;
+}
+
+bool CaptureEngine::enableXdp(const std::vector<std::string>& interfaces, std::string& error) {
+    if (m_running.load()) {
+        error = "capture already running";
+        return false;
+    }
+    if (m_handlers[static_cast<std::size_t>(Interest::ARP)].empty() &&
+        m_handlers[static_cast<std::size_t>(Interest::ICMPV4)].empty()) {
+        error = "no monitor needs ARP or ICMPv4 capture";
+        return false;
+    }
+    if (interfaces.size() > MAX_XDP_INTERFACES) {
+        error = "too many interfaces";
+        return false;
+    }
+    return m_xdp.open(interfaces, error);
+}
+
+bool CaptureEngine::start(std::string& error) {
+    if (m_running.load()) return true;
+    if (!hasSubscribers()) {
+        error = "no monitor needs packet capture";
+        return false;
+    }
+    if (m_wakeup.fd() < 0) {
+        error = "eventfd unavailable";
+        return false;
+    }
+
+    PacketRing::Options options;
+    options.protocol = ETH_P_ALL;
+    options.blockSize = 1u << 17;
+    options.blockCount = 16;
+    options.frameSize = 256;
+    options.retireTimeoutMs = RETIRE_TIMEOUT_MS;
+    options.filter = buildFilter();
+    if (m_workerCount > 1) {
+        options.fanout = true;
+        options.fanoutGroup = static_cast<uint16_t>(::getpid());
+        options.fanoutType = PACKET_FANOUT_CBPF;
+        options.fanoutProgram = remote_steering();
+    }
+
+    m_workers.clear();
+    for (unsigned i = 0; i < m_workerCount; ++i) {
+        auto worker = std::make_unique<Worker>();
+        for (std::size_t c = 0; c < worker->pending.size(); ++c) {
+            if (!m_handlers[c].empty()) worker->pending[c].reserve(BATCH_RESERVE);
+        }
+        if (!worker->ring.open(options, error)) {
+            m_workers.clear();
+            return false;
+        }
+        m_workers.push_back(std::move(worker));
+    }
+
+    // Workers leave on the wakeup without consuming it, so clear any earlier stop()
+    m_wakeup.drain();
+    m_running.store(true);
+    for (unsigned i = 0; i < m_workerCount; ++i) {
+        m_workers[i]->thread = std::thread(&CaptureEngine::loop, this, i);
+    }
+    return true;
+}
+
+void CaptureEngine::stop() {
+    bool expected = true;
+    if (m_running.compare_exchange_strong(expected, false)) {
+        m_wakeup.notify();
+    }
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+        worker->ring.close();
+    }
+    m_xdp.close();
+}
+
+PacketRing::Stats CaptureEngine::stats() {
+    PacketRing::Stats total;
+    for (auto& worker : m_workers) {
+        PacketRing::Stats st = worker->ring.stats();
+        total.packets += st.packets;
+        total.drops += st.drops;
+    }
+    return total;
+}
+
+void CaptureEngine::classify(const PacketFrame& frame, Worker& worker, unsigned index, uint32_t count) {
+    PacketView view;
+    view.frame = frame;
+    view.worker = index;
+    view.count = count;
+    view.ethertype = ntohs(frame.protocol);
+    view.l3 = frame.network;
+    view.l3Len = frame.networkLen;
+    view.outgoing = frame.pkttype == PACKET_OUTGOING;
+
+    auto deliver = [&](Interest interest) {
+        std::size_t c = static_cast<std::size_t>(interest);
+        if (!m_handlers[c].empty()) worker.pending[c].push_back(view);
+    };
+    // Queries leave towards port 53, responses arrive from it
+    auto deliver_dns = [&] {
+        if (!view.l4 || view.l4Len < 8) return;
+        if (load_be16(view.l4 + (view.outgoing ? 2 : 0)) == DNS_PORT) deliver(Interest::DNS);
+    };
+
+    if (view.ethertype == ETH_P_ARP) {
+        deliver(Interest::ARP);
+        return;
+    }
+    if (!view.l3 || view.l3Len < 20) return;
+
+    if (view.ethertype == ETH_P_IP && (view.l3[0] >> 4) == 4) {
+        uint32_t ihl = static_cast<uint32_t>(view.l3[0] & 0x0f) * 4;
+        if (ihl < 20 || view.l3Len < ihl) return;
+        view.ipVersion = 4;
+        view.ipProto = view.l3[9];
+        if ((load_be16(view.l3 + 6) & 0x1fff) == 0) {
+            view.l4 = view.l3 + ihl;
+            view.l4Len = view.l3Len - ihl;
+        }
+
+        if (view.ipProto == IPPROTO_ICMP) {
+            deliver(Interest::ICMPV4);
+        } else if (view.ipProto == IPPROTO_TCP || view.ipProto == IPPROTO_UDP) {
+            if (view.ipProto == IPPROTO_UDP) deliver_dns();
+            if (view.outgoing) {
+                deliver(Interest::IPV4_OUTBOUND);
+            } else if (view.ipProto == IPPROTO_TCP && view.l4 && view.l4Len > OFF_TCP_FLAGS &&
+                       (view.l4[OFF_TCP_FLAGS] & (TCP_SYN | TCP_ACK)) == TCP_SYN) {
+                deliver(Interest::TCP_SYN);
+            }
+        }
+        return;
+    }
+
+    if (view.ethertype == ETH_P_IPV6 && (view.l3[0] >> 4) == 6 && view.l3Len >= 40) {
+        view.ipVersion = 6;
+        view.ipProto = view.l3[6];
+        view.l4 = view.l3 + 40;
+        view.l4Len = view.l3Len - 40;
+        if (view.ipProto == IPPROTO_UDP) {
+            deliver_dns();
+            return;
+        }
+        if (view.ipProto != IPPROTO_ICMPV6 || view.l4Len < 2 || view.l4[1] != 0) return;
+        if (view.l4[0] >= ICMPV6_ROUTER_ADVERTISEMENT && view.l4[0] <= ICMPV6_NEIGHBOR_ADVERTISEMENT) {
+            deliver(Interest::NDP);
+        } else if (view.l4[0] == ICMPV6_ECHO_REQUEST && !view.outgoing) {
+            deliver(Interest::ICMPV6_ECHO);
+        }
+    }
+}
+
+void CaptureEngine::flush(Worker& worker) {
+    for (std::size_t c = 0; c < worker.pending.size(); ++c) {
+        std::vector<PacketView>& views = worker.pending[c];
+        if (views.empty()) continue;
+        for (const Handler& handler : m_handlers[c]) handler(views.data(), views.size());
+        views.clear();
+    }
+}
+
+void CaptureEngine::loop(unsigned index) {
+    Worker& worker = *m_workers[index];
+    PacketRing& ring = worker.ring;
+    // poll() skips negative descriptors: only worker 0 reads the XDP records
+    int xdpFd = index == 0 && m_xdp.isOpen() ? m_xdp.fd() : -1;
+    pollfd fds[3] = {{m_wakeup.fd(), POLLIN, 0}, {ring.fd(), POLLIN, 0}, {xdpFd, POLLIN, 0}};
+    while (m_running.load()) {
+        if (::poll(fds, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // The wakeup is shared by every worker: leave it readable for the others
+        if (!m_running.load()) break;
+        if (fds[1].revents & POLLIN) {
+            ring.drain([&](const PacketFrame& frame) { classify(frame, worker, index); },
+                       [&] { flush(worker); });
+        }
+        if (fds[2].revents & POLLIN) {
+            m_xdp.drain([&](const PacketFrame& frame, uint32_t count) { classify(frame, worker, index, count); },
+                        [&] { flush(worker); });
+        }
+    }
+}
+
+} // namespace capture
@@ -0,0 +1,258 @@
+/**
+ * @file DnsPacket.cpp
+ * @brief Decoded view of a captured DNS-over-UDP datagram.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/DnsPacket.hpp"
+
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+
+namespace capture {
+
+namespace {
+
+/// Ethernet + IPv6 + UDP headers + a 1232-byte EDNS message, rounded up
+constexpr uint32_t DNS_SNAPLEN = 1300;
+
+constexpr uint32_t SKF_PROTOCOL = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL);
+constexpr uint32_t SKF_PKTTYPE = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PKTTYPE);
+
+// Relative to the network header, so the filter works on any link type
+constexpr uint32_t NET_IPV4 = static_cast<uint32_t>(SKF_NET_OFF);
+constexpr uint32_t NET_IPV4_FRAG = NET_IPV4 + 6;
+constexpr uint32_t NET_IPV4_PROTO = NET_IPV4 + 9;
+constexpr uint32_t NET_IPV6_NEXT = static_cast<uint32_t>(SKF_NET_OFF + 6);
+constexpr uint32_t NET_UDP6 = static_cast<uint32_t>(SKF_NET_OFF + 40);
+
+constexpr uint16_t DNS_PORT = 53;
+constexpr uint32_t DNS_HEADER_LEN = 12;
+constexpr uint32_t UDP_HEADER_LEN = 8;
+
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t TYPE_AAAA = 28;
+
+/// Longest encoded name (RFC 1035), which also bounds the label count
+constexpr uint32_t MAX_NAME_LEN = 255;
+
+uint16_t load_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t load_be32(const uint8_t* p) noexcept {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+/// ::ffff:a.b.c.d from an IPv4 address in the packet
+Ipv6Addr mapped_ipv4(const uint8_t* p) noexcept {
+    Ipv6Addr addr;
+    addr.lo = 0xffff00000000ull | load_be32(p);
+    return addr;
+}
+
+/**
+ * @brief Step over an encoded name, compressed or not.
+ * @return False if the name runs past len or is malformed.
+ */
+bool skip_name(const uint8_t* msg, uint32_t len, uint32_t& offset) noexcept {
+    for (uint32_t total = 0;;) {
+        if (offset >= len) return false;
+        uint8_t label = msg[offset];
+        if (label == 0) {
+            offset += 1;
+            return true;
+        }
+        if ((label & 0xc0) == 0xc0) {
+            if (offset + 2 > len) return false;
+            offset += 2;
+            return true;
+        }
+        if (label & 0xc0) return false;
+        offset += 1 + label;
+        total += 1 + label;
+        // The root label still has to fit
+        if (total >= MAX_NAME_LEN) return false;
+    }
+}
+
+/**
+ * @brief Hash the uncompressed first question name, ASCII case folded.
+ * @return False if the name is compressed, too long or truncated.
+ */
+bool hash_name(const uint8_t* msg, uint32_t len, uint32_t& offset, uint64_t& hash) noexcept {
+    hash = 0xcbf29ce484222325ull;
+    for (uint32_t total = 0;;) {
+        if (offset >= len) return false;
+        uint8_t label = msg[offset];
+        if (label & 0xc0) return false;
+        if (offset + 1 + label > len) return false;
+        total += 1 + label;
+        if (total > MAX_NAME_LEN) return false;
+        for (uint32_t i = 0; i <= label; ++i) {
+            uint8_t c = msg[offset + i];
+            if (i > 0 && c >= 'A' && c <= 'Z') c = static_cast<uint8_t>(c + ('a' - 'A'));
+            hash = (hash ^ c) * 0x100000001b3ull;
+        }
+        offset += 1 + label;
+        if (label == 0) return true;
+    }
+}
+
+} // namespace
+
+bool DnsAnswerReader::next(DnsRecord& record) noexcept {
+    if (m_remaining == 0) return false;
+    uint32_t offset = m_offset;
+    if (!skip_name(m_message, m_len, offset) || offset + 10 > m_len) {
+        m_remaining = 0;
+        return false;
+    }
+    record.type = load_be16(m_message + offset);
+    record.rclass = load_be16(m_message + offset + 2);
+    record.ttl = load_be32(m_message + offset + 4);
+    record.rdataLen = load_be16(m_message + offset + 8);
+    offset += 10;
+    if (offset + record.rdataLen > m_len) {
+        m_remaining = 0;
+        return false;
+    }
+    record.rdata = m_message + offset;
+    m_offset = offset + record.rdataLen;
+    --m_remaining;
+    return true;
+}
+
+bool parseDnsDatagram(const uint8_t* l3, uint32_t l3Len, DnsPacket& dns) noexcept {
+    if (!l3 || l3Len < 20) return false;
+
+    const uint8_t* udp = nullptr;
+    uint32_t udpAvail = 0;
+    if ((l3[0] >> 4) == 4) {
+        uint32_t ihl = static_cast<uint32_t>(l3[0] & 0x0f) * 4;
+        if (ihl < 20 || l3Len < ihl || l3[9] != IPPROTO_UDP || (load_be16(l3 + 6) & 0x1fff) != 0) return false;
+        dns.source = mapped_ipv4(l3 + 12);
+        dns.destination = mapped_ipv4(l3 + 16);
+        udp = l3 + ihl;
+        udpAvail = l3Len - ihl;
+    } else if ((l3[0] >> 4) == 6) {
+        if (l3Len < 40 || l3[6] != IPPROTO_UDP) return false;
+        dns.source = NetAddr::packIpv6(l3 + 8);
+        dns.destination = NetAddr::packIpv6(l3 + 24);
+        udp = l3 + 40;
+        udpAvail = l3Len - 40;
+    } else {
+        return false;
+    }
+    if (udpAvail < UDP_HEADER_LEN + DNS_HEADER_LEN) return false;
+
+    uint32_t udpLen = load_be16(udp + 4);
+    if (udpLen < UDP_HEADER_LEN + DNS_HEADER_LEN) return false;
+    dns.sourcePort = load_be16(udp);
+    dns.destinationPort = load_be16(udp + 2);
+    return parseDnsMessage(udp + UDP_HEADER_LEN, (udpLen < udpAvail ? udpLen : udpAvail) - UDP_HEADER_LEN, dns);
+}
+
+bool parseDnsMessage(const uint8_t* message, uint32_t len, DnsPacket& dns) noexcept {
+    if (!message || len < DNS_HEADER_LEN) return false;
+    dns.message = message;
+    dns.messageLen = len;
+
+    const uint8_t* msg = dns.message;
+    uint16_t flags = load_be16(msg + 2);
+    dns.id = load_be16(msg);
+    dns.response = (flags & 0x8000) != 0;
+    dns.opcode = static_cast<uint8_t>((flags >> 11) & 0x0f);
+    dns.truncated = (flags & 0x0200) != 0;
+    dns.rcode = static_cast<uint8_t>(flags & 0x0f);
+    dns.questionCount = load_be16(msg + 4);
+    dns.answerCount = load_be16(msg + 6);
+
+    uint32_t offset = DNS_HEADER_LEN;
+    dns.qtype = 0;
+    dns.qclass = 0;
+    dns.questionHash = 0;
+    dns.questionNameLen = 0;
+    for (uint16_t q = 0; q < dns.questionCount; ++q) {
+        uint64_t hash = 0;
+        bool named = q == 0 ? hash_name(msg, dns.messageLen, offset, hash) : skip_name(msg, dns.messageLen, offset);
+        if (!named || offset + 4 > dns.messageLen) return false;
+        if (q == 0) {
+            dns.questionNameLen = static_cast<uint16_t>(offset - DNS_HEADER_LEN);
+            dns.qtype = load_be16(msg + offset);
+            dns.qclass = load_be16(msg + offset + 2);
+            // Never 0, which stands for "no question"
+            dns.questionHash = hashMix64(hash ^ (static_cast<uint64_t>(dns.qtype) << 16 | dns.qclass)) | 1;
+        }
+        offset += 4;
+    }
+    dns.answerOffset = offset;
+    return true;
+}
+
+uint64_t dnsAnswerDigest(const DnsPacket& dns) noexcept {
+    uint64_t digest = hashMix64(dns.rcode + 1);
+    DnsAnswerReader reader(dns);
+    DnsRecord record;
+    while (reader.next(record)) {
+        // A sum does not depend on the record order, which resolvers shuffle
+        if (record.type == TYPE_A && record.rdataLen == 4) {
+            digest += hashMix64(static_cast<uint64_t>(TYPE_A) << 32 | load_be32(record.rdata));
+        } else if (record.type == TYPE_AAAA && record.rdataLen == 16) {
+            Ipv6Addr addr = NetAddr::packIpv6(record.rdata);
+            digest += FlatHash<Ipv6Addr>{}(addr) ^ TYPE_AAAA;
+        }
+    }
+    return digest;
+}
+
+std::string dnsQuestionName(const DnsPacket& dns) {
+    std::string name;
+    if (dns.questionCount == 0) return ".";
+    for (uint32_t offset = DNS_HEADER_LEN; offset < dns.messageLen;) {
+        uint8_t label = dns.message[offset];
+        if (label == 0 || (label & 0xc0) || offset + 1 + label > dns.messageLen) break;
+        if (!name.empty()) name += '.';
+        for (uint32_t i = 1; i <= label; ++i) {
+            char c = static_cast<char>(dns.message[offset + i]);
+            name += c > ' ' && c < 127 ? c : '?';
+        }
+        offset += 1 + label;
+    }
+    return name.empty() ? "." : name;
+}
+
+std::vector<sock_filter> dnsCaptureFilter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 11),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV4_PROTO),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 19),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_IPV4_FRAG),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 17, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, NET_IPV4),
+        // Queries leave towards port 53, responses arrive from it
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 2),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, NET_IPV4 + 2),
+        BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, NET_IPV4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DNS_PORT, 9, 10),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 9),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, NET_IPV6_NEXT),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 2),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_UDP6 + 2),
+        BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, NET_UDP6),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DNS_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, DNS_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+} // namespace capture
@@ -0,0 +1,174 @@
+/**
+ * @file NdpPacket.cpp
+ * @brief Decoded views of captured IPv6 Neighbor Discovery messages (NS, NA, RA).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/NdpPacket.hpp"
+
+#include <linux/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+namespace capture {
+
+namespace {
+
+constexpr uint32_t IPV6_HLEN = 40;
+constexpr uint8_t IPPROTO_ICMPV6_NUM = 58;
+
+/// ICMPv6 header (4) + reserved/flags (4) + target address (16)
+constexpr uint32_t ND_MSG_LEN = 24;
+
+/// ICMPv6 header (4) + hop limit, flags, lifetime (4) + reachable and retrans timers (8)
+constexpr uint32_t RA_MSG_LEN = 16;
+
+constexpr uint8_t TYPE_ROUTER_ADVERTISEMENT = 134;
+
+constexpr uint8_t OPT_SOURCE_LLADDR = 1;
+constexpr uint8_t OPT_TARGET_LLADDR = 2;
+constexpr uint8_t OPT_PREFIX_INFO = 3;
+constexpr uint32_t PREFIX_INFO_LEN = 32;
+
+/// Offsets used by the kernel filter, relative to the network header (fixed IPv6 header)
+constexpr uint32_t SKF_PROTOCOL = static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL);
+constexpr uint32_t OFF_NEXT_HEADER = static_cast<uint32_t>(SKF_NET_OFF + 6);
+constexpr uint32_t OFF_ICMP_TYPE = static_cast<uint32_t>(SKF_NET_OFF + IPV6_HLEN);
+constexpr uint32_t OFF_ICMP_CODE = OFF_ICMP_TYPE + 1;
+
+/// RAs with a handful of options fit easily; longer frames are truncated by the kernel
+constexpr uint32_t FILTER_SNAPLEN = 1024;
+
+uint16_t load_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t load_be32(const uint8_t* p) noexcept {
+    return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | p[3];
+}
+
+/**
+ * @brief Locate the ICMPv6 message of an Ethernet/IPv6 frame without extension headers.
+ * @param[out] icmp Start of the ICMPv6 header.
+ * @param[out] icmpLen Captured ICMPv6 bytes, bounded by the IPv6 payload length.
+ * @return False if the frame is not ICMPv6.
+ */
+bool locate_icmpv6(const PacketFrame& frame, const uint8_t*& icmp, uint32_t& icmpLen) noexcept {
+    if (frame.hatype != ARPHRD_ETHER || frame.caplen < ETH_HLEN) return false;
+    if (!frame.network || frame.networkLen < IPV6_HLEN + 4) return false;
+
+    const uint8_t* ip = frame.network;
+    if ((ip[0] >> 4) != 6 || ip[6] != IPPROTO_ICMPV6_NUM) return false;
+
+    icmpLen = load_be16(ip + 4);
+    if (icmpLen > frame.networkLen - IPV6_HLEN) icmpLen = frame.networkLen - IPV6_HLEN;
+    icmp = ip + IPV6_HLEN;
+    return true;
+}
+
+} // namespace
+
+bool parseNdpFrame(const PacketFrame& frame, NdpPacket& ndp) noexcept {
+    const uint8_t* icmp = nullptr;
+    uint32_t icmpLen = 0;
+    if (!locate_icmpv6(frame, icmp, icmpLen) || icmpLen < ND_MSG_LEN || icmp[1] != 0) return false;
+
+    const uint8_t* ip = frame.network;
+    if (icmp[0] == static_cast<uint8_t>(NdpPacket::Type::NEIGHBOR_SOLICITATION)) {
+        ndp.type = NdpPacket::Type::NEIGHBOR_SOLICITATION;
+        ndp.router = ndp.solicited = ndp.override = false;
+    } else if (icmp[0] == static_cast<uint8_t>(NdpPacket::Type::NEIGHBOR_ADVERTISEMENT)) {
+        ndp.type = NdpPacket::Type::NEIGHBOR_ADVERTISEMENT;
+        ndp.router = (icmp[4] & 0x80) != 0;
+        ndp.solicited = (icmp[4] & 0x40) != 0;
+        ndp.override = (icmp[4] & 0x20) != 0;
+    } else {
+        return false;
+    }
+
+    ndp.ethSrc = NetAddr::packMac(frame.data + ETH_ALEN);
+    ndp.source = NetAddr::packIpv6(ip + 8);
+    ndp.destination = NetAddr::packIpv6(ip + 24);
+    ndp.target = NetAddr::packIpv6(icmp + 8);
+    ndp.hopLimit = ip[7];
+
+    // Options are length-prefixed in units of 8 octets; a zero length is invalid
+    uint8_t wanted = ndp.type == NdpPacket::Type::NEIGHBOR_SOLICITATION ? OPT_SOURCE_LLADDR : OPT_TARGET_LLADDR;
+    ndp.linkAddr = 0;
+    for (uint32_t off = ND_MSG_LEN; off + 2 <= icmpLen;) {
+        uint32_t optLen = uint32_t{icmp[off + 1]} * 8;
+        if (optLen == 0 || off + optLen > icmpLen) return false;
+        if (icmp[off] == wanted && optLen >= 8) ndp.linkAddr = NetAddr::packMac(icmp + off + 2);
+        off += optLen;
+    }
+
+    ndp.tsSec = frame.tsSec;
+    ndp.tsNsec = frame.tsNsec;
+    ndp.ifindex = frame.ifindex;
+    ndp.outgoing = frame.pkttype == PACKET_OUTGOING;
+    return true;
+}
+
+bool parseRaFrame(const PacketFrame& frame, RaPacket& ra) noexcept {
+    const uint8_t* icmp = nullptr;
+    uint32_t icmpLen = 0;
+    if (!locate_icmpv6(frame, icmp, icmpLen) || icmpLen < RA_MSG_LEN) return false;
+    if (icmp[0] != TYPE_ROUTER_ADVERTISEMENT || icmp[1] != 0) return false;
+
+    const uint8_t* ip = frame.network;
+    ra.ethSrc = NetAddr::packMac(frame.data + ETH_ALEN);
+    ra.source = NetAddr::packIpv6(ip + 8);
+    ra.hopLimit = ip[7];
+    ra.curHopLimit = icmp[4];
+    ra.managed = (icmp[5] & 0x80) != 0;
+    ra.otherConfig = (icmp[5] & 0x40) != 0;
+    ra.routerLifetime = load_be16(icmp + 6);
+    ra.linkAddr = 0;
+    ra.prefixCount = 0;
+
+    // A truncated trailing option is skipped rather than discarding the whole RA
+    for (uint32_t off = RA_MSG_LEN; off + 2 <= icmpLen;) {
+        uint32_t optLen = uint32_t{icmp[off + 1]} * 8;
+        if (optLen == 0) return false;
+        if (off + optLen > icmpLen) break;
+
+        const uint8_t* opt = icmp + off;
+        if (opt[0] == OPT_SOURCE_LLADDR && optLen >= 8) {
+            ra.linkAddr = NetAddr::packMac(opt + 2);
+        } else if (opt[0] == OPT_PREFIX_INFO && optLen == PREFIX_INFO_LEN &&
+                   ra.prefixCount < RaPacket::MAX_PREFIXES) {
+            RaPacket::Prefix& p = ra.prefixes[ra.prefixCount++];
+            p.length = opt[2];
+            p.onLink = (opt[3] & 0x80) != 0;
+            p.autonomous = (opt[3] & 0x40) != 0;
+            p.validLifetime = load_be32(opt + 4);
+            p.preferredLifetime = load_be32(opt + 8);
+            p.prefix = NetAddr::packIpv6(opt + 16);
+        }
+        off += optLen;
+    }
+
+    ra.tsSec = frame.tsSec;
+    ra.ifindex = frame.ifindex;
+    ra.outgoing = frame.pkttype == PACKET_OUTGOING;
+    return true;
+}
+
+std::vector<sock_filter> ndpCaptureFilter() {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_PROTOCOL),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 8),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, OFF_NEXT_HEADER),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMPV6_NUM, 0, 6),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, OFF_ICMP_CODE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 4),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, OFF_ICMP_TYPE),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, TYPE_ROUTER_ADVERTISEMENT, 0, 2),
+        BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, static_cast<uint8_t>(NdpPacket::Type::NEIGHBOR_ADVERTISEMENT), 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, FILTER_SNAPLEN),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+} // namespace capture
@@ -0,0 +1,161 @@
+/**
+ * @file PacketRing.cpp
+ * @brief Memory-mapped AF_PACKET receive ring (TPACKET_V3) for passive capture.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/PacketRing.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+std::string errno_message(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+PacketRing::~PacketRing() {
+    close();
+}
+
+bool PacketRing::open(const Options& options, std::string& error) {
+    close();
+
+    // Protocol 0 receives nothing until bind(), so no frame bypasses the filter
+    m_fd = ::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        error = errno_message("socket(AF_PACKET)");
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        error = errno_message("PACKET_VERSION");
+        close();
+        return false;
+    }
+
+    if (!options.filter.empty()) {
+        sock_fprog prog{};
+        prog.len = static_cast<unsigned short>(options.filter.size());
+        prog.filter = const_cast<sock_filter*>(options.filter.data());
+        if (setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+            error = errno_message("SO_ATTACH_FILTER");
+            close();
+            return false;
+        }
+    }
+
+    tpacket_req3 req{};
+    req.tp_block_size = options.blockSize;
+    req.tp_block_nr = options.blockCount;
+    req.tp_frame_size = options.frameSize;
+    req.tp_frame_nr = (options.blockSize / options.frameSize) * options.blockCount;
+    req.tp_retire_blk_tov = options.retireTimeoutMs;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        error = errno_message("PACKET_RX_RING");
+        close();
+        return false;
+    }
+
+    m_mapSize = static_cast<std::size_t>(options.blockSize) * options.blockCount;
+    void* map = ::mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, 0);
+    if (map == MAP_FAILED) {
+        error = errno_message("mmap(PACKET_RX_RING)");
+        m_mapSize = 0;
+        close();
+        return false;
+    }
+    m_map = static_cast<uint8_t*>(map);
+    m_blockSize = options.blockSize;
+    m_blockCount = options.blockCount;
+    m_current = 0;
+
+    sockaddr_ll addr{};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(options.protocol);
+    if (!options.interface.empty()) {
+        addr.sll_ifindex = static_cast<int>(if_nametoindex(options.interface.c_str()));
+        if (addr.sll_ifindex == 0) {
+            error = "unknown interface " + options.interface;
+            close();
+            return false;
+        }
+    }
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        error = errno_message("bind(AF_PACKET)");
+        close();
+        return false;
+    }
+
+    // Fanout groups can only be joined by bound sockets
+    if (options.fanout) {
+        int fanout = options.fanoutGroup | (options.fanoutType << 16);
+        if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+            error = errno_message("PACKET_FANOUT");
+            close();
+            return false;
+        }
+        if (!options.fanoutProgram.empty()) {
+            sock_fprog prog{};
+            prog.len = static_cast<unsigned short>(options.fanoutProgram.size());
+            prog.filter = const_cast<sock_filter*>(options.fanoutProgram.data());
+            if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog)) < 0) {
+                error = errno_message("PACKET_FANOUT_DATA");
+                close();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void PacketRing::close() noexcept {
+    if (m_map) {
+        ::munmap(m_map, m_mapSize);
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+PacketRing::Stats PacketRing::stats() {
+    if (m_fd >= 0) {
+        // The kernel resets its counters on every read
+        tpacket_stats_v3 st{};
+        socklen_t len = sizeof(st);
+        if (getsockopt(m_fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == 0) {
+            m_stats.packets += st.tp_packets;
+            m_stats.drops += st.tp_drops;
+        }
+    }
+    return m_stats;
+}
+
+tpacket_block_desc* PacketRing::readyBlock() const noexcept {
+    if (!m_map) return nullptr;
+    auto* block = reinterpret_cast<tpacket_block_desc*>(m_map + static_cast<std::size_t>(m_current) * m_blockSize);
+    uint32_t status = __atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+    return (status & TP_STATUS_USER) ? block : nullptr;
+}
+
+void PacketRing::releaseBlock(tpacket_block_desc* block) noexcept {
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    m_current = (m_current + 1) % m_blockCount;
+}
+
+} // namespace capture
@@ -0,0 +1,395 @@
+/**
+ * @file XdpAggregator.cpp
+ * @brief Optional XDP program folding repeated ARP frames and ICMP echo requests in the kernel.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "capture/XdpAggregator.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <ctime>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+/// Folding state of one key: time of the last record and repeats since
+struct Fold {
+    uint64_t lastNs;
+    uint64_t pending;
+};
+
+/// Source MAC, then the whole ARP body (bytes 6 to 42 of the frame, ethertype included)
+constexpr uint32_t ARP_KEY_SIZE = 36;
+
+/// IPv4 source and destination
+constexpr uint32_t ECHO_KEY_SIZE = 8;
+
+constexpr uint32_t ARP_FOLD_ENTRIES = 4096;
+constexpr uint32_t ECHO_FOLD_ENTRIES = 8192;
+constexpr uint32_t RING_BYTES = 256 * 1024;
+
+/// Smallest frame handled: Ethernet + ARP, or Ethernet + IPv4 + the ICMP type
+constexpr int32_t MIN_FRAME = 42;
+
+constexpr int32_t FOLD_INTERVAL_NS = 1000000000;
+
+constexpr uint8_t ICMP_ECHO_REQUEST = 8;
+
+std::string errno_message(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+long bpf(int cmd, bpf_attr& attr) {
+    return ::syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+}
+
+int create_map(bpf_map_type type, uint32_t keySize, uint32_t valueSize, uint32_t maxEntries, const char* name) {
+    bpf_attr attr{};
+    attr.map_type = type;
+    attr.key_size = keySize;
+    attr.value_size = valueSize;
+    attr.max_entries = maxEntries;
+    std::strncpy(attr.map_name, name, sizeof(attr.map_name) - 1);
+    return static_cast<int>(bpf(BPF_MAP_CREATE, attr));
+}
+
+int64_t clock_ns(clockid_t clock) {
+    timespec ts{};
+    ::clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Minimal eBPF assembler with forward labels.
+ */
+class Assembler {
+public:
+    enum Label { PASS, SNAP_OK, ARP, FOLD, FOUND, FLUSH, EMIT, DISCARD, LABEL_COUNT };
+
+    void mark(Label label) { m_labels[label] = static_cast<int>(m_insns.size()); }
+
+    void emit(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+        bpf_insn insn{};
+        insn.code = code;
+        insn.dst_reg = dst & 0x0f;
+        insn.src_reg = src & 0x0f;
+        insn.off = off;
+        insn.imm = imm;
+        m_insns.push_back(insn);
+    }
+
+    void mov(uint8_t dst, int32_t imm) { emit(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm); }
+    void movReg(uint8_t dst, uint8_t src) { emit(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0); }
+    void alu(uint8_t op, uint8_t dst, int32_t imm) { emit(BPF_ALU64 | op | BPF_K, dst, 0, 0, imm); }
+    void aluReg(uint8_t op, uint8_t dst, uint8_t src) { emit(BPF_ALU64 | op | BPF_X, dst, src, 0, 0); }
+    void load(uint8_t size, uint8_t dst, uint8_t src, int16_t off) { emit(BPF_LDX | size | BPF_MEM, dst, src, off, 0); }
+    void store(uint8_t size, uint8_t dst, int16_t off, uint8_t src) { emit(BPF_STX | size | BPF_MEM, dst, src, off, 0); }
+    void storeImm(uint8_t size, uint8_t dst, int16_t off, int32_t imm) { emit(BPF_ST | size | BPF_MEM, dst, 0, off, imm); }
+    void atomic(int32_t op, uint8_t dst, int16_t off, uint8_t src) { emit(BPF_STX | BPF_DW | BPF_ATOMIC, dst, src, off, op); }
+    void call(int32_t helper) { emit(BPF_JMP | BPF_CALL, 0, 0, 0, helper); }
+    void exit() { emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0); }
+
+    void loadMap(uint8_t dst, int fd) {
+        emit(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, fd);
+        emit(0, 0, 0, 0, 0);
+    }
+
+    void jump(uint8_t op, uint8_t dst, int32_t imm, Label target) {
+        m_fixups.push_back({m_insns.size(), target});
+        emit(BPF_JMP | op | BPF_K, dst, 0, 0, imm);
+    }
+
+    void jumpReg(uint8_t op, uint8_t dst, uint8_t src, Label target) {
+        m_fixups.push_back({m_insns.size(), target});
+        emit(BPF_JMP | op | BPF_X, dst, src, 0, 0);
+    }
+
+    void jumpAlways(Label target) { jump(BPF_JA, 0, 0, target); }
+
+    /** @brief Resolve the jumps and return the program. */
+    std::vector<bpf_insn> finish() {
+        for (const auto& [index, label] : m_fixups) {
+            m_insns[index].off = static_cast<int16_t>(m_labels[label] - static_cast<int>(index) - 1);
+        }
+        return m_insns;
+    }
+
+private:
+    std::vector<bpf_insn> m_insns;
+    std::vector<std::pair<std::size_t, Label>> m_fixups;
+    int m_labels[LABEL_COUNT] = {};
+};
+
+/**
+ * @brief Build the XDP program.
+ *
+ * Registers: r6 context, r7 bytes to copy, r8 key pointer then record count,
+ * r9 fold map then fold value then record. Stack: -8 echo key, -40 ARP key,
+ * -48 timestamp, -64 new fold value.
+ */
+std::vector<bpf_insn> build_program(int arpFolds, int echoFolds, int events) {
+    using A = Assembler;
+    A a;
+
+    a.movReg(BPF_REG_6, BPF_REG_1);
+    a.call(BPF_FUNC_xdp_get_buff_len);
+    a.jump(BPF_JLT, BPF_REG_0, MIN_FRAME, A::PASS);
+    a.jump(BPF_JLE, BPF_REG_0, XdpAggregator::SNAPLEN, A::SNAP_OK);
+    a.mov(BPF_REG_0, XdpAggregator::SNAPLEN);
+    a.mark(A::SNAP_OK);
+    a.movReg(BPF_REG_7, BPF_REG_0);
+
+    // Direct access to the first MIN_FRAME bytes
+    a.load(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(xdp_md, data));
+    a.load(BPF_W, BPF_REG_3, BPF_REG_6, offsetof(xdp_md, data_end));
+    a.movReg(BPF_REG_4, BPF_REG_2);
+    a.alu(BPF_ADD, BPF_REG_4, MIN_FRAME);
+    a.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, A::PASS);
+
+    a.load(BPF_H, BPF_REG_5, BPF_REG_2, 12);
+    a.jump(BPF_JEQ, BPF_REG_5, htons(ETH_P_ARP), A::ARP);
+    a.jump(BPF_JNE, BPF_REG_5, htons(ETH_P_IP), A::PASS);
+
+    // Unfragmented IPv4 ICMP echo request, any header length
+    a.load(BPF_B, BPF_REG_5, BPF_REG_2, 14 + 9);
+    a.jump(BPF_JNE, BPF_REG_5, IPPROTO_ICMP, A::PASS);
+    a.load(BPF_H, BPF_REG_5, BPF_REG_2, 14 + 6);
+    a.alu(BPF_AND, BPF_REG_5, htons(0x1fff));
+    a.jump(BPF_JNE, BPF_REG_5, 0, A::PASS);
+    a.load(BPF_B, BPF_REG_5, BPF_REG_2, 14);
+    a.alu(BPF_AND, BPF_REG_5, 0x0f);
+    a.alu(BPF_LSH, BPF_REG_5, 2);
+    a.movReg(BPF_REG_4, BPF_REG_2);
+    a.alu(BPF_ADD, BPF_REG_4, 14);
+    a.aluReg(BPF_ADD, BPF_REG_4, BPF_REG_5);
+    a.movReg(BPF_REG_5, BPF_REG_4);
+    a.alu(BPF_ADD, BPF_REG_5, 1);
+    a.jumpReg(BPF_JGT, BPF_REG_5, BPF_REG_3, A::PASS);
+    a.load(BPF_B, BPF_REG_5, BPF_REG_4, 0);
+    a.jump(BPF_JNE, BPF_REG_5, ICMP_ECHO_REQUEST, A::PASS);
+
+    a.load(BPF_W, BPF_REG_5, BPF_REG_2, 14 + 12);
+    a.store(BPF_W, BPF_REG_10, -8, BPF_REG_5);
+    a.load(BPF_W, BPF_REG_5, BPF_REG_2, 14 + 16);
+    a.store(BPF_W, BPF_REG_10, -4, BPF_REG_5);
+    a.movReg(BPF_REG_8, BPF_REG_10);
+    a.alu(BPF_ADD, BPF_REG_8, -static_cast<int32_t>(ECHO_KEY_SIZE));
+    a.loadMap(BPF_REG_9, echoFolds);
+    a.jumpAlways(A::FOLD);
+
+    a.mark(A::ARP);
+    for (int16_t i = 0; i < static_cast<int16_t>(ARP_KEY_SIZE); i += 4) {
+        a.load(BPF_W, BPF_REG_5, BPF_REG_2, static_cast<int16_t>(6 + i));
+        a.store(BPF_W, BPF_REG_10, static_cast<int16_t>(-40 + i), BPF_REG_5);
+    }
+    a.movReg(BPF_REG_8, BPF_REG_10);
+    a.alu(BPF_ADD, BPF_REG_8, -40);
+    a.loadMap(BPF_REG_9, arpFolds);
+
+    // First frame of a key: remember it and report it
+    a.mark(A::FOLD);
+    a.movReg(BPF_REG_1, BPF_REG_9);
+    a.movReg(BPF_REG_2, BPF_REG_8);
+    a.call(BPF_FUNC_map_lookup_elem);
+    a.jump(BPF_JNE, BPF_REG_0, 0, A::FOUND);
+    a.call(BPF_FUNC_ktime_get_ns);
+    a.store(BPF_DW, BPF_REG_10, -48, BPF_REG_0);
+    a.store(BPF_DW, BPF_REG_10, -64, BPF_REG_0);
+    a.storeImm(BPF_DW, BPF_REG_10, -56, 0);
+    a.movReg(BPF_REG_1, BPF_REG_9);
+    a.movReg(BPF_REG_2, BPF_REG_8);
+    a.movReg(BPF_REG_3, BPF_REG_10);
+    a.alu(BPF_ADD, BPF_REG_3, -64);
+    a.mov(BPF_REG_4, BPF_NOEXIST);
+    a.call(BPF_FUNC_map_update_elem);
+    a.mov(BPF_REG_8, 1);
+    a.jumpAlways(A::EMIT);
+
+    // Repeat: count it, report once a second or every FOLD_MAX frames
+    a.mark(A::FOUND);
+    a.movReg(BPF_REG_9, BPF_REG_0);
+    a.call(BPF_FUNC_ktime_get_ns);
+    a.store(BPF_DW, BPF_REG_10, -48, BPF_REG_0);
+    a.mov(BPF_REG_1, 1);
+    a.atomic(BPF_ADD | BPF_FETCH, BPF_REG_9, offsetof(Fold, pending), BPF_REG_1);
+    a.alu(BPF_ADD, BPF_REG_1, 1);
+    a.jump(BPF_JGE, BPF_REG_1, XdpAggregator::FOLD_MAX, A::FLUSH);
+    a.load(BPF_DW, BPF_REG_2, BPF_REG_10, -48);
+    a.load(BPF_DW, BPF_REG_1, BPF_REG_9, offsetof(Fold, lastNs));
+    a.aluReg(BPF_SUB, BPF_REG_2, BPF_REG_1);
+    a.jump(BPF_JLT, BPF_REG_2, FOLD_INTERVAL_NS, A::PASS);
+
+    a.mark(A::FLUSH);
+    a.load(BPF_DW, BPF_REG_1, BPF_REG_10, -48);
+    a.store(BPF_DW, BPF_REG_9, offsetof(Fold, lastNs), BPF_REG_1);
+    a.mov(BPF_REG_8, 0);
+    a.atomic(BPF_XCHG, BPF_REG_9, offsetof(Fold, pending), BPF_REG_8);
+    a.jump(BPF_JEQ, BPF_REG_8, 0, A::PASS);  // Another CPU flushed it
+
+    a.mark(A::EMIT);
+    a.loadMap(BPF_REG_1, events);
+    a.mov(BPF_REG_2, sizeof(XdpAggregator::Record));
+    a.mov(BPF_REG_3, 0);
+    a.call(BPF_FUNC_ringbuf_reserve);
+    a.jump(BPF_JEQ, BPF_REG_0, 0, A::PASS);
+    a.movReg(BPF_REG_9, BPF_REG_0);
+    a.store(BPF_W, BPF_REG_9, offsetof(XdpAggregator::Record, count), BPF_REG_8);
+    a.load(BPF_W, BPF_REG_1, BPF_REG_6, offsetof(xdp_md, ingress_ifindex));
+    a.store(BPF_W, BPF_REG_9, offsetof(XdpAggregator::Record, ifindex), BPF_REG_1);
+    a.load(BPF_DW, BPF_REG_1, BPF_REG_10, -48);
+    a.store(BPF_DW, BPF_REG_9, offsetof(XdpAggregator::Record, tsNs), BPF_REG_1);
+    a.store(BPF_W, BPF_REG_9, offsetof(XdpAggregator::Record, len), BPF_REG_7);
+    a.movReg(BPF_REG_1, BPF_REG_6);
+    a.mov(BPF_REG_2, 0);
+    a.movReg(BPF_REG_3, BPF_REG_9);
+    a.alu(BPF_ADD, BPF_REG_3, offsetof(XdpAggregator::Record, data));
+    a.movReg(BPF_REG_4, BPF_REG_7);
+    a.call(BPF_FUNC_xdp_load_bytes);
+    a.jump(BPF_JNE, BPF_REG_0, 0, A::DISCARD);
+    a.movReg(BPF_REG_1, BPF_REG_9);
+    a.mov(BPF_REG_2, 0);
+    a.call(BPF_FUNC_ringbuf_submit);
+    a.jumpAlways(A::PASS);
+
+    a.mark(A::DISCARD);
+    a.movReg(BPF_REG_1, BPF_REG_9);
+    a.mov(BPF_REG_2, 0);
+    a.call(BPF_FUNC_ringbuf_discard);
+
+    a.mark(A::PASS);
+    a.mov(BPF_REG_0, XDP_PASS);
+    a.exit();
+    return a.finish();
+}
+
+/// Last non-empty line of the verifier log, which names the rejected instruction
+std::string log_tail(const std::vector<char>& log) {
+    std::string text(log.data(), strnlen(log.data(), log.size()));
+    while (!text.empty() && text.back() == '\n') text.pop_back();
+    std::size_t start = text.rfind('\n');
+    return start == std::string::npos ? text : text.substr(start + 1);
+}
+
+} // namespace
+
+XdpAggregator::~XdpAggregator() {
+    close();
+}
+
+bool XdpAggregator::open(const std::vector<std::string>& interfaces, std::string& error) {
+    close();
+    if (interfaces.empty()) {
+        error = "no interface given";
+        return false;
+    }
+
+    m_arpFolds = create_map(BPF_MAP_TYPE_LRU_HASH, ARP_KEY_SIZE, sizeof(Fold), ARP_FOLD_ENTRIES, "se_arp_folds");
+    m_echoFolds = create_map(BPF_MAP_TYPE_LRU_HASH, ECHO_KEY_SIZE, sizeof(Fold), ECHO_FOLD_ENTRIES, "se_echo_folds");
+    int events = create_map(BPF_MAP_TYPE_RINGBUF, 0, 0, RING_BYTES, "se_events");
+    if (m_arpFolds < 0 || m_echoFolds < 0 || events < 0) {
+        error = errno_message("BPF_MAP_CREATE");
+        if (events >= 0) ::close(events);
+        close();
+        return false;
+    }
+    m_events = events;
+
+    std::vector<bpf_insn> program = build_program(m_arpFolds, m_echoFolds, m_events);
+    std::vector<char> log(64 * 1024, '\0');
+    bpf_attr attr{};
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.expected_attach_type = BPF_XDP;
+    attr.insns = reinterpret_cast<uint64_t>(program.data());
+    attr.insn_cnt = static_cast<uint32_t>(program.size());
+    attr.license = reinterpret_cast<uint64_t>("GPL");
+    attr.log_buf = reinterpret_cast<uint64_t>(log.data());
+    attr.log_size = static_cast<uint32_t>(log.size());
+    attr.log_level = 1;
+    std::strncpy(attr.prog_name, "spoofeye_fold", sizeof(attr.prog_name) - 1);
+    m_prog = static_cast<int>(bpf(BPF_PROG_LOAD, attr));
+    if (m_prog < 0) {
+        error = errno_message("BPF_PROG_LOAD");
+        std::string tail = log_tail(log);
+        if (!tail.empty()) error += " (" + tail + ")";
+        close();
+        return false;
+    }
+
+    // Ring buffer: consumer position (writable), then producer position and data mapped twice
+    m_pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    m_ringSize = RING_BYTES;
+    void* consumer = ::mmap(nullptr, m_pageSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_events, 0);
+    if (consumer == MAP_FAILED) {
+        error = errno_message("mmap(ringbuf consumer)");
+        close();
+        return false;
+    }
+    m_consumerPos = static_cast<uint64_t*>(consumer);
+    void* producer = ::mmap(nullptr, m_pageSize + 2 * m_ringSize, PROT_READ, MAP_SHARED, m_events,
+                            static_cast<off_t>(m_pageSize));
+    if (producer == MAP_FAILED) {
+        error = errno_message("mmap(ringbuf data)");
+        close();
+        return false;
+    }
+    m_producerPos = static_cast<const uint64_t*>(producer);
+    m_data = static_cast<const uint8_t*>(producer) + m_pageSize;
+
+    for (const std::string& name : interfaces) {
+        int ifindex = static_cast<int>(if_nametoindex(name.c_str()));
+        if (ifindex == 0) {
+            error = "unknown interface " + name;
+            close();
+            return false;
+        }
+        bpf_attr link{};
+        link.link_create.prog_fd = static_cast<uint32_t>(m_prog);
+        link.link_create.target_ifindex = static_cast<uint32_t>(ifindex);
+        link.link_create.attach_type = BPF_XDP;
+        int fd = static_cast<int>(bpf(BPF_LINK_CREATE, link));
+        if (fd < 0) {
+            error = errno_message(("XDP attach on " + name).c_str());
+            close();
+            return false;
+        }
+        m_links.push_back(fd);
+        m_ifindexes.push_back(ifindex);
+        m_interfaces.push_back(name);
+    }
+
+    m_clockOffsetNs = clock_ns(CLOCK_REALTIME) - clock_ns(CLOCK_MONOTONIC);
+    return true;
+}
+
+void XdpAggregator::close() noexcept {
+    // Closing the links detaches the program
+    for (int fd : m_links) ::close(fd);
+    m_links.clear();
+    m_ifindexes.clear();
+    m_interfaces.clear();
+
+    if (m_producerPos) {
+        ::munmap(const_cast<uint64_t*>(m_producerPos), m_pageSize + 2 * m_ringSize);
+        m_producerPos = nullptr;
+        m_data = nullptr;
+    }
+    if (m_consumerPos) {
+        ::munmap(m_consumerPos, m_pageSize);
+        m_consumerPos = nullptr;
+    }
+    for (int* fd : {&m_prog, &m_events, &m_echoFolds, &m_arpFolds}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+}
+
+} // namespace capture
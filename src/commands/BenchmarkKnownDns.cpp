@@ -0,0 +1,146 @@
+/**
+ * @file BenchmarkKnownDns.cpp
+ * @brief Implementation of the BenchmarkKnownDns command for SpoofEye.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "commands/BenchmarkKnownDns.hpp"
+#include "monitors/KnownDnsDb.hpp"
+#include "utils/Logger.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/PrefixTrie.hpp"
+
+#include "lib/json.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace commands {
+
+namespace {
+
+/// Distinct queries, half of them listed
+constexpr std::size_t QUERY_COUNT = 1 << 16;
+
+/// Passes over the queries per strategy
+constexpr int ROUNDS = 20;
+
+/// Random IPv4 prefixes (/16 to /24) in the synthetic provider-range trie
+constexpr std::size_t PREFIX_COUNT = 100000;
+
+/**
+ * @brief Time fn over every query and print the cost of one lookup.
+ */
+template <typename Query, typename Fn>
+void measure(const char* name, const std::vector<Query>& queries, Fn&& fn) {
+    std::size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (const Query& query : queries) hits += fn(query) ? 1 : 0;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "  %-40s %8.1f ns/lookup  (%zu hits)", name,
+                  elapsed / (static_cast<double>(queries.size()) * ROUNDS), hits / ROUNDS);
+    Logger::print(line);
+}
+
+} // namespace
+
+bool BenchmarkKnownDns::benchmark_known_dns = false;
+
+BenchmarkKnownDns::BenchmarkKnownDns() = default;
+
+void BenchmarkKnownDns::execute(const std::string&) {
+    benchmark_known_dns = true;
+}
+
+bool BenchmarkKnownDns::runBenchmark(const Config& cfg) {
+    const std::string& path = cfg.getKnownDNSPath();
+
+    monitors::KnownDnsDb db;
+    std::string error;
+    if (!db.loadJson(path, error)) {
+        Logger::print("Error: " + error, Logger::LogType::ERROR);
+        return false;
+    }
+
+    // The former representation, and a plain sorted array as the reference search
+    std::vector<std::string> listed;
+    {
+        std::ifstream ifs(path);
+        nlohmann::json j;
+        ifs >> j;
+        for (const auto& entry : j) listed.push_back(entry.get<std::string>());
+    }
+    std::set<std::string> strings(listed.begin(), listed.end());
+    std::vector<uint32_t> sorted;
+    for (const std::string& text : listed) {
+        uint32_t ip = 0;
+        if (NetAddr::parseIpv4(text, ip)) sorted.push_back(ntohl(ip));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // Fixed seed: runs are comparable
+    std::mt19937 rng(42);
+    std::vector<std::string> textQueries;
+    std::vector<uint32_t> packedQueries;
+    for (std::size_t i = 0; i < QUERY_COUNT; ++i) {
+        uint32_t ip = 0;
+        if (i % 2 == 0 && !sorted.empty()) {
+            ip = htonl(sorted[rng() % sorted.size()]);
+        } else {
+            ip = rng();
+        }
+        textQueries.push_back(NetAddr::formatIpv4(ip));
+        packedQueries.push_back(ip);
+    }
+
+    Logger::print("Known DNS lookups: " + std::to_string(db.size()) + " entries, " +
+                  std::to_string(QUERY_COUNT) + " queries (half listed)", Logger::LogType::INFO);
+    measure("std::set<std::string>::count", textQueries,
+            [&](const std::string& q) { return strings.count(q) > 0; });
+    measure("KnownDnsDb::contains (text, parsed)", textQueries,
+            [&](const std::string& q) { return db.contains(q); });
+    measure("std::binary_search (packed uint32)", packedQueries,
+            [&](uint32_t q) { return std::binary_search(sorted.begin(), sorted.end(), ntohl(q)); });
+    measure("KnownDnsDb::containsIpv4 (branchless)", packedQueries,
+            [&](uint32_t q) { return db.containsIpv4(q); });
+
+    // Provider ranges: a list of prefixes much larger than the shipped one
+    PrefixTrie trie;
+    auto buildStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < PREFIX_COUNT; ++i) {
+        Ipv6Addr key;
+        key.hi = static_cast<uint64_t>(rng()) << 32;
+        trie.insert(key, 16 + rng() % 9);
+    }
+    trie.finalize();
+    auto buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    std::vector<Ipv6Addr> keyQueries;
+    for (uint32_t ip : packedQueries) {
+        Ipv6Addr key;
+        key.hi = static_cast<uint64_t>(ntohl(ip)) << 32;
+        keyQueries.push_back(key);
+    }
+    char line[128];
+    std::snprintf(line, sizeof(line), "Prefix trie: %zu random IPv4 prefixes, %zu nodes, built in %.1f ms",
+                  trie.size(), trie.nodeCount(), buildMs);
+    Logger::print(line, Logger::LogType::INFO);
+    measure("PrefixTrie::longestMatch (IPv4)", keyQueries,
+            [&](const Ipv6Addr& q) { return trie.longestMatch(q) >= 0; });
+    return true;
+}
+
+} // namespace commands
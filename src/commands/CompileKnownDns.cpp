@@ -0,0 +1,50 @@
+/**
+ * @file CompileKnownDns.cpp
+ * @brief Implementation of the CompileKnownDns command for SpoofEye.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "commands/CompileKnownDns.hpp"
+#include "monitors/KnownDnsDb.hpp"
+#include "utils/Logger.hpp"
+
+#include <string>
+
+namespace commands {
+
+bool CompileKnownDns::compile_known_dns = false;
+
+CompileKnownDns::CompileKnownDns() = default;
+
+void CompileKnownDns::execute(const std::string&) {
+    compile_known_dns = true;
+}
+
+bool CompileKnownDns::compileDatabase(const Config& cfg) {
+    const std::string& source = cfg.getKnownDNSPath();
+    const std::string& target = cfg.getKnownDNSDbPath();
+
+    monitors::KnownDnsDb db;
+    std::string error;
+    std::size_t skipped = 0;
+    if (!db.loadJson(source, error, &skipped)) {
+        Logger::print("Error: " + error, Logger::LogType::ERROR);
+        return false;
+    }
+    if (skipped > 0) {
+        Logger::print("Skipped " + std::to_string(skipped) + " entries that are not IP addresses or prefixes",
+                      Logger::LogType::WARNING);
+    }
+    if (!db.compile(target, error)) {
+        Logger::print("Error: " + error, Logger::LogType::ERROR);
+        return false;
+    }
+
+    Logger::print("Compiled " + std::to_string(db.addressCount()) + " known DNS servers and " +
+                      std::to_string(db.prefixCount()) + " prefixes from " + source + " into " + target,
+                  Logger::LogType::INFO);
+    return true;
+}
+
+} // namespace commands
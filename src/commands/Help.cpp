@@ -36,6 +36,7 @@ void Help::execute(const std::string&) {
     Logger::print("\nUsage examples:");
     Logger::print("  " + std::string(SOFTWARE_COMMAND) + " --version");
     Logger::print("  " + std::string(SOFTWARE_COMMAND) + " --config-path /path/to/config.ini");
+    Logger::print("  " + std::string(SOFTWARE_COMMAND) + " --compile-known-dns");
     Logger::print("  " + std::string(SOFTWARE_COMMAND) + " --help");
 }
 
@@ -10,6 +10,8 @@
 #include "Core.hpp"
 #include "Config.hpp"
 #include "commands/Init.hpp"
+#include "commands/BenchmarkKnownDns.hpp"
+#include "commands/CompileKnownDns.hpp"
 #include "commands/ConfigPath.hpp"
 #include "commands/Help.hpp"
 #include "commands/PrintConfig.hpp"
@@ -82,6 +84,24 @@ int main(int argc, char** argv) {
         /*exitAfterExecution=*/false
     );
 
+    cmdManager.registerCommand(
+        "--compile-known-dns",
+        std::make_unique<commands::CompileKnownDns>(),
+        "Compile the known DNS list into the binary database loaded at startup",
+        {},
+        /*takesArgument=*/false,
+        /*exitAfterExecution=*/false
+    );
+
+    cmdManager.registerCommand(
+        "--benchmark-known-dns",
+        std::make_unique<commands::BenchmarkKnownDns>(),
+        "Time known DNS lookups (string set vs packed arrays) on the configured list",
+        {},
+        /*takesArgument=*/false,
+        /*exitAfterExecution=*/false
+    );
+
     // Register command-line commands
     cmdManager.registerCommand(
         "--version",
@@ -147,6 +167,14 @@ int main(int argc, char** argv) {
         // Load configuration
         Config cfg(iniPath);
 
+        if (commands::BenchmarkKnownDns::benchmark_known_dns) {
+            return commands::BenchmarkKnownDns::runBenchmark(cfg) ? 0 : 1;
+        }
+
+        if (commands::CompileKnownDns::compile_known_dns) {
+            return commands::CompileKnownDns::compileDatabase(cfg) ? 0 : 1;
+        }
+
         if (commands::PrintConfig::print_config) {
             commands::PrintConfig::printConfiguration(cfg);
         } else {
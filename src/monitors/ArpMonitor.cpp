@@ -6,19 +6,40 @@
  */
 
 #include "monitors/ArpMonitor.hpp"
+#include "capture/ArpPacket.hpp"
+#include "capture/CaptureEngine.hpp"
+#include "monitors/ArpRateTracker.hpp"
+#include "monitors/ArpRequestTracker.hpp"
+#include "monitors/BindingTracker.hpp"
 #include "monitors/Init.hpp"
+#include "monitors/ScanDetector.hpp"
+#include "utils/ConnectedNetworks.hpp"
+#include "utils/DefaultGateway.hpp"
 #include "utils/Logger.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/Netlink.hpp"
+#include "utils/SpscQueue.hpp"
+#include "utils/WakeupFd.hpp"
 
+#include <arpa/inet.h>
 #include <atomic>
 #include <cctype>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
+#include <ctime>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <linux/neighbour.h>
 #include <memory>
 #include <mutex>
+#include <poll.h>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -26,37 +47,132 @@ namespace monitors {
 
 namespace {
 
+/// Neighbour states carrying a usable link-layer address (kernel's NUD_VALID)
+constexpr uint16_t NUD_HAS_LLADDR = NUD_PERMANENT | NUD_NOARP | NUD_REACHABLE |
+                                    NUD_PROBE | NUD_STALE | NUD_DELAY;
+
 /**
- * @brief Execute a shell command and capture output.
- * @param cmd Command to execute.
- * @return Captured stdout with trailing newlines removed.
+ * @brief Current Unix time in seconds, as stored in binding timestamps.
  */
-std::string run_cmd_capture(const char* cmd) {
-    std::string result;
-    FILE* pipe = popen(cmd, "r");
-    if (!pipe) return result;
+uint32_t unix_now() {
+    return static_cast<uint32_t>(std::time(nullptr));
+}
 
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result += buffer;
-    }
-    pclose(pipe);
+/**
+ * @brief Current Unix time in milliseconds, the clock of capture timestamps.
+ */
+uint64_t unix_now_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
 
-    // Trim trailing whitespace/newlines
-    while (!result.empty() && (result.back() == '\n' || result.back() == '\r')) {
-        result.pop_back();
-    }
-    return result;
+/**
+ * @brief Capture time of a frame in milliseconds.
+ */
+uint64_t capture_ms(const capture::ArpPacket& arp) {
+    return uint64_t{arp.tsSec} * 1000 + arp.tsNsec / 1000000;
 }
 
+/// Minimum delay between two alerts of the same kind for the same IP (seconds)
+constexpr uint32_t ALERT_INTERVAL = 60;
+
+/// Upper bound on per-IP alerts per second across all IPs; the rest is summarized
+constexpr uint32_t MAX_ALERTS_PER_SECOND = 5;
+
+/// Minimum delay between two sweeps of a full alert table (seconds)
+constexpr uint32_t ALERT_SWEEP_INTERVAL = 5;
+
+/// Decoded frames a capture worker may queue ahead of the monitor thread
+constexpr std::size_t CAPTURE_QUEUE_SIZE = 2048;
+
+/// Time for the monitor thread to drain a retired block, on top of the block timeouts
+constexpr uint32_t HOLD_MARGIN_MS = 50;
+
+/// Unsolicited replies waiting for a late request; beyond that the oldest is judged early
+constexpr std::size_t MAX_HELD_REPLIES = 1024;
+
+/// Alert families throttled independently for each IP
+enum class AlertKind : uint64_t {
+    REBINDING = 1,
+    UNSOLICITED_REPLY = 2,
+    CONFLICTING_REPLY = 3,
+    POISONING_CADENCE = 4
+};
+
+/// Where a binding observation comes from
+enum class Source {
+    KERNEL, ///< Kernel neighbour table (netlink or /proc/net/arp)
+    WIRE    ///< ARP frame captured on the link
+};
+
+/**
+ * @brief One neighbour table entry, as reported by netlink or /proc/net/arp.
+ */
+struct NeighEntry {
+    uint32_t ip = 0;        ///< IPv4 address, network byte order
+    uint64_t mac = 0;       ///< Packed MAC (valid if resolved)
+    bool resolved = false;  ///< False for deleted, incomplete or failed entries
+};
+
+/**
+ * @brief ARP frame decoded on a capture worker, queued for the monitor thread.
+ */
+struct CapturedArp {
+    capture::ArpPacket arp;
+    uint32_t count = 1;     ///< Identical frames it stands for (XDP folding)
+};
+
+/**
+ * @brief Reply that matched no request, judged again once late requests are in.
+ */
+struct HeldReply {
+    capture::ArpPacket arp;
+    uint32_t count = 1;
+    uint64_t deadlineMs = 0; ///< Unix time (ms) of the final verdict
+};
+
 } // namespace
 
 // Implementation details hidden in Pimpl
 struct ArpMonitor::Impl {
     std::string gateway;
+    uint32_t gateway_addr = 0;  ///< Gateway IP, network byte order
+    bool auto_gateway = true;   ///< Follow default route changes (false when forced)
     int interval_seconds = 5;
     std::atomic<bool> running{false};
     std::mutex mtx;
+    WakeupFd wakeup;            ///< Signalled by stop() to interrupt poll()
+    std::string last_mac;       ///< Last known gateway MAC (normalized)
+    NotificationCallback notify_cb;
+
+    ArpBindingTracker bindings; ///< Bindings of every IPv4 neighbour
+    ConnectedNetworks connected; ///< Prefixes a captured sender must fall in to be learned
+    uint32_t last_expiry = 0;   ///< Last time stale bindings were evicted
+    bool table_full_logged = false;
+
+    // Captured frames are decoded on the capture workers and judged on the
+    // monitor thread, which owns every tracker below: no lock on either side
+    std::vector<std::unique_ptr<SpscQueue<CapturedArp>>> captured; ///< One queue per capture worker
+    WakeupFd captured_ready;                ///< Signalled by a worker after queuing a batch
+    std::atomic<uint64_t> captured_drops{0}; ///< Frames lost to a full queue, not yet logged
+    uint64_t unlogged_drops = 0;
+    uint32_t drops_logged_at = 0;
+
+    // XDP records reach worker 0 at once, while the request they answer may
+    // still sit in a ring block of another worker: an unmatched reply waits
+    // until every frame captured before it has been drained
+    std::deque<HeldReply> held; ///< Unsolicited replies, oldest first
+    uint32_t hold_ms = 0;       ///< How long an unmatched reply waits, 0 to judge at once
+
+    ArpRequestTracker requests;   ///< Pending who-has exchanges seen on the wire
+    ArpRateTracker rates;         ///< Per-source-MAC ARP rate buckets
+    ScanDetector sweeps;          ///< Distinct addresses requested per source MAC
+    FlatHashMap<uint64_t, uint32_t> alert_times{64, 4096}; ///< (kind, IP) -> last alert time
+    uint32_t alert_times_swept = 0; ///< Last sweep of a full alert_times
+    uint32_t alert_second = 0;      ///< Second the alerts below were counted in
+    uint32_t alerts_in_second = 0;
+    uint64_t suppressed_alerts = 0; ///< Alerts withheld by the current flood
+    uint32_t suppressed_at = 0;     ///< Last time an alert was withheld
 
     Impl() = default;
     ~Impl() = default;
@@ -66,35 +182,67 @@ struct ArpMonitor::Impl {
      * @return Detected gateway IP or empty string if not found.
      */
     static std::string detect_gateway_ip() {
-        std::string out = run_cmd_capture("ip route show default 2>/dev/null");
-        if (!out.empty()) {
-            std::istringstream iss(out);
-            std::string token;
-            while (iss >> token) {
-                if (token == "via" && (iss >> token)) return token;
-            }
-        }
+        return DefaultGateway::detect();
+    }
 
-        // Fallback using `route -n`
-        out = run_cmd_capture("route -n 2>/dev/null");
-        std::istringstream rss(out);
-        std::string line;
-        while (std::getline(rss, line)) {
-            std::istringstream ls(line);
-            std::string dest, gw;
-            if (ls >> dest >> gw && dest == "0.0.0.0") return gw;
+    /**
+     * @brief Thread-safe read of the monitored gateway.
+     */
+    std::string current_gateway() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return gateway;
+    }
+
+    /**
+     * @brief Re-detect the default gateway and switch to it if it changed.
+     *
+     * Only applies to an autodetected gateway; a forced gateway is never replaced.
+     * @return True if the monitored gateway changed.
+     */
+    bool refresh_gateway() {
+        if (!auto_gateway) return false;
+
+        std::string detected = detect_gateway_ip();
+        if (detected.empty() || detected == gateway) return false;
+
+        Logger::log("Default gateway changed from " + gateway + " to " + detected + ", re-targeting",
+                    Logger::LogType::INFO, LogPrefixes::arp_monitor);
+        set_gateway(detected);
+        return true;
+    }
+
+    /**
+     * @brief Replace the monitored gateway (thread-safe for readers).
+     */
+    void set_gateway(const std::string& ip) {
+        std::lock_guard<std::mutex> lock(mtx);
+        gateway = ip;
+        if (!NetAddr::parseIpv4(ip, gateway_addr)) gateway_addr = 0;
+    }
+
+    /**
+     * @brief Forward an alert to the notification callback, if any.
+     */
+    void notify(const std::string& title, const std::string& body) {
+        NotificationCallback cb;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cb = notify_cb;
+        }
+        if (cb) {
+            try { cb(title, body); } catch (...) {}
         }
-        return {};
     }
 
     /**
-     * @brief Read MAC address of given IP from /proc/net/arp.
-     * @param ip IP address to lookup.
-     * @return MAC address in lowercase, or empty if not found.
+     * @brief Parse every IPv4 entry of /proc/net/arp.
+     * @param fn Called as fn(const NeighEntry&) for each entry.
+     * @return False if the file could not be read.
      */
-    static std::string read_mac_from_proc_arp(const std::string& ip) {
+    template <typename Fn>
+    static bool scan_proc_arp(Fn&& fn) {
         std::ifstream ifs("/proc/net/arp");
-        if (!ifs.is_open()) return {};
+        if (!ifs.is_open()) return false;
 
         std::string line;
         std::getline(ifs, line); // skip header
@@ -102,13 +250,29 @@ struct ArpMonitor::Impl {
             std::istringstream iss(line);
             std::string ipaddr, hwtype, flags, hwaddr, mask, device;
             if (!(iss >> ipaddr >> hwtype >> flags >> hwaddr >> mask >> device)) continue;
-            if (ipaddr == ip) {
-                if (hwaddr == "00:00:00:00:00:00") return {};
-                for (auto& c : hwaddr) c = std::tolower(static_cast<unsigned char>(c));
-                return hwaddr;
-            }
+
+            NeighEntry entry;
+            if (!NetAddr::parseIpv4(ipaddr, entry.ip)) continue;
+            entry.resolved = NetAddr::parseMac(hwaddr, entry.mac) && entry.mac != 0;
+            fn(static_cast<const NeighEntry&>(entry));
         }
-        return {};
+        return true;
+    }
+
+    /**
+     * @brief Read MAC address of given IP from /proc/net/arp.
+     * @param ip IP address to lookup.
+     * @return MAC address in lowercase, or empty if not found.
+     */
+    static std::string read_mac_from_proc_arp(const std::string& ip) {
+        uint32_t addr = 0;
+        if (!NetAddr::parseIpv4(ip, addr)) return {};
+
+        std::string mac;
+        scan_proc_arp([&](const NeighEntry& entry) {
+            if (entry.ip == addr && entry.resolved) mac = NetAddr::formatMac(entry.mac);
+        });
+        return mac;
     }
 
     /**
@@ -125,10 +289,36 @@ struct ArpMonitor::Impl {
     }
 
     /**
-     * @brief Monitor loop to detect MAC changes.
+     * @brief Compare a freshly observed gateway MAC with the last one and report changes.
+     * @param mac Observed MAC (empty if the entry is gone or incomplete).
      */
-    void monitor_loop(ChangeCallback cb) {
-        std::string last_mac = read_mac_from_proc_arp(gateway);
+    void update_gateway_mac(const std::string& mac, const ChangeCallback& cb) {
+        std::string current = normalize_mac(mac);
+        std::string prev = last_mac;
+
+        if (current == prev) return;
+
+        if (prev.empty()) {
+            Logger::log("ARP entry appeared for gateway " + gateway + " : " + current,
+                        Logger::LogType::INFO, LogPrefixes::arp_monitor);
+        } else if (current.empty()) {
+            Logger::log("ARP entry for gateway " + gateway + " disappeared (was " + prev + ")",
+                        Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+        } else {
+            Logger::log("MAC change for gateway " + gateway + " : " + prev + " -> " + current,
+                        Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+        }
+
+        if (cb) {
+            try { cb(prev, current, gateway); } catch (...) {}
+        }
+        last_mac = current;
+    }
+
+    /**
+     * @brief Log the initial gateway ARP state.
+     */
+    void log_initial_state() const {
         if (!last_mac.empty()) {
             Logger::log("Initial MAC for gateway " + gateway + " : " + last_mac,
                         Logger::LogType::INFO, LogPrefixes::arp_monitor);
@@ -136,35 +326,532 @@ struct ArpMonitor::Impl {
             Logger::log("No ARP entry for gateway " + gateway + " (yet)",
                         Logger::LogType::INFO, LogPrefixes::arp_monitor);
         }
+    }
+
+    /**
+     * @brief Decode an IPv4 RTM_NEWNEIGH / RTM_DELNEIGH message.
+     * @param msg Netlink message.
+     * @param[out] entry Decoded entry.
+     * @return True if the message is an IPv4 neighbour update.
+     */
+    static bool parse_neigh(const nlmsghdr& msg, NeighEntry& entry) {
+        if (msg.nlmsg_type != RTM_NEWNEIGH && msg.nlmsg_type != RTM_DELNEIGH) return false;
+        if (msg.nlmsg_len < NLMSG_LENGTH(sizeof(ndmsg))) return false;
+
+        const auto* ndm = static_cast<const ndmsg*>(NLMSG_DATA(&msg));
+        if (ndm->ndm_family != AF_INET) return false;
+
+        const rtattr* attrs[NDA_MAX + 1];
+        NetlinkSocket::parseAttributes(RTM_RTA(ndm), static_cast<int>(RTM_PAYLOAD(&msg)), attrs, NDA_MAX);
+
+        const rtattr* dst = attrs[NDA_DST];
+        if (!dst || RTA_PAYLOAD(dst) != sizeof(uint32_t)) return false;
+        std::memcpy(&entry.ip, RTA_DATA(dst), sizeof(uint32_t));
+
+        entry.mac = 0;
+        entry.resolved = false;
+        const rtattr* lladdr = attrs[NDA_LLADDR];
+        bool valid = msg.nlmsg_type == RTM_NEWNEIGH && (ndm->ndm_state & NUD_HAS_LLADDR);
+        if (valid && lladdr && RTA_PAYLOAD(lladdr) == 6) {
+            entry.mac = NetAddr::packMac(static_cast<const uint8_t*>(RTA_DATA(lladdr)));
+            entry.resolved = entry.mac != 0;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Rate-limit alerts per IP (racing replies flip bindings back and forth).
+     *
+     * Forged senders get a fresh IP per frame, so alerts are also capped per
+     * second overall. Whatever the cap or a full table withholds is reported
+     * once as a flood, never let through.
+     * @return True if an alert of this kind for ip may be raised now.
+     */
+    bool alert_allowed(AlertKind kind, uint32_t ip, uint32_t now) {
+        uint64_t key = (static_cast<uint64_t>(kind) << 32) | ip;
+        auto [last, inserted] = alert_times.insert(key);
+        if (!last && now - alert_times_swept >= ALERT_SWEEP_INTERVAL) {
+            alert_times_swept = now;
+            alert_times.eraseIf([&](uint64_t, uint32_t at) { return now - at >= ALERT_INTERVAL; });
+            std::tie(last, inserted) = alert_times.insert(key);
+        }
+        if (!last) {
+            suppress_alert(now);
+            return false;
+        }
+        if (!inserted && now - *last < ALERT_INTERVAL) return false;
+        if (!take_alert_slot(now)) {
+            if (inserted) alert_times.erase(key);
+            suppress_alert(now);
+            return false;
+        }
+        *last = now;
+        return true;
+    }
 
+    /**
+     * @brief Count an alert against the per-second budget.
+     * @return False if MAX_ALERTS_PER_SECOND were already raised this second.
+     */
+    bool take_alert_slot(uint32_t now) {
+        if (now != alert_second) {
+            alert_second = now;
+            alerts_in_second = 0;
+        }
+        if (alerts_in_second >= MAX_ALERTS_PER_SECOND) return false;
+        ++alerts_in_second;
+        return true;
+    }
+
+    /**
+     * @brief Withhold an alert; the first one of a flood raises a single aggregate alert.
+     */
+    void suppress_alert(uint32_t now) {
+        end_alert_flood(now);
+        suppressed_at = now;
+        if (suppressed_alerts++ > 0) return;
+        std::string msg = "more than " + std::to_string(MAX_ALERTS_PER_SECOND) +
+                          " ARP alerts per second, further alerts are withheld until it calms down";
+        Logger::log("ARP alert flood: " + msg, Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+        notify("ARP Alert Flood", "ARP spoofing flood, " + msg);
+    }
+
+    /**
+     * @brief Log how many alerts a flood withheld once none was for ALERT_INTERVAL.
+     */
+    void end_alert_flood(uint32_t now) {
+        if (suppressed_alerts == 0 || now - suppressed_at < ALERT_INTERVAL) return;
+        Logger::log("ARP alert flood over, " + std::to_string(suppressed_alerts) + " alert(s) withheld",
+                    Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        suppressed_alerts = 0;
+    }
+
+    /**
+     * @brief Feed a resolved neighbour into the binding tracker.
+     * @param report False while loading the initial table (no alerts).
+     * @param source Kernel table or captured ARP frame.
+     */
+    void observe_binding(uint32_t ip, uint64_t mac, uint32_t now, bool report,
+                         Source source = Source::KERNEL) {
+        uint64_t previous = 0;
+        ArpBindingTracker::Origin origin = source == Source::KERNEL ? ArpBindingTracker::Origin::KERNEL
+                                                                  : ArpBindingTracker::Origin::WIRE;
+        ArpBindingTracker::Update result = bindings.observe(ip, mac, now, origin, &previous);
+
+        if (result == ArpBindingTracker::Update::DROPPED) {
+            if (!table_full_logged) {
+                Logger::log("ARP binding table full (" + std::to_string(bindings.size()) + " entries, " +
+                            std::to_string(bindings.wireOnlyCount()) +
+                            " only seen on the wire), ignoring new neighbours",
+                            Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+                table_full_logged = true;
+            }
+            return;
+        }
+        table_full_logged = false;
+        if (result == ArpBindingTracker::Update::REFRESHED) return;
+
+        if (bindings.checkGatewayFanIn(gateway_addr, mac)) {
+            std::string macStr = NetAddr::formatMac(mac);
+            std::string count = std::to_string(bindings.claimCount(mac));
+            std::string detail = ip == gateway_addr
+                ? "the gateway " + gateway + " now resolves to " + macStr +
+                  ", which already answers for other hosts"
+                : macStr + " answers for both the gateway " + gateway + " and " + NetAddr::formatIpv4(ip);
+            Logger::log("Possible ARP MITM: " + detail + " (" + count + " IPs)",
+                        Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+            notify("ARP MITM Alert", "Possible man-in-the-middle: " + detail + " (" + count + " IPs claimed)");
+        }
+
+        // Kernel-side gateway changes are reported through the ChangeCallback path
+        if (result != ArpBindingTracker::Update::REBOUND || !report) return;
+        bool is_gateway = ip == gateway_addr;
+        if (is_gateway && source == Source::KERNEL) return;
+        if (!alert_allowed(AlertKind::REBINDING, ip, now)) return;
+
+        std::string ipStr = NetAddr::formatIpv4(ip);
+        std::string oldMac = NetAddr::formatMac(previous);
+        std::string newMac = NetAddr::formatMac(mac);
+        if (is_gateway) {
+            Logger::log("ARP frame claims gateway " + ipStr + " is at " + newMac + " (was " + oldMac + ")",
+                        Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+            notify("ARP Alert", "ARP traffic claims the gateway " + ipStr + " is at " + newMac +
+                   " instead of " + oldMac);
+            return;
+        }
+        Logger::log("ARP rebinding for " + ipStr + " : " + oldMac + " -> " + newMac,
+                    Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        notify("ARP Rebinding", "Host " + ipStr + " moved from " + oldMac + " to " + newMac);
+    }
+
+    /**
+     * @brief Match a captured reply against the requests seen on the wire.
+     *
+     * Announcements (gratuitous replies) and our own replies are not answers
+     * to anything and are left to the binding tracker.
+     *
+     * @param[out] firstMac MAC of the earlier answer when the result is CONFLICTING.
+     * @return Verdict, SOLICITED for frames that are not judged.
+     */
+    ArpRequestTracker::Verdict check_reply(const capture::ArpPacket& arp, uint64_t* firstMac) {
+        if (arp.outgoing || arp.isGratuitous() || arp.targetIp == 0) {
+            return ArpRequestTracker::Verdict::SOLICITED;
+        }
+        return requests.onReply(arp.senderIp, arp.senderMac, arp.targetIp, capture_ms(arp), firstMac);
+    }
+
+    /**
+     * @brief Raise the alert of a final reply verdict.
+     * @param firstMac Earlier answer, for CONFLICTING.
+     */
+    void report_reply(const capture::ArpPacket& arp, ArpRequestTracker::Verdict verdict, uint64_t firstMac) {
+        if (verdict == ArpRequestTracker::Verdict::UNSOLICITED) {
+            if (!alert_allowed(AlertKind::UNSOLICITED_REPLY, arp.senderIp, arp.tsSec)) return;
+            std::string ipStr = NetAddr::formatIpv4(arp.senderIp);
+            std::string macStr = NetAddr::formatMac(arp.senderMac);
+            Logger::log("Unsolicited ARP reply: " + ipStr + " is-at " + macStr + " sent to " +
+                        NetAddr::formatIpv4(arp.targetIp) + " without a request",
+                        Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+            notify("Unsolicited ARP Reply", "Unrequested ARP reply claims " + ipStr + " is at " + macStr);
+        } else if (verdict == ArpRequestTracker::Verdict::CONFLICTING) {
+            if (!alert_allowed(AlertKind::CONFLICTING_REPLY, arp.senderIp, arp.tsSec)) return;
+            std::string ipStr = NetAddr::formatIpv4(arp.senderIp);
+            std::string macStr = NetAddr::formatMac(arp.senderMac);
+            std::string firstStr = NetAddr::formatMac(firstMac);
+            Logger::log("Conflicting ARP replies for " + ipStr + " : " + firstStr + " and " + macStr,
+                        Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+            notify("ARP Alert", "Two hosts answered for " + ipStr + " (" + firstStr + " and " + macStr +
+                   "), possible ARP spoofing race");
+        }
+    }
+
+    /**
+     * @brief True for verdicts that make a reply a claim nobody asked for.
+     */
+    static bool is_claim(ArpRequestTracker::Verdict verdict) {
+        return verdict == ArpRequestTracker::Verdict::UNSOLICITED ||
+               verdict == ArpRequestTracker::Verdict::CONFLICTING;
+    }
+
+    /**
+     * @brief Charge a captured frame to its source MAC and report sustained excess.
+     * @param count Identical frames folded into this one.
+     */
+    void check_rate(const capture::ArpPacket& arp, uint64_t nowMs, uint32_t count) {
+        ArpRateTracker::Result result = rates.record(arp.ethSrc, ArpRateTracker::Kind::FRAME, nowMs, count);
+        if (result == ArpRateTracker::Result::EXCEEDED) {
+            std::string mac = NetAddr::formatMac(arp.ethSrc);
+            std::string limit = std::to_string(rates.limit(ArpRateTracker::Kind::FRAME).perMinute / 60);
+            Logger::log("ARP storm: " + mac + " keeps sending more than " + limit + " ARP frames/s",
+                        Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+            notify("ARP Storm", "Host " + mac + " is flooding the network with ARP traffic");
+        } else if (result == ArpRateTracker::Result::OVERFLOW) {
+            std::string count = std::to_string(rates.size());
+            Logger::log("ARP flood from too many source MACs to track (" + count +
+                        " sources), possibly randomised", Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+            notify("ARP Storm", "ARP flood from " + count + "+ different source MACs");
+        }
+    }
+
+    /**
+     * @brief Charge an announcement or unsolicited reply to its source MAC and
+     *        report a poisoning cadence.
+     * @param count Identical frames folded into this one.
+     */
+    void check_claims(const capture::ArpPacket& arp, uint64_t nowMs, uint32_t count) {
+        ArpRateTracker::Result result = rates.record(arp.ethSrc, ArpRateTracker::Kind::CLAIM, nowMs, count);
+        if (result == ArpRateTracker::Result::THROTTLED || result == ArpRateTracker::Result::NORMAL) return;
+        if (!alert_allowed(AlertKind::POISONING_CADENCE, arp.senderIp, arp.tsSec)) return;
+
+        std::string ipStr = NetAddr::formatIpv4(arp.senderIp);
+        std::string mac = result == ArpRateTracker::Result::OVERFLOW
+            ? "untracked sources" : NetAddr::formatMac(arp.ethSrc);
+        Logger::log("ARP poisoning cadence: " + mac + " keeps announcing " + ipStr + " at " +
+                    NetAddr::formatMac(arp.senderMac) + " without being asked",
+                    Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+        notify("ARP Poisoning Alert", "Repeated unsolicited ARP claims for " + ipStr + " from " + mac);
+    }
+
+    /**
+     * @brief Report a source MAC resolving many distinct addresses (host discovery).
+     */
+    void check_sweep(const capture::ArpPacket& arp) {
+        uint32_t distinct = 0;
+        if (!sweeps.observe(arp.senderMac, arp.targetIp, arp.tsSec, distinct)) return;
+        std::string msg = NetAddr::formatMac(arp.senderMac) + " (" + NetAddr::formatIpv4(arp.senderIp) +
+                          ") requested ~" + std::to_string(distinct) + " distinct addresses within " +
+                          std::to_string(2 * sweeps.windowSeconds()) + "s";
+        Logger::log("ARP sweep: " + msg, Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        notify("Scan Alert", "Possible ARP host discovery scan: " + msg);
+    }
+
+    /**
+     * @brief Feed a captured request, reply or announcement into the trackers.
+     * @param count Identical frames it stands for; only the rate buckets weigh it.
+     */
+    void handle_frame(const capture::ArpPacket& arp, uint32_t count) {
+        uint64_t nowMs = capture_ms(arp);
+        bool claim = arp.isGratuitous();
+        if (arp.op == capture::ArpPacket::Op::REQUEST) {
+            if (!claim) requests.onRequest(arp.senderIp, arp.targetIp, nowMs);
+            if (!claim && !arp.outgoing) check_sweep(arp);
+        } else {
+            uint64_t firstMac = 0;
+            ArpRequestTracker::Verdict verdict = check_reply(arp, &firstMac);
+            if (verdict == ArpRequestTracker::Verdict::UNSOLICITED && hold_ms > 0) {
+                // Only the verdict waits: the frame still counts and still binds now
+                hold_reply(arp, count, nowMs + hold_ms);
+            } else {
+                report_reply(arp, verdict, firstMac);
+                claim = claim || is_claim(verdict);
+            }
+        }
+        if (!arp.outgoing) {
+            check_rate(arp, nowMs, count);
+            if (claim) check_claims(arp, nowMs, count);
+        }
+        if (on_link(arp)) observe_binding(arp.senderIp, arp.senderMac, arp.tsSec, true, Source::WIRE);
+    }
+
+    /**
+     * @brief True if the sender may be a neighbour: inside a prefix of the receiving interface.
+     *
+     * Forged senders from anywhere else would only fill the binding table.
+     * Everything is accepted until the interface addresses could be read.
+     */
+    bool on_link(const capture::ArpPacket& arp) const {
+        return !connected.loaded() || connected.containsIpv4(arp.ifindex, arp.senderIp);
+    }
+
+    /**
+     * @brief Park an unmatched reply until its deadline; the oldest one is judged early if full.
+     */
+    void hold_reply(const capture::ArpPacket& arp, uint32_t count, uint64_t deadlineMs) {
+        if (held.size() >= MAX_HELD_REPLIES) judge_held();
+        held.push_back(HeldReply{arp, count, deadlineMs});
+    }
+
+    /**
+     * @brief Give the oldest held reply its final verdict, with every request drained so far.
+     */
+    void judge_held() {
+        const HeldReply& reply = held.front();
+        uint64_t firstMac = 0;
+        ArpRequestTracker::Verdict verdict = check_reply(reply.arp, &firstMac);
+        report_reply(reply.arp, verdict, firstMac);
+        if (is_claim(verdict)) check_claims(reply.arp, capture_ms(reply.arp), reply.count);
+        held.pop_front();
+    }
+
+    /**
+     * @brief Judge the held replies whose deadline passed.
+     * @return Milliseconds until the next deadline, -1 if none is held (a poll() timeout).
+     */
+    int release_held() {
+        if (held.empty()) return -1;
+        // Requests captured before the deadline are queued by now
+        drain_captured();
+        uint64_t nowMs = unix_now_ms();
+        while (!held.empty() && held.front().deadlineMs <= nowMs) judge_held();
+        if (held.empty()) return -1;
+        return static_cast<int>(held.front().deadlineMs - nowMs);
+    }
+
+    /**
+     * @brief Judge the frames every capture worker queued, in capture order per worker.
+     *
+     * Symmetric steering puts a request and its reply on the same worker, so
+     * each exchange is replayed in the order it was captured.
+     */
+    void drain_captured() {
+        captured_ready.drain();
+        for (auto& queue : captured) {
+            queue->drain([&](const CapturedArp& frame) { handle_frame(frame.arp, frame.count); });
+        }
+
+        unlogged_drops += captured_drops.exchange(0, std::memory_order_relaxed);
+        uint32_t now = unix_now();
+        end_alert_flood(now);
+        if (unlogged_drops == 0 || now - drops_logged_at < ALERT_INTERVAL) return;
+        Logger::log(std::to_string(unlogged_drops) + " captured ARP frame(s) dropped, the monitor fell behind",
+                    Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        unlogged_drops = 0;
+        drops_logged_at = now;
+    }
+
+    /**
+     * @brief Evict stale bindings at most once a minute.
+     */
+    void maybe_expire(uint32_t now) {
+        if (now - last_expiry < 60) return;
+        last_expiry = now;
+        bindings.expire(now);
+    }
+
+    /**
+     * @brief Event-driven loop fed by rtnetlink neighbour and route notifications.
+     * @return False if netlink is unavailable and the caller should fall back to polling.
+     */
+    bool netlink_loop(const ChangeCallback& cb) {
+        if (gateway_addr == 0) return false;
+
+        uint32_t groups = RTMGRP_NEIGH | RTMGRP_IPV4_IFADDR | (auto_gateway ? RTMGRP_IPV4_ROUTE : 0);
+        NetlinkSocket nl;
+        if (!nl.open(groups) || wakeup.fd() < 0) return false;
+
+        std::string observed;
+        bool seen = false;
+        bool route_changed = false;
+        bool addresses_changed = false;
+        bool report = false;
+        uint32_t now = unix_now();
+        auto handler = [&](const nlmsghdr& msg) {
+            NeighEntry entry;
+            if (parse_neigh(msg, entry)) {
+                if (entry.resolved) observe_binding(entry.ip, entry.mac, now, report);
+                if (entry.ip == gateway_addr) {
+                    observed = entry.resolved ? NetAddr::formatMac(entry.mac) : std::string{};
+                    seen = true;
+                }
+            } else if (DefaultGateway::isDefaultRouteMessage(msg)) {
+                route_changed = true;
+            } else if (msg.nlmsg_type == RTM_NEWADDR || msg.nlmsg_type == RTM_DELADDR) {
+                addresses_changed = true;
+            }
+        };
+
+        // Frames captured meanwhile wait in their queues until the table is loaded
+        if (!nl.dump(RTM_GETNEIGH, AF_INET, handler)) return false;
+        connected.refresh();
+        report = true;
+        last_expiry = now;
+        last_mac = normalize_mac(observed);
+        log_initial_state();
+        Logger::log("Listening for neighbour table changes (netlink)",
+                    Logger::LogType::INFO, LogPrefixes::arp_monitor);
+
+        pollfd fds[3] = {{nl.fd(), POLLIN, 0}, {wakeup.fd(), POLLIN, 0}, {captured_ready.fd(), POLLIN, 0}};
+        int timeout = -1;
         while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::seconds(interval_seconds));
+            if (::poll(fds, 3, timeout) < 0) {
+                if (errno == EINTR) continue;
+                Logger::log("poll() failed on netlink socket: " + std::string(std::strerror(errno)),
+                            Logger::LogType::ERROR, LogPrefixes::arp_monitor);
+                break;
+            }
+            if (fds[1].revents & POLLIN) wakeup.drain();
             if (!running.load()) break;
+            if (fds[2].revents & POLLIN) drain_captured();
+            timeout = release_held();
+            if (!(fds[0].revents & POLLIN)) continue;
+
+            // Only the latest state of the gateway entry within a batch matters
+            seen = false;
+            route_changed = false;
+            addresses_changed = false;
+            now = unix_now();
+
+            NetlinkSocket::RecvStatus status = nl.receive(handler);
+            if (status == NetlinkSocket::RecvStatus::OVERRUN) {
+                // Notifications were dropped: resynchronize from a full dump
+                Logger::log("Netlink receive buffer overrun, resynchronizing neighbour table",
+                            Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+                observed.clear();
+                seen = nl.dump(RTM_GETNEIGH, AF_INET, handler);
+                route_changed = true;
+                addresses_changed = true;
+            } else if (status == NetlinkSocket::RecvStatus::ERROR) {
+                Logger::log("Netlink socket error, falling back to polling",
+                            Logger::LogType::ERROR, LogPrefixes::arp_monitor);
+                return false;
+            }
+
+            if (addresses_changed) connected.refresh();
+            maybe_expire(now);
+
+            if (route_changed && refresh_gateway()) {
+                // New gateway: take its current binding as the baseline, no alert
+                observed.clear();
+                nl.dump(RTM_GETNEIGH, AF_INET, handler);
+                last_mac = normalize_mac(observed);
+                log_initial_state();
+                continue;
+            }
 
-            std::string current = normalize_mac(read_mac_from_proc_arp(gateway));
-            std::string prev = normalize_mac(last_mac);
+            if (seen) update_gateway_mac(observed, cb);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Re-read /proc/net/arp, update all bindings and return the gateway MAC.
+     */
+    std::string scan_bindings(bool report) {
+        uint32_t now = unix_now();
+        connected.refresh();
+        std::string gw_mac;
+        scan_proc_arp([&](const NeighEntry& entry) {
+            if (!entry.resolved) return;
+            observe_binding(entry.ip, entry.mac, now, report);
+            if (entry.ip == gateway_addr) gw_mac = NetAddr::formatMac(entry.mac);
+        });
+        maybe_expire(now);
+        return gw_mac;
+    }
 
-            if (current.empty() && prev.empty()) continue;
+    /**
+     * @brief Fallback loop polling /proc/net/arp every interval_seconds.
+     */
+    void poll_loop(const ChangeCallback& cb) {
+        last_mac = normalize_mac(scan_bindings(false));
+        log_initial_state();
 
-            if (current != prev) {
-                if (prev.empty()) {
-                    Logger::log("ARP entry appeared for gateway " + gateway + " : " + current,
-                                Logger::LogType::INFO, LogPrefixes::arp_monitor);
-                } else if (current.empty()) {
-                    Logger::log("ARP entry for gateway " + gateway + " disappeared (was " + prev + ")",
-                                Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+        pollfd fds[2] = {{wakeup.fd(), POLLIN, 0}, {captured_ready.fd(), POLLIN, 0}};
+        auto next_scan = std::chrono::steady_clock::now() + std::chrono::seconds(interval_seconds);
+        while (running.load()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_scan - std::chrono::steady_clock::now()).count();
+            if (remaining > 0) {
+                if (fds[0].fd >= 0) {
+                    int timeout = release_held();
+                    if (timeout < 0 || timeout > remaining) timeout = static_cast<int>(remaining);
+                    if (::poll(fds, 2, timeout) > 0) {
+                        if (fds[0].revents & POLLIN) wakeup.drain();
+                        if (fds[1].revents & POLLIN) drain_captured();
+                    }
                 } else {
-                    Logger::log("MAC change for gateway " + gateway + " : " + prev + " -> " + current,
-                                Logger::LogType::CRITICAL, LogPrefixes::arp_monitor);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(remaining));
                 }
+                continue;
+            }
+            next_scan = std::chrono::steady_clock::now() + std::chrono::seconds(interval_seconds);
 
-                if (cb) {
-                    try { cb(prev, current, gateway); } catch (...) {}
-                }
-                last_mac = current;
+            if (refresh_gateway()) {
+                last_mac = normalize_mac(scan_bindings(true));
+                log_initial_state();
+                continue;
             }
+            update_gateway_mac(scan_bindings(true), cb);
         }
     }
+
+    /**
+     * @brief Monitor loop to detect MAC changes.
+     *
+     * Prefers rtnetlink neighbour notifications; /proc/net/arp polling is kept
+     * as a fallback when netlink is unavailable. ARP frames captured on the
+     * link are decoded by the capture workers and judged here, between two
+     * kernel events, so this thread owns all the state.
+     */
+    void monitor_loop(ChangeCallback cb) {
+        if (netlink_loop(cb)) return;
+        if (!running.load()) return;
+
+        Logger::log("Netlink unavailable, polling /proc/net/arp every " +
+                    std::to_string(interval_seconds) + "s",
+                    Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        poll_loop(cb);
+    }
 };
 
 // ---------- Public Interface ----------
@@ -172,13 +859,14 @@ struct ArpMonitor::Impl {
 ArpMonitor::ArpMonitor(int poll_interval_seconds) {
     pimpl = std::make_unique<Impl>();
     pimpl->interval_seconds = (poll_interval_seconds > 0 ? poll_interval_seconds : 5);
-    pimpl->gateway = Impl::detect_gateway_ip();
+    pimpl->set_gateway(Impl::detect_gateway_ip());
 }
 
 ArpMonitor::ArpMonitor(const std::string& gateway_ip, int poll_interval_seconds) {
     pimpl = std::make_unique<Impl>();
     pimpl->interval_seconds = (poll_interval_seconds > 0 ? poll_interval_seconds : 5);
-    pimpl->gateway = gateway_ip.empty() ? Impl::detect_gateway_ip() : gateway_ip;
+    pimpl->auto_gateway = gateway_ip.empty();
+    pimpl->set_gateway(gateway_ip.empty() ? Impl::detect_gateway_ip() : gateway_ip);
 }
 
 ArpMonitor::~ArpMonitor() {
@@ -214,14 +902,60 @@ void ArpMonitor::stop() {
 
     bool expected = true;
     if (pimpl->running.compare_exchange_strong(expected, false)) {
+        pimpl->wakeup.notify();
         std::this_thread::sleep_for(100ms);
     }
 
     Logger::log("ARP monitor stopped", Logger::LogType::DEFAULT, LogPrefixes::arp_monitor);
 }
 
+void ArpMonitor::attachCapture(capture::CaptureEngine& engine) {
+    if (!pimpl) return;
+    Impl* impl = pimpl.get();
+    if (impl->captured_ready.fd() < 0) {
+        Logger::log("eventfd unavailable, not capturing ARP frames", Logger::LogType::WARNING, LogPrefixes::arp_monitor);
+        return;
+    }
+    unsigned workers = engine.workerCount() > 0 ? engine.workerCount() : 1;
+    // A request may wait one block timeout in its ring, the monitor thread another
+    impl->hold_ms = 2 * capture::CaptureEngine::RETIRE_TIMEOUT_MS + HOLD_MARGIN_MS;
+    impl->captured.clear();
+    for (unsigned i = 0; i < workers; ++i) {
+        impl->captured.push_back(std::make_unique<SpscQueue<CapturedArp>>(CAPTURE_QUEUE_SIZE));
+    }
+
+    engine.subscribe(capture::Interest::ARP, [impl](const capture::PacketView* views, std::size_t count) {
+        // A batch comes from a single worker, the only producer of its queue
+        SpscQueue<CapturedArp>& queue = *impl->captured[views[0].worker % impl->captured.size()];
+        bool queued = false;
+        for (std::size_t i = 0; i < count; ++i) {
+            CapturedArp* slot = queue.acquire();
+            if (!slot) {
+                impl->captured_drops.fetch_add(count - i, std::memory_order_relaxed);
+                break;
+            }
+            if (!capture::parseArpFrame(views[i].frame, slot->arp) || slot->arp.isProbe()) continue;
+            slot->count = views[i].count;
+            queue.commit();
+            queued = true;
+        }
+        if (queued) impl->captured_ready.notify();
+    });
+}
+
+void ArpMonitor::setRateTableMemory(std::size_t bytes) {
+    if (!pimpl) return;
+    pimpl->rates = ArpRateTracker(bytes);
+}
+
+void ArpMonitor::setNotificationCallback(NotificationCallback cb) {
+    if (!pimpl) return;
+    std::lock_guard<std::mutex> lock(pimpl->mtx);
+    pimpl->notify_cb = std::move(cb);
+}
+
 std::string ArpMonitor::gateway_ip() const {
-    return pimpl ? pimpl->gateway : std::string{};
+    return pimpl ? pimpl->current_gateway() : std::string{};
 }
 
 } // namespace monitors
@@ -0,0 +1,101 @@
+/**
+ * @file ArpRateTracker.cpp
+ * @brief Per-source-MAC token buckets for ARP storm and poisoning cadence detection.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/ArpRateTracker.hpp"
+
+#include <algorithm>
+
+namespace monitors {
+
+namespace {
+
+/// Tokens are stored in thousandths so slow rates still refill between events
+constexpr uint64_t TOKEN = 1000;
+
+/// Minimum delay between two sweeps of idle sources (milliseconds)
+constexpr uint64_t SWEEP_INTERVAL_MS = 1000;
+
+uint32_t capacity(const ArpRateTracker::Limit& limit) noexcept {
+    return static_cast<uint32_t>(std::min<uint64_t>(uint64_t{limit.burst} * TOKEN, UINT32_MAX));
+}
+
+/**
+ * @brief Add the tokens earned over elapsedMs, capped at the bucket size.
+ */
+uint32_t credit(uint32_t tokens, const ArpRateTracker::Limit& limit, uint64_t elapsedMs) noexcept {
+    // perMinute tokens per 60000 ms == perMinute / 60 thousandths per ms
+    uint64_t earned = elapsedMs * limit.perMinute / 60;
+    return static_cast<uint32_t>(std::min<uint64_t>(tokens + earned, capacity(limit)));
+}
+
+} // namespace
+
+ArpRateTracker::ArpRateTracker(std::size_t memoryBytes, Limit frameLimit, Limit claimLimit)
+    : m_sources(256, FlatHashMap<uint64_t, Source>::maxSizeForBytes(memoryBytes)),
+      m_frameLimit(frameLimit), m_claimLimit(claimLimit) {}
+
+void ArpRateTracker::refill(Source& source, uint64_t nowMs) const noexcept {
+    if (!source.initialized) {
+        source.initialized = true;
+        source.lastMs = nowMs;
+        source.frameTokens = capacity(m_frameLimit);
+        source.claimTokens = capacity(m_claimLimit);
+        return;
+    }
+    if (nowMs <= source.lastMs) return;
+
+    uint64_t elapsed = nowMs - source.lastMs;
+    source.lastMs = nowMs;
+    source.frameTokens = credit(source.frameTokens, m_frameLimit, elapsed);
+    source.claimTokens = credit(source.claimTokens, m_claimLimit, elapsed);
+
+    // A full bucket ends the episode: the next time it runs dry is news again
+    if (source.frameTokens == capacity(m_frameLimit)) source.reported &= ~(1u << 0);
+    if (source.claimTokens == capacity(m_claimLimit)) source.reported &= ~(1u << 1);
+}
+
+bool ArpRateTracker::idle(const Source& source, uint64_t nowMs) const noexcept {
+    uint64_t elapsed = nowMs > source.lastMs ? nowMs - source.lastMs : 0;
+    return credit(source.frameTokens, m_frameLimit, elapsed) == capacity(m_frameLimit) &&
+           credit(source.claimTokens, m_claimLimit, elapsed) == capacity(m_claimLimit);
+}
+
+ArpRateTracker::Result ArpRateTracker::take(Source& source, Kind kind, uint32_t count) noexcept {
+    uint32_t& tokens = kind == Kind::FRAME ? source.frameTokens : source.claimTokens;
+    uint8_t bit = kind == Kind::FRAME ? 1u << 0 : 1u << 1;
+
+    uint64_t cost = uint64_t{count} * TOKEN;
+    if (tokens >= cost) {
+        tokens -= static_cast<uint32_t>(cost);
+        return Result::NORMAL;
+    }
+    tokens = 0;
+    if (source.reported & bit) return Result::THROTTLED;
+    source.reported |= bit;
+    return Result::EXCEEDED;
+}
+
+ArpRateTracker::Result ArpRateTracker::record(uint64_t mac, Kind kind, uint64_t nowMs, uint32_t count) {
+    auto [source, inserted] = m_sources.insert(mac);
+    if (!source && nowMs - m_lastSweepMs >= SWEEP_INTERVAL_MS) {
+        // Full: forget sources whose buckets are back to full, then retry once
+        m_lastSweepMs = nowMs;
+        if (m_sources.eraseIf([&](uint64_t, const Source& s) { return idle(s, nowMs); }) > 0) {
+            source = m_sources.insert(mac).first;
+        }
+    }
+
+    if (!source) {
+        refill(m_untracked, nowMs);
+        Result result = take(m_untracked, kind, count);
+        return result == Result::EXCEEDED ? Result::OVERFLOW : result;
+    }
+    refill(*source, nowMs);
+    return take(*source, kind, count);
+}
+
+} // namespace monitors
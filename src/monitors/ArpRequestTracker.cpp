@@ -0,0 +1,65 @@
+/**
+ * @file ArpRequestTracker.cpp
+ * @brief Matches captured ARP replies against recently seen requests.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/ArpRequestTracker.hpp"
+
+namespace monitors {
+
+ArpRequestTracker::ArpRequestTracker(std::size_t maxPending, uint32_t timeoutMs)
+    : m_pending(256, maxPending), m_timers(maxPending),
+      m_timeoutTicks(timeoutMs / TICK_MS > 0 ? timeoutMs / TICK_MS : 1) {}
+
+void ArpRequestTracker::advance(uint64_t nowMs) {
+    uint64_t tick = nowMs / TICK_MS;
+    if (!m_started) {
+        // Requests sent before capture started are unknown: be lenient for one timeout
+        m_started = true;
+        m_timers = TimingWheel<uint64_t>(m_timers.capacity(), tick);
+        m_blindUntil = tick + m_timeoutTicks;
+        return;
+    }
+    m_timers.advance(tick, [this](uint64_t k) { m_pending.erase(k); });
+}
+
+void ArpRequestTracker::onRequest(uint32_t requesterIp, uint32_t targetIp, uint64_t nowMs) {
+    advance(nowMs);
+    uint64_t expiry = m_timers.now() + m_timeoutTicks;
+    uint64_t k = key(targetIp, requesterIp);
+
+    auto [exchange, inserted] = m_pending.insert(k);
+    if (exchange && !inserted) {
+        // Retransmission: keep the answer seen so far, extend the window
+        m_timers.cancel(exchange->timer);
+        exchange->timer = m_timers.schedule(expiry, k);
+        return;
+    }
+    if (exchange) {
+        exchange->timer = m_timers.schedule(expiry, k);
+        if (exchange->timer != TimingWheel<uint64_t>::INVALID_HANDLE) return;
+        m_pending.erase(k);
+    }
+    // Table full: this request is lost, so its reply cannot be judged
+    m_blindUntil = expiry;
+}
+
+ArpRequestTracker::Verdict ArpRequestTracker::onReply(uint32_t senderIp, uint64_t senderMac,
+                                                      uint32_t targetIp, uint64_t nowMs,
+                                                      uint64_t* firstMac) {
+    advance(nowMs);
+    Exchange* exchange = m_pending.find(key(senderIp, targetIp));
+    if (!exchange) {
+        return m_timers.now() < m_blindUntil ? Verdict::UNVERIFIED : Verdict::UNSOLICITED;
+    }
+    if (exchange->answerMac == 0 || exchange->answerMac == senderMac) {
+        exchange->answerMac = senderMac;
+        return Verdict::SOLICITED;
+    }
+    if (firstMac) *firstMac = exchange->answerMac;
+    return Verdict::CONFLICTING;
+}
+
+} // namespace monitors
@@ -0,0 +1,151 @@
+/**
+ * @file BindingTracker.cpp
+ * @brief IP -> MAC binding table for every neighbour on the LAN (ARP and NDP).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/BindingTracker.hpp"
+
+#include <cstdint>
+
+namespace monitors {
+
+template <typename Address>
+BindingTracker<Address>::BindingTracker(std::size_t maxBindings, uint32_t retentionSeconds, std::size_t maxWireOnly)
+    : m_table(256, maxBindings), m_claims(256, maxBindings), m_retentionSeconds(retentionSeconds),
+      m_maxWireOnly(maxWireOnly > 0 ? maxWireOnly : (maxBindings / 4 > 0 ? maxBindings / 4 : 1)) {}
+
+template <typename Address>
+typename BindingTracker<Address>::Update BindingTracker<Address>::observe(const Address& ip, uint64_t mac,
+                                                                         uint32_t now, Origin origin,
+                                                                         uint64_t* previousMac) {
+    bool wire = origin == Origin::WIRE;
+    NeighborBinding* binding = m_table.find(ip);
+    if (!binding) {
+        // Out of room: sweep (rate-limited), then retry once
+        if (wire && m_wireOnly >= m_maxWireOnly) {
+            makeRoom(now);
+            if (m_wireOnly >= m_maxWireOnly) return Update::DROPPED;
+        }
+        binding = m_table.insert(ip).first;
+        if (!binding) {
+            makeRoom(now);
+            binding = m_table.insert(ip).first;
+            if (!binding) return Update::DROPPED;
+        }
+        binding->mac = mac;
+        binding->confirmed = !wire;
+        binding->firstSeen = now;
+        binding->lastSeen = now;
+        if (wire) ++m_wireOnly;
+        claim(mac);
+        return Update::NEW;
+    }
+
+    if (!wire && !binding->confirmed) {
+        binding->confirmed = true;
+        --m_wireOnly;
+    }
+
+    if (binding->mac == mac) {
+        binding->lastSeen = now;
+        return Update::REFRESHED;
+    }
+
+    if (previousMac) *previousMac = binding->mac;
+    uint64_t oldMac = binding->mac;
+    binding->mac = mac;
+    binding->firstSeen = now;
+    binding->lastSeen = now;
+    release(oldMac);
+    claim(mac);
+    return Update::REBOUND;
+}
+
+template <typename Address>
+const NeighborBinding* BindingTracker<Address>::find(const Address& ip) const noexcept {
+    return m_table.find(ip);
+}
+
+template <typename Address>
+uint32_t BindingTracker<Address>::claimCount(uint64_t mac) const noexcept {
+    const MacClaims* c = m_claims.find(mac);
+    return c ? c->ipCount : 0;
+}
+
+template <typename Address>
+bool BindingTracker<Address>::checkGatewayFanIn(const Address& gatewayIp, uint64_t mac) noexcept {
+    MacClaims* c = m_claims.find(mac);
+    if (!c) return false;
+
+    const NeighborBinding* gw = m_table.find(gatewayIp);
+    bool fanIn = gw && gw->mac == mac && c->ipCount >= 2;
+    if (!fanIn) {
+        c->fanInReported = false;
+        return false;
+    }
+    if (c->fanInReported) return false;
+    c->fanInReported = true;
+    return true;
+}
+
+template <typename Address>
+std::size_t BindingTracker<Address>::expire(uint32_t now) {
+    return m_table.eraseIf([&](const Address&, const NeighborBinding& b) {
+        bool stale = now > b.lastSeen && now - b.lastSeen > m_retentionSeconds;
+        if (!stale) return false;
+        release(b.mac);
+        if (!b.confirmed) --m_wireOnly;
+        return true;
+    });
+}
+
+template <typename Address>
+void BindingTracker<Address>::makeRoom(uint32_t now) {
+    // Under a flood of invented addresses every frame would otherwise scan the table
+    if (now < m_nextSweep) return;
+    m_nextSweep = now + SWEEP_INTERVAL_SECONDS;
+    expire(now);
+    if (m_wireOnly < m_maxWireOnly && !m_table.full()) return;
+    if (m_wireOnly == 0) return;
+
+    // Least recently seen half of the wire-only bindings, by lastSeen
+    uint32_t oldest = UINT32_MAX;
+    uint32_t newest = 0;
+    m_table.forEach([&](const Address&, const NeighborBinding& b) {
+        if (b.confirmed) return;
+        if (b.lastSeen < oldest) oldest = b.lastSeen;
+        if (b.lastSeen > newest) newest = b.lastSeen;
+    });
+    uint32_t cutoff = oldest + (newest - oldest) / 2;
+    m_table.eraseIf([&](const Address&, const NeighborBinding& b) {
+        if (b.confirmed || b.lastSeen > cutoff) return false;
+        release(b.mac);
+        --m_wireOnly;
+        return true;
+    });
+}
+
+template <typename Address>
+void BindingTracker<Address>::claim(uint64_t mac) {
+    // Never full: there are at most as many claiming MACs as bindings
+    MacClaims* c = m_claims.insert(mac).first;
+    if (c) ++c->ipCount;
+}
+
+template <typename Address>
+void BindingTracker<Address>::release(uint64_t mac) noexcept {
+    MacClaims* c = m_claims.find(mac);
+    if (!c) return;
+    if (--c->ipCount == 0) {
+        m_claims.erase(mac);
+    } else if (c->ipCount < 2) {
+        c->fanInReported = false;
+    }
+}
+
+template class BindingTracker<uint32_t>;
+template class BindingTracker<Ipv6Addr>;
+
+} // namespace monitors
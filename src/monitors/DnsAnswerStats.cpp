@@ -0,0 +1,92 @@
+/**
+ * @file DnsAnswerStats.cpp
+ * @brief Per-name history of DNS answers, flagging sudden changes of network or TTL.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/DnsAnswerStats.hpp"
+
+#include <algorithm>
+
+namespace monitors {
+
+DnsAnswerStats::DnsAnswerStats(std::size_t maxNames) : m_names(maxNames > 0 ? maxNames : 1) {}
+
+uint32_t DnsAnswerStats::networkKey(const Ipv6Addr& addr) noexcept {
+    // IPv4 /24s stay below 2^24; IPv6 /48s are hashed into the upper half so both never collide
+    if (NetAddr::isMappedIpv4(addr)) return static_cast<uint32_t>(addr.lo) >> 8;
+    return static_cast<uint32_t>(hashMix64(addr.hi >> 16)) | 0x80000000u;
+}
+
+DnsAnswerStats::Anomaly DnsAnswerStats::observe(uint64_t questionHash, const uint32_t* networks, std::size_t count,
+                                                uint32_t ttl, uint32_t now, uint32_t& usualTtl) {
+    if (count == 0) return Anomaly::NONE;
+
+    if (!m_names.find(questionHash)) {
+        uint8_t seen = m_sketch.add(hashMix64(questionHash));
+        if (++m_additions == AGING_PERIOD) {
+            m_sketch.halve();
+            m_additions = 0;
+        }
+        if (seen < ADMIT_COUNT) return Anomaly::NONE;
+    }
+
+    auto [stats, inserted] = m_names.touch(questionHash);
+    if (inserted) {
+        learn(*stats, networks, count);
+        stats->maxTtl = ttl;
+        stats->answers = 1;
+        return Anomaly::NONE;
+    }
+
+    Anomaly result = Anomaly::NONE;
+    if (stats->answers >= LEARN_ANSWERS) {
+        bool known = false;
+        for (std::size_t i = 0; i < count && !known; ++i) {
+            known = std::find(stats->networks, stats->networks + stats->networkCount, networks[i]) !=
+                    stats->networks + stats->networkCount;
+        }
+        if (!known && stats->changes < VOLATILE_CHANGES) {
+            result = Anomaly::NEW_NETWORK;
+        } else if (ttl > std::max<uint64_t>(uint64_t{stats->maxTtl} * TTL_FACTOR, MIN_FLAGGED_TTL)) {
+            result = Anomaly::LONG_TTL;
+        }
+    }
+
+    usualTtl = stats->maxTtl;
+    learn(*stats, networks, count);
+    stats->maxTtl = std::max(stats->maxTtl, ttl);
+    if (stats->answers < UINT16_MAX) ++stats->answers;
+
+    if (result == Anomaly::NONE) return result;
+    if (stats->alerted && now - stats->alertedAt < ALERT_INTERVAL) return Anomaly::NONE;
+    stats->alerted = true;
+    stats->alertedAt = now;
+    return result;
+}
+
+void DnsAnswerStats::learn(NameStats& stats, const uint32_t* networks, std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+        auto* end = stats.networks + stats.networkCount;
+        auto* found = std::find(stats.networks, end, networks[i]);
+        if (found != end) {
+            uint8_t& hits = stats.hits[found - stats.networks];
+            if (hits < UINT8_MAX) ++hits;
+            continue;
+        }
+
+        // Networks first seen once learned count towards volatility
+        if (stats.answers >= LEARN_ANSWERS && stats.changes < UINT8_MAX) ++stats.changes;
+        std::size_t slot = stats.networkCount;
+        if (slot == MAX_NETWORKS) {
+            slot = static_cast<std::size_t>(std::min_element(stats.hits, stats.hits + MAX_NETWORKS) - stats.hits);
+        } else {
+            ++stats.networkCount;
+        }
+        stats.networks[slot] = networks[i];
+        stats.hits[slot] = 1;
+    }
+}
+
+} // namespace monitors
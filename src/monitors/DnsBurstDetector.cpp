@@ -0,0 +1,28 @@
+/**
+ * @file DnsBurstDetector.cpp
+ * @brief Flags floods of guessed DNS responses aimed at one query (Kaminsky-style poisoning).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/DnsBurstDetector.hpp"
+
+namespace monitors {
+
+DnsBurstDetector::DnsBurstDetector(uint32_t threshold, uint32_t windowMs, std::size_t maxQuestions)
+    : m_questions(maxQuestions), m_threshold(threshold > 0 ? threshold : 1), m_window(windowMs > 0 ? windowMs : 1) {}
+
+bool DnsBurstDetector::observe(const Ipv6Addr& resolver, uint64_t questionHash, uint64_t nowMs, uint32_t& count) {
+    // Collisions only merge two questions' counts; the key stays one word
+    uint64_t key = FlatHash<Ipv6Addr>{}(resolver) ^ questionHash;
+    auto [counter, inserted] = m_questions.touch(key);
+    if (inserted || nowMs - counter->windowStart >= m_window) {
+        counter->windowStart = nowMs;
+        counter->count = 0;
+    }
+    if (counter->count < UINT32_MAX) ++counter->count;
+    count = counter->count;
+    return count == m_threshold;
+}
+
+} // namespace monitors
@@ -0,0 +1,319 @@
+/**
+ * @file DnsConsistencyChecker.cpp
+ * @brief Re-queries sampled names through trusted resolvers and reports diverging answers.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/DnsConsistencyChecker.hpp"
+#include "capture/DnsPacket.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+
+namespace monitors {
+
+namespace {
+
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t TYPE_AAAA = 28;
+constexpr uint16_t CLASS_IN = 1;
+constexpr uint8_t RCODE_NXDOMAIN = 3;
+
+/// Wait between submissions while the rate limit holds queries back (milliseconds)
+constexpr int RATE_SLICE_MS = 50;
+
+/// Addresses listed per side in a report
+constexpr std::size_t REPORTED_ADDRESSES = 4;
+
+/// Globally routed, i.e. something a public resolver can confirm
+bool is_public(const Ipv6Addr& addr) noexcept {
+    if (NetAddr::isMappedIpv4(addr)) {
+        uint32_t ip = static_cast<uint32_t>(addr.lo);
+        uint32_t first = ip >> 24;
+        return first != 0 && first != 10 && first != 127 && first < 224 &&
+               (ip >> 16) != 0xa9fe &&   // 169.254/16
+               (ip >> 20) != 0xac1 &&    // 172.16/12
+               (ip >> 16) != 0xc0a8 &&   // 192.168/16
+               (ip >> 22) != 0x191;      // 100.64/10
+    }
+    return !(addr.hi == 0 && addr.lo <= 1) &&
+           (addr.hi >> 57) != 0x7e &&    // fc00::/7
+           (addr.hi >> 54) != 0x3fa &&   // fe80::/10
+           (addr.hi >> 56) != 0xff;      // ff00::/8
+}
+
+/// Same /24 (IPv4) or /48 (IPv6)
+bool same_network(const Ipv6Addr& a, const Ipv6Addr& b) noexcept {
+    if (NetAddr::isMappedIpv4(a)) return NetAddr::isMappedIpv4(b) && (a.lo >> 8) == (b.lo >> 8);
+    return !NetAddr::isMappedIpv4(b) && (a.hi >> 16) == (b.hi >> 16);
+}
+
+std::string format_addresses(const Ipv6Addr* addrs, std::size_t count) {
+    std::string out;
+    for (std::size_t i = 0; i < count && i < REPORTED_ADDRESSES; ++i) {
+        if (i > 0) out += ", ";
+        out += NetAddr::formatIp(addrs[i]);
+    }
+    if (count > REPORTED_ADDRESSES) out += ", ...";
+    return out;
+}
+
+bool parse_port(const std::string& text, uint16_t& port) noexcept {
+    auto digit = [](unsigned char c) { return std::isdigit(c) != 0; };
+    if (text.empty() || text.size() > 5 || !std::all_of(text.begin(), text.end(), digit)) return false;
+    unsigned long value = std::stoul(text);
+    if (value == 0 || value > 65535) return false;
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+/// "address", "IPv4:port" or "[IPv6]:port"
+bool parse_server(const std::string& entry, DnsQueryEngine::Server& server) {
+    server.port = 53;
+    if (!entry.empty() && entry.front() == '[') {
+        std::size_t close = entry.find(']');
+        if (close == std::string::npos) return false;
+        if (close + 1 < entry.size() && (entry[close + 1] != ':' || !parse_port(entry.substr(close + 2), server.port))) {
+            return false;
+        }
+        return NetAddr::parseIpv6(entry.substr(1, close - 1), server.address);
+    }
+    std::size_t colon = entry.find(':');
+    if (colon != std::string::npos && entry.find(':', colon + 1) == std::string::npos) {
+        uint32_t ip = 0;
+        if (!NetAddr::parseIpv4(entry.substr(0, colon), ip) || !parse_port(entry.substr(colon + 1), server.port)) {
+            return false;
+        }
+        server.address = NetAddr::mapIpv4(ip);
+        return true;
+    }
+    return NetAddr::parseIp(entry, server.address);
+}
+
+} // namespace
+
+DnsConsistencyChecker::~DnsConsistencyChecker() {
+    stop();
+}
+
+bool DnsConsistencyChecker::setTrustedResolvers(const std::vector<std::string>& entries, std::string& error) {
+    m_trusted.clear();
+    for (const auto& entry : entries) {
+        DnsQueryEngine::Server server;
+        if (!parse_server(entry, server)) {
+            error = "Invalid trusted resolver '" + entry + "'";
+            m_trusted.clear();
+            return false;
+        }
+        if (m_trusted.size() == MAX_TRUSTED) {
+            error = "Too many trusted resolvers, keeping the first " + std::to_string(MAX_TRUSTED);
+            return false;
+        }
+        m_trusted.push_back(server);
+    }
+    return true;
+}
+
+void DnsConsistencyChecker::setLimits(std::size_t maxInFlight, uint32_t queriesPerSecond) {
+    m_maxInFlight = maxInFlight > 0 ? maxInFlight : 1;
+    m_rate = queriesPerSecond > 0 ? queriesPerSecond : 1;
+}
+
+void DnsConsistencyChecker::setNotificationCallback(NotificationCallback cb) {
+    m_notify = std::move(cb);
+}
+
+bool DnsConsistencyChecker::start(std::string& error) {
+    if (m_running.load() || m_trusted.empty()) return false;
+    m_engine = std::make_unique<DnsQueryEngine>(m_maxInFlight, m_rate);
+    if (!m_engine->open(m_wakeup.fd(), error)) {
+        m_engine.reset();
+        return false;
+    }
+    // Every check keeps at least one query in flight
+    m_checks.assign(m_maxInFlight, Check{});
+    m_running = true;
+    m_thread = std::thread(&DnsConsistencyChecker::loop, this);
+    return true;
+}
+
+void DnsConsistencyChecker::stop() {
+    bool expected = true;
+    if (!m_running.compare_exchange_strong(expected, false)) return;
+    m_wakeup.notify();
+    if (m_thread.joinable()) m_thread.join();
+    m_engine.reset();
+}
+
+void DnsConsistencyChecker::offer(const capture::DnsPacket& dns, uint32_t now) {
+    if (!m_running.load() || !dns.response || dns.rcode != 0 || dns.truncated || dns.qclass != CLASS_IN ||
+        (dns.qtype != TYPE_A && dns.qtype != TYPE_AAAA) || dns.questionNameLen == 0) {
+        return;
+    }
+
+    Sample sample;
+    capture::DnsAnswerReader reader(dns);
+    capture::DnsRecord record;
+    while (sample.addressCount < sample.addresses.size() && reader.next(record)) {
+        if (record.type != dns.qtype) continue;
+        Ipv6Addr addr;
+        if (record.type == TYPE_A && record.rdataLen == 4) {
+            uint32_t ip;
+            std::memcpy(&ip, record.rdata, 4);
+            addr = NetAddr::mapIpv4(ip);
+        } else if (record.type == TYPE_AAAA && record.rdataLen == 16) {
+            addr = NetAddr::packIpv6(record.rdata);
+        } else {
+            continue;
+        }
+        if (!is_public(addr)) return;
+        sample.addresses[sample.addressCount++] = addr;
+    }
+    if (sample.addressCount == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [offered, inserted] = m_recent.touch(dns.questionHash);
+        if (!inserted && now - *offered < RECHECK_INTERVAL) return;
+        if (m_backlogSize == BACKLOG) return;
+        *offered = now;
+
+        sample.name = capture::dnsQuestionName(dns);
+        sample.questionHash = dns.questionHash;
+        std::memcpy(sample.qname.data(), dns.message + 12, dns.questionNameLen);
+        sample.qnameLen = dns.questionNameLen;
+        sample.qtype = dns.qtype;
+        sample.resolver = dns.source;
+        m_backlog[(m_backlogHead + m_backlogSize++) % BACKLOG] = std::move(sample);
+    }
+    m_wakeup.notify();
+}
+
+bool DnsConsistencyChecker::submitPending() {
+    for (std::size_t i = 0; i < m_checks.size(); ++i) {
+        Check& check = m_checks[i];
+        if (!check.active) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_backlogSize == 0) continue;
+            check = Check{};
+            check.sample = std::move(m_backlog[m_backlogHead]);
+            m_backlogHead = (m_backlogHead + 1) % BACKLOG;
+            --m_backlogSize;
+            check.active = true;
+        }
+        while (check.submitted < m_trusted.size()) {
+            if (!m_engine->ready()) return true;
+            const DnsQueryEngine::Server& server = m_trusted[check.submitted++];
+            // A refused query (e.g. no IPv6 socket) only leaves that resolver out
+            if (m_engine->submit(server, check.sample.qname.data(), check.sample.qnameLen, check.sample.qtype, i)) {
+                ++check.outstanding;
+            }
+        }
+        if (check.outstanding == 0) {
+            judge(check);
+            check.active = false;
+        }
+    }
+    return false;
+}
+
+void DnsConsistencyChecker::loop() {
+    Logger::log("Checking DNS answers against " + std::to_string(m_trusted.size()) + " trusted resolver(s), at most " +
+                    std::to_string(m_rate) + " queries/s",
+                Logger::LogType::INFO, LogPrefixes::dns_monitor);
+    std::vector<DnsQueryEngine::Reply> replies;
+    while (m_running.load()) {
+        bool throttled = submitPending();
+        replies.clear();
+        m_engine->poll(throttled ? RATE_SLICE_MS : -1, replies);
+        m_wakeup.drain();
+
+        for (const auto& reply : replies) {
+            if (reply.tag >= m_checks.size()) continue;
+            Check& check = m_checks[reply.tag];
+            if (!check.active || check.outstanding == 0) continue;
+            --check.outstanding;
+            if (reply.answered) {
+                ++check.replies;
+                if (reply.rcode == RCODE_NXDOMAIN) ++check.nxdomain;
+                uint8_t before = check.trustedCount;
+                for (uint8_t a = 0; a < reply.addressCount && check.trustedCount < check.trusted.size(); ++a) {
+                    check.trusted[check.trustedCount++] = reply.addresses[a];
+                }
+                if (check.trustedCount > before) check.replyEnds[++check.addressReplies] = check.trustedCount;
+            }
+            if (check.outstanding == 0 && check.submitted == m_trusted.size()) {
+                judge(check);
+                check.active = false;
+            }
+        }
+    }
+}
+
+void DnsConsistencyChecker::judge(const Check& check) {
+    const Sample& sample = check.sample;
+    if (check.replies == 0) return;
+
+    std::string verdict;
+    if (check.trustedCount == 0) {
+        // NODATA or SERVFAIL somewhere: inconclusive
+        if (check.nxdomain != check.replies) return;
+        verdict = "trusted resolvers say the name does not exist";
+    } else {
+        for (uint8_t l = 0; l < sample.addressCount; ++l) {
+            for (uint8_t t = 0; t < check.trustedCount; ++t) {
+                if (same_network(sample.addresses[l], check.trusted[t])) return;
+            }
+        }
+        verdict = "trusted resolvers answered " + format_addresses(check.trusted.data(), check.trustedCount);
+    }
+
+    std::string report = "Resolver " + NetAddr::formatIp(sample.resolver) + " answered " + sample.name + " with " +
+                         format_addresses(sample.addresses.data(), sample.addressCount) + ", but " + verdict;
+    if (!trustedAgree(check)) {
+        // Each trusted resolver gets its own CDN answer: nothing to compare with
+        Logger::log("DNS answers differ, but so do the trusted resolvers: " + report,
+                    Logger::LogType::INFO, LogPrefixes::dns_monitor);
+        return;
+    }
+
+    uint32_t now = static_cast<uint32_t>(std::time(nullptr));
+    auto [suspected, inserted] = m_suspects.touch(sample.questionHash);
+    if (inserted || now - *suspected > RECHECK_INTERVAL) {
+        // First divergence: let the next answer for the name through early to confirm it
+        *suspected = now;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (uint32_t* offered = m_recent.find(sample.questionHash)) {
+                *offered = now + CONFIRM_DELAY - RECHECK_INTERVAL;
+            }
+        }
+        Logger::log("Unconfirmed DNS divergence, rechecking on the next answer: " + report,
+                    Logger::LogType::INFO, LogPrefixes::dns_monitor);
+        return;
+    }
+    m_suspects.erase(sample.questionHash);
+
+    if (m_notify) m_notify("DNS Consistency Alert", report + " (confirmed twice)");
+}
+
+bool DnsConsistencyChecker::trustedAgree(const Check& check) noexcept {
+    for (uint8_t a = 0; a < check.addressReplies; ++a) {
+        for (uint8_t b = a + 1; b < check.addressReplies; ++b) {
+            bool shared = false;
+            for (uint8_t i = check.replyEnds[a]; i < check.replyEnds[a + 1] && !shared; ++i) {
+                for (uint8_t j = check.replyEnds[b]; j < check.replyEnds[b + 1] && !shared; ++j) {
+                    shared = same_network(check.trusted[i], check.trusted[j]);
+                }
+            }
+            if (!shared) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace monitors
@@ -6,12 +6,16 @@
  */
 
 #include "monitors/DnsMonitor.hpp"
+#include "capture/CaptureEngine.hpp"
+#include "capture/DnsPacket.hpp"
 #include "monitors/Init.hpp"
+#include "utils/FileWatcher.hpp"
 #include "utils/Logger.hpp"
-
-#include "lib/json.hpp"
+#include "constants.hpp"
 
 #include <algorithm>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <sstream>
 #include <thread>
@@ -24,6 +28,9 @@
 #pragma comment(lib, "Iphlpapi.lib")
 #pragma comment(lib, "Ws2_32.lib")
 #else
+#include <cerrno>
+#include <poll.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -34,6 +41,18 @@
 namespace monitors {
 
 // -------------------- Utility --------------------
+#ifdef __linux__
+/// Files that carry the resolver configuration; symlinks are followed by FileWatcher
+static const std::vector<std::string> RESOLVER_FILES = {
+    "/etc/resolv.conf",
+    "/run/systemd/resolve/resolv.conf",
+    "/run/systemd/resolve/stub-resolv.conf",
+    "/run/NetworkManager/resolv.conf",
+    "/run/NetworkManager/no-stub-resolv.conf",
+};
+#endif
+
+
 static std::string normalizeIpString(std::string s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(),
         [](unsigned char ch){ return !std::isspace(ch); }));
@@ -42,6 +61,19 @@ static std::string normalizeIpString(std::string s) {
     return s;
 }
 
+/// Resolver address as captured: IPv4 as ::ffff:a.b.c.d, scope suffix dropped
+static bool parseResolver(const std::string& text, Ipv6Addr& addr) {
+    return NetAddr::parseIp(text.substr(0, text.find('%')), addr);
+}
+
+/// Record types whose answers feed DnsAnswerStats
+static constexpr uint16_t DNS_TYPE_A = 1;
+static constexpr uint16_t DNS_TYPE_AAAA = 28;
+static constexpr uint16_t DNS_CLASS_IN = 1;
+
+/// Addresses of an answer judged by DnsAnswerStats
+static constexpr std::size_t MAX_ANSWER_ADDRESSES = 8;
+
 // -------------------- Constructors --------------------
 DnsMonitor::DnsMonitor()
     : m_pollInterval(DEFAULT_POLL_INTERVAL), m_running(false), m_alerting(false) {}
@@ -58,11 +90,45 @@ DnsMonitor::~DnsMonitor() {
     stop();
 }
 
+void DnsMonitor::attachCapture(capture::CaptureEngine& engine) {
+    if (m_alertsReady.fd() < 0) {
+        Logger::log("eventfd unavailable, not capturing DNS traffic", Logger::LogType::WARNING, LogPrefixes::dns_monitor);
+        return;
+    }
+    unsigned workers = engine.workerCount() > 0 ? engine.workerCount() : 1;
+    std::size_t names = std::max(MAX_ANSWER_NAMES / workers, MIN_SHARD_NAMES);
+    std::size_t pending = std::max(DnsTransactionTracker::DEFAULT_MAX_PENDING / workers, MIN_SHARD_PENDING);
+    m_shards.clear();
+    for (unsigned i = 0; i < workers; ++i) m_shards.push_back(std::make_unique<WorkerShard>(names, pending));
+
+    engine.subscribe(capture::Interest::DNS, [this](const capture::PacketView* views, std::size_t count) {
+        if (m_running.load()) handleDns(views, count);
+    });
+}
+
+void DnsMonitor::setConsistencyCheck(const std::vector<std::string>& trustedResolvers, std::size_t maxInFlight,
+                                     uint32_t queriesPerSecond) {
+    std::string error;
+    if (!m_consistency.setTrustedResolvers(trustedResolvers, error)) {
+        Logger::log(error, Logger::LogType::WARNING, LogPrefixes::dns_monitor);
+    }
+    m_consistency.setLimits(maxInFlight, queriesPerSecond);
+    m_consistency.setNotificationCallback([this](const std::string& title, const std::string& body) {
+        notify(title, body);
+    });
+}
+
 // -------------------- Control --------------------
 void DnsMonitor::start() {
     Logger::log("DNS monitor enabled", Logger::LogType::DEFAULT, LogPrefixes::dns_monitor);
     bool expected = false;
     if (!m_running.compare_exchange_strong(expected, true)) return;
+    if (m_consistency.enabled()) {
+        std::string error;
+        if (!m_consistency.start(error)) {
+            Logger::log("DNS consistency check disabled: " + error, Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+        }
+    }
     m_thread = std::thread(&DnsMonitor::workerLoop, this);
 }
 
@@ -72,8 +138,10 @@ void DnsMonitor::stop() {
 
     bool expected = true;
     if (m_running.compare_exchange_strong(expected, false)) {
+        m_wakeup.notify();
         if (m_thread.joinable()) m_thread.join();
     }
+    m_consistency.stop();
 
     Logger::log("DNS monitor stopped", Logger::LogType::DEFAULT, LogPrefixes::dns_monitor);
 }
@@ -88,6 +156,11 @@ void DnsMonitor::setKnownDnsPath(const std::string& path) {
     loadKnownDnsFromFile(path);
 }
 
+void DnsMonitor::setKnownDnsDbPath(const std::string& path) {
+    std::lock_guard<std::recursive_mutex> lk(m_mutex);
+    m_knownDbPath = path;
+}
+
 std::string DnsMonitor::getKnownDnsPath() const {
     std::lock_guard<std::recursive_mutex> lk(m_mutex);
     return m_knownDnsPath;
@@ -115,46 +188,116 @@ bool DnsMonitor::isInitialized() const {
 
 // -------------------- Worker --------------------
 void DnsMonitor::workerLoop() {
+#ifdef __linux__
+    if (watchLoop()) return;
+#endif
+    pollLoop();
+}
+
+bool DnsMonitor::watchLoop() {
+#ifdef __linux__
+    FileWatcher watcher;
+    if (!watcher.open() || m_wakeup.fd() < 0) return false;
+    if (watcher.watch(RESOLVER_FILES) == 0) return false;
+    Logger::log("Watching resolver configuration for changes (inotify)",
+                Logger::LogType::INFO, LogPrefixes::dns_monitor);
+
+    // Watches are in place before the first read, so no change can slip in between
+    checkGuarded();
+
+    pollfd fds[3] = {{watcher.fd(), POLLIN, 0}, {m_wakeup.fd(), POLLIN, 0}, {m_alertsReady.fd(), POLLIN, 0}};
     while (m_running.load()) {
-        try {
-            checkOnce();
-        } catch (const std::exception& ex) {
-            Logger::log("Exception in workerLoop: " + std::string(ex.what()), Logger::LogType::ERROR, LogPrefixes::dns_monitor);
-        } catch (...) {
-            Logger::log("Unknown exception in worker loop.", Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+        if (::poll(fds, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            Logger::log("poll() failed on inotify descriptor: " + std::string(std::strerror(errno)),
+                        Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+            break;
         }
-        std::this_thread::sleep_for(m_pollInterval);
+        if (fds[1].revents & POLLIN) m_wakeup.drain();
+        if (!m_running.load()) break;
+        if (fds[2].revents & POLLIN) drainAlerts();
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        FileWatcher::Status status = watcher.receive();
+        if (status == FileWatcher::Status::ERROR) {
+            Logger::log("inotify read failed, falling back to polling",
+                        Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+            return false;
+        }
+        if (status == FileWatcher::Status::UNCHANGED) continue;
+
+        // The symlink target or a runtime directory may have moved
+        watcher.watch(RESOLVER_FILES);
+        checkGuarded();
     }
+    return true;
+#else
+    return false;
+#endif
 }
 
-void DnsMonitor::checkOnce() {
-    auto current = getSystemDnsServers();
-    {
-        std::lock_guard<std::recursive_mutex> lk(m_mutex);
-        m_lastObservedDns = current;
+void DnsMonitor::pollLoop() {
+#ifdef _WIN32
+    while (m_running.load()) {
+        checkGuarded();
+        std::this_thread::sleep_for(m_pollInterval);
     }
-
-    std::set<std::string> currentSet(current.begin(), current.end());
-    std::vector<std::string> unknowns;
-
-    {
-        std::lock_guard<std::recursive_mutex> lk(m_mutex);
-        for (const auto& s : currentSet) {
-            if (m_knownDns.find(s) == m_knownDns.end()) unknowns.push_back(s);
+#else
+    // Queued alerts are notified between two checks
+    pollfd fds[2] = {{m_wakeup.fd(), POLLIN, 0}, {m_alertsReady.fd(), POLLIN, 0}};
+    auto nextCheck = std::chrono::steady_clock::now();
+    while (m_running.load()) {
+        if (std::chrono::steady_clock::now() >= nextCheck) {
+            checkGuarded();
+            nextCheck = std::chrono::steady_clock::now() + m_pollInterval;
         }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            nextCheck - std::chrono::steady_clock::now()).count();
+        if (::poll(fds, 2, static_cast<int>(std::max<long long>(remaining, 0))) <= 0) continue;
+        if (fds[0].revents & POLLIN) m_wakeup.drain();
+        if (fds[1].revents & POLLIN) drainAlerts();
+    }
+#endif
+}
+
+void DnsMonitor::checkGuarded() {
+    try {
+        checkOnce();
+    } catch (const std::exception& ex) {
+        Logger::log("Exception in workerLoop: " + std::string(ex.what()), Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+    } catch (...) {
+        Logger::log("Unknown exception in worker loop.", Logger::LogType::ERROR, LogPrefixes::dns_monitor);
     }
+}
 
-    std::set<std::string> currentUnknowns(unknowns.begin(), unknowns.end());
+void DnsMonitor::checkOnce() {
+    // Sorted and deduplicated, so the unknown servers come out sorted as well
+    auto current = getSystemDnsServers();
+    std::vector<std::string> unknowns;
     bool notifyChange = false;
     {
         std::lock_guard<std::recursive_mutex> lk(m_mutex);
-        if (currentUnknowns != m_lastUnknownDns) {
-            m_lastUnknownDns = currentUnknowns;
+        for (const auto& s : current) {
+            if (!m_knownDns.contains(s)) unknowns.push_back(s);
+        }
+        std::vector<Ipv6Addr> resolvers;
+        for (const auto& s : current) {
+            Ipv6Addr addr;
+            if (parseResolver(s, addr)) resolvers.push_back(addr);
+        }
+        {
+            std::lock_guard<std::mutex> published(m_resolversMutex);
+            m_configuredResolvers = std::move(resolvers);
+            m_resolversGeneration.fetch_add(1, std::memory_order_release);
+        }
+        m_lastObservedDns = std::move(current);
+        if (unknowns != m_lastUnknownDns) {
+            m_lastUnknownDns = unknowns;
             notifyChange = true;
         }
     }
 
-    if (notifyChange && !currentUnknowns.empty()) {
+    if (notifyChange && !unknowns.empty()) {
         std::ostringstream body;
         body << "Unrecognized DNS server(s) detected: ";
         for (size_t i = 0; i < unknowns.size(); ++i) {
@@ -163,7 +306,7 @@ void DnsMonitor::checkOnce() {
         }
         notify("Unknown DNS", body.str());
         m_alerting = true;
-    } else if (currentUnknowns.empty()) {
+    } else if (unknowns.empty()) {
         bool wasAlerting = m_alerting.exchange(false);
         if (wasAlerting) {
             notify("DNS Monitor — Resolved", "Previously detected unknown DNS servers are no longer present.");
@@ -171,6 +314,207 @@ void DnsMonitor::checkOnce() {
     }
 }
 
+// -------------------- Captured traffic --------------------
+void DnsMonitor::handleDns(const capture::PacketView* views, std::size_t count) {
+    std::vector<std::pair<const char*, std::string>> alerts;  // Title, body
+    // A batch comes from a single worker, which owns its shard
+    WorkerShard& shard = *m_shards[views[0].worker % m_shards.size()];
+    uint64_t generation = m_resolversGeneration.load(std::memory_order_acquire);
+    if (generation != shard.resolversGeneration) {
+        std::lock_guard<std::mutex> published(m_resolversMutex);
+        shard.configuredResolvers = m_configuredResolvers;
+        shard.resolversGeneration = generation;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const capture::PacketView& view = views[i];
+        capture::DnsPacket dns;
+        if (!capture::parseDnsDatagram(view.l3, view.l3Len, dns) || dns.opcode != 0) continue;
+        uint32_t now = view.frame.tsSec;
+        uint64_t nowMs = static_cast<uint64_t>(now) * 1000 + view.frame.tsNsec / 1000000;
+
+        if (view.outgoing) {
+            if (dns.response) continue;
+            shard.transactions.onQuery(dns.destination, dns.sourcePort, dns.id, dns.questionHash, nowMs);
+            *shard.queriedResolvers.touch(dns.destination).first = now;
+            continue;
+        }
+        if (!dns.response) continue;
+
+        using Verdict = DnsTransactionTracker::Verdict;
+        Verdict verdict = shard.transactions.onResponse(dns.source, dns.destinationPort, dns.id, dns.questionHash,
+                                                        capture::dnsAnswerDigest(dns), nowMs);
+        bool configured = std::find(shard.configuredResolvers.begin(), shard.configuredResolvers.end(),
+                                    dns.source) != shard.configuredResolvers.end();
+        const char* reason = nullptr;
+        switch (verdict) {
+            case Verdict::MATCHED:
+                checkAnswer(shard.stats, dns, now, alerts);
+                // Names already seen moving between networks would only diverge by design
+                if (configured && !shard.stats.isVolatile(dns.questionHash)) m_consistency.offer(dns, now);
+                continue;
+            case Verdict::COMPETING:
+                reason = "second, different answer to a query already answered";
+                break;
+            case Verdict::QUESTION_MISMATCH:
+                reason = "answers another question than the one asked";
+                break;
+            case Verdict::TXID_MISMATCH:
+                checkBurst(shard.bursts, shard.burstReports, dns, nowMs, alerts);
+                reason = "transaction ID matches no pending query";
+                break;
+            case Verdict::UNSOLICITED:
+            case Verdict::UNVERIFIED:
+                if (configured || shard.queriedResolvers.find(dns.source)) {
+                    // Guessed ports: no query open on that port, so no TXID to compare
+                    if (verdict == Verdict::UNSOLICITED) {
+                        checkBurst(shard.bursts, shard.burstReports, dns, nowMs, alerts);
+                    }
+                    continue;
+                }
+                reason = "resolver neither configured nor queried";
+                break;
+        }
+        if (!takeResponseAlert(shard.responseAlerts, dns.source, now)) continue;
+        alerts.emplace_back("DNS Spoofing Alert",
+                            "Possible DNS spoofing: response for " + capture::dnsQuestionName(dns) + " from " +
+                                NetAddr::formatIp(dns.source) + " to port " + std::to_string(dns.destinationPort) +
+                                " (" + reason + ")");
+    }
+
+    // Notifications may block (D-Bus): the monitor thread sends them
+    if (alerts.empty()) return;
+    for (auto& [title, body] : alerts) {
+        QueuedAlert* slot = shard.alerts.acquire();
+        if (!slot) {
+            m_alertDrops.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        slot->title = title;
+        slot->body = std::move(body);
+        shard.alerts.commit();
+    }
+    m_alertsReady.notify();
+}
+
+void DnsMonitor::drainAlerts() {
+    m_alertsReady.drain();
+    uint32_t now = static_cast<uint32_t>(std::time(nullptr));
+    if (m_suppressedAlerts > 0 && now - m_suppressedAt >= RESPONSE_ALERT_INTERVAL) {
+        Logger::log("DNS alert flood over, " + std::to_string(m_suppressedAlerts) + " alert(s) withheld",
+                    Logger::LogType::WARNING, LogPrefixes::dns_monitor);
+        m_suppressedAlerts = 0;
+    }
+    for (auto& shard : m_shards) {
+        shard->alerts.drain([&](const QueuedAlert& alert) { raiseAlert(alert.title, alert.body, now); });
+    }
+    uint64_t dropped = m_alertDrops.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) withholdAlerts(dropped, now);
+}
+
+void DnsMonitor::raiseAlert(const char* title, const std::string& body, uint32_t now) {
+    if (now != m_alertSecond) {
+        m_alertSecond = now;
+        m_alertsInSecond = 0;
+    }
+    if (m_alertsInSecond < MAX_ALERTS_PER_SECOND) {
+        ++m_alertsInSecond;
+        notify(title, body);
+        return;
+    }
+    withholdAlerts(1, now);
+}
+
+void DnsMonitor::withholdAlerts(uint64_t count, uint32_t now) {
+    bool first = m_suppressedAlerts == 0;
+    m_suppressedAlerts += count;
+    m_suppressedAt = now;
+    if (!first) return;
+    std::string msg = "more than " + std::to_string(MAX_ALERTS_PER_SECOND) +
+                      " DNS alerts per second, further alerts are withheld until it calms down";
+    Logger::log("DNS alert flood: " + msg, Logger::LogType::CRITICAL, LogPrefixes::dns_monitor);
+    notify("DNS Alert Flood", "DNS spoofing flood, " + msg);
+}
+
+void DnsMonitor::checkBurst(DnsBurstDetector& bursts, LruMap<Ipv6Addr, BurstReport>& reports,
+                            const capture::DnsPacket& dns, uint64_t nowMs,
+                            std::vector<std::pair<const char*, std::string>>& alerts) {
+    uint32_t guessed = 0;
+    if (!bursts.observe(dns.source, dns.questionHash, nowMs, guessed)) return;
+
+    // Kaminsky's attack bursts on a fresh random name each time: one alert per resolver
+    uint32_t now = static_cast<uint32_t>(nowMs / 1000);
+    auto [report, inserted] = reports.touch(dns.source);
+    if (inserted) *report = BurstReport{};
+    ++report->questions;
+    report->responses += guessed;
+    if (!inserted && now - report->lastAlert < RESPONSE_ALERT_INTERVAL) return;
+
+    std::string target = report->questions == 1
+        ? capture::dnsQuestionName(dns)
+        : std::to_string(report->questions) + " questions (latest " + capture::dnsQuestionName(dns) + ")";
+    alerts.emplace_back("DNS Poisoning Alert",
+                        "Possible DNS cache poisoning: " + std::to_string(report->responses) +
+                            " responses with guessed transaction IDs or ports for " + target + " from " +
+                            NetAddr::formatIp(dns.source) + ", at least " + std::to_string(bursts.threshold()) +
+                            " per question within " + std::to_string(bursts.windowMs() / 1000) + "s");
+    report->lastAlert = now;
+    report->questions = 0;
+    report->responses = 0;
+}
+
+void DnsMonitor::checkAnswer(DnsAnswerStats& stats, const capture::DnsPacket& dns, uint32_t now,
+                             std::vector<std::pair<const char*, std::string>>& alerts) {
+    if (dns.rcode != 0 || dns.truncated || dns.qclass != DNS_CLASS_IN || (dns.qtype != DNS_TYPE_A && dns.qtype != DNS_TYPE_AAAA)) {
+        return;
+    }
+
+    Ipv6Addr addresses[MAX_ANSWER_ADDRESSES];
+    uint32_t networks[MAX_ANSWER_ADDRESSES];
+    std::size_t count = 0;
+    uint32_t ttl = UINT32_MAX;
+    capture::DnsAnswerReader reader(dns);
+    capture::DnsRecord record;
+    while (count < MAX_ANSWER_ADDRESSES && reader.next(record)) {
+        if (record.type == DNS_TYPE_A && record.rdataLen == 4) {
+            uint32_t ip;
+            std::memcpy(&ip, record.rdata, 4);
+            addresses[count] = NetAddr::mapIpv4(ip);
+        } else if (record.type == DNS_TYPE_AAAA && record.rdataLen == 16) {
+            addresses[count] = NetAddr::packIpv6(record.rdata);
+        } else {
+            continue;  // CNAME chain
+        }
+        networks[count] = DnsAnswerStats::networkKey(addresses[count]);
+        ++count;
+        ttl = std::min(ttl, record.ttl);
+    }
+    if (count == 0) return;
+
+    uint32_t usualTtl = 0;
+    std::string detail;
+    switch (stats.observe(dns.questionHash, networks, count, ttl, now, usualTtl)) {
+        case DnsAnswerStats::Anomaly::NONE:
+            return;
+        case DnsAnswerStats::Anomaly::NEW_NETWORK:
+            detail = "now resolves to " + NetAddr::formatIp(addresses[0]) +
+                     ", outside the networks it usually resolves to";
+            break;
+        case DnsAnswerStats::Anomaly::LONG_TTL:
+            detail = "carries a TTL of " + std::to_string(ttl) + "s, usually at most " + std::to_string(usualTtl) + "s";
+            break;
+    }
+    alerts.emplace_back("DNS Answer Anomaly Alert", "Unusual DNS answer: " + capture::dnsQuestionName(dns) + " from " +
+                                                        NetAddr::formatIp(dns.source) + " " + detail);
+}
+
+bool DnsMonitor::takeResponseAlert(LruMap<Ipv6Addr, uint32_t>& alerts, const Ipv6Addr& resolver, uint32_t now) {
+    auto [last, inserted] = alerts.touch(resolver);
+    if (!inserted && now - *last < RESPONSE_ALERT_INTERVAL) return false;
+    *last = now;
+    return true;
+}
+
 // -------------------- System DNS --------------------
 std::vector<std::string> DnsMonitor::getSystemDnsServers() const {
     std::vector<std::string> out;
@@ -273,44 +617,45 @@ void DnsMonitor::notify(const std::string& title, const std::string& body) {
 bool DnsMonitor::loadKnownDnsFromFile(const std::string& path) {
     if (path.empty()) return false;
 
-    std::ifstream ifs(path);
-    if (!ifs) {
-        Logger::log("Failed to open known DNS JSON: " + path, Logger::LogType::ERROR, LogPrefixes::dns_monitor);
-        return false;
-    }
-
-    try {
-        nlohmann::json j;
-        ifs >> j;
-        if (!j.is_array()) {
-            Logger::log("Known DNS JSON is not an array.", Logger::LogType::ERROR, LogPrefixes::dns_monitor);
-            return false;
+    KnownDnsDb db;
+    std::string error;
+
+    // The compiled database is only trusted while it is at least as recent as the JSON
+    struct stat dbStat{}, jsonStat{};
+    if (!m_knownDbPath.empty() && ::stat(m_knownDbPath.c_str(), &dbStat) == 0) {
+        bool stale = ::stat(path.c_str(), &jsonStat) == 0 && jsonStat.st_mtime > dbStat.st_mtime;
+        if (stale) {
+            Logger::log("Compiled known DNS database " + m_knownDbPath + " is older than " + path +
+                        ", loading the JSON (run " + SOFTWARE_COMMAND + " --compile-known-dns)",
+                        Logger::LogType::WARNING, LogPrefixes::dns_monitor);
+        } else if (db.open(m_knownDbPath, error)) {
+            Logger::log("Loaded " + std::to_string(db.addressCount()) + " known DNS servers and " +
+                            std::to_string(db.prefixCount()) + " prefixes from " + m_knownDbPath,
+                        Logger::LogType::INFO, LogPrefixes::dns_monitor);
+            std::lock_guard<std::recursive_mutex> lk(m_mutex);
+            m_knownDns = std::move(db);
+            m_knownDnsPath = path;
+            return true;
+        } else {
+            Logger::log("Ignoring compiled known DNS database: " + error,
+                        Logger::LogType::WARNING, LogPrefixes::dns_monitor);
         }
+    }
 
-        std::set<std::string> tmp;
-        for (auto &entry : j) {
-            if (!entry.is_string()) {
-                Logger::log("Known DNS JSON contains non-string entries.", Logger::LogType::ERROR, LogPrefixes::dns_monitor);
-                return false;
-            }
-            std::string s = normalizeIpString(entry.get<std::string>());
-            if (!s.empty()) tmp.insert(s);
-        }
-
-        if (tmp.empty()) {
-            Logger::log("No valid DNS entries found in the JSON file.", Logger::LogType::ERROR, LogPrefixes::dns_monitor);
-            return false;
-        }
-
-        std::lock_guard<std::recursive_mutex> lk(m_mutex);
-        m_knownDns = std::move(tmp);
-        m_knownDnsPath = path;
-
-        return true;
-    } catch (const std::exception& ex) {
-        Logger::log("JSON parse error: " + std::string(ex.what()), Logger::LogType::ERROR, LogPrefixes::dns_monitor);
+    std::size_t skipped = 0;
+    if (!db.loadJson(path, error, &skipped)) {
+        Logger::log(error, Logger::LogType::ERROR, LogPrefixes::dns_monitor);
         return false;
     }
+    if (skipped > 0) {
+        Logger::log("Skipped " + std::to_string(skipped) + " known DNS entries that are not IP addresses or prefixes",
+                    Logger::LogType::WARNING, LogPrefixes::dns_monitor);
+    }
+
+    std::lock_guard<std::recursive_mutex> lk(m_mutex);
+    m_knownDns = std::move(db);
+    m_knownDnsPath = path;
+    return true;
 }
 
 } // namespace monitors
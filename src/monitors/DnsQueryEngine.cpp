@@ -0,0 +1,247 @@
+/**
+ * @file DnsQueryEngine.cpp
+ * @brief Non-blocking DNS client multiplexing bounded queries over epoll.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/DnsQueryEngine.hpp"
+#include "capture/DnsPacket.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace monitors {
+
+namespace {
+
+constexpr uint32_t DNS_HEADER_LEN = 12;
+constexpr uint32_t MAX_NAME_LEN = 255;
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t TYPE_AAAA = 28;
+constexpr uint16_t CLASS_IN = 1;
+
+/// Longest wait while queries are in flight, so they expire on time
+constexpr int EXPIRY_SLICE_MS = 100;
+
+/// Largest reply read; longer ones are truncated and lose trailing records
+constexpr std::size_t RECEIVE_BUFFER = 4096;
+
+void to_sockaddr(const DnsQueryEngine::Server& server, sockaddr_storage& ss, socklen_t& len) noexcept {
+    std::memset(&ss, 0, sizeof(ss));
+    if (NetAddr::isMappedIpv4(server.address)) {
+        auto* sin = reinterpret_cast<sockaddr_in*>(&ss);
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(server.port);
+        sin->sin_addr.s_addr = NetAddr::unmapIpv4(server.address);
+        len = sizeof(sockaddr_in);
+    } else {
+        auto* sin6 = reinterpret_cast<sockaddr_in6*>(&ss);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(server.port);
+        NetAddr::unpackIpv6(server.address, sin6->sin6_addr.s6_addr);
+        len = sizeof(sockaddr_in6);
+    }
+}
+
+} // namespace
+
+DnsQueryEngine::DnsQueryEngine(std::size_t maxInFlight, uint32_t queriesPerSecond, uint32_t timeoutMs)
+    : m_pending(16, maxInFlight > 0 ? maxInFlight : 1), m_timers(maxInFlight > 0 ? maxInFlight : 1),
+      m_events((maxInFlight > 0 ? maxInFlight : 1) + 1),
+      m_maxInFlight(maxInFlight > 0 ? maxInFlight : 1), m_rate(queriesPerSecond > 0 ? queriesPerSecond : 1),
+      m_timeoutMs(timeoutMs > 0 ? timeoutMs : 1), m_random(std::random_device{}()) {}
+
+DnsQueryEngine::~DnsQueryEngine() {
+    close();
+}
+
+uint64_t DnsQueryEngine::nowMs() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+bool DnsQueryEngine::open(int wakeupFd, std::string& error) {
+    close();
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0) {
+        error = std::string("epoll_create1: ") + std::strerror(errno);
+        return false;
+    }
+    if (wakeupFd >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeupFd;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, wakeupFd, &ev) != 0) {
+            error = std::string("epoll_ctl: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+    }
+
+    uint64_t now = nowMs();
+    m_timers = TimingWheel<int>(m_maxInFlight, now);
+    m_tokens = static_cast<uint64_t>(m_rate) * 1000;
+    m_refilledAt = now;
+    return true;
+}
+
+void DnsQueryEngine::close() noexcept {
+    m_pending.forEach([](int fd, Pending&) { ::close(fd); });
+    m_pending.clear();
+    m_timers = TimingWheel<int>(m_maxInFlight);
+    if (m_epoll >= 0) ::close(m_epoll);
+    m_epoll = -1;
+}
+
+void DnsQueryEngine::release(int fd) noexcept {
+    // Closing the last reference also leaves the epoll set
+    ::close(fd);
+    m_pending.erase(fd);
+}
+
+void DnsQueryEngine::refill(uint64_t now) noexcept {
+    uint64_t burst = static_cast<uint64_t>(m_rate) * 1000;
+    if (now > m_refilledAt) {
+        // Rate per second is thousandths per millisecond
+        m_tokens += (now - m_refilledAt) * m_rate;
+        if (m_tokens > burst) m_tokens = burst;
+    }
+    m_refilledAt = now;
+}
+
+bool DnsQueryEngine::ready() {
+    if (m_epoll < 0 || m_pending.size() >= m_maxInFlight) return false;
+    refill(nowMs());
+    return m_tokens >= 1000;
+}
+
+bool DnsQueryEngine::submit(const Server& server, const uint8_t* qname, uint32_t qnameLen, uint16_t qtype,
+                            uint64_t tag) {
+    if (!ready() || !qname || qnameLen == 0 || qnameLen > MAX_NAME_LEN) return false;
+
+    uint32_t id = m_random() & 0xffff;
+
+    uint8_t query[DNS_HEADER_LEN + MAX_NAME_LEN + 4] = {};
+    query[0] = static_cast<uint8_t>(id >> 8);
+    query[1] = static_cast<uint8_t>(id);
+    query[2] = 0x01;  // RD
+    query[5] = 1;     // QDCOUNT
+    std::memcpy(query + DNS_HEADER_LEN, qname, qnameLen);
+    uint32_t len = DNS_HEADER_LEN + qnameLen;
+    query[len++] = static_cast<uint8_t>(qtype >> 8);
+    query[len++] = static_cast<uint8_t>(qtype);
+    query[len++] = static_cast<uint8_t>(CLASS_IN >> 8);
+    query[len++] = static_cast<uint8_t>(CLASS_IN);
+
+    // The reply must carry the same question, hashed like captured traffic
+    capture::DnsPacket parsed;
+    if (!capture::parseDnsMessage(query, len, parsed) || parsed.questionNameLen != qnameLen) return false;
+
+    // Connecting binds a fresh ephemeral port and makes the kernel drop datagrams
+    // from any other address or port
+    sockaddr_storage ss;
+    socklen_t ssLen = 0;
+    to_sockaddr(server, ss, ssLen);
+    int fd = ::socket(ss.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&ss), ssLen) != 0 ||
+        ::send(fd, query, len, 0) != static_cast<ssize_t>(len) ||
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    auto [pending, inserted] = m_pending.insert(fd);
+    if (!pending || !inserted) {
+        ::close(fd);
+        return false;
+    }
+    pending->tag = tag;
+    pending->questionHash = parsed.questionHash;
+    pending->id = static_cast<uint16_t>(id);
+    pending->qtype = qtype;
+    uint64_t now = nowMs();
+    // An empty wheel jumps forward at once; a busy one would replay the gap tick by tick
+    if (m_timers.size() == 0) m_timers.advance(now, [](const int&) {});
+    pending->timer = m_timers.schedule(now + m_timeoutMs, fd);
+    m_tokens -= 1000;
+    return true;
+}
+
+void DnsQueryEngine::poll(int maxWaitMs, std::vector<Reply>& replies) {
+    if (m_epoll < 0) return;
+    int wait = maxWaitMs;
+    if (!m_pending.empty() && (wait < 0 || wait > EXPIRY_SLICE_MS)) wait = EXPIRY_SLICE_MS;
+
+    int n = ::epoll_wait(m_epoll, m_events.data(), static_cast<int>(m_events.size()), wait);
+    for (int i = 0; i < n; ++i) {
+        // The wakeup descriptor is not a query: left to the caller
+        int fd = m_events[i].data.fd;
+        if (Pending* pending = m_pending.find(fd)) receive(fd, *pending, replies);
+    }
+
+    m_timers.advance(nowMs(), [&](const int& fd) {
+        Pending* pending = m_pending.find(fd);
+        if (!pending) return;
+        Reply reply;
+        reply.tag = pending->tag;
+        replies.push_back(reply);
+        release(fd);
+    });
+}
+
+void DnsQueryEngine::receive(int fd, Pending& pending, std::vector<Reply>& replies) {
+    uint8_t buffer[RECEIVE_BUFFER];
+    Reply reply;
+    reply.tag = pending.tag;
+    for (;;) {
+        ssize_t len = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        // An error (ICMP unreachable) ends the query like a timeout, only sooner
+        if (len < 0 || parseReply(pending, buffer, static_cast<std::size_t>(len), reply)) break;
+    }
+    replies.push_back(reply);
+    m_timers.cancel(pending.timer);
+    release(fd);
+}
+
+bool DnsQueryEngine::parseReply(const Pending& pending, const uint8_t* data, std::size_t len, Reply& reply) {
+    capture::DnsPacket dns;
+    if (!capture::parseDnsMessage(data, static_cast<uint32_t>(len), dns) || !dns.response ||
+        dns.id != pending.id || pending.questionHash != dns.questionHash) {
+        return false;
+    }
+
+    reply.answered = true;
+    reply.truncated = dns.truncated;
+    reply.rcode = dns.rcode;
+    capture::DnsAnswerReader reader(dns);
+    capture::DnsRecord record;
+    while (reply.addressCount < MAX_ADDRESSES && reader.next(record)) {
+        if (record.type != pending.qtype) continue;
+        Ipv6Addr& addr = reply.addresses[reply.addressCount];
+        if (record.type == TYPE_A && record.rdataLen == 4) {
+            uint32_t ip;
+            std::memcpy(&ip, record.rdata, 4);
+            addr = NetAddr::mapIpv4(ip);
+            ++reply.addressCount;
+        } else if (record.type == TYPE_AAAA && record.rdataLen == 16) {
+            addr = NetAddr::packIpv6(record.rdata);
+            ++reply.addressCount;
+        }
+    }
+    return true;
+}
+
+} // namespace monitors
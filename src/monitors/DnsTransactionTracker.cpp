@@ -0,0 +1,83 @@
+/**
+ * @file DnsTransactionTracker.cpp
+ * @brief Matches captured DNS responses against the queries this host sent.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/DnsTransactionTracker.hpp"
+
+namespace monitors {
+
+DnsTransactionTracker::DnsTransactionTracker(std::size_t maxPending, uint32_t timeoutMs)
+    : m_pending(256, maxPending), m_endpoints(256, maxPending), m_timers(maxPending),
+      m_timeoutTicks(timeoutMs / TICK_MS > 0 ? timeoutMs / TICK_MS : 1) {}
+
+void DnsTransactionTracker::advance(uint64_t nowMs) {
+    uint64_t tick = nowMs / TICK_MS;
+    if (!m_started) {
+        // Queries sent before capture started are unknown: be lenient for one timeout
+        m_started = true;
+        m_timers = TimingWheel<Key>(m_timers.capacity(), tick);
+        m_blindUntil = tick + m_timeoutTicks;
+        return;
+    }
+    m_timers.advance(tick, [this](const Key& key) { close(key); });
+}
+
+void DnsTransactionTracker::close(const Key& key) {
+    if (!m_pending.erase(key)) return;
+    uint32_t* open = m_endpoints.find(key.endpoint);
+    if (open && --*open == 0) m_endpoints.erase(key.endpoint);
+}
+
+void DnsTransactionTracker::onQuery(const Ipv6Addr& resolver, uint16_t port, uint16_t id, uint64_t questionHash,
+                                    uint64_t nowMs) {
+    advance(nowMs);
+    uint64_t expiry = m_timers.now() + m_timeoutTicks;
+    Key key{{resolver, port}, id};
+
+    auto [transaction, inserted] = m_pending.insert(key);
+    if (transaction && !inserted) {
+        // Retransmission: keep the answer seen so far, extend the window
+        m_timers.cancel(transaction->timer);
+        transaction->timer = m_timers.schedule(expiry, key);
+        transaction->questionHash = questionHash;
+        return;
+    }
+    if (transaction) {
+        auto [open, fresh] = m_endpoints.insert(key.endpoint);
+        transaction->timer = open ? m_timers.schedule(expiry, key) : TimingWheel<Key>::INVALID_HANDLE;
+        if (transaction->timer != TimingWheel<Key>::INVALID_HANDLE) {
+            transaction->questionHash = questionHash;
+            ++*open;
+            return;
+        }
+        m_pending.erase(key);
+        if (open && fresh) m_endpoints.erase(key.endpoint);
+    }
+    // Table full: this query is lost, so its response cannot be judged
+    m_blindUntil = expiry;
+}
+
+DnsTransactionTracker::Verdict DnsTransactionTracker::onResponse(const Ipv6Addr& resolver, uint16_t port, uint16_t id,
+                                                                 uint64_t questionHash, uint64_t answerDigest,
+                                                                 uint64_t nowMs) {
+    advance(nowMs);
+    Endpoint endpoint{resolver, port};
+    Transaction* transaction = m_pending.find(Key{endpoint, id});
+    if (!transaction) {
+        if (m_endpoints.find(endpoint)) return Verdict::TXID_MISMATCH;
+        return m_timers.now() < m_blindUntil ? Verdict::UNVERIFIED : Verdict::UNSOLICITED;
+    }
+    // Some error responses leave the question out
+    if (questionHash != 0 && transaction->questionHash != questionHash) return Verdict::QUESTION_MISMATCH;
+    if (!transaction->answered || transaction->answerDigest == answerDigest) {
+        transaction->answered = true;
+        transaction->answerDigest = answerDigest;
+        return Verdict::MATCHED;
+    }
+    return Verdict::COMPETING;
+}
+
+} // namespace monitors
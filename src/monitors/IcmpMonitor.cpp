@@ -6,42 +6,111 @@
  */
 
 #include "monitors/IcmpMonitor.hpp"
+#include "capture/CaptureEngine.hpp"
 #include "monitors/Init.hpp"
+#include "utils/DefaultGateway.hpp"
 #include "utils/Logger.hpp"
+#include "utils/NetAddr.hpp"
 
-#include <arpa/inet.h>
 #include <cstring>
-#include <netinet/ip.h>
 #include <netinet/ip_icmp.h>
-#include <pcap.h>
 
 namespace monitors {
 
-IcmpMonitor::IcmpMonitor()
-    : m_pollInterval(std::chrono::milliseconds(100)), m_running(false), m_handle(nullptr) {}
+namespace {
 
-IcmpMonitor::IcmpMonitor(std::chrono::milliseconds pollInterval)
-    : m_pollInterval(pollInterval), m_running(false), m_handle(nullptr) {}
+uint32_t load_addr(const uint8_t* p) noexcept {
+    uint32_t addr;
+    std::memcpy(&addr, p, 4);
+    return addr;
+}
+
+std::string format_source(uint32_t addr) {
+    return NetAddr::formatIpv4(addr);
+}
+
+std::string format_source(const Ipv6Addr& addr) {
+    return NetAddr::formatIpv6(addr);
+}
+
+uint64_t scan_key(uint32_t addr) noexcept {
+    return addr;
+}
+
+uint64_t scan_key(const Ipv6Addr& addr) noexcept {
+    return FlatHash<Ipv6Addr>{}(addr);
+}
+
+/// Smallest per-shard source table when the sources are split over many workers
+constexpr std::size_t MIN_SHARD_SOURCES = 64;
+
+const char* redirect_kind(uint8_t code) {
+    switch (code) {
+        case ICMP_REDIR_NET: return "network";
+        case ICMP_REDIR_HOST: return "host";
+        case ICMP_REDIR_NETTOS: return "network/TOS";
+        case ICMP_REDIR_HOSTTOS: return "host/TOS";
+        default: return "unknown";
+    }
+}
+
+} // namespace
+
+IcmpMonitor::Shard::Shard(std::size_t maxSources)
+    : pingSources(maxSources), pingSources6(maxSources),
+      pingSweeps(ScanDetector::DEFAULT_THRESHOLD, ScanDetector::DEFAULT_WINDOW_SECONDS, maxSources),
+      pingSweeps6(ScanDetector::DEFAULT_THRESHOLD, ScanDetector::DEFAULT_WINDOW_SECONDS, maxSources),
+      synScans(ScanDetector::DEFAULT_THRESHOLD, ScanDetector::DEFAULT_WINDOW_SECONDS, maxSources),
+      redirectAlerts(maxSources) {}
+
+IcmpMonitor::IcmpMonitor() {
+    m_shards.push_back(std::make_unique<Shard>(MAX_SOURCES));
+}
 
 IcmpMonitor::~IcmpMonitor() {
     stop();
 }
 
+void IcmpMonitor::attachCapture(capture::CaptureEngine& engine) {
+    // Split the source budget so memory stays fixed whatever the worker count
+    unsigned workers = engine.workerCount() > 0 ? engine.workerCount() : 1;
+    std::size_t perShard = MAX_SOURCES / workers > MIN_SHARD_SOURCES ? MAX_SOURCES / workers : MIN_SHARD_SOURCES;
+    m_shards.clear();
+    for (unsigned i = 0; i < workers; ++i) m_shards.push_back(std::make_unique<Shard>(perShard));
+
+    engine.subscribe(capture::Interest::ICMPV4, [this](const capture::PacketView* views, std::size_t count) {
+        if (!m_running.load()) return;
+        for (std::size_t i = 0; i < count; ++i) handleIcmp(views[i]);
+    });
+    engine.subscribe(capture::Interest::ICMPV6_ECHO, [this](const capture::PacketView* views, std::size_t count) {
+        if (!m_running.load()) return;
+        for (std::size_t i = 0; i < count; ++i) handleIcmp6Echo(views[i]);
+    });
+    engine.subscribe(capture::Interest::IPV4_OUTBOUND, [this](const capture::PacketView* views, std::size_t count) {
+        if (m_running.load()) recordOutbound(views, count);
+    });
+    engine.subscribe(capture::Interest::TCP_SYN, [this](const capture::PacketView* views, std::size_t count) {
+        if (!m_running.load()) return;
+        for (std::size_t i = 0; i < count; ++i) {
+            const capture::PacketView& view = views[i];
+            if (!view.l4 || view.l4Len < 4) continue;
+            uint64_t target = (static_cast<uint64_t>(load_addr(view.l3 + 16)) << 16) | ((view.l4[2] << 8) | view.l4[3]);
+            checkScan(shardFor(view).synScans, "SYN scan", load_addr(view.l3 + 12), target, view.frame.tsSec);
+        }
+    });
+}
+
 void IcmpMonitor::start() {
     bool expected = false;
     if (!m_running.compare_exchange_strong(expected, true)) return;
-    m_thread = std::thread(&IcmpMonitor::workerLoop, this);
+    Logger::log("ICMP monitor enabled", Logger::LogType::DEFAULT, LogPrefixes::icmp_monitor);
 }
 
 void IcmpMonitor::stop() {
     bool expected = true;
     if (m_running.compare_exchange_strong(expected, false)) {
-        if (m_handle) {
-            pcap_breakloop(m_handle); // Interrupt pcap_next_ex
-        }
-        if (m_thread.joinable()) {
-            m_thread.join();
-        }
+        logPingSummary();
+        Logger::log("ICMP monitor stopped", Logger::LogType::DEFAULT, LogPrefixes::icmp_monitor);
     }
 }
 
@@ -49,65 +118,187 @@ void IcmpMonitor::setPingCallback(Callback cb) {
     m_callback = std::move(cb);
 }
 
-void IcmpMonitor::workerLoop() {
-    char errbuf[PCAP_ERRBUF_SIZE];
-    m_handle = pcap_open_live("any", 65536, 1, static_cast<int>(m_pollInterval.count()), errbuf);
-    if (!m_handle) {
-        Logger::log(std::string("pcap_open_live failed: ") + errbuf, Logger::LogType::ERROR, LogPrefixes::icmp_monitor);
+void IcmpMonitor::setNotificationCallback(NotificationCallback cb) {
+    m_notify = std::move(cb);
+}
+
+void IcmpMonitor::setGateway(const std::string& gatewayIp) {
+    uint32_t ip = 0;
+    if (!NetAddr::parseIpv4(gatewayIp, ip)) {
+        Logger::log("Invalid gateway '" + gatewayIp + "', detecting the default route instead",
+                    Logger::LogType::WARNING, LogPrefixes::icmp_monitor);
         return;
     }
+    m_pinnedGateway = ip;
+}
 
-    struct bpf_program fp{};
-    if (pcap_compile(m_handle, &fp, "icmp", 1, PCAP_NETMASK_UNKNOWN) == -1) {
-        Logger::log(std::string("pcap_compile failed: ") + pcap_geterr(m_handle), Logger::LogType::ERROR, LogPrefixes::icmp_monitor);
-        pcap_close(m_handle);
-        return;
+IcmpMonitor::Shard& IcmpMonitor::shardFor(const capture::PacketView& view) {
+    return *m_shards[view.worker % m_shards.size()];
+}
+
+uint32_t IcmpMonitor::currentGateway(Shard& shard, uint32_t now) {
+    if (m_pinnedGateway != 0) return m_pinnedGateway;
+    if (shard.gatewayCheckedAt == 0 || now - shard.gatewayCheckedAt >= GATEWAY_REFRESH) {
+        uint32_t ip = 0;
+        shard.gateway = NetAddr::parseIpv4(DefaultGateway::detect(), ip) ? ip : 0;
+        shard.gatewayCheckedAt = now;
     }
-    if (pcap_setfilter(m_handle, &fp) == -1) {
-        Logger::log(std::string("pcap_setfilter failed: ") + pcap_geterr(m_handle), Logger::LogType::ERROR, LogPrefixes::icmp_monitor);
-        pcap_close(m_handle);
-        return;
+    return shard.gateway;
+}
+
+template <typename Addr>
+void IcmpMonitor::handleEcho(LruMap<Addr, PingStats>& sources, const Addr& source, uint32_t count, uint32_t now) {
+    auto [stats, inserted] = sources.touch(source);
+    if (inserted) stats->firstSeen = now;
+    stats->total += count;
+    stats->sinceAlert += count;
+
+    if (!inserted && now - stats->lastAlert < static_cast<uint32_t>(NOTIFY_INTERVAL.count())) return;
+
+    // Spoofed-source floods get a fresh entry per packet: cap alerts per second overall
+    if (!takeAlertSlot(now)) return;
+
+    if (m_callback) m_callback(format_source(source), *stats);
+    stats->lastAlert = now;
+    stats->sinceAlert = 0;
+}
+
+bool IcmpMonitor::takeAlertSlot(uint32_t now) {
+    uint64_t slots = m_alertSlots.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t used = static_cast<uint32_t>(slots >> 32) == now ? static_cast<uint32_t>(slots) : 0;
+        if (used >= MAX_ALERTS_PER_SECOND) return false;
+        uint64_t next = (static_cast<uint64_t>(now) << 32) | (used + 1);
+        if (m_alertSlots.compare_exchange_weak(slots, next, std::memory_order_relaxed)) return true;
     }
+}
 
-    Logger::log("ICMP monitor enabled", Logger::LogType::DEFAULT, LogPrefixes::icmp_monitor);
+template <typename Addr>
+void IcmpMonitor::checkScan(ScanDetector& detector, const char* kind, const Addr& source, uint64_t destination,
+                            uint32_t now) {
+    uint32_t distinct = 0;
+    if (!detector.observe(scan_key(source), destination, now, distinct)) return;
+    std::string msg = "Possible " + std::string(kind) + " from " + format_source(source) + ": ~" +
+                      std::to_string(distinct) + " distinct targets within " +
+                      std::to_string(2 * detector.windowSeconds()) + "s";
+    Logger::log(msg, Logger::LogType::WARNING, LogPrefixes::icmp_monitor);
+    if (m_notify) m_notify("Scan Alert", msg);
+}
 
-    while (m_running.load()) {
-        struct pcap_pkthdr* header{};
-        const u_char* packet{};
-        int ret = pcap_next_ex(m_handle, &header, &packet);
-
-        if (ret == 1 && packet) {
-            int linkType = pcap_datalink(m_handle);
-            const u_char* ipPacket = packet;
-
-            // Adjust for link-layer header
-            if (linkType == DLT_EN10MB) ipPacket += 14;
-            else if (linkType == DLT_LINUX_SLL) ipPacket += 16;
-            else if (linkType == DLT_NULL || linkType == DLT_LOOP) ipPacket += 4;
-            else continue;
-
-            auto* iphdr = reinterpret_cast<const struct ip*>(ipPacket);
-            if (iphdr->ip_p != IPPROTO_ICMP) continue;
-
-            auto* icmp = reinterpret_cast<const struct icmphdr*>(ipPacket + iphdr->ip_hl * 4);
-            if (icmp->type == ICMP_ECHO) {
-                std::string srcIp = inet_ntoa(iphdr->ip_src);
-                auto now = std::chrono::steady_clock::now();
-
-                if (m_callback && (now - m_lastNotification >= NOTIFY_INTERVAL)) {
-                    m_callback(srcIp);
-                    m_lastNotification = now;
-                }
-            }
-        } else if (ret == -1) {
-            Logger::log(std::string("pcap_next_ex error: ") + pcap_geterr(m_handle), Logger::LogType::ERROR, LogPrefixes::icmp_monitor);
+void IcmpMonitor::logPingSummary() {
+    // Each source lives in a single shard, so the shards merge by simple union
+    std::size_t sources = 0;
+    for (const auto& shard : m_shards) sources += shard->pingSources.size() + shard->pingSources6.size();
+    if (sources == 0) return;
+
+    // Busiest sources first; only addresses entering the top list are formatted
+    constexpr std::size_t TOP = 5;
+    std::pair<uint64_t, std::string> top[TOP] = {};
+    uint64_t total = 0;
+    auto rank = [&](const auto& source, const PingStats& stats) {
+        total += stats.total;
+        for (std::size_t i = 0; i < TOP; ++i) {
+            if (stats.total <= top[i].first) continue;
+            for (std::size_t j = TOP - 1; j > i; --j) top[j] = std::move(top[j - 1]);
+            top[i] = {stats.total, format_source(source)};
+            break;
         }
-        // ret == 0: timeout, loop again
+    };
+    for (const auto& shard : m_shards) {
+        shard->pingSources.forEach(rank);
+        shard->pingSources6.forEach(rank);
+    }
+
+    std::string busiest;
+    for (const auto& [count, source] : top) {
+        if (count == 0) break;
+        if (!busiest.empty()) busiest += ", ";
+        busiest += source + " (" + std::to_string(count) + ")";
+    }
+    Logger::log(std::to_string(total) + " echo request(s) from " + std::to_string(sources) +
+                " tracked source(s); busiest: " + busiest, Logger::LogType::INFO, LogPrefixes::icmp_monitor);
+}
+
+void IcmpMonitor::checkRedirect(Shard& shard, const uint8_t* ip, const uint8_t* icmp, std::size_t icmpLen,
+                                uint32_t now) {
+    uint32_t source = 0;
+    uint32_t newGateway = 0;
+    std::memcpy(&source, ip + 12, 4);
+    std::memcpy(&newGateway, icmp + 4, 4);
+
+    // The original datagram follows the 8-byte ICMP header
+    Ipv4Flow quoted;
+    bool parsed = icmpLen > 8 && parseIpv4Flow(icmp + 8, icmpLen - 8, quoted);
+    uint32_t gateway = currentGateway(shard, now);
+    bool fromGateway = gateway != 0 && source == gateway;
+    OutboundFlowRing::Match match = parsed ? shard.flows.lookup(quoted, now) : OutboundFlowRing::Match::UNKNOWN;
+
+    std::string redirect = std::string(redirect_kind(icmp[1])) + " redirect from " + NetAddr::formatIpv4(source) +
+                           (parsed ? " for " + NetAddr::formatIpv4(quoted.dst) : std::string{}) +
+                           " via " + NetAddr::formatIpv4(newGateway);
+
+    std::string reason;
+    if (!fromGateway) {
+        reason = gateway != 0 ? "not sent by the default gateway " + NetAddr::formatIpv4(gateway)
+                              : "no default gateway to validate it against";
+    }
+    if (!parsed) {
+        reason += std::string(reason.empty() ? "" : "; ") + "malformed original datagram";
+    } else if (match == OutboundFlowRing::Match::UNKNOWN) {
+        reason += std::string(reason.empty() ? "" : "; ") + "quotes traffic this host did not send (" +
+                  NetAddr::formatIpv4(quoted.src) + " -> " + NetAddr::formatIpv4(quoted.dst) +
+                  ", protocol " + std::to_string(quoted.proto) + ")";
     }
 
-    pcap_close(m_handle);
-    m_handle = nullptr;
-    Logger::log("ICMP monitor stopped", Logger::LogType::DEFAULT, LogPrefixes::icmp_monitor);
+    if (reason.empty()) {
+        Logger::log("ICMP " + redirect, Logger::LogType::INFO, LogPrefixes::icmp_monitor);
+        return;
+    }
+
+    auto [last, inserted] = shard.redirectAlerts.touch(source);
+    if (!inserted && now - *last < REDIRECT_ALERT_INTERVAL) return;
+    *last = now;
+
+    Logger::log("Suspicious ICMP " + redirect + ": " + reason, Logger::LogType::WARNING, LogPrefixes::icmp_monitor);
+    if (m_notify) m_notify("ICMP Redirect Alert", "Unexpected ICMP " + redirect + ": " + reason);
+}
+
+void IcmpMonitor::recordOutbound(const capture::PacketView* views, std::size_t count) {
+    // Remember what we sent, so redirects quoting it can be checked; a batch comes from a single worker
+    OutboundFlowRing& flows = shardFor(views[0]).flows;
+    for (std::size_t i = 0; i < count; ++i) {
+        Ipv4Flow flow;
+        if (parseIpv4Flow(views[i].l3, views[i].l3Len, flow)) flows.record(flow, views[i].frame.tsSec);
+    }
+}
+
+void IcmpMonitor::handleIcmp(const capture::PacketView& view) {
+    if (view.outgoing) {
+        recordOutbound(&view, 1);
+        return;
+    }
+    if (!view.l4 || view.l4Len < 8) return;
+
+    uint32_t tsSec = view.frame.tsSec;
+    uint32_t source = load_addr(view.l3 + 12);
+    if (view.l4[0] == ICMP_REDIRECT) {
+        checkRedirect(shardFor(view), view.l3, view.l4, view.l4Len, tsSec);
+    } else if (view.l4[0] == ICMP_ECHO) {
+        Shard& shard = shardFor(view);
+        handleEcho(shard.pingSources, source, view.count, tsSec);
+        checkScan(shard.pingSweeps, "ping sweep", source, load_addr(view.l3 + 16), tsSec);
+    }
+}
+
+void IcmpMonitor::handleIcmp6Echo(const capture::PacketView& view) {
+    if (view.outgoing || view.l3Len < 40) return;
+
+    uint32_t tsSec = view.frame.tsSec;
+    Ipv6Addr source = NetAddr::packIpv6(view.l3 + 8);
+    Ipv6Addr target = NetAddr::packIpv6(view.l3 + 24);
+    Shard& shard = shardFor(view);
+    handleEcho(shard.pingSources6, source, view.count, tsSec);
+    checkScan(shard.pingSweeps6, "ping sweep", source, scan_key(target), tsSec);
 }
 
 } // namespace monitors
@@ -13,5 +13,6 @@ namespace monitors {
 const std::string LogPrefixes::arp_monitor = "ARP Monitor";
 const std::string LogPrefixes::dns_monitor = "DNS Monitor";
 const std::string LogPrefixes::icmp_monitor = "ICMP Monitor";
+const std::string LogPrefixes::ndp_monitor = "NDP Monitor";
 
 } // namespace monitors
@@ -0,0 +1,431 @@
+/**
+ * @file KnownDnsDb.cpp
+ * @brief Known DNS resolver set, loaded from JSON or from a compiled memory-mapped file.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/KnownDnsDb.hpp"
+
+#include "lib/json.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace monitors {
+
+namespace {
+
+constexpr char MAGIC[8] = {'S', 'P', 'E', 'Y', 'E', 'K', 'D', 'B'};
+
+static_assert(sizeof(KnownDnsDb::Header) == 48, "compiled header layout");
+static_assert(sizeof(Ipv6Addr) == 16, "compiled IPv6 entry layout");
+
+/// Section offsets of a compiled file
+struct Layout {
+    std::size_t ipv6;
+    std::size_t jump4;
+    std::size_t nodes4;
+    std::size_t jump6;
+    std::size_t nodes6;
+    std::size_t size;
+};
+
+/// Sections are padded so the 64-bit words stay aligned
+std::size_t align8(std::size_t bytes) noexcept {
+    return (bytes + 7) / 8 * 8;
+}
+
+std::size_t jump_bytes(unsigned stride) noexcept {
+    return stride ? (std::size_t{1} << stride) * sizeof(uint32_t) : 0;
+}
+
+Layout layout_of(const KnownDnsDb::Header& header) noexcept {
+    Layout layout{};
+    layout.ipv6 = sizeof(KnownDnsDb::Header) + align8(std::size_t{header.ipv4Count} * sizeof(uint32_t));
+    layout.jump4 = layout.ipv6 + std::size_t{header.ipv6Count} * sizeof(Ipv6Addr);
+    layout.nodes4 = layout.jump4 + align8(jump_bytes(header.trie4Stride));
+    layout.jump6 = layout.nodes4 + std::size_t{header.trie4Nodes} * sizeof(PrefixTrie::Node);
+    layout.nodes6 = layout.jump6 + align8(jump_bytes(header.trie6Stride));
+    layout.size = layout.nodes6 + std::size_t{header.trie6Nodes} * sizeof(PrefixTrie::Node);
+    return layout;
+}
+
+uint64_t fnv1a(const uint8_t* data, std::size_t len) noexcept {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool ipv6_less(const Ipv6Addr& a, const Ipv6Addr& b) noexcept {
+    return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo;
+}
+
+/**
+ * @brief Branchless search of a sorted array.
+ *
+ * Each step halves the window with a conditional move instead of a branch,
+ * so a lookup costs log2(n) dependent loads and no mispredictions; both
+ * candidates of the next step are prefetched while the current one is
+ * compared. The window never shrinks to zero: the final element is the
+ * largest one not above the key.
+ */
+template <typename T, typename LessEq>
+bool branchless_contains(const T* base, std::size_t n, const T& key, LessEq lessEq) noexcept {
+    if (n == 0) return false;
+    while (n > 1) {
+        std::size_t half = n / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base = lessEq(base[half], key) ? base + half : base;
+        n -= half;
+    }
+    return lessEq(*base, key) && lessEq(key, *base);
+}
+
+bool ipv4_less_eq(uint32_t a, uint32_t b) noexcept {
+    return a <= b;
+}
+
+bool ipv6_less_eq(const Ipv6Addr& a, const Ipv6Addr& b) noexcept {
+    return (a.hi < b.hi) | ((a.hi == b.hi) & (a.lo <= b.lo));
+}
+
+/// ::ffff:a.b.c.d
+bool is_v4_mapped(const Ipv6Addr& addr) noexcept {
+    return addr.hi == 0 && (addr.lo >> 32) == 0xffff;
+}
+
+/// IPv4 trie key: the host-order address in the top 32 bits
+Ipv6Addr ipv4_key(uint32_t hostOrder) noexcept {
+    Ipv6Addr key;
+    key.hi = static_cast<uint64_t>(hostOrder) << 32;
+    return key;
+}
+
+/**
+ * @brief Parse one entry into either array.
+ * @return False if the text is not an IP address.
+ */
+bool parse_address(std::string text, uint32_t& v4, Ipv6Addr& v6, bool& isV4) noexcept {
+    std::size_t scope = text.find('%');
+    if (scope != std::string::npos) text.erase(scope);
+
+    uint32_t ip = 0;
+    if (NetAddr::parseIpv4(text, ip)) {
+        v4 = ntohl(ip);
+        isV4 = true;
+        return true;
+    }
+    if (!NetAddr::parseIpv6(text, v6)) return false;
+    isV4 = is_v4_mapped(v6);
+    if (isV4) v4 = static_cast<uint32_t>(v6.lo);
+    return true;
+}
+
+/**
+ * @brief Parse one entry: an address, or a CIDR prefix of either family.
+ * @param[out] len Prefix length, 32 or 128 for a plain address.
+ * @return False if the text is neither.
+ */
+bool parse_entry(std::string text, uint32_t& v4, Ipv6Addr& v6, bool& isV4, unsigned& len) {
+    std::size_t slash = text.find('/');
+    std::string lenText;
+    if (slash != std::string::npos) {
+        lenText = text.substr(slash + 1);
+        text.erase(slash);
+    }
+    if (!parse_address(text, v4, v6, isV4)) return false;
+
+    len = isV4 ? 32 : 128;
+    if (slash == std::string::npos) return true;
+    if (lenText.empty() || lenText.size() > 3 || lenText.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned value = static_cast<unsigned>(std::stoul(lenText));
+    // ::ffff:a.b.c.d/n is an IPv4 prefix only when it stays inside the mapped range
+    if (isV4 && text.find(':') != std::string::npos) {
+        if (value < 96) {
+            isV4 = false;
+            len = 128;
+        } else {
+            value -= 96;
+        }
+    }
+    if (value > len) return false;
+    len = value;
+    return true;
+}
+
+std::string errno_message(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+KnownDnsDb::~KnownDnsDb() {
+    reset();
+}
+
+KnownDnsDb::KnownDnsDb(KnownDnsDb&& other) noexcept {
+    swap(other);
+}
+
+KnownDnsDb& KnownDnsDb::operator=(KnownDnsDb&& other) noexcept {
+    if (this != &other) {
+        reset();
+        swap(other);
+    }
+    return *this;
+}
+
+void KnownDnsDb::swap(KnownDnsDb& other) noexcept {
+    // Swapping vectors keeps their buffers, so the array pointers stay valid
+    std::swap(m_ipv4, other.m_ipv4);
+    std::swap(m_ipv6, other.m_ipv6);
+    std::swap(m_ipv4Count, other.m_ipv4Count);
+    std::swap(m_ipv6Count, other.m_ipv6Count);
+    m_ownedIpv4.swap(other.m_ownedIpv4);
+    m_ownedIpv6.swap(other.m_ownedIpv6);
+    std::swap(m_prefixes4, other.m_prefixes4);
+    std::swap(m_prefixes6, other.m_prefixes6);
+    std::swap(m_mapping, other.m_mapping);
+    std::swap(m_mappingSize, other.m_mappingSize);
+}
+
+void KnownDnsDb::reset() noexcept {
+    if (m_mapping) ::munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_ownedIpv4.clear();
+    m_ownedIpv4.shrink_to_fit();
+    m_ownedIpv6.clear();
+    m_ownedIpv6.shrink_to_fit();
+    m_ipv4 = nullptr;
+    m_ipv6 = nullptr;
+    m_ipv4Count = 0;
+    m_ipv6Count = 0;
+    m_prefixes4.clear();
+    m_prefixes6.clear();
+}
+
+bool KnownDnsDb::loadJson(const std::string& path, std::string& error, std::size_t* skipped) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        error = "Failed to open known DNS JSON: " + path;
+        return false;
+    }
+
+    std::vector<uint32_t> ipv4;
+    std::vector<Ipv6Addr> ipv6;
+    PrefixTrie prefixes4;
+    PrefixTrie prefixes6;
+    std::size_t invalid = 0;
+    try {
+        nlohmann::json j;
+        ifs >> j;
+        if (!j.is_array()) {
+            error = "Known DNS JSON is not an array.";
+            return false;
+        }
+        ipv4.reserve(j.size());
+        for (const auto& entry : j) {
+            if (!entry.is_string()) {
+                error = "Known DNS JSON contains non-string entries.";
+                return false;
+            }
+            uint32_t v4 = 0;
+            Ipv6Addr v6;
+            bool isV4 = false;
+            unsigned len = 0;
+            if (!parse_entry(entry.get<std::string>(), v4, v6, isV4, len)) {
+                ++invalid;
+            } else if (isV4 && len == 32) {
+                ipv4.push_back(v4);
+            } else if (isV4) {
+                if (!prefixes4.insert(ipv4_key(v4), len)) ++invalid;
+            } else if (len == 128) {
+                ipv6.push_back(v6);
+            } else if (!prefixes6.insert(v6, len)) {
+                ++invalid;
+            }
+        }
+    } catch (const std::exception& ex) {
+        error = "JSON parse error: " + std::string(ex.what());
+        return false;
+    }
+
+    if (ipv4.empty() && ipv6.empty() && prefixes4.empty() && prefixes6.empty()) {
+        error = "No valid DNS entries found in the JSON file.";
+        return false;
+    }
+
+    std::sort(ipv4.begin(), ipv4.end());
+    ipv4.erase(std::unique(ipv4.begin(), ipv4.end()), ipv4.end());
+    std::sort(ipv6.begin(), ipv6.end(), ipv6_less);
+    ipv6.erase(std::unique(ipv6.begin(), ipv6.end()), ipv6.end());
+    prefixes4.finalize();
+    prefixes6.finalize();
+
+    reset();
+    m_ownedIpv4 = std::move(ipv4);
+    m_ownedIpv6 = std::move(ipv6);
+    m_ipv4 = m_ownedIpv4.data();
+    m_ipv6 = m_ownedIpv6.data();
+    m_ipv4Count = m_ownedIpv4.size();
+    m_ipv6Count = m_ownedIpv6.size();
+    m_prefixes4 = std::move(prefixes4);
+    m_prefixes6 = std::move(prefixes6);
+    if (skipped) *skipped = invalid;
+    return true;
+}
+
+bool KnownDnsDb::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = errno_message(path);
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) {
+        error = errno_message(path);
+        ::close(fd);
+        return false;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size < sizeof(Header)) {
+        error = path + ": truncated";
+        ::close(fd);
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = errno_message("mmap " + path);
+        return false;
+    }
+
+    const auto* base = static_cast<const uint8_t*>(mapping);
+    const auto* header = reinterpret_cast<const Header*>(base);
+    const char* problem = nullptr;
+    Layout layout{};
+    PrefixTrie prefixes4;
+    PrefixTrie prefixes6;
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        problem = "not a compiled known DNS database";
+    } else if (header->byteOrder != BYTE_ORDER_MARK) {
+        problem = "compiled on a host with another byte order";
+    } else if (header->version != FORMAT_VERSION) {
+        problem = "unsupported format version";
+    } else if (header->trie4Stride > PrefixTrie::MAX_STRIDE || header->trie6Stride > PrefixTrie::MAX_STRIDE ||
+               size != (layout = layout_of(*header)).size) {
+        problem = "size does not match the header";
+    } else if (fnv1a(base + sizeof(Header), size - sizeof(Header)) != header->checksum) {
+        problem = "checksum mismatch";
+    } else if (!prefixes4.attach(reinterpret_cast<const PrefixTrie::Node*>(base + layout.nodes4), header->trie4Nodes,
+                                 reinterpret_cast<const uint32_t*>(base + layout.jump4), header->trie4Stride) ||
+               !prefixes6.attach(reinterpret_cast<const PrefixTrie::Node*>(base + layout.nodes6), header->trie6Nodes,
+                                 reinterpret_cast<const uint32_t*>(base + layout.jump6), header->trie6Stride)) {
+        problem = "inconsistent prefix trie";
+    }
+    if (problem) {
+        error = path + ": " + problem;
+        ::munmap(mapping, size);
+        return false;
+    }
+
+    reset();
+    m_mapping = mapping;
+    m_mappingSize = size;
+    m_ipv4Count = header->ipv4Count;
+    m_ipv6Count = header->ipv6Count;
+    m_ipv4 = reinterpret_cast<const uint32_t*>(base + sizeof(Header));
+    m_ipv6 = reinterpret_cast<const Ipv6Addr*>(base + layout.ipv6);
+    m_prefixes4 = std::move(prefixes4);
+    m_prefixes6 = std::move(prefixes6);
+    return true;
+}
+
+bool KnownDnsDb::compile(const std::string& path, std::string& error) const {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.ipv4Count = static_cast<uint32_t>(m_ipv4Count);
+    header.ipv6Count = static_cast<uint32_t>(m_ipv6Count);
+    header.trie4Nodes = static_cast<uint32_t>(m_prefixes4.nodeCount());
+    header.trie6Nodes = static_cast<uint32_t>(m_prefixes6.nodeCount());
+    header.trie4Stride = static_cast<uint8_t>(m_prefixes4.stride());
+    header.trie6Stride = static_cast<uint8_t>(m_prefixes6.stride());
+
+    const Layout layout = layout_of(header);
+    const std::size_t size = layout.size;
+    std::vector<uint8_t> image(size, 0);
+    auto put = [&image](std::size_t offset, const void* data, std::size_t bytes) {
+        if (bytes) std::memcpy(image.data() + offset, data, bytes);
+    };
+    put(sizeof(Header), m_ipv4, m_ipv4Count * sizeof(uint32_t));
+    put(layout.ipv6, m_ipv6, m_ipv6Count * sizeof(Ipv6Addr));
+    put(layout.jump4, m_prefixes4.jumpTable(), jump_bytes(m_prefixes4.stride()));
+    put(layout.nodes4, m_prefixes4.nodes(), m_prefixes4.nodeCount() * sizeof(PrefixTrie::Node));
+    put(layout.jump6, m_prefixes6.jumpTable(), jump_bytes(m_prefixes6.stride()));
+    put(layout.nodes6, m_prefixes6.nodes(), m_prefixes6.nodeCount() * sizeof(PrefixTrie::Node));
+    header.checksum = fnv1a(image.data() + sizeof(Header), size - sizeof(Header));
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    // Readers (and the running monitor) only ever see a complete file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            error = errno_message(tmp);
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(size));
+        if (!ofs.flush()) {
+            error = errno_message(tmp);
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = errno_message(path);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool KnownDnsDb::contains(const std::string& ip) const {
+    uint32_t v4 = 0;
+    Ipv6Addr v6;
+    bool isV4 = false;
+    if (!parse_address(ip, v4, v6, isV4)) return false;
+    return isV4 ? containsHostIpv4(v4) : containsIpv6(v6);
+}
+
+bool KnownDnsDb::containsIpv4(uint32_t ip) const noexcept {
+    return containsHostIpv4(ntohl(ip));
+}
+
+bool KnownDnsDb::containsIpv6(const Ipv6Addr& ip) const noexcept {
+    if (is_v4_mapped(ip)) return containsHostIpv4(static_cast<uint32_t>(ip.lo));
+    return branchless_contains(m_ipv6, m_ipv6Count, ip, ipv6_less_eq) || m_prefixes6.longestMatch(ip) >= 0;
+}
+
+bool KnownDnsDb::containsHostIpv4(uint32_t ip) const noexcept {
+    return branchless_contains(m_ipv4, m_ipv4Count, ip, ipv4_less_eq) || m_prefixes4.longestMatch(ipv4_key(ip)) >= 0;
+}
+
+} // namespace monitors
@@ -0,0 +1,799 @@
+/**
+ * @file NdpMonitor.cpp
+ * @brief Implementation of the IPv6 Neighbor Discovery monitor.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/NdpMonitor.hpp"
+#include "capture/CaptureEngine.hpp"
+#include "capture/NdpPacket.hpp"
+#include "monitors/BindingTracker.hpp"
+#include "monitors/RouterAdvertTracker.hpp"
+#include "utils/ConnectedNetworks.hpp"
+#include "utils/DefaultGateway.hpp"
+#include "utils/Logger.hpp"
+#include "utils/NetAddr.hpp"
+#include "utils/Netlink.hpp"
+#include "utils/SpscQueue.hpp"
+#include "utils/WakeupFd.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <linux/neighbour.h>
+#include <memory>
+#include <mutex>
+#include <net/if.h>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace monitors {
+
+namespace {
+
+/// Neighbour states carrying a usable link-layer address (kernel's NUD_VALID)
+constexpr uint16_t NUD_HAS_LLADDR = NUD_PERMANENT | NUD_NOARP | NUD_REACHABLE |
+                                    NUD_PROBE | NUD_STALE | NUD_DELAY;
+
+/// Minimum delay between two alerts for the same address (seconds)
+constexpr uint32_t ALERT_INTERVAL = 60;
+
+/// Upper bound on per-address alerts per second across all addresses; the rest is summarized
+constexpr uint32_t MAX_ALERTS_PER_SECOND = 5;
+
+/// Minimum delay between two sweeps of a full alert table (seconds)
+constexpr uint32_t ALERT_SWEEP_INTERVAL = 5;
+
+/**
+ * @brief Last alert time per address, swept at most every ALERT_SWEEP_INTERVAL when full.
+ */
+struct AlertTable {
+    FlatHashMap<Ipv6Addr, uint32_t> last;
+    uint32_t sweptAt = 0;
+
+    AlertTable(std::size_t initialCapacity, std::size_t maxSize) : last(initialCapacity, maxSize) {}
+};
+
+/// Hop limit of every genuine Neighbor Discovery message (RFC 4861)
+constexpr uint8_t ND_HOP_LIMIT = 255;
+
+constexpr uint8_t ICMPV6_ROUTER_ADVERTISEMENT = 134;
+
+/// Decoded NS/NA and RAs a capture worker may queue ahead of the monitor thread
+constexpr std::size_t NEIGHBOUR_QUEUE_SIZE = 1024;
+constexpr std::size_t ADVERT_QUEUE_SIZE = 256;
+
+uint32_t unix_now() {
+    return static_cast<uint32_t>(std::time(nullptr));
+}
+
+/// Where a binding observation comes from
+enum class Source {
+    KERNEL, ///< Kernel neighbour table (netlink)
+    WIRE    ///< NDP packet captured on the link
+};
+
+/**
+ * @brief One IPv6 neighbour table entry, as reported by netlink.
+ */
+struct Neigh6Entry {
+    Ipv6Addr addr;          ///< Scoped address, see scoped()
+    uint64_t mac = 0;       ///< Packed MAC (valid if resolved)
+    bool resolved = false;  ///< False for deleted, incomplete or failed entries
+    bool router = false;    ///< Kernel flagged the neighbour as a router (NTF_ROUTER)
+};
+
+/**
+ * @brief Messages decoded by one capture worker, queued for the monitor thread.
+ */
+struct CaptureQueues {
+    SpscQueue<capture::NdpPacket> neighbours{NEIGHBOUR_QUEUE_SIZE};  ///< Solicitations and advertisements
+    SpscQueue<capture::RaPacket> adverts{ADVERT_QUEUE_SIZE};         ///< Router Advertisements
+};
+
+/**
+ * @brief Table key of an address seen on an interface.
+ *
+ * The same link-local address (typically fe80::1) may exist on several links,
+ * so the interface index is folded into the always-zero bits 32-63 of
+ * fe80::/64, as the KAME stack does with scope IDs.
+ */
+Ipv6Addr scoped(Ipv6Addr addr, int ifindex) noexcept {
+    if (addr.isLinkLocal()) addr.hi |= static_cast<uint32_t>(ifindex);
+    return addr;
+}
+
+/**
+ * @brief Format a scoped key as "addr" or "fe80::...%ifname".
+ */
+std::string format_scoped(const Ipv6Addr& key) {
+    if (!key.isLinkLocal()) return NetAddr::formatIpv6(key);
+
+    Ipv6Addr addr = key;
+    unsigned ifindex = static_cast<uint32_t>(addr.hi);
+    addr.hi &= ~uint64_t{0xffffffff};
+    std::string text = NetAddr::formatIpv6(addr);
+    char name[IF_NAMESIZE] = {0};
+    if (ifindex != 0 && if_indextoname(ifindex, name)) text += std::string("%") + name;
+    return text;
+}
+
+/**
+ * @brief Format an advertised prefix as "2001:db8::/64".
+ */
+std::string format_prefix(const capture::RaPacket::Prefix& p) {
+    return NetAddr::formatIpv6(p.prefix) + "/" + std::to_string(p.length);
+}
+
+/**
+ * @brief Join the prefixes selected by a bitmask (all if mask is 0xff).
+ */
+std::string format_prefixes(const capture::RaPacket& ra, uint8_t mask) {
+    std::string out;
+    for (uint8_t i = 0; i < ra.prefixCount; ++i) {
+        if (!(mask & (1u << i))) continue;
+        if (!out.empty()) out += ", ";
+        out += format_prefix(ra.prefixes[i]);
+    }
+    return out.empty() ? "none" : out;
+}
+
+} // namespace
+
+// Implementation details hidden in Pimpl
+struct NdpMonitor::Impl {
+    std::string router;         ///< IPv6 default router, empty if none
+    Ipv6Addr router_key;        ///< Scoped key of the default router
+    std::atomic<bool> running{false};
+    std::mutex mtx;
+    WakeupFd wakeup;            ///< Signalled by stop() to interrupt poll()
+    NotificationCallback notify_cb;
+
+    NdpBindingTracker bindings; ///< Bindings of every IPv6 neighbour
+    ConnectedNetworks connected; ///< Prefixes a captured address must fall in to be learned
+    uint32_t last_expiry = 0;   ///< Last time stale bindings were evicted
+    bool table_full_logged = false;
+
+    // Captured messages are decoded on the capture workers and judged on the
+    // monitor thread, which owns every tracker: no lock on either side
+    bool capture_attached = false;
+    std::vector<std::unique_ptr<CaptureQueues>> captured;  ///< One set of queues per capture worker
+    WakeupFd captured_ready;                ///< Signalled by a worker after queuing a batch
+    std::atomic<uint64_t> captured_drops{0}; ///< Messages lost to a full queue, not yet logged
+    uint64_t unlogged_drops = 0;
+    uint32_t drops_logged_at = 0;
+
+    FlatHashMap<Ipv6Addr, uint32_t> routers{16, 1024};       ///< Router -> last time it acted as one
+    AlertTable rebind_alerts{64, 4096};   ///< Address -> last rebinding alert time
+    AlertTable forged_alerts{64, 4096};   ///< Address -> last forged-packet alert time
+    RouterAdvertTracker ra_tracker;       ///< Trusted routers and their prefixes
+    AlertTable spoofed_ra_alerts{16, 1024}; ///< Router -> last spoofed RA alert time
+    AlertTable rogue_ra_alerts{16, 1024};   ///< Router -> last unknown-router alert time
+    uint64_t ra_flood_count = 0;          ///< RAs of unknown routers not remembered during the current flood
+    uint32_t ra_flood_at = 0;             ///< Last such RA
+    uint32_t alert_second = 0;            ///< Second the alerts below were counted in
+    uint32_t alerts_in_second = 0;
+    uint64_t suppressed_alerts = 0;       ///< Alerts withheld by the current flood
+    uint32_t suppressed_at = 0;           ///< Last time an alert was withheld
+
+    Impl() = default;
+    ~Impl() = default;
+
+    /**
+     * @brief Thread-safe read of the default router.
+     */
+    std::string current_router() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return router;
+    }
+
+    /**
+     * @brief Re-detect the IPv6 default router and switch to it if it changed.
+     * @param announce Log the change (false for the initial detection).
+     * @return True if the default router changed.
+     */
+    bool refresh_router(bool announce = true) {
+        int ifindex = 0;
+        std::string detected = DefaultGateway::detectIpv6(&ifindex);
+        Ipv6Addr addr;
+        Ipv6Addr key = NetAddr::parseIpv6(detected, addr) ? scoped(addr, ifindex) : Ipv6Addr{};
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (detected == router && key == router_key) return false;
+        if (announce) {
+            Logger::log("IPv6 default router changed from " + (router.empty() ? "(none)" : router) +
+                        " to " + (detected.empty() ? "(none)" : format_scoped(key)),
+                        Logger::LogType::INFO, LogPrefixes::ndp_monitor);
+        }
+        router = detected;
+        router_key = key;
+        return true;
+    }
+
+    /**
+     * @brief Forward an alert to the notification callback, if any.
+     */
+    void notify(const std::string& title, const std::string& body) {
+        NotificationCallback cb;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cb = notify_cb;
+        }
+        if (cb) {
+            try { cb(title, body); } catch (...) {}
+        }
+    }
+
+    /**
+     * @brief Rate-limit alerts per address, and overall since forged addresses are free.
+     *
+     * Whatever the per-second cap or a full table withholds is reported once
+     * as a flood, never let through.
+     * @return True if an alert for key may be raised now.
+     */
+    bool alert_allowed(AlertTable& table, const Ipv6Addr& key, uint32_t now) {
+        auto [last, inserted] = table.last.insert(key);
+        if (!last && now - table.sweptAt >= ALERT_SWEEP_INTERVAL) {
+            table.sweptAt = now;
+            table.last.eraseIf([&](const Ipv6Addr&, uint32_t at) { return now - at >= ALERT_INTERVAL; });
+            std::tie(last, inserted) = table.last.insert(key);
+        }
+        if (!last) {
+            suppress_alert(now);
+            return false;
+        }
+        if (!inserted && now - *last < ALERT_INTERVAL) return false;
+        if (!take_alert_slot(now)) {
+            if (inserted) table.last.erase(key);
+            suppress_alert(now);
+            return false;
+        }
+        *last = now;
+        return true;
+    }
+
+    /**
+     * @brief Count an alert against the per-second budget.
+     * @return False if MAX_ALERTS_PER_SECOND were already raised this second.
+     */
+    bool take_alert_slot(uint32_t now) {
+        if (now != alert_second) {
+            alert_second = now;
+            alerts_in_second = 0;
+        }
+        if (alerts_in_second >= MAX_ALERTS_PER_SECOND) return false;
+        ++alerts_in_second;
+        return true;
+    }
+
+    /**
+     * @brief Withhold an alert; the first one of a flood raises a single aggregate alert.
+     */
+    void suppress_alert(uint32_t now) {
+        end_alert_flood(now);
+        suppressed_at = now;
+        if (suppressed_alerts++ > 0) return;
+        std::string msg = "more than " + std::to_string(MAX_ALERTS_PER_SECOND) +
+                          " NDP alerts per second, further alerts are withheld until it calms down";
+        Logger::log("NDP alert flood: " + msg, Logger::LogType::CRITICAL, LogPrefixes::ndp_monitor);
+        notify("NDP Alert Flood", "Neighbor Discovery spoofing flood, " + msg);
+    }
+
+    /**
+     * @brief Log how many alerts a flood withheld once none was for ALERT_INTERVAL.
+     */
+    void end_alert_flood(uint32_t now) {
+        if (suppressed_alerts == 0 || now - suppressed_at < ALERT_INTERVAL) return;
+        Logger::log("NDP alert flood over, " + std::to_string(suppressed_alerts) + " alert(s) withheld",
+                    Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        suppressed_alerts = 0;
+    }
+
+    /**
+     * @brief Remember that an address acts as a router.
+     */
+    void mark_router(const Ipv6Addr& key, uint32_t now) {
+        if (routers.full()) {
+            routers.eraseIf([&](const Ipv6Addr&, uint32_t last) {
+                return now - last > NdpBindingTracker::DEFAULT_RETENTION_SECONDS;
+            });
+        }
+        if (uint32_t* last = routers.insert(key).first) *last = now;
+    }
+
+    bool is_router(const Ipv6Addr& key) const {
+        return (!router_key.isUnspecified() && key == router_key) || routers.find(key) != nullptr;
+    }
+
+    /**
+     * @brief Decode an IPv6 RTM_NEWNEIGH / RTM_DELNEIGH message.
+     * @param msg Netlink message.
+     * @param[out] entry Decoded entry.
+     * @return True if the message is an IPv6 neighbour update.
+     */
+    static bool parse_neigh(const nlmsghdr& msg, Neigh6Entry& entry) {
+        if (msg.nlmsg_type != RTM_NEWNEIGH && msg.nlmsg_type != RTM_DELNEIGH) return false;
+        if (msg.nlmsg_len < NLMSG_LENGTH(sizeof(ndmsg))) return false;
+
+        const auto* ndm = static_cast<const ndmsg*>(NLMSG_DATA(&msg));
+        if (ndm->ndm_family != AF_INET6) return false;
+
+        const rtattr* attrs[NDA_MAX + 1];
+        NetlinkSocket::parseAttributes(RTM_RTA(ndm), static_cast<int>(RTM_PAYLOAD(&msg)), attrs, NDA_MAX);
+
+        const rtattr* dst = attrs[NDA_DST];
+        if (!dst || RTA_PAYLOAD(dst) != 16) return false;
+        Ipv6Addr addr = NetAddr::packIpv6(static_cast<const uint8_t*>(RTA_DATA(dst)));
+        if (addr.isMulticast() || addr.isUnspecified()) return false;
+        entry.addr = scoped(addr, ndm->ndm_ifindex);
+        entry.router = (ndm->ndm_flags & NTF_ROUTER) != 0;
+
+        entry.mac = 0;
+        entry.resolved = false;
+        const rtattr* lladdr = attrs[NDA_LLADDR];
+        bool valid = msg.nlmsg_type == RTM_NEWNEIGH && (ndm->ndm_state & NUD_HAS_LLADDR);
+        if (valid && lladdr && RTA_PAYLOAD(lladdr) == 6) {
+            entry.mac = NetAddr::packMac(static_cast<const uint8_t*>(RTA_DATA(lladdr)));
+            entry.resolved = entry.mac != 0;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Feed a resolved neighbour into the binding tracker.
+     * @param report False while loading the initial table (no alerts).
+     * @param source Kernel table or captured NS/NA.
+     */
+    void observe_binding(const Ipv6Addr& key, uint64_t mac, uint32_t now, bool report, Source source) {
+        uint64_t previous = 0;
+        NdpBindingTracker::Origin origin = source == Source::KERNEL ? NdpBindingTracker::Origin::KERNEL
+                                                                  : NdpBindingTracker::Origin::WIRE;
+        NdpBindingTracker::Update result = bindings.observe(key, mac, now, origin, &previous);
+
+        if (result == NdpBindingTracker::Update::DROPPED) {
+            if (!table_full_logged) {
+                Logger::log("NDP binding table full (" + std::to_string(bindings.size()) + " entries, " +
+                            std::to_string(bindings.wireOnlyCount()) +
+                            " only seen on the wire), ignoring new neighbours",
+                            Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+                table_full_logged = true;
+            }
+            return;
+        }
+        table_full_logged = false;
+        if (result != NdpBindingTracker::Update::REBOUND || !report) return;
+        if (!alert_allowed(rebind_alerts, key, now)) return;
+
+        std::string addrStr = format_scoped(key);
+        std::string oldMac = NetAddr::formatMac(previous);
+        std::string newMac = NetAddr::formatMac(mac);
+        if (is_router(key)) {
+            std::string origin = source == Source::WIRE ? "Neighbor Discovery" : "neighbour table";
+            Logger::log("MAC change for IPv6 router " + addrStr + " : " + oldMac + " -> " + newMac +
+                        " (" + origin + ")", Logger::LogType::CRITICAL, LogPrefixes::ndp_monitor);
+            notify("NDP Alert", "IPv6 router " + addrStr + " moved from " + oldMac + " to " + newMac);
+            return;
+        }
+        Logger::log("NDP rebinding for " + addrStr + " : " + oldMac + " -> " + newMac,
+                    Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        notify("NDP Rebinding", "Host " + addrStr + " moved from " + oldMac + " to " + newMac);
+    }
+
+    /**
+     * @brief Report an RA or NS/NA that was routed to us, hence forged off-link.
+     */
+    void report_forged(const Ipv6Addr& key, uint64_t ethSrc, uint8_t hopLimit, uint32_t now) {
+        if (!alert_allowed(forged_alerts, key, now)) return;
+        Logger::log("Forged NDP packet for " + format_scoped(key) + " from " +
+                    NetAddr::formatMac(ethSrc) + " (hop limit " + std::to_string(hopLimit) + ")",
+                    Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        notify("NDP Alert", "Routed (forged) Neighbor Discovery packet about " + format_scoped(key));
+    }
+
+    /**
+     * @brief Trust the current default router on first use, unless a whitelist is set.
+     */
+    void seed_trusted_router() {
+        if (ra_tracker.hasWhitelist() || !router_key.isLinkLocal()) return;
+        const NeighborBinding* binding = bindings.find(router_key);
+        ra_tracker.trustRouter(router_key, binding ? binding->mac : 0);
+    }
+
+    /**
+     * @brief Check a captured Router Advertisement against the trusted routers.
+     */
+    void check_router_advert(const capture::RaPacket& ra) {
+        Ipv6Addr key = scoped(ra.source, ra.ifindex);
+        if (ra.hopLimit != ND_HOP_LIMIT) {
+            report_forged(key, ra.ethSrc, ra.hopLimit, ra.tsSec);
+            return;
+        }
+        // RFC 4861: routers always advertise from their link-local address
+        if (!ra.source.isLinkLocal()) return;
+
+        uint64_t mac = ra.routerMac();
+        RouterAdvertTracker::Findings found = ra_tracker.observe(ra, key);
+
+        if (found.spoofed) {
+            if (!alert_allowed(spoofed_ra_alerts, key, ra.tsSec)) return;
+            std::string detail = "RA for trusted router " + format_scoped(key) + " sent by " +
+                                 NetAddr::formatMac(mac) + " instead of " + NetAddr::formatMac(found.expectedMac);
+            if (found.withdrawn) detail += ", with router lifetime 0 (default route kill)";
+            Logger::log("Spoofed " + detail, Logger::LogType::CRITICAL, LogPrefixes::ndp_monitor);
+            notify("Rogue Router Alert", "Spoofed " + detail);
+            return;
+        }
+
+        // Only RAs from trusted routers may teach the binding of a router
+        if (!found.untrusted) {
+            mark_router(key, ra.tsSec);
+            if (ra.linkAddr != 0) observe_binding(key, ra.linkAddr, ra.tsSec, true, Source::WIRE);
+        }
+
+        std::string router = format_scoped(key) + " (" + NetAddr::formatMac(mac) + ")";
+        if (found.learned) {
+            // The kernel's default router at startup is seeded as trusted, so this one was
+            // not it: whoever advertised first now vouches for every later RA
+            std::string detail = "IPv6 router " + router + " trusted on first use, though it was not the "
+                                 "default router at startup, prefixes: " + format_prefixes(ra, 0xff);
+            Logger::log(detail, Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+            notify("New IPv6 Router", detail);
+        }
+        if (found.untrusted && found.overflow) {
+            report_ra_flood(ra.tsSec);
+        } else if (found.untrusted && alert_allowed(rogue_ra_alerts, key, ra.tsSec)) {
+            std::string detail = "Router Advertisement from unknown router " + router + ", lifetime " +
+                                 std::to_string(ra.routerLifetime) + "s, prefixes: " + format_prefixes(ra, 0xff);
+            Logger::log("Rogue " + detail, Logger::LogType::CRITICAL, LogPrefixes::ndp_monitor);
+            notify("Rogue Router Alert", detail);
+        }
+        if (found.withdrawn) {
+            Logger::log("IPv6 router " + router + " stopped acting as default router (lifetime 0)",
+                        Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+            notify("Router Withdrawn", "IPv6 router " + router + " advertised a router lifetime of 0");
+        }
+        if (found.newPrefixes) {
+            std::string prefixes = format_prefixes(ra, found.newPrefixes);
+            Logger::log("IPv6 router " + router + " advertises new prefix(es): " + prefixes,
+                        Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+            notify("IPv6 Prefix Change", "Router " + router + " now advertises " + prefixes);
+        }
+        if (found.killedPrefixes) {
+            std::string prefixes = format_prefixes(ra, found.killedPrefixes);
+            Logger::log("IPv6 router " + router + " withdrew prefix(es) with lifetime 0: " + prefixes,
+                        Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+            notify("IPv6 Prefix Change", "Router " + router + " invalidated " + prefixes);
+        }
+    }
+
+    /**
+     * @brief Count an RA of an unknown router that no longer fits the router table.
+     *
+     * Only a flood of invented routers fills the table, so the first such RA
+     * raises a single "RA flood" alert and the rest are counted.
+     */
+    void report_ra_flood(uint32_t now) {
+        end_ra_flood(now);
+        ra_flood_at = now;
+        if (ra_flood_count++ > 0) return;
+        std::string detail = "Router Advertisement flood: more than " +
+                             std::to_string(RouterAdvertTracker::DEFAULT_MAX_ROUTERS) +
+                             " routers advertised, further unknown routers are only counted";
+        Logger::log(detail, Logger::LogType::CRITICAL, LogPrefixes::ndp_monitor);
+        notify("Rogue Router Alert", detail);
+    }
+
+    /**
+     * @brief Log how many RAs a flood sent once none overflowed for ALERT_INTERVAL.
+     */
+    void end_ra_flood(uint32_t now) {
+        if (ra_flood_count == 0 || now - ra_flood_at < ALERT_INTERVAL) return;
+        Logger::log("Router Advertisement flood over, " + std::to_string(ra_flood_count) +
+                    " RA(s) from unknown routers", Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        ra_flood_count = 0;
+    }
+
+    /**
+     * @brief Feed a captured neighbour advertisement or solicitation into the trackers.
+     */
+    void handle_neighbour(const capture::NdpPacket& ndp) {
+        if (ndp.hopLimit != ND_HOP_LIMIT) {
+            // The kernel drops it, but someone off-link is trying
+            report_forged(scoped(ndp.target, ndp.ifindex), ndp.ethSrc, ndp.hopLimit, ndp.tsSec);
+            return;
+        }
+
+        if (ndp.type == capture::NdpPacket::Type::NEIGHBOR_SOLICITATION) {
+            if (ndp.linkAddr == 0 || !on_link(ndp.source, ndp.ifindex)) return;
+            observe_binding(scoped(ndp.source, ndp.ifindex), ndp.linkAddr, ndp.tsSec, true, Source::WIRE);
+            return;
+        }
+
+        // Unicast answers may omit the option: the frame source is the binding then
+        if (!on_link(ndp.target, ndp.ifindex)) return;
+        Ipv6Addr key = scoped(ndp.target, ndp.ifindex);
+        if (ndp.router) mark_router(key, ndp.tsSec);
+        uint64_t mac = ndp.linkAddr != 0 ? ndp.linkAddr : ndp.ethSrc;
+        observe_binding(key, mac, ndp.tsSec, true, Source::WIRE);
+    }
+
+    /**
+     * @brief True if a captured address may be a neighbour: link-local, or in a prefix of the interface.
+     *
+     * Forged addresses from anywhere else would only fill the binding table.
+     * Everything is accepted until the interface addresses could be read.
+     */
+    bool on_link(const Ipv6Addr& addr, int ifindex) const {
+        return !connected.loaded() || connected.containsIpv6(ifindex, addr);
+    }
+
+    /**
+     * @brief Judge the messages every capture worker queued, in capture order per worker and kind.
+     */
+    void drain_captured() {
+        captured_ready.drain();
+        for (auto& queues : captured) {
+            queues->adverts.drain([&](const capture::RaPacket& ra) { check_router_advert(ra); });
+            queues->neighbours.drain([&](const capture::NdpPacket& ndp) { handle_neighbour(ndp); });
+        }
+
+        unlogged_drops += captured_drops.exchange(0, std::memory_order_relaxed);
+        uint32_t now = unix_now();
+        end_alert_flood(now);
+        end_ra_flood(now);
+        if (unlogged_drops == 0 || now - drops_logged_at < ALERT_INTERVAL) return;
+        Logger::log(std::to_string(unlogged_drops) + " captured NDP message(s) dropped, the monitor fell behind",
+                    Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        unlogged_drops = 0;
+        drops_logged_at = now;
+    }
+
+    /**
+     * @brief Evict stale bindings at most once a minute.
+     */
+    void maybe_expire(uint32_t now) {
+        if (now - last_expiry < 60) return;
+        last_expiry = now;
+        bindings.expire(now);
+    }
+
+    /**
+     * @brief Log the initial default router state.
+     */
+    void log_initial_state() {
+        std::string current = current_router();
+        if (current.empty()) {
+            Logger::log("No IPv6 default router (yet)", Logger::LogType::INFO, LogPrefixes::ndp_monitor);
+            return;
+        }
+        const NeighborBinding* binding = bindings.find(router_key);
+        Logger::log("IPv6 default router " + format_scoped(router_key) + " : " +
+                    (binding ? NetAddr::formatMac(binding->mac) : std::string("(unresolved)")),
+                    Logger::LogType::INFO, LogPrefixes::ndp_monitor);
+    }
+
+    /**
+     * @brief Event-driven loop fed by rtnetlink neighbour and route notifications.
+     * @return False if netlink is unavailable.
+     */
+    bool netlink_loop() {
+        NetlinkSocket nl;
+        if (!nl.open(RTMGRP_NEIGH | RTMGRP_IPV6_ROUTE | RTMGRP_IPV6_IFADDR) || wakeup.fd() < 0) return false;
+
+        bool route_changed = false;
+        bool addresses_changed = false;
+        bool report = false;
+        uint32_t now = unix_now();
+        auto handler = [&](const nlmsghdr& msg) {
+            Neigh6Entry entry;
+            if (parse_neigh(msg, entry)) {
+                if (entry.router) mark_router(entry.addr, now);
+                if (entry.resolved) observe_binding(entry.addr, entry.mac, now, report, Source::KERNEL);
+            } else if (DefaultGateway::isIpv6DefaultRouteMessage(msg)) {
+                route_changed = true;
+            } else if (msg.nlmsg_type == RTM_NEWADDR || msg.nlmsg_type == RTM_DELADDR) {
+                addresses_changed = true;
+            }
+        };
+
+        // Messages captured meanwhile wait in their queues until the table is loaded
+        if (!nl.dump(RTM_GETNEIGH, AF_INET6, handler)) return false;
+        connected.refresh();
+        report = true;
+        last_expiry = now;
+        log_initial_state();
+        seed_trusted_router();
+        Logger::log("Listening for IPv6 neighbour table changes (netlink)",
+                    Logger::LogType::INFO, LogPrefixes::ndp_monitor);
+
+        pollfd fds[3] = {{nl.fd(), POLLIN, 0}, {wakeup.fd(), POLLIN, 0}, {captured_ready.fd(), POLLIN, 0}};
+        while (running.load()) {
+            if (::poll(fds, 3, -1) < 0) {
+                if (errno == EINTR) continue;
+                Logger::log("poll() failed on netlink socket: " + std::string(std::strerror(errno)),
+                            Logger::LogType::ERROR, LogPrefixes::ndp_monitor);
+                break;
+            }
+            if (fds[1].revents & POLLIN) wakeup.drain();
+            if (!running.load()) break;
+            if (fds[2].revents & POLLIN) drain_captured();
+            if (!(fds[0].revents & POLLIN)) continue;
+
+            route_changed = false;
+            addresses_changed = false;
+            now = unix_now();
+
+            NetlinkSocket::RecvStatus status = nl.receive(handler);
+            if (status == NetlinkSocket::RecvStatus::OVERRUN) {
+                // Notifications were dropped: resynchronize from a full dump
+                Logger::log("Netlink receive buffer overrun, resynchronizing IPv6 neighbour table",
+                            Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+                nl.dump(RTM_GETNEIGH, AF_INET6, handler);
+                route_changed = true;
+                addresses_changed = true;
+            } else if (status == NetlinkSocket::RecvStatus::ERROR) {
+                Logger::log("Netlink socket error, continuing with passive capture only",
+                            Logger::LogType::ERROR, LogPrefixes::ndp_monitor);
+                return false;
+            }
+
+            if (addresses_changed) connected.refresh();
+            maybe_expire(now);
+            if (route_changed && refresh_router()) log_initial_state();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Degraded loop when netlink is unavailable: captured NDP only, expired once a minute.
+     */
+    void capture_loop() {
+        pollfd fds[2] = {{wakeup.fd(), POLLIN, 0}, {captured_ready.fd(), POLLIN, 0}};
+        connected.refresh();
+        while (running.load()) {
+            int ready = ::poll(fds, 2, 60 * 1000);
+            if (ready < 0 && errno != EINTR) break;
+            if (fds[0].revents & POLLIN) wakeup.drain();
+            if (fds[1].revents & POLLIN) drain_captured();
+            uint32_t now = unix_now();
+            // No address notifications without netlink: re-read them with every expiry pass
+            if (now - last_expiry >= 60) connected.refresh();
+            maybe_expire(now);
+        }
+    }
+
+    /**
+     * @brief Monitor loop: netlink events and the messages decoded by the capture workers.
+     */
+    void monitor_loop() {
+        if (netlink_loop()) return;
+        if (!running.load()) return;
+
+        if (!capture_attached) {
+            Logger::log("ERROR: Neither netlink nor packet capture is available. Exiting.",
+                        Logger::LogType::ERROR, LogPrefixes::ndp_monitor);
+            return;
+        }
+        Logger::log("Netlink unavailable, monitoring captured NS/NA only",
+                    Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        capture_loop();
+    }
+};
+
+// ---------- Public Interface ----------
+
+NdpMonitor::NdpMonitor() {
+    pimpl = std::make_unique<Impl>();
+    pimpl->refresh_router(false);
+}
+
+NdpMonitor::~NdpMonitor() {
+    stop();
+    pimpl.reset();
+}
+
+void NdpMonitor::start() {
+    Logger::log("NDP monitor enabled", Logger::LogType::DEFAULT, LogPrefixes::ndp_monitor);
+
+    if (!pimpl) return;
+
+    bool expected = false;
+    if (!pimpl->running.compare_exchange_strong(expected, true)) {
+        Logger::log("Monitor already running.", Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        return;
+    }
+
+    pimpl->monitor_loop();
+}
+
+void NdpMonitor::stop() {
+    if (stopped_) return;
+    stopped_ = true;
+
+    if (!pimpl) return;
+
+    bool expected = true;
+    if (pimpl->running.compare_exchange_strong(expected, false)) {
+        pimpl->wakeup.notify();
+        std::this_thread::sleep_for(100ms);
+    }
+
+    Logger::log("NDP monitor stopped", Logger::LogType::DEFAULT, LogPrefixes::ndp_monitor);
+}
+
+void NdpMonitor::setNotificationCallback(NotificationCallback cb) {
+    if (!pimpl) return;
+    std::lock_guard<std::mutex> lock(pimpl->mtx);
+    pimpl->notify_cb = std::move(cb);
+}
+
+void NdpMonitor::attachCapture(capture::CaptureEngine& engine) {
+    if (!pimpl) return;
+    Impl* impl = pimpl.get();
+    if (impl->captured_ready.fd() < 0) {
+        Logger::log("eventfd unavailable, not capturing NDP messages", Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        return;
+    }
+    impl->capture_attached = true;
+    unsigned workers = engine.workerCount() > 0 ? engine.workerCount() : 1;
+    impl->captured.clear();
+    for (unsigned i = 0; i < workers; ++i) impl->captured.push_back(std::make_unique<CaptureQueues>());
+
+    engine.subscribe(capture::Interest::NDP, [impl](const capture::PacketView* views, std::size_t count) {
+        // A batch comes from a single worker, the only producer of its queues
+        CaptureQueues& queues = *impl->captured[views[0].worker % impl->captured.size()];
+        bool queued = false;
+        for (std::size_t i = 0; i < count; ++i) {
+            const capture::PacketFrame& frame = views[i].frame;
+            if (views[i].l4[0] == ICMPV6_ROUTER_ADVERTISEMENT) {
+                capture::RaPacket* ra = queues.adverts.acquire();
+                if (!ra) {
+                    impl->captured_drops.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (!capture::parseRaFrame(frame, *ra) || ra->outgoing) continue;
+                queues.adverts.commit();
+            } else {
+                capture::NdpPacket* ndp = queues.neighbours.acquire();
+                if (!ndp) {
+                    impl->captured_drops.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (!capture::parseNdpFrame(frame, *ndp) || ndp->outgoing || ndp->isDadProbe()) continue;
+                queues.neighbours.commit();
+            }
+            queued = true;
+        }
+        if (queued) impl->captured_ready.notify();
+    });
+}
+
+void NdpMonitor::setTrustedRouters(const std::vector<std::string>& routers) {
+    if (!pimpl) return;
+    for (const std::string& entry : routers) {
+        Ipv6Addr addr;
+        uint64_t mac = 0;
+        if (NetAddr::parseIpv6(entry, addr)) {
+            pimpl->ra_tracker.trustAddress(addr);
+        } else if (NetAddr::parseMac(entry, mac)) {
+            pimpl->ra_tracker.trustMac(mac);
+        } else {
+            Logger::log("Ignoring invalid trusted router '" + entry + "' (expected an IPv6 address or MAC)",
+                        Logger::LogType::WARNING, LogPrefixes::ndp_monitor);
+        }
+    }
+}
+
+std::string NdpMonitor::router_ip() const {
+    return pimpl ? pimpl->current_router() : std::string{};
+}
+
+} // namespace monitors
@@ -0,0 +1,89 @@
+/**
+ * @file OutboundFlowRing.cpp
+ * @brief Remembers the IPv4 flows this host recently sent.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/OutboundFlowRing.hpp"
+
+#include <cstring>
+#include <netinet/in.h>
+
+namespace monitors {
+
+namespace {
+
+uint16_t load_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+/// ICMP echo request and reply types
+constexpr uint8_t ICMP_ECHO_REPLY = 0;
+constexpr uint8_t ICMP_ECHO_REQUEST = 8;
+
+} // namespace
+
+bool parseIpv4Flow(const uint8_t* ip, std::size_t len, Ipv4Flow& flow) noexcept {
+    if (!ip || len < 20 || (ip[0] >> 4) != 4) return false;
+    std::size_t ihl = static_cast<std::size_t>(ip[0] & 0x0f) * 4;
+    if (ihl < 20 || len < ihl) return false;
+    if ((load_be16(ip + 6) & 0x1fff) != 0) return false;  // Non-first fragment: no transport header
+
+    flow.proto = ip[9];
+    std::memcpy(&flow.src, ip + 12, 4);
+    std::memcpy(&flow.dst, ip + 16, 4);
+    flow.ports = 0;
+
+    const uint8_t* l4 = ip + ihl;
+    std::size_t l4Len = len - ihl;
+    if (flow.proto == IPPROTO_TCP || flow.proto == IPPROTO_UDP) {
+        if (l4Len < 4) return false;
+        flow.ports = (static_cast<uint32_t>(load_be16(l4)) << 16) | load_be16(l4 + 2);
+    } else if (flow.proto == IPPROTO_ICMP) {
+        if (l4Len < 8) return false;
+        if (l4[0] == ICMP_ECHO_REQUEST || l4[0] == ICMP_ECHO_REPLY) flow.ports = load_be16(l4 + 4);
+    }
+    return true;
+}
+
+OutboundFlowRing::OutboundFlowRing(std::size_t capacity, uint32_t windowSeconds)
+    : m_ring(capacity > 0 ? capacity : 1), m_index(64, capacity > 0 ? capacity : 1),
+      m_window(windowSeconds) {}
+
+void OutboundFlowRing::start(uint32_t now) noexcept {
+    if (m_started) return;
+    m_started = true;
+    m_startedAt = now;
+}
+
+void OutboundFlowRing::record(const Ipv4Flow& flow, uint32_t now) {
+    start(now);
+    if (uint32_t* slot = m_index.find(flow)) {
+        m_ring[*slot].lastSeen = now;
+        return;
+    }
+
+    Entry& entry = m_ring[m_next];
+    if (entry.used) {
+        m_index.erase(entry.flow);
+        m_evictedSeen = entry.lastSeen;
+    }
+    entry.flow = flow;
+    entry.lastSeen = now;
+    entry.used = true;
+    if (uint32_t* slot = m_index.insert(flow).first) *slot = static_cast<uint32_t>(m_next);
+    m_next = (m_next + 1) % m_ring.size();
+}
+
+OutboundFlowRing::Match OutboundFlowRing::lookup(const Ipv4Flow& flow, uint32_t now) {
+    start(now);
+    if (const uint32_t* slot = m_index.find(flow)) {
+        if (now - m_ring[*slot].lastSeen <= m_window) return Match::SENT;
+    }
+    if (now - m_startedAt <= m_window) return Match::UNVERIFIED;
+    if (m_evictedSeen != 0 && now - m_evictedSeen <= m_window) return Match::UNVERIFIED;
+    return Match::UNKNOWN;
+}
+
+} // namespace monitors
@@ -0,0 +1,141 @@
+/**
+ * @file RouterAdvertTracker.cpp
+ * @brief Tracks IPv6 routers and their advertised prefixes to spot rogue RAs.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/RouterAdvertTracker.hpp"
+
+#include <tuple>
+
+namespace monitors {
+
+namespace {
+
+/// Untrusted routers silent for this long are forgotten when the table is full (seconds)
+constexpr uint32_t UNTRUSTED_RETENTION_SECONDS = 3600;
+
+} // namespace
+
+RouterAdvertTracker::RouterAdvertTracker(std::size_t maxRouters)
+    : m_routers(16, maxRouters), m_trustedAddrs(16), m_trustedMacs(16) {}
+
+void RouterAdvertTracker::trustAddress(const Ipv6Addr& addr) {
+    m_trustedAddrs.insert(addr);
+}
+
+void RouterAdvertTracker::trustMac(uint64_t mac) {
+    m_trustedMacs.insert(mac);
+}
+
+void RouterAdvertTracker::trustRouter(const Ipv6Addr& key, uint64_t mac) {
+    if (hasWhitelist()) return;
+    RouterState* state = m_routers.insert(key).first;
+    if (!state) return;
+    state->trusted = true;
+    if (mac != 0) state->mac = mac;
+    m_anyTrusted = true;
+}
+
+bool RouterAdvertTracker::admit(const Ipv6Addr& addr, uint64_t mac) const noexcept {
+    if (!hasWhitelist()) return !m_anyTrusted;
+    bool addrOk = m_trustedAddrs.empty() || m_trustedAddrs.find(addr) != nullptr;
+    bool macOk = m_trustedMacs.empty() || m_trustedMacs.find(mac) != nullptr;
+    return addrOk && macOk;
+}
+
+void RouterAdvertTracker::updatePrefixes(RouterState& state, const capture::RaPacket& ra,
+                                         Findings& findings) noexcept {
+    for (uint8_t i = 0; i < ra.prefixCount; ++i) {
+        const capture::RaPacket::Prefix& p = ra.prefixes[i];
+        int known = -1;
+        for (uint8_t j = 0; j < state.prefixCount; ++j) {
+            if (state.prefixes[j].length == p.length && state.prefixes[j].prefix == p.prefix) {
+                known = j;
+                break;
+            }
+        }
+
+        if (p.validLifetime == 0) {
+            if (known < 0) continue;
+            // Forget it, so a repeated withdrawal is not reported twice
+            findings.killedPrefixes |= static_cast<uint8_t>(1u << i);
+            state.prefixes[known] = state.prefixes[--state.prefixCount];
+            continue;
+        }
+        if (known >= 0) continue;
+
+        findings.newPrefixes |= static_cast<uint8_t>(1u << i);
+        uint8_t slot = state.prefixCount;
+        if (slot < capture::RaPacket::MAX_PREFIXES) {
+            ++state.prefixCount;
+        } else {
+            slot = state.nextSlot;
+            state.nextSlot = static_cast<uint8_t>((slot + 1) % capture::RaPacket::MAX_PREFIXES);
+        }
+        state.prefixes[slot].prefix = p.prefix;
+        state.prefixes[slot].length = p.length;
+    }
+}
+
+RouterAdvertTracker::Findings RouterAdvertTracker::observe(const capture::RaPacket& ra, const Ipv6Addr& key) {
+    Findings findings;
+    uint64_t mac = ra.routerMac();
+
+    auto [state, inserted] = m_routers.insert(key);
+    uint32_t now = ra.tsSec;
+    if (!state && now >= m_nextSweep) {
+        // Full: drop untrusted routers gone quiet, then retry once. Rate-limited,
+        // a flood of invented routers would otherwise scan the table per RA
+        m_nextSweep = now + SWEEP_INTERVAL_SECONDS;
+        m_routers.eraseIf([&](const Ipv6Addr&, const RouterState& s) {
+            return !s.trusted && now - s.lastSeen > UNTRUSTED_RETENTION_SECONDS;
+        });
+        std::tie(state, inserted) = m_routers.insert(key);
+    }
+
+    RouterState scratch;
+    if (!state) {
+        // Still full: judge the RA without remembering the router
+        state = &scratch;
+        inserted = true;
+        findings.overflow = true;
+    }
+
+    if (inserted) {
+        bool trusted = admit(ra.source, mac);
+        state->trusted = trusted;
+        state->mac = mac;
+        state->lifetime = ra.routerLifetime;
+        state->lastSeen = ra.tsSec;
+        if (trusted && !hasWhitelist()) {
+            findings.learned = true;
+            m_anyTrusted = true;
+        }
+        findings.untrusted = !trusted;
+        // Baseline: the first RA's prefixes are the router's, not a change
+        Findings baseline;
+        updatePrefixes(*state, ra, baseline);
+        return findings;
+    }
+
+    state->lastSeen = ra.tsSec;
+    if (!state->trusted) return findings;
+
+    if (state->mac == 0) state->mac = mac;
+    if (mac != state->mac) {
+        // Someone else speaking for a trusted router: do not learn from it
+        findings.spoofed = true;
+        findings.expectedMac = state->mac;
+        findings.withdrawn = ra.routerLifetime == 0;
+        return findings;
+    }
+
+    findings.withdrawn = ra.routerLifetime == 0 && state->lifetime != 0;
+    state->lifetime = ra.routerLifetime;
+    updatePrefixes(*state, ra, findings);
+    return findings;
+}
+
+} // namespace monitors
@@ -0,0 +1,57 @@
+/**
+ * @file ScanDetector.cpp
+ * @brief Flags sources that contact many distinct destinations (sweeps and scans).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "monitors/ScanDetector.hpp"
+
+#include <cmath>
+
+namespace monitors {
+
+ScanDetector::ScanDetector(uint32_t threshold, uint32_t windowSeconds, std::size_t maxSources)
+    : m_sources(maxSources), m_threshold(threshold > 0 ? threshold : 1),
+      m_window(windowSeconds > 0 ? windowSeconds : 1) {}
+
+void ScanDetector::rotate(SourceState& state, uint32_t now) const noexcept {
+    uint32_t elapsed = now - state.windowStart;
+    if (elapsed < m_window) return;
+
+    if (elapsed < 2 * m_window) {
+        state.previous = state.current;
+        state.windowStart += m_window;
+    } else {
+        // Idle for more than a window: nothing recent to carry over
+        state.previous.clear();
+        state.windowStart = now;
+    }
+    state.current.clear();
+
+    HyperLogLog<PRECISION> window = state.current;
+    window.merge(state.previous);
+    state.distinct = static_cast<uint32_t>(std::lround(window.estimate()));
+}
+
+bool ScanDetector::observe(uint64_t source, uint64_t destination, uint32_t now, uint32_t& distinct) {
+    auto [state, inserted] = m_sources.touch(source);
+    if (inserted) state->windowStart = now;
+    else rotate(*state, now);
+
+    if (state->current.add(hashMix64(destination))) {
+        HyperLogLog<PRECISION> window = state->current;
+        window.merge(state->previous);
+        state->distinct = static_cast<uint32_t>(std::lround(window.estimate()));
+    }
+
+    distinct = state->distinct;
+    if (state->distinct < m_threshold) return false;
+    // The estimate covers up to two windows: do not report the same probes twice
+    if (state->reported && now - state->reportedAt < 2 * m_window) return false;
+    state->reported = true;
+    state->reportedAt = now;
+    return true;
+}
+
+} // namespace monitors
@@ -0,0 +1,68 @@
+/**
+ * @file ConnectedNetworks.cpp
+ * @brief Prefixes assigned to the local interfaces, read with getifaddrs().
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/ConnectedNetworks.hpp"
+
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+
+bool ConnectedNetworks::refresh() {
+    ifaddrs* list = nullptr;
+    if (::getifaddrs(&list) != 0) return false;
+
+    std::vector<Ipv4Prefix> ipv4;
+    std::vector<Ipv6Prefix> ipv6;
+    for (const ifaddrs* ifa = list; ifa; ifa = ifa->ifa_next) {
+        if (!ifa->ifa_addr || !ifa->ifa_netmask || !ifa->ifa_name) continue;
+        int ifindex = static_cast<int>(::if_nametoindex(ifa->ifa_name));
+        if (ifindex <= 0) continue;
+
+        if (ifa->ifa_addr->sa_family == AF_INET) {
+            Ipv4Prefix prefix;
+            prefix.ifindex = ifindex;
+            prefix.mask = reinterpret_cast<const sockaddr_in*>(ifa->ifa_netmask)->sin_addr.s_addr;
+            prefix.network = reinterpret_cast<const sockaddr_in*>(ifa->ifa_addr)->sin_addr.s_addr & prefix.mask;
+            ipv4.push_back(prefix);
+        } else if (ifa->ifa_addr->sa_family == AF_INET6) {
+            Ipv6Prefix prefix;
+            prefix.ifindex = ifindex;
+            prefix.mask = NetAddr::packIpv6(
+                reinterpret_cast<const sockaddr_in6*>(ifa->ifa_netmask)->sin6_addr.s6_addr);
+            Ipv6Addr addr = NetAddr::packIpv6(reinterpret_cast<const sockaddr_in6*>(ifa->ifa_addr)->sin6_addr.s6_addr);
+            if (addr.isLinkLocal()) continue;
+            prefix.network.hi = addr.hi & prefix.mask.hi;
+            prefix.network.lo = addr.lo & prefix.mask.lo;
+            ipv6.push_back(prefix);
+        }
+    }
+    ::freeifaddrs(list);
+
+    m_ipv4.swap(ipv4);
+    m_ipv6.swap(ipv6);
+    m_loaded = true;
+    return true;
+}
+
+bool ConnectedNetworks::containsIpv4(int ifindex, uint32_t ip) const noexcept {
+    for (const Ipv4Prefix& prefix : m_ipv4) {
+        if (ifindex != 0 && prefix.ifindex != ifindex) continue;
+        if ((ip & prefix.mask) == prefix.network) return true;
+    }
+    return false;
+}
+
+bool ConnectedNetworks::containsIpv6(int ifindex, const Ipv6Addr& addr) const noexcept {
+    if (addr.isLinkLocal()) return true;
+    for (const Ipv6Prefix& prefix : m_ipv6) {
+        if (ifindex != 0 && prefix.ifindex != ifindex) continue;
+        if ((addr.hi & prefix.mask.hi) == prefix.network.hi && (addr.lo & prefix.mask.lo) == prefix.network.lo) {
+            return true;
+        }
+    }
+    return false;
+}
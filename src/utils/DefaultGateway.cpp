@@ -0,0 +1,214 @@
+/**
+ * @file DefaultGateway.cpp
+ * @brief In-process default gateway discovery (rtnetlink, /proc/net/route, /proc/net/ipv6_route).
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/DefaultGateway.hpp"
+#include "utils/Netlink.hpp"
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <net/if.h>
+#include <net/route.h>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Check the fixed part of a route message for a main-table default route.
+ */
+const rtmsg* default_route_header(const nlmsghdr& msg, uint8_t family = AF_INET) noexcept {
+    if (msg.nlmsg_type != RTM_NEWROUTE && msg.nlmsg_type != RTM_DELROUTE) return nullptr;
+    if (msg.nlmsg_len < NLMSG_LENGTH(sizeof(rtmsg))) return nullptr;
+
+    const auto* rtm = static_cast<const rtmsg*>(NLMSG_DATA(&msg));
+    if (rtm->rtm_family != family || rtm->rtm_dst_len != 0) return nullptr;
+    if (rtm->rtm_table != RT_TABLE_MAIN || rtm->rtm_type != RTN_UNICAST) return nullptr;
+    return rtm;
+}
+
+std::string format_ipv4(const void* addr) {
+    char buf[INET_ADDRSTRLEN] = {0};
+    if (!inet_ntop(AF_INET, addr, buf, sizeof(buf))) return {};
+    return buf;
+}
+
+std::string format_ipv6(const void* addr) {
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (!inet_ntop(AF_INET6, addr, buf, sizeof(buf))) return {};
+    return buf;
+}
+
+/**
+ * @brief Decode 32 hex digits of /proc/net/ipv6_route (address bytes in order).
+ */
+bool parse_hex_ipv6(const std::string& hex, in6_addr& addr) noexcept {
+    if (hex.size() != 32) return false;
+    for (std::size_t i = 0; i < 16; ++i) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        char* end = nullptr;
+        unsigned long v = std::strtoul(byte, &end, 16);
+        if (end != byte + 2) return false;
+        addr.s6_addr[i] = static_cast<uint8_t>(v);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string DefaultGateway::detect() {
+    std::string gw = fromNetlink();
+    if (gw.empty()) gw = fromProcRoute();
+    return gw;
+}
+
+std::string DefaultGateway::fromNetlink() {
+    NetlinkSocket nl;
+    if (!nl.open(0)) return {};
+
+    std::string best;
+    uint32_t bestMetric = std::numeric_limits<uint32_t>::max();
+
+    bool ok = nl.dump(RTM_GETROUTE, AF_INET, [&](const nlmsghdr& msg) {
+        if (msg.nlmsg_type != RTM_NEWROUTE) return;
+        const rtmsg* rtm = default_route_header(msg);
+        if (!rtm) return;
+
+        const rtattr* attrs[RTA_MAX + 1];
+        NetlinkSocket::parseAttributes(RTM_RTA(rtm), static_cast<int>(RTM_PAYLOAD(&msg)), attrs, RTA_MAX);
+
+        const rtattr* gateway = attrs[RTA_GATEWAY];
+        if (!gateway || RTA_PAYLOAD(gateway) != sizeof(in_addr)) return;
+
+        uint32_t metric = 0;
+        if (attrs[RTA_PRIORITY] && RTA_PAYLOAD(attrs[RTA_PRIORITY]) == sizeof(uint32_t)) {
+            std::memcpy(&metric, RTA_DATA(attrs[RTA_PRIORITY]), sizeof(metric));
+        }
+        if (best.empty() || metric < bestMetric) {
+            best = format_ipv4(RTA_DATA(gateway));
+            bestMetric = metric;
+        }
+    });
+    return ok ? best : std::string{};
+}
+
+std::string DefaultGateway::fromProcRoute(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) return {};
+
+    std::string best;
+    unsigned long bestMetric = std::numeric_limits<unsigned long>::max();
+
+    std::string line;
+    std::getline(ifs, line); // skip header
+    while (std::getline(ifs, line)) {
+        // Iface Destination Gateway Flags RefCnt Use Metric Mask ...
+        std::istringstream iss(line);
+        std::string iface, dest, gw, flags, refcnt, use, metric, mask;
+        if (!(iss >> iface >> dest >> gw >> flags >> refcnt >> use >> metric >> mask)) continue;
+
+        unsigned long flagBits = std::strtoul(flags.c_str(), nullptr, 16);
+        if (dest != "00000000" || mask != "00000000") continue;
+        if (!(flagBits & RTF_UP) || !(flagBits & RTF_GATEWAY)) continue;
+
+        // Addresses are the raw network-order words printed in host order
+        in_addr addr{};
+        addr.s_addr = static_cast<in_addr_t>(std::strtoul(gw.c_str(), nullptr, 16));
+        unsigned long m = std::strtoul(metric.c_str(), nullptr, 10);
+        if (best.empty() || m < bestMetric) {
+            best = format_ipv4(&addr);
+            bestMetric = m;
+        }
+    }
+    return best;
+}
+
+bool DefaultGateway::isDefaultRouteMessage(const nlmsghdr& msg) noexcept {
+    return default_route_header(msg) != nullptr;
+}
+
+std::string DefaultGateway::detectIpv6(int* ifindex) {
+    std::string gw = fromNetlinkIpv6(ifindex);
+    if (gw.empty()) gw = fromProcIpv6Route("/proc/net/ipv6_route", ifindex);
+    return gw;
+}
+
+std::string DefaultGateway::fromNetlinkIpv6(int* ifindex) {
+    NetlinkSocket nl;
+    if (!nl.open(0)) return {};
+
+    std::string best;
+    uint32_t bestMetric = std::numeric_limits<uint32_t>::max();
+    int bestIfindex = 0;
+
+    bool ok = nl.dump(RTM_GETROUTE, AF_INET6, [&](const nlmsghdr& msg) {
+        if (msg.nlmsg_type != RTM_NEWROUTE) return;
+        const rtmsg* rtm = default_route_header(msg, AF_INET6);
+        if (!rtm) return;
+
+        const rtattr* attrs[RTA_MAX + 1];
+        NetlinkSocket::parseAttributes(RTM_RTA(rtm), static_cast<int>(RTM_PAYLOAD(&msg)), attrs, RTA_MAX);
+
+        const rtattr* gateway = attrs[RTA_GATEWAY];
+        if (!gateway || RTA_PAYLOAD(gateway) != sizeof(in6_addr)) return;
+
+        uint32_t metric = 0;
+        if (attrs[RTA_PRIORITY] && RTA_PAYLOAD(attrs[RTA_PRIORITY]) == sizeof(uint32_t)) {
+            std::memcpy(&metric, RTA_DATA(attrs[RTA_PRIORITY]), sizeof(metric));
+        }
+        if (best.empty() || metric < bestMetric) {
+            best = format_ipv6(RTA_DATA(gateway));
+            bestMetric = metric;
+            bestIfindex = 0;
+            if (attrs[RTA_OIF] && RTA_PAYLOAD(attrs[RTA_OIF]) == sizeof(int)) {
+                std::memcpy(&bestIfindex, RTA_DATA(attrs[RTA_OIF]), sizeof(int));
+            }
+        }
+    });
+    if (!ok) return {};
+    if (ifindex) *ifindex = bestIfindex;
+    return best;
+}
+
+std::string DefaultGateway::fromProcIpv6Route(const std::string& path, int* ifindex) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) return {};
+
+    std::string best;
+    unsigned long bestMetric = std::numeric_limits<unsigned long>::max();
+    std::string bestIface;
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        // Dest DestLen Src SrcLen NextHop Metric RefCnt Use Flags Iface (no header)
+        std::istringstream iss(line);
+        std::string dest, destLen, src, srcLen, nextHop, metric, refcnt, use, flags, iface;
+        if (!(iss >> dest >> destLen >> src >> srcLen >> nextHop >> metric >> refcnt >> use >> flags >> iface)) {
+            continue;
+        }
+
+        unsigned long flagBits = std::strtoul(flags.c_str(), nullptr, 16);
+        if (destLen != "00" || dest != std::string(32, '0')) continue;
+        if (!(flagBits & RTF_UP) || !(flagBits & RTF_GATEWAY)) continue;
+
+        in6_addr addr{};
+        if (!parse_hex_ipv6(nextHop, addr)) continue;
+        unsigned long m = std::strtoul(metric.c_str(), nullptr, 16);
+        if (best.empty() || m < bestMetric) {
+            best = format_ipv6(&addr);
+            bestMetric = m;
+            bestIface = iface;
+        }
+    }
+    if (ifindex && !best.empty()) *ifindex = static_cast<int>(if_nametoindex(bestIface.c_str()));
+    return best;
+}
+
+bool DefaultGateway::isIpv6DefaultRouteMessage(const nlmsghdr& msg) noexcept {
+    return default_route_header(msg, AF_INET6) != nullptr;
+}
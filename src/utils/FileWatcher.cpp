@@ -0,0 +1,123 @@
+/**
+ * @file FileWatcher.cpp
+ * @brief Minimal inotify wrapper reporting changes to a set of files.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/FileWatcher.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// Creations, deletions, renames and completed writes, plus the directory itself going away
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+void split_path(const std::string& path, std::string& dir, std::string& name) {
+    std::size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        dir = ".";
+        name = path;
+    } else {
+        dir = slash == 0 ? "/" : path.substr(0, slash);
+        name = path.substr(slash + 1);
+    }
+}
+
+} // namespace
+
+FileWatcher::~FileWatcher() {
+    close();
+}
+
+bool FileWatcher::open() {
+    close();
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    return m_fd >= 0;
+}
+
+void FileWatcher::close() noexcept {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+    m_names.clear();
+}
+
+std::size_t FileWatcher::watch(const std::vector<std::string>& paths) {
+    if (m_fd < 0) return 0;
+
+    // Adding a directory already watched returns its descriptor, so unchanged
+    // watches survive; only the ones no longer needed are removed below
+    auto previous = std::move(m_names);
+    m_names.clear();
+    for (const std::string& path : paths) {
+        std::string dir, name;
+        split_path(path, dir, name);
+        watchEntry(dir, name);
+
+        struct stat st{};
+        char target[PATH_MAX];
+        if (::lstat(path.c_str(), &st) == 0 && S_ISLNK(st.st_mode) && ::realpath(path.c_str(), target)) {
+            split_path(target, dir, name);
+            watchEntry(dir, name);
+        }
+    }
+    for (const auto& entry : previous) {
+        if (m_names.find(entry.first) == m_names.end()) inotify_rm_watch(m_fd, entry.first);
+    }
+    return m_names.size();
+}
+
+void FileWatcher::watchEntry(std::string dir, std::string name) {
+    while (!name.empty()) {
+        int wd = inotify_add_watch(m_fd, dir.c_str(), WATCH_MASK);
+        if (wd >= 0) {
+            m_names[wd].insert(name);
+            return;
+        }
+        if ((errno != ENOENT && errno != ENOTDIR) || dir == "/" || dir == ".") return;
+        // Missing directory: wait for it to appear in its parent
+        std::string parent;
+        split_path(dir, parent, name);
+        dir = parent;
+    }
+}
+
+FileWatcher::Status FileWatcher::receive() {
+    if (m_fd < 0) return Status::ERROR;
+
+    Status status = Status::UNCHANGED;
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t len = ::read(m_fd, buffer, sizeof(buffer));
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return status;
+            return Status::ERROR;
+        }
+        if (len == 0) return status;
+
+        for (ssize_t offset = 0; offset < len;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                status = Status::CHANGED;
+                continue;
+            }
+            auto it = m_names.find(event->wd);
+            if (it == m_names.end()) continue;  // Watch removed by watch()
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                status = Status::CHANGED;
+            } else if (event->len > 0 && it->second.count(event->name)) {
+                status = Status::CHANGED;
+            }
+        }
+    }
+}
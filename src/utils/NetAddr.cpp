@@ -0,0 +1,89 @@
+/**
+ * @file NetAddr.cpp
+ * @brief Packed IPv4 / IPv6 / MAC address helpers shared by the monitors.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/NetAddr.hpp"
+
+#include <arpa/inet.h>
+#include <cctype>
+#include <cstdio>
+
+std::string NetAddr::formatMac(uint64_t mac) {
+    uint8_t b[6];
+    unpackMac(mac, b);
+    char buf[18];
+    std::snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x",
+                  b[0], b[1], b[2], b[3], b[4], b[5]);
+    return buf;
+}
+
+bool NetAddr::parseMac(const std::string& text, uint64_t& mac) noexcept {
+    uint64_t value = 0;
+    int digits = 0;
+    int groups = 0;
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isxdigit(uc)) {
+            if (++digits > 2) return false;
+            int nibble = std::isdigit(uc) ? uc - '0' : std::tolower(uc) - 'a' + 10;
+            value = (value << 4) | static_cast<uint64_t>(nibble);
+        } else if (c == ':' || c == '-') {
+            if (digits == 0) return false;
+            if (digits == 1) value = (value & ~0xfULL) << 4 | (value & 0xf);
+            digits = 0;
+            ++groups;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0 || groups != 5) return false;
+    if (digits == 1) value = (value & ~0xfULL) << 4 | (value & 0xf);
+    mac = value;
+    return true;
+}
+
+std::string NetAddr::formatIpv4(uint32_t ip) {
+    char buf[INET_ADDRSTRLEN] = {0};
+    in_addr addr{};
+    addr.s_addr = ip;
+    inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+    return buf;
+}
+
+bool NetAddr::parseIpv4(const std::string& text, uint32_t& ip) noexcept {
+    in_addr addr{};
+    if (inet_pton(AF_INET, text.c_str(), &addr) != 1) return false;
+    ip = addr.s_addr;
+    return true;
+}
+
+std::string NetAddr::formatIpv6(const Ipv6Addr& addr) {
+    char buf[INET6_ADDRSTRLEN] = {0};
+    in6_addr raw{};
+    unpackIpv6(addr, raw.s6_addr);
+    inet_ntop(AF_INET6, &raw, buf, sizeof(buf));
+    return buf;
+}
+
+bool NetAddr::parseIpv6(const std::string& text, Ipv6Addr& addr) noexcept {
+    in6_addr raw{};
+    if (inet_pton(AF_INET6, text.c_str(), &raw) != 1) return false;
+    addr = packIpv6(raw.s6_addr);
+    return true;
+}
+
+std::string NetAddr::formatIp(const Ipv6Addr& addr) {
+    return isMappedIpv4(addr) ? formatIpv4(unmapIpv4(addr)) : formatIpv6(addr);
+}
+
+bool NetAddr::parseIp(const std::string& text, Ipv6Addr& addr) noexcept {
+    uint32_t ip = 0;
+    if (parseIpv4(text, ip)) {
+        addr = mapIpv4(ip);
+        return true;
+    }
+    return parseIpv6(text, addr);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file Netlink.cpp
+ * @brief Minimal rtnetlink socket wrapper for event-driven kernel table monitoring.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/Netlink.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+NetlinkSocket::~NetlinkSocket() {
+    close();
+}
+
+bool NetlinkSocket::open(uint32_t groups) {
+    close();
+
+    m_fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (m_fd < 0) return false;
+
+    // A larger receive buffer makes ENOBUFS overruns rare during ARP storms
+    int rcvbuf = 1 << 20;
+    setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = groups;
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void NetlinkSocket::close() noexcept {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool NetlinkSocket::dump(uint16_t type, uint8_t family, const MessageHandler& handler, int timeoutMs) {
+    if (m_fd < 0) return false;
+
+    struct {
+        nlmsghdr hdr;
+        rtgenmsg gen;
+    } req{};
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+    req.hdr.nlmsg_type = type;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.hdr.nlmsg_seq = ++m_seq;
+    req.gen.rtgen_family = family;
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    if (::sendto(m_fd, &req, req.hdr.nlmsg_len, 0,
+                 reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        ReadResult r = readOnce(handler, req.hdr.nlmsg_seq);
+        if (r == ReadResult::DONE) return true;
+        if (r == ReadResult::ERROR || r == ReadResult::OVERRUN) return false;
+        if (r == ReadResult::MESSAGES) continue;
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+
+        pollfd pfd{m_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(remaining)) < 0 && errno != EINTR) return false;
+    }
+}
+
+NetlinkSocket::RecvStatus NetlinkSocket::receive(const MessageHandler& handler) {
+    if (m_fd < 0) return RecvStatus::ERROR;
+
+    while (true) {
+        ReadResult r = readOnce(handler, 0);
+        switch (r) {
+            case ReadResult::MESSAGES:
+            case ReadResult::DONE:    continue;
+            case ReadResult::EMPTY:   return RecvStatus::OK;
+            case ReadResult::OVERRUN: return RecvStatus::OVERRUN;
+            case ReadResult::ERROR:   return RecvStatus::ERROR;
+        }
+    }
+}
+
+NetlinkSocket::ReadResult NetlinkSocket::readOnce(const MessageHandler& handler, uint32_t dumpSeq) {
+    ssize_t len = ::recv(m_fd, m_buffer, sizeof(m_buffer), 0);
+    if (len < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return ReadResult::EMPTY;
+        if (errno == ENOBUFS) return ReadResult::OVERRUN;
+        return ReadResult::ERROR;
+    }
+    if (len == 0) return ReadResult::ERROR;
+
+    bool done = false;
+    int remaining = static_cast<int>(len);
+    for (auto* hdr = reinterpret_cast<const nlmsghdr*>(m_buffer); NLMSG_OK(hdr, remaining);
+         hdr = NLMSG_NEXT(hdr, remaining)) {
+        bool partOfDump = dumpSeq != 0 && hdr->nlmsg_seq == dumpSeq;
+        if (hdr->nlmsg_type == NLMSG_DONE) {
+            if (partOfDump) done = true;
+            continue;
+        }
+        if (hdr->nlmsg_type == NLMSG_ERROR) {
+            if (partOfDump) return ReadResult::ERROR;
+            continue;
+        }
+        if (hdr->nlmsg_type == NLMSG_NOOP) continue;
+        if (handler) handler(*hdr);
+    }
+    return done ? ReadResult::DONE : ReadResult::MESSAGES;
+}
+
+void NetlinkSocket::parseAttributes(const rtattr* rta, int len, const rtattr** table, int max) noexcept {
+    std::memset(table, 0, sizeof(*table) * static_cast<std::size_t>(max + 1));
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type <= max) table[rta->rta_type] = rta;
+    }
+}
@@ -0,0 +1,202 @@
+/**
+ * @file PrefixTrie.cpp
+ * @brief Path-compressed binary trie answering longest-prefix-match queries.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/PrefixTrie.hpp"
+
+namespace {
+
+static_assert(sizeof(PrefixTrie::Node) == 32, "two nodes per cache line");
+
+constexpr uint32_t NODE_MASK = PrefixTrie::MAX_NODES;
+constexpr unsigned BEST_SHIFT = 24;
+
+/// Number of leading bits a and b share
+unsigned common_bits(const Ipv6Addr& a, const Ipv6Addr& b) noexcept {
+    uint64_t diff = a.hi ^ b.hi;
+    if (diff) return static_cast<unsigned>(__builtin_clzll(diff));
+    diff = a.lo ^ b.lo;
+    return diff ? 64 + static_cast<unsigned>(__builtin_clzll(diff)) : 128;
+}
+
+/// Bit i of key, 0 being the most significant bit of hi
+unsigned bit_at(const Ipv6Addr& key, unsigned i) noexcept {
+    return i < 64 ? static_cast<unsigned>(key.hi >> (63 - i)) & 1 : static_cast<unsigned>(key.lo >> (127 - i)) & 1;
+}
+
+/// key with every bit from len on cleared
+Ipv6Addr masked(const Ipv6Addr& key, unsigned len) noexcept {
+    Ipv6Addr out;
+    if (len == 0) return out;
+    if (len <= 64) {
+        out.hi = key.hi & (~0ull << (64 - len));
+    } else {
+        out.hi = key.hi;
+        out.lo = key.lo & (~0ull << (128 - len));
+    }
+    return out;
+}
+
+PrefixTrie::Node make_node(const Ipv6Addr& key, unsigned len, bool terminal) noexcept {
+    PrefixTrie::Node node{};
+    node.prefix = masked(key, len);
+    node.len = static_cast<uint8_t>(len);
+    node.terminal = terminal ? 1 : 0;
+    return node;
+}
+
+/// Jump table size for a prefix count: about two entries per prefix
+unsigned stride_for(std::size_t prefixes) noexcept {
+    unsigned stride = 1;
+    while (stride < PrefixTrie::MAX_STRIDE && (std::size_t{1} << stride) < prefixes * 2) ++stride;
+    return stride;
+}
+
+} // namespace
+
+bool PrefixTrie::insert(const Ipv6Addr& prefix, unsigned len) {
+    if (len > 128) return false;
+    if (m_ownedNodes.empty()) {
+        clear();
+        m_ownedNodes.push_back(make_node(prefix, 0, false));
+    }
+    // Lookups wait for finalize()
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+    m_jump = nullptr;
+
+    const Ipv6Addr key = masked(prefix, len);
+    std::vector<Node>& nodes = m_ownedNodes;
+    uint32_t index = 0;
+    for (;;) {
+        // Invariant: nodes[index] covers key and is not longer than len
+        if (nodes[index].len == len) {
+            if (!nodes[index].terminal) ++m_prefixCount;
+            nodes[index].terminal = 1;
+            return true;
+        }
+        if (nodes.size() + 2 > MAX_NODES) return false;
+
+        unsigned side = bit_at(key, nodes[index].len);
+        uint32_t child = nodes[index].child[side];
+        if (child == 0) {
+            nodes.push_back(make_node(key, len, true));
+            nodes[index].child[side] = static_cast<uint32_t>(nodes.size() - 1);
+            ++m_prefixCount;
+            return true;
+        }
+
+        unsigned common = common_bits(key, nodes[child].prefix);
+        if (common > len) common = len;
+        if (common >= nodes[child].len) {
+            index = child;
+            continue;
+        }
+
+        // key leaves the child's path at bit common: split with a node of that length
+        Node split = make_node(key, common, common == len);
+        split.child[bit_at(nodes[child].prefix, common)] = child;
+        nodes.push_back(split);
+        auto splitIndex = static_cast<uint32_t>(nodes.size() - 1);
+        if (common < len) {
+            nodes.push_back(make_node(key, len, true));
+            nodes[splitIndex].child[bit_at(key, common)] = static_cast<uint32_t>(nodes.size() - 1);
+        }
+        nodes[index].child[side] = splitIndex;
+        ++m_prefixCount;
+        return true;
+    }
+}
+
+void PrefixTrie::finalize() {
+    if (m_ownedNodes.empty()) {
+        clear();
+        return;
+    }
+
+    const std::vector<Node>& nodes = m_ownedNodes;
+    m_stride = stride_for(m_prefixCount);
+    m_ownedJump.assign(std::size_t{1} << m_stride, 0);
+
+    // Each slot starts at the deepest node of at most stride bits covering it,
+    // with the longest stored prefix above that node
+    for (std::size_t slot = 0; slot < m_ownedJump.size(); ++slot) {
+        Ipv6Addr key;
+        key.hi = static_cast<uint64_t>(slot) << (64 - m_stride);
+        uint32_t index = 0;
+        int best = -1;
+        while (nodes[index].len < m_stride) {
+            uint32_t child = nodes[index].child[bit_at(key, nodes[index].len)];
+            if (child == 0 || nodes[child].len > m_stride || common_bits(key, nodes[child].prefix) < nodes[child].len) break;
+            if (nodes[index].terminal) best = nodes[index].len;
+            index = child;
+        }
+        m_ownedJump[slot] = static_cast<uint32_t>(best + 1) << BEST_SHIFT | index;
+    }
+
+    m_nodes = m_ownedNodes.data();
+    m_nodeCount = m_ownedNodes.size();
+    m_jump = m_ownedJump.data();
+}
+
+bool PrefixTrie::attach(const Node* nodes, std::size_t nodeCount, const uint32_t* jump, unsigned stride) {
+    if (nodeCount == 0) {
+        if (stride != 0) return false;
+        clear();
+        return true;
+    }
+    if (stride == 0 || stride > MAX_STRIDE || nodeCount > MAX_NODES || nodes[0].len != 0) return false;
+
+    // Children are strictly longer than their parent, so every walk ends
+    std::size_t prefixes = 0;
+    for (std::size_t i = 0; i < nodeCount; ++i) {
+        if (nodes[i].len > 128) return false;
+        for (uint32_t child : nodes[i].child) {
+            if (child >= nodeCount || (child != 0 && nodes[child].len <= nodes[i].len)) return false;
+        }
+        prefixes += nodes[i].terminal ? 1 : 0;
+    }
+    for (std::size_t slot = 0; slot < (std::size_t{1} << stride); ++slot) {
+        if ((jump[slot] & NODE_MASK) >= nodeCount || (jump[slot] >> BEST_SHIFT) > 129) return false;
+    }
+
+    clear();
+    m_nodes = nodes;
+    m_nodeCount = nodeCount;
+    m_jump = jump;
+    m_stride = stride;
+    m_prefixCount = prefixes;
+    return true;
+}
+
+void PrefixTrie::clear() noexcept {
+    m_ownedNodes.clear();
+    m_ownedNodes.shrink_to_fit();
+    m_ownedJump.clear();
+    m_ownedJump.shrink_to_fit();
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+    m_jump = nullptr;
+    m_stride = 0;
+    m_prefixCount = 0;
+}
+
+int PrefixTrie::longestMatch(const Ipv6Addr& key) const noexcept {
+    if (!m_jump) return -1;
+
+    uint32_t entry = m_jump[key.hi >> (64 - m_stride)];
+    int best = static_cast<int>(entry >> BEST_SHIFT) - 1;
+    const Node* node = m_nodes + (entry & NODE_MASK);
+    for (;;) {
+        if (common_bits(key, node->prefix) < node->len) break;
+        if (node->terminal) best = node->len;
+        if (node->len == 128) break;
+        uint32_t child = node->child[bit_at(key, node->len)];
+        if (child == 0) break;
+        node = m_nodes + child;
+    }
+    return best;
+}
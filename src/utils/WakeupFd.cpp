@@ -0,0 +1,31 @@
+/**
+ * @file WakeupFd.cpp
+ * @brief eventfd-based wakeup handle used to interrupt blocking poll() loops.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "utils/WakeupFd.hpp"
+
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+WakeupFd::WakeupFd()
+    : m_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+WakeupFd::~WakeupFd() {
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+void WakeupFd::notify() noexcept {
+    if (m_fd < 0) return;
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = ::write(m_fd, &one, sizeof(one));
+}
+
+void WakeupFd::drain() noexcept {
+    if (m_fd < 0) return;
+    uint64_t value = 0;
+    [[maybe_unused]] ssize_t n = ::read(m_fd, &value, sizeof(value));
+}
@@ -0,0 +1,36 @@
+/**
+ * @file Check.hpp
+ * @brief Minimal assertion helpers shared by the unit tests.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+namespace test {
+
+/** Failed checks so far. */
+inline int failures = 0;
+
+/** @brief Exit status of a test program: 0 when every check passed. */
+inline int result(const char* name) {
+    if (failures == 0) {
+        std::printf("%s: passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d check(s) failed\n", name, failures);
+    return 1;
+}
+
+} // namespace test
+
+/** Record a failure (with its location) unless the condition holds; keeps running. */
+#define CHECK(...)                                                                          \
+    do {                                                                                    \
+        if (!(__VA_ARGS__)) {                                                               \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__); \
+            ++test::failures;                                                               \
+        }                                                                                   \
+    } while (0)
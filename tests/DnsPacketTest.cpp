@@ -0,0 +1,354 @@
+/**
+ * @file DnsPacketTest.cpp
+ * @brief Decoding of DNS datagrams: names, compression, truncation and bounds.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "capture/DnsPacket.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using capture::DnsAnswerReader;
+using capture::DnsPacket;
+using capture::DnsRecord;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+void put16(Bytes& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void put32(Bytes& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value >> 16));
+    put16(out, static_cast<uint16_t>(value));
+}
+
+/// Encode a dotted name as uncompressed labels
+void putName(Bytes& out, const std::string& name) {
+    std::size_t start = 0;
+    while (start < name.size()) {
+        std::size_t dot = name.find('.', start);
+        if (dot == std::string::npos) dot = name.size();
+        out.push_back(static_cast<uint8_t>(dot - start));
+        out.insert(out.end(), name.begin() + static_cast<long>(start), name.begin() + static_cast<long>(dot));
+        start = dot + 1;
+    }
+    out.push_back(0);
+}
+
+Bytes header(uint16_t id, uint16_t flags, uint16_t questions, uint16_t answers) {
+    Bytes out;
+    put16(out, id);
+    put16(out, flags);
+    put16(out, questions);
+    put16(out, answers);
+    put16(out, 0);
+    put16(out, 0);
+    return out;
+}
+
+Bytes query(const std::string& name, uint16_t qtype = 1) {
+    Bytes out = header(0x1234, 0x0100, 1, 0);
+    putName(out, name);
+    put16(out, qtype);
+    put16(out, 1);
+    return out;
+}
+
+/// Response for name with one A record per address, names compressed towards the question
+Bytes response(const std::string& name, const std::vector<uint32_t>& addresses) {
+    Bytes out = header(0x1234, 0x8180, 1, static_cast<uint16_t>(addresses.size()));
+    putName(out, name);
+    put16(out, 1);
+    put16(out, 1);
+    for (uint32_t address : addresses) {
+        put16(out, 0xc00c);
+        put16(out, 1);
+        put16(out, 1);
+        put32(out, 300);
+        put16(out, 4);
+        put32(out, address);
+    }
+    return out;
+}
+
+/// Dotted name of labels of the given lengths
+std::string nameOf(const std::vector<std::size_t>& labels) {
+    std::string name;
+    for (std::size_t length : labels) {
+        if (!name.empty()) name += '.';
+        name.append(length, 'a');
+    }
+    return name;
+}
+
+bool parse(const Bytes& message, DnsPacket& dns) {
+    return capture::parseDnsMessage(message.data(), static_cast<uint32_t>(message.size()), dns);
+}
+
+/// dns points into the message, so only rejected messages may be temporaries
+bool rejects(const Bytes& message) {
+    DnsPacket dns;
+    return !parse(message, dns);
+}
+
+std::size_t countAnswers(const DnsPacket& dns) {
+    DnsAnswerReader reader(dns);
+    DnsRecord record;
+    std::size_t count = 0;
+    while (reader.next(record)) {
+        // Every record handed out lies within the captured message
+        CHECK(record.rdata >= dns.message);
+        CHECK(record.rdata + record.rdataLen <= dns.message + dns.messageLen);
+        ++count;
+    }
+    return count;
+}
+
+void testQuestion() {
+    Bytes mixed = query("WWW.Example.COM");
+    Bytes folded = query("www.example.com");
+    DnsPacket upper;
+    DnsPacket lower;
+    CHECK(parse(mixed, upper));
+    CHECK(parse(folded, lower));
+    CHECK(!upper.response);
+    CHECK(upper.id == 0x1234);
+    CHECK(upper.qtype == 1);
+    CHECK(upper.questionNameLen == 17);
+    CHECK(upper.questionHash != 0);
+    CHECK(upper.questionHash == lower.questionHash);
+    CHECK(capture::dnsQuestionName(upper) == "WWW.Example.COM");
+
+    DnsPacket other;
+    Bytes aaaa = query("www.example.com", 28);
+    CHECK(parse(aaaa, other));
+    CHECK(other.questionHash != lower.questionHash);
+
+    Bytes empty = query("");
+    DnsPacket root;
+    CHECK(parse(empty, root));
+    CHECK(root.questionNameLen == 1);
+    CHECK(capture::dnsQuestionName(root) == ".");
+}
+
+void testCompression() {
+    Bytes message = response("example.com", {0x01020304, 0x05060708});
+    DnsPacket dns;
+    CHECK(parse(message, dns));
+    CHECK(dns.response);
+    CHECK(countAnswers(dns) == 2);
+
+    // Resolvers shuffle records; the digest must not care
+    DnsPacket swapped;
+    Bytes reordered = response("example.com", {0x05060708, 0x01020304});
+    CHECK(parse(reordered, swapped));
+    CHECK(capture::dnsAnswerDigest(dns) == capture::dnsAnswerDigest(swapped));
+    DnsPacket forged;
+    Bytes other = response("example.com", {0x01020304, 0x0a0b0c0d});
+    CHECK(parse(other, forged));
+    CHECK(capture::dnsAnswerDigest(dns) != capture::dnsAnswerDigest(forged));
+
+    // The first question is never compressed in a genuine message
+    Bytes pointer = header(1, 0x8180, 1, 0);
+    put16(pointer, 0xc00c);
+    put16(pointer, 1);
+    put16(pointer, 1);
+    CHECK(!parse(pointer, dns));
+
+    // Reserved label types are malformed wherever they appear
+    Bytes reserved = header(1, 0x0100, 1, 0);
+    reserved.push_back(0x40);
+    reserved.push_back(0);
+    put16(reserved, 1);
+    put16(reserved, 1);
+    CHECK(!parse(reserved, dns));
+
+    // Later questions may be compressed
+    Bytes two = header(1, 0x0100, 2, 0);
+    putName(two, "example.com");
+    put16(two, 1);
+    put16(two, 1);
+    put16(two, 0xc00c);
+    put16(two, 28);
+    put16(two, 1);
+    CHECK(parse(two, dns));
+    CHECK(dns.answerOffset == two.size());
+}
+
+void testTruncation() {
+    Bytes message = response("example.com", {0x01020304, 0x05060708});
+    const std::size_t question = 12 + 13 + 4;
+    const std::size_t record = 16;
+    for (std::size_t len = 0; len < message.size(); ++len) {
+        // An exact-size copy so any read past len leaves the allocation
+        Bytes prefix(message.begin(), message.begin() + static_cast<long>(len));
+        DnsPacket dns;
+        bool parsed = capture::parseDnsMessage(prefix.data(), static_cast<uint32_t>(len), dns);
+        CHECK(parsed == (len >= question));
+        if (!parsed) continue;
+        CHECK(countAnswers(dns) == (len - question) / record);
+    }
+
+    // A pointer cut in half at the end of the capture
+    Bytes cut = response("example.com", {});
+    cut[7] = 1;
+    cut.push_back(0xc0);
+    DnsPacket dns;
+    CHECK(parse(cut, dns));
+    CHECK(countAnswers(dns) == 0);
+
+    // More answers announced than present
+    Bytes short_count = response("example.com", {0x01020304});
+    short_count[7] = 5;
+    CHECK(parse(short_count, dns));
+    CHECK(countAnswers(dns) == 1);
+
+    // rdata running past the end
+    Bytes long_rdata = response("example.com", {0x01020304});
+    long_rdata[long_rdata.size() - 5] = 40;
+    CHECK(parse(long_rdata, dns));
+    CHECK(countAnswers(dns) == 0);
+}
+
+void testOversizedNames() {
+    // 3 * (1 + 63) + (1 + 61) + 1 = 255 bytes encoded, the RFC 1035 limit
+    std::string longest = nameOf({63, 63, 63, 61});
+    Bytes limit = query(longest);
+    DnsPacket dns;
+    CHECK(parse(limit, dns));
+    CHECK(dns.questionNameLen == 255);
+    CHECK(capture::dnsQuestionName(dns) == longest);
+
+    // One byte over
+    CHECK(rejects(query(nameOf({63, 63, 63, 62}))));
+    CHECK(rejects(query(nameOf({63, 63, 63, 63, 1}))));
+
+    // Many short labels over the limit
+    std::vector<std::size_t> tiny(128, 1);
+    CHECK(rejects(query(nameOf(tiny))));
+    tiny.resize(127);
+    Bytes labels = query(nameOf(tiny));
+    CHECK(parse(labels, dns));
+    CHECK(dns.questionNameLen == 255);
+
+    // An answer owner name over the limit ends the answer section
+    Bytes message = header(1, 0x8180, 1, 1);
+    putName(message, "example.com");
+    put16(message, 1);
+    put16(message, 1);
+    putName(message, nameOf({63, 63, 63, 62}));
+    put16(message, 1);
+    put16(message, 1);
+    put32(message, 300);
+    put16(message, 4);
+    put32(message, 0x01020304);
+    CHECK(parse(message, dns));
+    CHECK(countAnswers(dns) == 0);
+}
+
+void testDatagram() {
+    Bytes payload = response("example.com", {0x01020304});
+
+    Bytes ipv4 = {0x45, 0, 0, 0, 0, 0, 0, 0, 64, 17, 0, 0, 192, 0, 2, 53, 192, 0, 2, 1};
+    put16(ipv4, 53);
+    put16(ipv4, 40000);
+    put16(ipv4, static_cast<uint16_t>(8 + payload.size()));
+    put16(ipv4, 0);
+    ipv4.insert(ipv4.end(), payload.begin(), payload.end());
+    // Ethernet padding beyond the UDP length is not part of the message
+    Bytes padded = ipv4;
+    padded.resize(padded.size() + 16, 0xff);
+
+    DnsPacket dns;
+    CHECK(capture::parseDnsDatagram(padded.data(), static_cast<uint32_t>(padded.size()), dns));
+    CHECK(dns.messageLen == payload.size());
+    CHECK(dns.sourcePort == 53);
+    CHECK(dns.destinationPort == 40000);
+    CHECK(NetAddr::isMappedIpv4(dns.source));
+    CHECK((dns.source.lo & 0xffffffff) == 0xc0000235);
+    CHECK(countAnswers(dns) == 1);
+
+    // Later fragments carry no UDP header
+    Bytes fragment = ipv4;
+    fragment[7] = 1;
+    CHECK(!capture::parseDnsDatagram(fragment.data(), static_cast<uint32_t>(fragment.size()), dns));
+
+    // Not UDP
+    Bytes tcp = ipv4;
+    tcp[9] = 6;
+    CHECK(!capture::parseDnsDatagram(tcp.data(), static_cast<uint32_t>(tcp.size()), dns));
+
+    // A UDP length below the headers is malformed
+    Bytes runt = ipv4;
+    runt[24] = 0;
+    runt[25] = 8;
+    CHECK(!capture::parseDnsDatagram(runt.data(), static_cast<uint32_t>(runt.size()), dns));
+
+    Bytes ipv6(40, 0);
+    ipv6[0] = 0x60;
+    ipv6[6] = 17;
+    ipv6[8] = 0x20;
+    ipv6[9] = 0x01;
+    ipv6[23] = 1;
+    put16(ipv6, 53);
+    put16(ipv6, 40000);
+    put16(ipv6, static_cast<uint16_t>(8 + payload.size()));
+    put16(ipv6, 0);
+    ipv6.insert(ipv6.end(), payload.begin(), payload.end());
+    CHECK(capture::parseDnsDatagram(ipv6.data(), static_cast<uint32_t>(ipv6.size()), dns));
+    CHECK(!NetAddr::isMappedIpv4(dns.source));
+    CHECK(dns.messageLen == payload.size());
+
+    // Captured bytes cut short of the UDP length
+    CHECK(capture::parseDnsDatagram(ipv6.data(), static_cast<uint32_t>(ipv6.size() - 8), dns));
+    CHECK(dns.messageLen == payload.size() - 8);
+    CHECK(countAnswers(dns) == 0);
+}
+
+/// Random corruption of valid messages must never read out of bounds nor loop
+void testCorruption() {
+    std::mt19937 rng(0x5eed);
+    std::vector<Bytes> seeds = {query("www.example.com"), response("example.com", {1, 2, 3}),
+                                query(nameOf({63, 63, 63, 61}))};
+    for (int round = 0; round < 20000; ++round) {
+        Bytes message = seeds[static_cast<std::size_t>(round) % seeds.size()];
+        int edits = 1 + static_cast<int>(rng() % 8);
+        for (int e = 0; e < edits; ++e) {
+            std::size_t at = rng() % message.size();
+            switch (rng() % 3) {
+            case 0: message[at] = static_cast<uint8_t>(rng()); break;
+            case 1: message[at] = static_cast<uint8_t>(0xc0 | (rng() & 1)); break;
+            default: message.resize(at + 1); break;
+            }
+        }
+        DnsPacket dns;
+        if (!parse(message, dns)) continue;
+        CHECK(dns.answerOffset <= dns.messageLen);
+        CHECK(dns.questionNameLen <= 255);
+        countAnswers(dns);
+        capture::dnsAnswerDigest(dns);
+        capture::dnsQuestionName(dns);
+    }
+}
+
+} // namespace
+
+int main() {
+    testQuestion();
+    testCompression();
+    testTruncation();
+    testOversizedNames();
+    testDatagram();
+    testCorruption();
+    return test::result("DnsPacketTest");
+}
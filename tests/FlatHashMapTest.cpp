@@ -0,0 +1,115 @@
+/**
+ * @file FlatHashMapTest.cpp
+ * @brief Randomized comparison of FlatHashMap against std::unordered_map.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "utils/FlatHashMap.hpp"
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+/// Few distinct home slots near the end of the array: long probe runs that wrap around
+struct ClusteredHash {
+    uint64_t operator()(uint32_t key) const noexcept { return ~uint64_t{0} - key % 5; }
+};
+
+template <typename Map>
+void checkSame(const Map& map, const std::unordered_map<uint32_t, uint32_t>& ref, uint32_t keyRange) {
+    CHECK(map.size() == ref.size());
+    CHECK(map.empty() == ref.empty());
+    for (uint32_t key = 0; key < keyRange; ++key) {
+        const uint32_t* value = map.find(key);
+        auto it = ref.find(key);
+        CHECK((value != nullptr) == (it != ref.end()));
+        if (value && it != ref.end()) CHECK(*value == it->second);
+    }
+    std::size_t visited = 0;
+    map.forEach([&](uint32_t key, uint32_t value) {
+        auto it = ref.find(key);
+        CHECK(it != ref.end() && it->second == value);
+        ++visited;
+    });
+    CHECK(visited == ref.size());
+}
+
+template <typename Hash>
+void testRandomOps(std::mt19937_64& rng, uint32_t keyRange, std::size_t maxSize) {
+    FlatHashMap<uint32_t, uint32_t, Hash> map(8, maxSize);
+    std::unordered_map<uint32_t, uint32_t> ref;
+
+    for (int step = 0; step < 20000; ++step) {
+        uint32_t key = static_cast<uint32_t>(rng() % keyRange);
+        switch (rng() % 8) {
+        case 0: {
+            // Drop about a third of the entries at once; shifted entries must be re-checked
+            uint32_t salt = static_cast<uint32_t>(rng());
+            auto pred = [&](uint32_t k, uint32_t v) { return (k ^ v ^ salt) % 3 == 0; };
+            std::size_t expected = 0;
+            for (auto it = ref.begin(); it != ref.end();) {
+                if (pred(it->first, it->second)) {
+                    it = ref.erase(it);
+                    ++expected;
+                } else {
+                    ++it;
+                }
+            }
+            CHECK(map.eraseIf(pred) == expected);
+            break;
+        }
+        case 1:
+        case 2:
+            CHECK(map.erase(key) == (ref.erase(key) == 1));
+            break;
+        default: {
+            bool present = ref.count(key) != 0;
+            bool room = maxSize == 0 || ref.size() < maxSize;
+            auto [value, inserted] = map.insert(key);
+            CHECK(inserted == (!present && room));
+            CHECK((value != nullptr) == (present || room));
+            if (inserted) CHECK(*value == 0);
+            if (value) {
+                *value = static_cast<uint32_t>(rng());
+                ref[key] = *value;
+            }
+            CHECK(map.full() == (maxSize != 0 && ref.size() >= maxSize));
+            break;
+        }
+        }
+        if (step % 97 == 0) checkSame(map, ref, keyRange);
+    }
+    checkSame(map, ref, keyRange);
+
+    map.clear();
+    ref.clear();
+    checkSame(map, ref, keyRange);
+}
+
+void testMaxSizeForBytes() {
+    using Map = FlatHashMap<uint64_t, uint64_t>;
+    CHECK(Map::maxSizeForBytes(0) == 6);
+    std::size_t limit = Map::maxSizeForBytes(1 << 20);
+    Map map(16, limit);
+    for (uint64_t key = 0; !map.full(); ++key) CHECK(map.insert(key).second);
+    CHECK(map.size() == limit);
+    CHECK(map.capacity() * (2 * sizeof(uint64_t) + 1) <= (1u << 20));
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(0x5eed);
+    testRandomOps<FlatHash<uint32_t>>(rng, 64, 0);
+    testRandomOps<FlatHash<uint32_t>>(rng, 4096, 0);
+    testRandomOps<FlatHash<uint32_t>>(rng, 512, 100);
+    testRandomOps<ClusteredHash>(rng, 200, 0);
+    testRandomOps<ClusteredHash>(rng, 200, 48);
+    testMaxSizeForBytes();
+    return test::result("FlatHashMapTest");
+}
@@ -0,0 +1,366 @@
+/**
+ * @file KnownDnsDbTest.cpp
+ * @brief Randomized comparison of the known-DNS lookups against std::set references.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "monitors/KnownDnsDb.hpp"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using monitors::KnownDnsDb;
+
+namespace {
+
+struct Ipv6Less {
+    bool operator()(const Ipv6Addr& a, const Ipv6Addr& b) const { return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo; }
+};
+
+struct PrefixLess {
+    bool operator()(const std::pair<unsigned, Ipv6Addr>& a, const std::pair<unsigned, Ipv6Addr>& b) const {
+        return a.first != b.first ? a.first < b.first : Ipv6Less{}(a.second, b.second);
+    }
+};
+
+/// addr with every bit from len on cleared
+Ipv6Addr masked(const Ipv6Addr& addr, unsigned len) {
+    Ipv6Addr out;
+    if (len == 0) return out;
+    if (len <= 64) {
+        out.hi = addr.hi & (~0ull << (64 - len));
+    } else {
+        out.hi = addr.hi;
+        out.lo = addr.lo & (~0ull << (128 - len));
+    }
+    return out;
+}
+
+std::string ipv4Text(uint32_t hostOrder) {
+    uint32_t ip = htonl(hostOrder);
+    char text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &ip, text, sizeof(text));
+    return text;
+}
+
+std::string ipv6Text(const Ipv6Addr& addr) {
+    uint8_t bytes[16];
+    NetAddr::unpackIpv6(addr, bytes);
+    char text[INET6_ADDRSTRLEN];
+    inet_ntop(AF_INET6, bytes, text, sizeof(text));
+    return text;
+}
+
+Ipv6Addr mapped(uint32_t hostOrder) {
+    Ipv6Addr addr;
+    addr.lo = 0xffff00000000ull | hostOrder;
+    return addr;
+}
+
+/// Temporary file removed on destruction
+struct TempFile {
+    std::string path;
+
+    TempFile() {
+        char name[] = "/tmp/spoofeye-test-XXXXXX";
+        int fd = mkstemp(name);
+        if (fd >= 0) close(fd);
+        path = name;
+    }
+    ~TempFile() { unlink(path.c_str()); }
+};
+
+/// The reference: plain sets of every listed address
+struct Reference {
+    std::set<uint32_t> ipv4;
+    std::set<Ipv6Addr, Ipv6Less> ipv6;
+    std::vector<std::string> entries;
+
+    void addIpv4(uint32_t ip, bool asMapped) {
+        ipv4.insert(ip);
+        entries.push_back(asMapped ? "::ffff:" + ipv4Text(ip) : ipv4Text(ip));
+    }
+
+    void addIpv6(const Ipv6Addr& ip) {
+        ipv6.insert(ip);
+        entries.push_back(ipv6Text(ip));
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream out(path);
+        out << "[\n";
+        for (std::size_t i = 0; i < entries.size(); ++i) out << (i ? ",\n" : "") << '"' << entries[i] << '"';
+        out << "\n]\n";
+        return static_cast<bool>(out);
+    }
+};
+
+/// Every lookup entry point must agree with the reference
+void compare(const KnownDnsDb& db, const Reference& ref, const std::vector<uint32_t>& probes4,
+             const std::vector<Ipv6Addr>& probes6) {
+    for (uint32_t ip : probes4) {
+        bool expected = ref.ipv4.count(ip) != 0;
+        CHECK(db.containsIpv4(htonl(ip)) == expected);
+        CHECK(db.containsIpv6(mapped(ip)) == expected);
+        CHECK(db.contains(ipv4Text(ip)) == expected);
+    }
+    for (const Ipv6Addr& ip : probes6) {
+        bool expected = ref.ipv6.count(ip) != 0;
+        CHECK(db.containsIpv6(ip) == expected);
+        CHECK(db.contains(ipv6Text(ip)) == expected);
+    }
+}
+
+void testRandomLists(std::mt19937_64& rng) {
+    // Small sizes walk every window split of the search, large ones its depth
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 1; n <= 40; ++n) sizes.push_back(n);
+    sizes.push_back(1000);
+    sizes.push_back(20000);
+
+    for (std::size_t size : sizes) {
+        Reference ref;
+        // Clustered values so neighbours of members are probed too
+        uint32_t base4 = static_cast<uint32_t>(rng());
+        uint64_t base6 = rng();
+        for (std::size_t i = 0; i < size; ++i) {
+            switch (rng() % 4) {
+            case 0: ref.addIpv4(static_cast<uint32_t>(rng()), false); break;
+            case 1: ref.addIpv4(base4 + static_cast<uint32_t>(rng() % (4 * size)), rng() % 4 == 0); break;
+            case 2: {
+                Ipv6Addr ip;
+                ip.hi = rng();
+                ip.lo = rng();
+                ref.addIpv6(ip);
+                break;
+            }
+            default: {
+                // Same upper half, so the search has to compare the lower one
+                Ipv6Addr ip;
+                ip.hi = base6;
+                ip.lo = rng() % (4 * size);
+                ref.addIpv6(ip);
+                break;
+            }
+            }
+        }
+        // Duplicates collapse
+        ref.entries.push_back(ref.entries.front());
+
+        std::vector<uint32_t> probes4 = {0, 1, UINT32_MAX, UINT32_MAX - 1};
+        for (uint32_t ip : ref.ipv4) {
+            probes4.push_back(ip);
+            probes4.push_back(ip - 1);
+            probes4.push_back(ip + 1);
+        }
+        for (std::size_t i = 0; i < 4 * size; ++i) probes4.push_back(base4 + static_cast<uint32_t>(rng() % (4 * size)));
+
+        std::vector<Ipv6Addr> probes6 = {Ipv6Addr{}, Ipv6Addr{UINT64_MAX, UINT64_MAX}};
+        for (const Ipv6Addr& ip : ref.ipv6) {
+            probes6.push_back(ip);
+            probes6.push_back(Ipv6Addr{ip.hi, ip.lo + 1});
+            probes6.push_back(Ipv6Addr{ip.hi, ip.lo - 1});
+            probes6.push_back(Ipv6Addr{ip.hi + 1, ip.lo});
+        }
+        for (std::size_t i = 0; i < 4 * size; ++i) probes6.push_back(Ipv6Addr{base6, rng() % (4 * size)});
+
+        TempFile json;
+        TempFile compiled;
+        CHECK(ref.write(json.path));
+        KnownDnsDb db;
+        std::string error;
+        CHECK(db.loadJson(json.path, error));
+        CHECK(db.addressCount() == ref.ipv4.size() + ref.ipv6.size());
+        compare(db, ref, probes4, probes6);
+
+        // The mapped compiled file answers like the arrays it was written from
+        CHECK(db.compile(compiled.path, error));
+        KnownDnsDb mappedDb;
+        CHECK(mappedDb.open(compiled.path, error));
+        CHECK(mappedDb.isMapped());
+        compare(mappedDb, ref, probes4, probes6);
+    }
+}
+
+void testEdges() {
+    Reference ref;
+    ref.addIpv4(0, false);
+    ref.addIpv4(UINT32_MAX, true);
+    ref.addIpv6(Ipv6Addr{});
+    ref.addIpv6(Ipv6Addr{UINT64_MAX, UINT64_MAX});
+
+    TempFile json;
+    CHECK(ref.write(json.path));
+    KnownDnsDb db;
+    std::string error;
+    CHECK(db.loadJson(json.path, error));
+    compare(db, ref, {0, 1, UINT32_MAX - 1, UINT32_MAX}, {Ipv6Addr{}, Ipv6Addr{0, 1}, Ipv6Addr{UINT64_MAX, UINT64_MAX},
+                                                          Ipv6Addr{UINT64_MAX, UINT64_MAX - 1}});
+    CHECK(db.contains("::%eth0"));
+    CHECK(!db.contains("not an address"));
+
+    // Nothing loaded, nothing known
+    KnownDnsDb empty;
+    CHECK(!empty.containsIpv4(0));
+    CHECK(!empty.containsIpv6(Ipv6Addr{}));
+}
+
+/// Listed prefixes by (length, masked address), tried from the longest length down
+struct PrefixReference {
+    std::set<std::pair<unsigned, uint32_t>> ipv4;
+    std::set<std::pair<unsigned, Ipv6Addr>, PrefixLess> ipv6;
+
+    bool coversIpv4(uint32_t ip) const {
+        for (unsigned len = 0; len <= 32; ++len) {
+            if (ipv4.count({len, len ? ip & (~0u << (32 - len)) : 0})) return true;
+        }
+        return false;
+    }
+
+    bool coversIpv6(const Ipv6Addr& ip) const {
+        for (unsigned len = 0; len <= 128; ++len) {
+            if (ipv6.count({len, masked(ip, len)})) return true;
+        }
+        return false;
+    }
+};
+
+void testPrefixes(std::mt19937_64& rng) {
+    for (int round = 0; round < 40; ++round) {
+        Reference ref;
+        PrefixReference prefixes;
+        uint32_t base4 = static_cast<uint32_t>(rng());
+        Ipv6Addr base6{rng(), rng()};
+        std::size_t count = 1 + static_cast<std::size_t>(rng() % (round < 30 ? 40 : 2000));
+        for (std::size_t i = 0; i < count; ++i) {
+            // Near a base so prefixes nest and probes hit them
+            uint32_t v4 = rng() % 2 ? base4 ^ static_cast<uint32_t>(1u << (rng() % 32)) : static_cast<uint32_t>(rng());
+            Ipv6Addr v6 = base6;
+            if (rng() % 2) v6 = masked(Ipv6Addr{rng(), rng()}, 128);
+            else if (rng() % 2) v6.lo ^= 1ull << (rng() % 64);
+            else v6.hi ^= 1ull << (rng() % 64);
+
+            switch (rng() % 5) {
+            case 0: ref.addIpv4(v4, rng() % 2 == 0); break;
+            case 1: ref.addIpv6(v6); break;
+            case 2: {
+                unsigned len = static_cast<unsigned>(rng() % 32);
+                uint32_t prefix = len ? v4 & (~0u << (32 - len)) : 0;
+                prefixes.ipv4.insert({len, prefix});
+                // The same range written as an IPv4-mapped IPv6 prefix
+                if (rng() % 2) {
+                    ref.entries.push_back("::ffff:" + ipv4Text(v4) + "/" + std::to_string(len + 96));
+                } else {
+                    ref.entries.push_back(ipv4Text(v4) + "/" + std::to_string(len));
+                }
+                break;
+            }
+            default: {
+                unsigned len = static_cast<unsigned>(rng() % 128);
+                // Never the first 96 bits of the mapped range, which only IPv4 lookups reach
+                if (masked(v6, 96) == masked(mapped(0), 96)) break;
+                prefixes.ipv6.insert({len, masked(v6, len)});
+                ref.entries.push_back(ipv6Text(v6) + "/" + std::to_string(len));
+                break;
+            }
+            }
+        }
+        if (round % 10 == 0) {
+            ref.entries.push_back("0.0.0.0/0");
+            prefixes.ipv4.insert({0, 0});
+        } else if (round % 10 == 1) {
+            ref.entries.push_back("::/0");
+            prefixes.ipv6.insert({0, Ipv6Addr{}});
+        }
+        if (ref.entries.empty()) continue;
+
+        std::vector<uint32_t> probes4 = {0, UINT32_MAX};
+        std::vector<Ipv6Addr> probes6 = {Ipv6Addr{}, Ipv6Addr{UINT64_MAX, UINT64_MAX}};
+        for (int i = 0; i < 2000; ++i) {
+            probes4.push_back(i % 2 ? base4 ^ static_cast<uint32_t>(rng() % 4096) : static_cast<uint32_t>(rng()));
+            Ipv6Addr v6 = base6;
+            if (i % 3 == 0) v6 = Ipv6Addr{rng(), rng()};
+            else v6.lo ^= rng() % 4096;
+            probes6.push_back(v6);
+        }
+        for (uint32_t ip : ref.ipv4) probes4.push_back(ip);
+        for (const Ipv6Addr& ip : ref.ipv6) probes6.push_back(ip);
+
+        TempFile json;
+        TempFile compiled;
+        CHECK(ref.write(json.path));
+        KnownDnsDb db;
+        std::string error;
+        std::size_t skipped = 0;
+        CHECK(db.loadJson(json.path, error, &skipped));
+        CHECK(skipped == 0);
+        CHECK(db.prefixCount() == prefixes.ipv4.size() + prefixes.ipv6.size());
+        CHECK(db.compile(compiled.path, error));
+        KnownDnsDb mappedDb;
+        CHECK(mappedDb.open(compiled.path, error));
+
+        for (const KnownDnsDb* known : {&db, &mappedDb}) {
+            for (uint32_t ip : probes4) {
+                bool expected = ref.ipv4.count(ip) != 0 || prefixes.coversIpv4(ip);
+                CHECK(known->containsIpv4(htonl(ip)) == expected);
+                CHECK(known->containsIpv6(mapped(ip)) == expected);
+            }
+            for (const Ipv6Addr& ip : probes6) {
+                if (NetAddr::isMappedIpv4(ip)) continue;
+                CHECK(known->containsIpv6(ip) == (ref.ipv6.count(ip) != 0 || prefixes.coversIpv6(ip)));
+            }
+        }
+    }
+}
+
+void testPrefixSyntax() {
+    Reference ref;
+    ref.entries = {"192.0.2.0/24", "::ffff:198.51.100.0/120", "::ffff:0.0.0.0/95", "2001:db8::/32",
+                   "203.0.113.7/32", "2001:db8:1::1/128", "10.0.0.0/33", "::ffff:10.0.0.0/129",
+                   "10.0.0.0/", "10.0.0.0/x", "2001:db8::/1280"};
+    TempFile json;
+    CHECK(ref.write(json.path));
+    KnownDnsDb db;
+    std::string error;
+    std::size_t skipped = 0;
+    CHECK(db.loadJson(json.path, error, &skipped));
+    CHECK(skipped == 5);
+    // /32 and /128 are plain addresses
+    CHECK(db.addressCount() == 2);
+    CHECK(db.prefixCount() == 4);
+
+    CHECK(db.contains("192.0.2.255"));
+    CHECK(!db.contains("192.0.3.0"));
+    CHECK(db.contains("198.51.100.200"));
+    CHECK(db.contains("::ffff:198.51.100.1"));
+    CHECK(db.contains("203.0.113.7"));
+    CHECK(!db.contains("203.0.113.8"));
+    CHECK(db.contains("2001:db8:ffff::1"));
+    CHECK(db.contains("2001:db8:1::1"));
+    CHECK(!db.contains("2001:db9::"));
+    // A mapped prefix shorter than /96 is an IPv6 range and says nothing about IPv4
+    CHECK(!db.contains("8.8.8.8"));
+    CHECK(db.contains("::fffe:0:1"));
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(0x5eed);
+    testRandomLists(rng);
+    testEdges();
+    testPrefixes(rng);
+    testPrefixSyntax();
+    return test::result("KnownDnsDbTest");
+}
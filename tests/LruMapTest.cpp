@@ -0,0 +1,104 @@
+/**
+ * @file LruMapTest.cpp
+ * @brief Randomized comparison of LruMap against a list-based LRU.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "utils/LruMap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <utility>
+
+namespace {
+
+/// Most recently used first
+using Reference = std::list<std::pair<uint32_t, uint32_t>>;
+
+Reference::iterator lookup(Reference& ref, uint32_t key) {
+    return std::find_if(ref.begin(), ref.end(), [&](const auto& entry) { return entry.first == key; });
+}
+
+void checkSame(LruMap<uint32_t, uint32_t>& lru, Reference& ref) {
+    CHECK(lru.size() == ref.size());
+    auto it = ref.begin();
+    lru.forEach([&](uint32_t key, uint32_t value) {
+        CHECK(it != ref.end());
+        if (it == ref.end()) return;
+        CHECK(key == it->first && value == it->second);
+        ++it;
+    });
+    CHECK(it == ref.end());
+}
+
+void testRandomOps(std::mt19937_64& rng, std::size_t capacity, uint32_t keyRange) {
+    LruMap<uint32_t, uint32_t> lru(capacity);
+    Reference ref;
+    CHECK(lru.capacity() == capacity);
+
+    for (int step = 0; step < 20000; ++step) {
+        uint32_t key = static_cast<uint32_t>(rng() % keyRange);
+        auto found = lookup(ref, key);
+        switch (rng() % 6) {
+        case 0:
+            CHECK(lru.erase(key) == (found != ref.end()));
+            if (found != ref.end()) ref.erase(found);
+            break;
+        case 1: {
+            // find() does not refresh recency
+            const auto& constLru = lru;
+            const uint32_t* value = constLru.find(key);
+            CHECK((value != nullptr) == (found != ref.end()));
+            if (value && found != ref.end()) CHECK(*value == found->second);
+            break;
+        }
+        default: {
+            bool evicted = true;
+            auto [value, inserted] = lru.touch(key, &evicted);
+            CHECK(value != nullptr);
+            CHECK(inserted == (found == ref.end()));
+            CHECK(evicted == (found == ref.end() && ref.size() == capacity));
+            if (found != ref.end()) {
+                CHECK(*value == found->second);
+                ref.splice(ref.begin(), ref, found);
+            } else {
+                CHECK(*value == 0);
+                if (ref.size() == capacity) ref.pop_back();
+                ref.emplace_front(key, 0);
+            }
+            *value = static_cast<uint32_t>(rng());
+            ref.front().second = *value;
+            break;
+        }
+        }
+        if (step % 31 == 0) checkSame(lru, ref);
+    }
+    checkSame(lru, ref);
+}
+
+void testCapacityOne() {
+    LruMap<uint32_t, uint32_t> lru(0);
+    CHECK(lru.capacity() == 1);
+    bool evicted = true;
+    CHECK(lru.touch(1, &evicted).second && !evicted);
+    CHECK(lru.touch(2, &evicted).second && evicted);
+    CHECK(lru.find(1) == nullptr && lru.find(2) != nullptr);
+    CHECK(lru.erase(2) && !lru.erase(2));
+    CHECK(lru.size() == 0);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(0x5eed);
+    testRandomOps(rng, 8, 16);
+    testRandomOps(rng, 64, 96);
+    testRandomOps(rng, 100, 1000);
+    testCapacityOne();
+    return test::result("LruMapTest");
+}
@@ -0,0 +1,246 @@
+/**
+ * @file PrefixTrieTest.cpp
+ * @brief Randomized comparison of PrefixTrie longest-prefix match against std::set.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "utils/PrefixTrie.hpp"
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// key with every bit from len on cleared
+Ipv6Addr masked(const Ipv6Addr& key, unsigned len) {
+    Ipv6Addr out;
+    if (len == 0) return out;
+    if (len <= 64) {
+        out.hi = key.hi & (~0ull << (64 - len));
+    } else {
+        out.hi = key.hi;
+        out.lo = key.lo & (~0ull << (128 - len));
+    }
+    return out;
+}
+
+/// key with bit i flipped, 0 being the most significant bit of hi
+Ipv6Addr flipped(Ipv6Addr key, unsigned i) {
+    if (i < 64) {
+        key.hi ^= 1ull << (63 - i);
+    } else {
+        key.lo ^= 1ull << (127 - i);
+    }
+    return key;
+}
+
+/// The reference: every stored (length, masked prefix), tried from the longest length down
+struct Reference {
+    std::set<std::pair<unsigned, std::pair<uint64_t, uint64_t>>> prefixes;
+
+    void insert(const Ipv6Addr& prefix, unsigned len) {
+        Ipv6Addr key = masked(prefix, len);
+        prefixes.insert({len, {key.hi, key.lo}});
+    }
+
+    int longestMatch(const Ipv6Addr& key, unsigned maxLen) const {
+        for (int len = static_cast<int>(maxLen); len >= 0; --len) {
+            Ipv6Addr prefix = masked(key, static_cast<unsigned>(len));
+            if (prefixes.count({static_cast<unsigned>(len), {prefix.hi, prefix.lo}})) return len;
+        }
+        return -1;
+    }
+};
+
+/// Random prefix of a family: IPv4 uses the top 32 bits of hi, like KnownDnsDb
+struct Generator {
+    std::mt19937_64& rng;
+    unsigned maxLen;
+    std::vector<Ipv6Addr> bases;
+
+    Ipv6Addr key() {
+        Ipv6Addr key;
+        // Most keys share a few bases, so prefixes nest and split each other
+        if (!bases.empty() && rng() % 4 != 0) {
+            key = bases[rng() % bases.size()];
+            unsigned bit = static_cast<unsigned>(rng() % maxLen);
+            key = flipped(key, bit);
+        } else {
+            key.hi = rng();
+            key.lo = maxLen > 64 ? rng() : 0;
+        }
+        if (maxLen == 32) key.hi &= ~0ull << 32;
+        return key;
+    }
+
+    unsigned length() {
+        switch (rng() % 8) {
+        case 0: return maxLen;
+        case 1: return static_cast<unsigned>(rng() % 9);
+        default: return static_cast<unsigned>(rng() % (maxLen + 1));
+        }
+    }
+};
+
+void compare(const PrefixTrie& trie, const Reference& ref, const std::vector<Ipv6Addr>& probes, unsigned maxLen) {
+    CHECK(trie.size() == ref.prefixes.size());
+    for (const Ipv6Addr& key : probes) CHECK(trie.longestMatch(key) == ref.longestMatch(key, maxLen));
+}
+
+/// Keys on both sides of every prefix boundary, plus random ones
+std::vector<Ipv6Addr> probesFor(const Reference& ref, Generator& gen, std::size_t randomCount) {
+    std::vector<Ipv6Addr> probes = {Ipv6Addr{}, masked(Ipv6Addr{UINT64_MAX, UINT64_MAX}, gen.maxLen)};
+    for (const auto& entry : ref.prefixes) {
+        Ipv6Addr prefix{entry.second.first, entry.second.second};
+        unsigned len = entry.first;
+        probes.push_back(prefix);
+        if (len < gen.maxLen) {
+            probes.push_back(flipped(prefix, len));
+            probes.push_back(flipped(prefix, gen.maxLen - 1));
+        }
+        if (len > 0) probes.push_back(flipped(prefix, len - 1));
+    }
+    for (std::size_t i = 0; i < randomCount; ++i) probes.push_back(gen.key());
+    return probes;
+}
+
+void testRandomSets(std::mt19937_64& rng, unsigned maxLen) {
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 0; n <= 48; ++n) sizes.push_back(n);
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+
+    for (std::size_t size : sizes) {
+        Generator gen{rng, maxLen, {}};
+        for (int i = 0; i < 4; ++i) gen.bases.push_back(gen.key());
+
+        PrefixTrie trie;
+        Reference ref;
+        for (std::size_t i = 0; i < size; ++i) {
+            Ipv6Addr prefix = gen.key();
+            unsigned len = gen.length();
+            // Bits past len are ignored
+            CHECK(trie.insert(prefix, len));
+            ref.insert(prefix, len);
+        }
+        if (size % 3 == 0) {
+            trie.insert(Ipv6Addr{}, 0);
+            ref.insert(Ipv6Addr{}, 0);
+        }
+        trie.finalize();
+
+        std::vector<Ipv6Addr> probes = probesFor(ref, gen, 8 * size + 64);
+        compare(trie, ref, probes, maxLen);
+
+        // A copy of the arrays, as a mapped file provides them, answers alike
+        std::vector<PrefixTrie::Node> nodes(trie.nodes(), trie.nodes() + trie.nodeCount());
+        std::vector<uint32_t> jump;
+        if (trie.jumpTable()) jump.assign(trie.jumpTable(), trie.jumpTable() + (std::size_t{1} << trie.stride()));
+        PrefixTrie attached;
+        CHECK(attached.attach(nodes.data(), nodes.size(), jump.data(), trie.stride()));
+        compare(attached, ref, probes, maxLen);
+
+        // Inserting after finalize() and finalizing again
+        for (std::size_t i = 0; i < size / 4 + 1; ++i) {
+            Ipv6Addr prefix = gen.key();
+            unsigned len = gen.length();
+            CHECK(trie.insert(prefix, len));
+            ref.insert(prefix, len);
+        }
+        CHECK(trie.longestMatch(Ipv6Addr{}) == -1);
+        trie.finalize();
+        compare(trie, ref, probesFor(ref, gen, 4 * size + 64), maxLen);
+    }
+}
+
+void testEdges() {
+    PrefixTrie trie;
+    CHECK(trie.empty());
+    CHECK(trie.longestMatch(Ipv6Addr{}) == -1);
+    CHECK(!trie.insert(Ipv6Addr{}, 129));
+
+    // /0 alone covers everything
+    CHECK(trie.insert(Ipv6Addr{UINT64_MAX, UINT64_MAX}, 0));
+    trie.finalize();
+    CHECK(trie.longestMatch(Ipv6Addr{}) == 0);
+    CHECK(trie.longestMatch(Ipv6Addr{UINT64_MAX, UINT64_MAX}) == 0);
+
+    // A /128 only covers itself
+    Ipv6Addr host{0x20010db800000000ull, 1};
+    CHECK(trie.insert(host, 128));
+    trie.finalize();
+    CHECK(trie.longestMatch(host) == 128);
+    CHECK(trie.longestMatch(flipped(host, 127)) == 0);
+    CHECK(trie.size() == 2);
+
+    // Duplicates count once
+    CHECK(trie.insert(host, 128));
+    trie.finalize();
+    CHECK(trie.size() == 2);
+
+    // An IPv4 /32 in the top bits of hi
+    PrefixTrie v4;
+    Ipv6Addr address{0xc000020100000000ull, 0};
+    CHECK(v4.insert(address, 32));
+    CHECK(v4.insert(address, 24));
+    v4.finalize();
+    CHECK(v4.longestMatch(address) == 32);
+    CHECK(v4.longestMatch(flipped(address, 31)) == 24);
+    CHECK(v4.longestMatch(flipped(address, 23)) == -1);
+
+    // clear() forgets everything
+    v4.clear();
+    CHECK(v4.empty());
+    CHECK(v4.longestMatch(address) == -1);
+}
+
+void testAttachRejects() {
+    PrefixTrie trie;
+    trie.insert(Ipv6Addr{0x8000000000000000ull, 0}, 1);
+    trie.insert(Ipv6Addr{0xc000000000000000ull, 0}, 2);
+    trie.finalize();
+    std::vector<PrefixTrie::Node> nodes(trie.nodes(), trie.nodes() + trie.nodeCount());
+    std::vector<uint32_t> jump(trie.jumpTable(), trie.jumpTable() + (std::size_t{1} << trie.stride()));
+
+    PrefixTrie attached;
+    CHECK(attached.attach(nodes.data(), nodes.size(), jump.data(), trie.stride()));
+    CHECK(attached.size() == 2);
+    CHECK(!attached.attach(nodes.data(), nodes.size(), jump.data(), 0));
+    CHECK(!attached.attach(nodes.data(), nodes.size(), jump.data(), PrefixTrie::MAX_STRIDE + 1));
+
+    // A child out of range
+    std::vector<PrefixTrie::Node> bad = nodes;
+    bad[0].child[1] = static_cast<uint32_t>(bad.size());
+    CHECK(!attached.attach(bad.data(), bad.size(), jump.data(), trie.stride()));
+
+    // A child not longer than its parent would loop
+    bad = nodes;
+    bad[1].child[0] = 1;
+    CHECK(!attached.attach(bad.data(), bad.size(), jump.data(), trie.stride()));
+
+    // A jump entry out of range
+    std::vector<uint32_t> badJump = jump;
+    badJump[0] = static_cast<uint32_t>(nodes.size());
+    CHECK(!attached.attach(nodes.data(), nodes.size(), badJump.data(), trie.stride()));
+
+    // An empty trie has no jump table
+    CHECK(attached.attach(nullptr, 0, nullptr, 0));
+    CHECK(attached.empty());
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(0x5eed);
+    testRandomSets(rng, 32);
+    testRandomSets(rng, 128);
+    testEdges();
+    testAttachRejects();
+    return test::result("PrefixTrieTest");
+}
@@ -0,0 +1,102 @@
+/**
+ * @file SpscQueueTest.cpp
+ * @brief Capacity, wrap-around and cross-thread ordering of SpscQueue.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "utils/SpscQueue.hpp"
+
+#include <cstdint>
+#include <thread>
+
+namespace {
+
+void testCapacity() {
+    CHECK(SpscQueue<int>(0).capacity() == 2);
+    CHECK(SpscQueue<int>(5).capacity() == 8);
+    CHECK(SpscQueue<int>(8).capacity() == 8);
+
+    SpscQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        int* slot = queue.acquire();
+        CHECK(slot != nullptr);
+        if (!slot) return;
+        *slot = i;
+        queue.commit();
+    }
+    CHECK(queue.acquire() == nullptr);
+
+    int expected = 0;
+    CHECK(queue.drain([&](int value) { CHECK(value == expected++); }) == 4);
+    CHECK(queue.drain([](int) { CHECK(false); }) == 0);
+}
+
+void testUncommitted() {
+    // A slot acquired but not committed is neither consumed nor skipped
+    SpscQueue<int> queue(2);
+    *queue.acquire() = 1;
+    CHECK(queue.drain([](int) { CHECK(false); }) == 0);
+    int* slot = queue.acquire();
+    *slot = 2;
+    queue.commit();
+    CHECK(queue.drain([](int value) { CHECK(value == 2); }) == 1);
+}
+
+void testWrapAround() {
+    SpscQueue<uint32_t> queue(8);
+    uint32_t produced = 0;
+    uint32_t consumed = 0;
+    for (int round = 0; round < 1000; ++round) {
+        // 1 to 8 items per round, so the indexes cross the end of the ring at every offset
+        for (int i = 0; i <= round % 8; ++i) {
+            uint32_t* slot = queue.acquire();
+            CHECK(slot != nullptr);
+            if (!slot) return;
+            *slot = produced++;
+            queue.commit();
+        }
+        queue.drain([&](uint32_t value) { CHECK(value == consumed++); });
+    }
+    CHECK(consumed == produced);
+}
+
+void testThreads() {
+    constexpr uint64_t ITEMS = 2000000;
+    SpscQueue<uint64_t> queue(64);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < ITEMS;) {
+            uint64_t* slot = queue.acquire();
+            if (!slot) {
+                std::this_thread::yield();
+                continue;
+            }
+            *slot = i++;
+            queue.commit();
+        }
+    });
+
+    uint64_t next = 0;
+    uint64_t outOfOrder = 0;
+    while (next < ITEMS) {
+        queue.drain([&](uint64_t value) {
+            if (value != next) ++outOfOrder;
+            next = value + 1;
+        });
+    }
+    producer.join();
+    CHECK(outOfOrder == 0);
+    CHECK(next == ITEMS);
+}
+
+} // namespace
+
+int main() {
+    testCapacity();
+    testUncommitted();
+    testWrapAround();
+    testThreads();
+    return test::result("SpscQueueTest");
+}
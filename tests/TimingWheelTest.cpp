@@ -0,0 +1,170 @@
+/**
+ * @file TimingWheelTest.cpp
+ * @brief Randomized comparison of TimingWheel against a sorted timer reference.
+ *
+ * Part of the SpoofEye project, licensed under GPLv3.
+ */
+
+#include "Check.hpp"
+
+#include "utils/TimingWheel.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Wheel = TimingWheel<uint32_t>;
+
+/// Ticks covered by the four levels; timers beyond are parked and re-filed
+constexpr uint64_t RANGE = uint64_t{1} << 24;
+
+struct Reference {
+    std::set<std::pair<uint64_t, uint32_t>> due;     ///< (tick it fires at, id)
+    std::map<uint32_t, std::pair<uint64_t, Wheel::Handle>> byId;
+};
+
+/// Delays spread over every level, past expiries and beyond the wheel's range
+uint64_t randomExpiry(std::mt19937_64& rng, uint64_t now) {
+    switch (rng() % 6) {
+    case 0: return now > 100 ? now - rng() % 100 : 0;
+    case 1: return now + rng() % 64;
+    case 2: return now + rng() % 4096;
+    case 3: return now + rng() % (uint64_t{1} << 18);
+    case 4: return now + rng() % RANGE;
+    default: return now + RANGE + rng() % (3 * RANGE);
+    }
+}
+
+/// Either a few ticks, or far enough to cross level boundaries
+uint64_t randomStep(std::mt19937_64& rng) {
+    switch (rng() % 4) {
+    case 0: return rng() % 3;
+    case 1: return rng() % 70;
+    case 2: return rng() % 5000;
+    default: return rng() % (RANGE / 4);
+    }
+}
+
+void advanceBoth(Wheel& wheel, Reference& ref, uint64_t to) {
+    std::vector<uint32_t> fired;
+    std::size_t count = wheel.advance(to, [&](uint32_t id) { fired.push_back(id); });
+    CHECK(count == fired.size());
+
+    // Expected: everything due by now, in tick order (any order within a tick)
+    uint64_t lastTick = 0;
+    for (uint32_t id : fired) {
+        auto it = ref.byId.find(id);
+        CHECK(it != ref.byId.end());
+        if (it == ref.byId.end()) continue;
+        uint64_t tick = it->second.first;
+        CHECK(tick <= to);
+        CHECK(tick >= lastTick);
+        lastTick = tick;
+        ref.due.erase({tick, id});
+        ref.byId.erase(it);
+    }
+    CHECK(ref.due.empty() || ref.due.begin()->first > to);
+    CHECK(wheel.size() == ref.byId.size());
+}
+
+void testRandomOps(std::mt19937_64& rng, std::size_t capacity, uint64_t start) {
+    Wheel wheel(capacity, start);
+    Reference ref;
+    uint32_t nextId = 0;
+
+    for (int step = 0; step < 4000; ++step) {
+        uint64_t now = wheel.now();
+        switch (rng() % 8) {
+        case 0:
+            advanceBoth(wheel, ref, now + randomStep(rng));
+            break;
+        case 1: {
+            if (ref.byId.empty()) break;
+            auto it = ref.byId.lower_bound(static_cast<uint32_t>(rng() % nextId));
+            if (it == ref.byId.end()) it = ref.byId.begin();
+            Wheel::Handle handle = it->second.second;
+            CHECK(wheel.get(handle) && *wheel.get(handle) == it->first);
+            CHECK(wheel.cancel(handle));
+            CHECK(!wheel.cancel(handle));
+            CHECK(wheel.get(handle) == nullptr);
+            ref.due.erase({it->second.first, it->first});
+            ref.byId.erase(it);
+            break;
+        }
+        default: {
+            uint64_t expiry = randomExpiry(rng, now);
+            uint32_t id = nextId++;
+            Wheel::Handle handle = wheel.schedule(expiry, id);
+            CHECK((handle == Wheel::INVALID_HANDLE) == (ref.byId.size() == capacity));
+            CHECK(wheel.full() == (ref.byId.size() + (handle != Wheel::INVALID_HANDLE) == capacity));
+            if (handle == Wheel::INVALID_HANDLE) break;
+            // Past or current expiries fire on the next tick
+            uint64_t tick = expiry > now ? expiry : now + 1;
+            ref.due.insert({tick, id});
+            ref.byId[id] = {tick, handle};
+            break;
+        }
+        }
+        CHECK(wheel.size() == ref.byId.size());
+    }
+
+    // Drain: every remaining timer, including the far-future ones, fires on time
+    while (!ref.due.empty()) {
+        uint64_t next = ref.due.begin()->first;
+        if (next > wheel.now() + 1) advanceBoth(wheel, ref, next - 1);
+        CHECK(ref.due.begin()->first == next);
+        advanceBoth(wheel, ref, next);
+        // A timer that missed its tick would never fire: stop rather than spin
+        if (!ref.due.empty() && ref.due.begin()->first <= next) break;
+    }
+    CHECK(wheel.size() == 0);
+}
+
+void testEdges() {
+    Wheel wheel(2, 1000);
+    int fired = 0;
+    auto count = [&](uint32_t) { ++fired; };
+
+    // Going back in time, or standing still, is ignored
+    CHECK(wheel.advance(1000, count) == 0);
+    CHECK(wheel.advance(10, count) == 0);
+    CHECK(wheel.now() == 1000);
+
+    // An empty wheel jumps straight to the new time
+    CHECK(wheel.advance(5000, count) == 0);
+    CHECK(wheel.now() == 5000);
+
+    CHECK(wheel.schedule(5000 + 3 * RANGE, 1) != Wheel::INVALID_HANDLE);
+    CHECK(wheel.schedule(5000 + 64, 2) != Wheel::INVALID_HANDLE);
+    CHECK(wheel.full());
+    CHECK(wheel.schedule(5001, 3) == Wheel::INVALID_HANDLE);
+    CHECK(!wheel.cancel(Wheel::INVALID_HANDLE));
+
+    CHECK(wheel.advance(5000 + 63, count) == 0);
+    CHECK(wheel.advance(5000 + 64, count) == 1);
+    // The parked timer is re-filed at least twice before it is due
+    CHECK(wheel.advance(5000 + 3 * RANGE - 1, count) == 0);
+    CHECK(wheel.advance(5000 + 3 * RANGE, count) == 1);
+    CHECK(fired == 2);
+    CHECK(wheel.size() == 0);
+
+    Wheel none(0);
+    CHECK(none.full());
+    CHECK(none.schedule(1, 1) == Wheel::INVALID_HANDLE);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(0x5eed);
+    testRandomOps(rng, 64, 0);
+    testRandomOps(rng, 1024, RANGE - 5);
+    testRandomOps(rng, 4096, (uint64_t{1} << 40) + 12345);
+    testEdges();
+    return test::result("TimingWheelTest");
+}
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+dns_standin_server.py
+---
+Purpose:
+    Minimal stand-in DNS server for exercising SpoofEye's DNS monitor and its
+    consistency checker without touching a real resolver.
+    - Answers A queries from a fixed table, or NXDOMAIN.
+    - Can delay every reply, to keep queries outstanding.
+    - Logs every query with its source port and how many were outstanding.
+
+Usage:
+    python3 dns_standin_server.py --listen 127.0.0.1:53 \
+        --answer lie.test=6.6.6.6 --default 1.1.1.1 --delay-ms 500 --log queries.log
+"""
+
+import argparse
+import heapq
+import select
+import socket
+import struct
+import sys
+import time
+
+
+def parse_endpoint(text: str):
+    """Split 'a.b.c.d:port' into (host, port)."""
+    host, _, port = text.rpartition(":")
+    return host, int(port)
+
+
+def question(query: bytes):
+    """
+    Locate the question of a query.
+
+    Returns:
+        (name, end) with end the offset just past QTYPE/QCLASS, or None if malformed.
+    """
+    offset, labels = 12, []
+    while offset < len(query) and query[offset]:
+        length = query[offset]
+        labels.append(query[offset + 1:offset + 1 + length].decode("ascii", "replace"))
+        offset += 1 + length
+    if offset + 5 > len(query):
+        return None
+    return ".".join(labels).lower(), offset + 5
+
+
+def build_reply(query: bytes, end: int, addresses, qtype: int) -> bytes:
+    """Echo the question and answer it with the A records, NXDOMAIN if None."""
+    flags = 0x8180 if addresses is not None else 0x8183
+    answers = addresses if addresses is not None and qtype == 1 else []
+    out = query[:2] + struct.pack("!HHHHH", flags, 1, len(answers), 0, 0) + query[12:end]
+    for address in answers:
+        out += b"\xc0\x0c" + struct.pack("!HHIH", 1, 1, 60, 4) + socket.inet_aton(address)
+    return out
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Stand-in DNS server (A records only)")
+    parser.add_argument("--listen", action="append", required=True, help="address:port, repeatable")
+    parser.add_argument("--answer", action="append", default=[], help="name=ip[,ip...], repeatable")
+    parser.add_argument("--default", help="address for names not listed (default: NXDOMAIN)")
+    parser.add_argument("--delay-ms", type=int, default=0, help="delay before each reply")
+    parser.add_argument("--log", help="append 'time port txid outstanding name' per query")
+    args = parser.parse_args()
+
+    table = {}
+    for entry in args.answer:
+        name, _, addresses = entry.partition("=")
+        table[name.lower().rstrip(".")] = [a for a in addresses.split(",") if a]
+
+    sockets = []
+    for endpoint in args.listen:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.bind(parse_endpoint(endpoint))
+        sockets.append(sock)
+    log = open(args.log, "a", buffering=1) if args.log else None
+
+    # (due time, sequence, socket, reply, client)
+    scheduled = []
+    sequence = 0
+    while True:
+        timeout = max(0.0, scheduled[0][0] - time.monotonic()) if scheduled else None
+        for sock in select.select(sockets, [], [], timeout)[0]:
+            query, client = sock.recvfrom(4096)
+            parsed = question(query)
+            if len(query) < 12 or query[2] & 0x80 or parsed is None:
+                continue
+            name, end = parsed
+            qtype = struct.unpack("!H", query[end - 4:end - 2])[0]
+            addresses = table.get(name, [args.default] if args.default else None)
+            reply = build_reply(query, end, addresses, qtype)
+            sequence += 1
+            heapq.heappush(scheduled, (time.monotonic() + args.delay_ms / 1000, sequence, sock, reply, client))
+            if log:
+                txid = struct.unpack("!H", query[:2])[0]
+                log.write("%.3f %d %d %d %s\n" % (time.time(), client[1], txid, len(scheduled), name))
+        now = time.monotonic()
+        while scheduled and scheduled[0][0] <= now:
+            _, _, sock, reply, client = heapq.heappop(scheduled)
+            sock.sendto(reply, client)
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(0)
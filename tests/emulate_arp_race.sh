@@ -0,0 +1,145 @@
+#!/usr/bin/env bash
+# tests/emulate_arp_race.sh
+# Checks that ARP replies arriving right behind the host's own request are not
+# reported as unsolicited, with XDP folding on and several capture workers.
+# Everything runs on a veth pair between two throwaway network namespaces:
+#   se-host (10.77.0.1, runs SpoofEye, XDP on se-h) <-> se-peer (answers on se-p)
+# The peer answers every request of the host as fast as it can, then sends a
+# few replies nobody asked for, which must still be reported.
+# Needs root, iproute2, python3 and a kernel with XDP on veth (5.18+ for the
+# ring buffer link used by SpoofEye).
+
+set -euo pipefail
+
+SCRIPT_NAME="$(basename "$0")"
+REPO_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BINARY="${1:-$REPO_DIR/build/spoofeye}"
+REQUESTS="${REQUESTS:-200}"
+CONTROLS=3
+HOST_NS="se-host"
+PEER_NS="se-peer"
+WORK_DIR="$(mktemp -d)"
+SPOOFEYE_PID=""
+
+if [[ "${1:-}" == "-h" || "${1:-}" == "--help" ]]; then
+  echo "Usage: sudo $SCRIPT_NAME [SPOOFEYE_BINARY]   (default: build/spoofeye, REQUESTS=$REQUESTS)"
+  exit 0
+fi
+if (( REQUESTS < 1 || REQUESTS > 250 )); then
+  echo "Error: REQUESTS must be within 1-250 (one per address of 10.77.0.0/24)." >&2
+  exit 2
+fi
+if [[ $EUID -ne 0 ]]; then
+  echo "Error: run as root (network namespaces, raw sockets, XDP)." >&2
+  exit 2
+fi
+if [[ ! -x "$BINARY" ]]; then
+  echo "Error: $BINARY not found, build it first (make)." >&2
+  exit 2
+fi
+
+cleanup() {
+  [[ -n "$SPOOFEYE_PID" ]] && kill "$SPOOFEYE_PID" 2>/dev/null && wait "$SPOOFEYE_PID" 2>/dev/null || true
+  ip netns del "$HOST_NS" 2>/dev/null || true
+  ip netns del "$PEER_NS" 2>/dev/null || true
+  rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+echo "[*] Creating namespaces $HOST_NS / $PEER_NS"
+ip netns add "$HOST_NS"
+ip netns add "$PEER_NS"
+ip link add se-h netns "$HOST_NS" type veth peer name se-p netns "$PEER_NS"
+ip -n "$HOST_NS" link set lo up
+ip -n "$HOST_NS" link set se-h up
+ip -n "$HOST_NS" addr add 10.77.0.1/24 dev se-h
+ip -n "$HOST_NS" route add default via 10.77.0.254
+ip -n "$PEER_NS" link set se-p up
+HOST_MAC="$(ip netns exec "$HOST_NS" cat /sys/class/net/se-h/address)"
+
+cat > "$WORK_DIR/spoofeye.ini" <<EOF
+output_log_path = $WORK_DIR/spoofeye.log
+show_notifications = false
+stylize_output = false
+known_dns_path = $REPO_DIR/resources/known_dns.json
+known_dns_db_path = $WORK_DIR/known_dns.bin
+
+[Monitors]
+arp_monitor = true
+ndp_monitor = false
+dns_monitor = false
+icmp_monitor = false
+
+[Capture]
+workers = 4
+xdp_interfaces = se-h
+EOF
+
+echo "[*] Starting $BINARY in $HOST_NS"
+ip netns exec "$HOST_NS" "$BINARY" --config-path "$WORK_DIR/spoofeye.ini" > "$WORK_DIR/stdout.log" 2>&1 &
+SPOOFEYE_PID=$!
+sleep 2
+if grep -q "XDP pre-aggregation unavailable" "$WORK_DIR/stdout.log" "$WORK_DIR/spoofeye.log" 2>/dev/null; then
+  echo "Warning: XDP could not be attached, only the ring path is tested." >&2
+fi
+
+# The peer: one announcement to start the request tracker (blind for one
+# request timeout), then an immediate reply to every request of the host,
+# then replies nobody asked for
+ip netns exec "$PEER_NS" timeout 120 python3 - "$HOST_MAC" "$REQUESTS" "$CONTROLS" > "$WORK_DIR/peer.log" 2>&1 <<'EOF' &
+import socket, struct, sys
+
+host_mac = bytes.fromhex(sys.argv[1].replace(":", ""))
+requests, controls = int(sys.argv[2]), int(sys.argv[3])
+host_ip = socket.inet_aton("10.77.0.1")
+raw = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(0x0806))
+raw.bind(("se-p", 0))
+
+def arp(op, smac, sip, dmac, tmac, tip):
+    body = struct.pack("!HHBBH", 1, 0x0800, 6, 4, op) + smac + sip + tmac + tip
+    return dmac + smac + b"\x08\x06" + body
+
+def peer_mac(last):
+    return bytes([2, 0, 0, 0x77, 0, last])
+
+raw.send(arp(1, peer_mac(254), socket.inet_aton("10.77.0.254"), b"\xff" * 6, bytes(6),
+             socket.inet_aton("10.77.0.254")))
+answered = 0
+while answered < requests:
+    frame = raw.recv(64)
+    if frame[21] != 1 or frame[28:32] != host_ip:
+        continue
+    target = frame[38:42]
+    raw.send(arp(2, peer_mac(target[3]), target, host_mac, host_mac, host_ip))
+    answered += 1
+for i in range(controls):
+    ip = socket.inet_aton("10.77.1.%d" % (i + 1))
+    raw.send(arp(2, peer_mac(200 + i), ip, host_mac, host_mac, host_ip))
+print("answered", answered, "sent", controls, "unsolicited")
+EOF
+PEER_PID=$!
+sleep 3
+
+echo "[*] Resolving $REQUESTS addresses from $HOST_NS"
+ip netns exec "$HOST_NS" python3 - "$REQUESTS" <<'EOF'
+import socket, sys, time
+udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+for i in range(int(sys.argv[1])):
+    # Each datagram makes the kernel resolve a new neighbour
+    udp.sendto(b"x", ("10.77.0.%d" % (2 + i), 9))
+    time.sleep(0.02)
+EOF
+wait "$PEER_PID" || { echo "Error: the peer did not see every request:" >&2; cat "$WORK_DIR/peer.log" >&2; exit 1; }
+
+# Held replies are judged within a second
+sleep 1
+LOG="$WORK_DIR/spoofeye.log"
+FALSE_ALERTS="$(grep -c "Unsolicited ARP reply: 10\.77\.0\." "$LOG" || true)"
+CONTROL_ALERTS="$(grep -c "Unsolicited ARP reply: 10\.77\.1\." "$LOG" || true)"
+echo "Answered requests reported as unsolicited: $FALSE_ALERTS (expected 0)"
+echo "Unsolicited replies reported: $CONTROL_ALERTS (expected $CONTROLS)"
+if [[ "$FALSE_ALERTS" -ne 0 || "$CONTROL_ALERTS" -ne "$CONTROLS" ]]; then
+  grep "ARP" "$LOG" | tail -20 >&2
+  exit 1
+fi
+echo "OK"
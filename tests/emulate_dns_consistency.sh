@@ -0,0 +1,162 @@
+#!/usr/bin/env bash
+# tests/emulate_dns_consistency.sh
+# Runs SpoofEye's DNS consistency checker against stand-in DNS servers inside a
+# throwaway network namespace (se-dns), using tests/dns_standin_server.py:
+#   127.0.0.1:53    the configured resolver, which lies about lie.test
+#   127.0.0.2:5300  a trusted resolver, which answers slowly
+#   127.0.0.3:5300  another trusted resolver, which gets another CDN answer for cdn.test
+# Checks that the lie is reported once a second sample confirms it and the
+# honest answer is not, and that the re-queries stay within the configured
+# rate and in-flight bounds, each from its own source port.
+# Needs root, iproute2 and python3.
+
+set -euo pipefail
+
+SCRIPT_NAME="$(basename "$0")"
+REPO_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BINARY="${1:-$REPO_DIR/build/spoofeye}"
+NS="se-dns"
+RATE=10
+IN_FLIGHT=4
+DELAY_MS=800
+NAMES=40
+CONFIRM_DELAY=31  # DnsConsistencyChecker::CONFIRM_DELAY, plus a second
+WORK_DIR="$(mktemp -d)"
+PIDS=()
+
+if [[ "${1:-}" == "-h" || "${1:-}" == "--help" ]]; then
+  echo "Usage: sudo $SCRIPT_NAME [SPOOFEYE_BINARY]   (default: build/spoofeye)"
+  exit 0
+fi
+if [[ $EUID -ne 0 ]]; then
+  echo "Error: run as root (network namespaces, packet capture)." >&2
+  exit 2
+fi
+if [[ ! -x "$BINARY" ]]; then
+  echo "Error: $BINARY not found, build it first (make)." >&2
+  exit 2
+fi
+
+cleanup() {
+  for pid in "${PIDS[@]}"; do kill "$pid" 2>/dev/null || true; done
+  wait 2>/dev/null || true
+  ip netns del "$NS" 2>/dev/null || true
+  rm -rf "/etc/netns/$NS" "$WORK_DIR"
+}
+trap cleanup EXIT
+
+echo "[*] Creating namespace $NS"
+ip netns add "$NS"
+ip -n "$NS" link set lo up
+# ip netns exec bind-mounts this file over /etc/resolv.conf inside the namespace
+mkdir -p "/etc/netns/$NS"
+echo "nameserver 127.0.0.1" > "/etc/netns/$NS/resolv.conf"
+
+SERVER="$REPO_DIR/tests/dns_standin_server.py"
+ip netns exec "$NS" python3 "$SERVER" --listen 127.0.0.1:53 \
+  --answer lie.test=6.6.6.6 --answer agree.test=93.184.216.34 --answer cdn.test=203.0.113.5 \
+  --default 93.184.216.200 &
+PIDS+=($!)
+ip netns exec "$NS" python3 "$SERVER" --listen 127.0.0.2:5300 \
+  --answer lie.test=93.184.216.34 --answer agree.test=93.184.216.34 --answer cdn.test=93.184.216.34 \
+  --default 93.184.216.200 --delay-ms "$DELAY_MS" --log "$WORK_DIR/trusted.log" &
+PIDS+=($!)
+ip netns exec "$NS" python3 "$SERVER" --listen 127.0.0.3:5300 \
+  --answer lie.test=93.184.216.34 --answer agree.test=93.184.216.34 --answer cdn.test=198.51.100.7 \
+  --default 93.184.216.200 &
+PIDS+=($!)
+
+cat > "$WORK_DIR/spoofeye.ini" <<EOF
+output_log_path = $WORK_DIR/spoofeye.log
+show_notifications = false
+stylize_output = false
+known_dns_path = $REPO_DIR/resources/known_dns.json
+known_dns_db_path = $WORK_DIR/known_dns.bin
+
+[Monitors]
+arp_monitor = false
+ndp_monitor = false
+dns_monitor = true
+icmp_monitor = false
+
+[DNS]
+trusted_resolvers = 127.0.0.2:5300, 127.0.0.3:5300
+consistency_rate = $RATE
+consistency_in_flight = $IN_FLIGHT
+EOF
+
+echo "[*] Starting $BINARY in $NS"
+ip netns exec "$NS" "$BINARY" --config-path "$WORK_DIR/spoofeye.ini" > "$WORK_DIR/stdout.log" 2>&1 &
+PIDS+=($!)
+sleep 2
+
+resolve() {
+  ip netns exec "$NS" python3 - "$@" <<'EOF'
+import socket, struct, sys
+
+def query(name, txid):
+    qname = b"".join(bytes([len(l)]) + l.encode() for l in name.split(".")) + b"\0"
+    return struct.pack("!HHHHHH", txid, 0x0100, 1, 0, 0, 0) + qname + struct.pack("!HH", 1, 1)
+
+client = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+client.settimeout(1)
+for txid, name in enumerate(sys.argv[1:], 1):
+    client.sendto(query(name, txid), ("127.0.0.1", 53))
+    client.recvfrom(4096)
+EOF
+}
+
+echo "[*] Resolving lie.test, agree.test, cdn.test and $NAMES other names through the configured resolver"
+OTHERS=()
+for ((i = 0; i < NAMES; i++)); do OTHERS+=("name$i.test"); done
+resolve lie.test agree.test cdn.test "${OTHERS[@]}"
+
+# Every re-query has answered or expired once the rate allows them all (two per name)
+WAIT=$(( 2 * (NAMES + 3) / RATE + DELAY_MS / 1000 + 5 ))
+sleep "$WAIT"
+LOG="$WORK_DIR/spoofeye.log"
+FAILED=0
+if grep -q "DNS Consistency Alert" "$LOG"; then
+  echo "reported on the first sample: yes (expected no)"; FAILED=1
+fi
+
+# A divergence is only reported once the next sample of the name confirms it
+echo "[*] Resolving lie.test, agree.test and cdn.test again after ${CONFIRM_DELAY}s"
+sleep "$CONFIRM_DELAY"
+resolve lie.test agree.test cdn.test
+sleep $(( DELAY_MS / 1000 + 3 ))
+
+if grep -q "DNS Consistency Alert.*lie\.test" "$LOG"; then
+  echo "lie.test reported: yes (expected)"
+else
+  echo "lie.test reported: no (expected yes)"; FAILED=1
+fi
+for name in agree cdn; do
+  if grep -q "DNS Consistency Alert.*$name\.test" "$LOG"; then
+    echo "$name.test reported: yes (expected no)"; FAILED=1
+  else
+    echo "$name.test reported: no (expected)"
+  fi
+done
+
+python3 - "$WORK_DIR/trusted.log" "$RATE" "$IN_FLIGHT" <<'EOF' || FAILED=1
+import sys
+
+rate, in_flight = int(sys.argv[2]), int(sys.argv[3])
+rows = [line.split() for line in open(sys.argv[1])]
+times = [float(r[0]) for r in rows]
+ports = {r[1] for r in rows}
+outstanding = max(int(r[3]) for r in rows)
+# Token bucket: one second's worth at once, then the rate
+worst = max(sum(1 for t in times if start <= t < start + 1) for start in times)
+print("trusted queries: %d, distinct source ports: %d" % (len(rows), len(ports)))
+print("most outstanding: %d (limit %d), most in one second: %d (limit %d)" % (outstanding, in_flight, worst, 2 * rate))
+ok = len(rows) > 2 and outstanding <= in_flight and worst <= 2 * rate and len(ports) >= 0.9 * len(rows)
+sys.exit(0 if ok else 1)
+EOF
+
+if [[ "$FAILED" -ne 0 ]]; then
+  grep "DNS" "$LOG" | tail -20 >&2
+  exit 1
+fi
+echo "OK"